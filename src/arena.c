@@ -0,0 +1,304 @@
+/**
+* @file
+* @author Steve Karg
+* @brief Bump allocator whose memory is released all at once
+*
+* @section LICENSE
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+* @section DESCRIPTION
+*
+* An arena hands out memory by moving a pointer forward through a
+* block that was allocated with malloc.  Nothing is freed on its own;
+* arena_free releases every block at once.  The arena bookkeeping lives
+* at the start of the first block, so an arena that is sized right
+* when it is created costs exactly one malloc.
+* {@code
+* ARENA *arena = arena_create(4096);
+* char *name = arena_strndup(arena, "section", 7);
+* arena_free(arena);
+* }
+*/
+
+/* includes */
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/* smallest block that is worth a malloc */
+#define ARENA_MIN_BLOCK 256
+/* blocks stop doubling at this size */
+#define ARENA_MAX_BLOCK (1024UL * 1024UL)
+
+/* alignment of every allocation */
+union arena_align {
+    void *p;
+    long double d;
+    long long l;
+    void (*f)(void);
+};
+#define ARENA_ALIGN (sizeof(union arena_align))
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/* header at the start of each block */
+struct arena_block {
+    struct arena_block *next;
+    size_t size;        /* bytes in the block, including this header */
+    size_t used;        /* bytes handed out, including this header */
+};
+
+struct arena {
+    struct arena_block *current;        /* block being filled */
+    size_t size;        /* bytes in all blocks */
+    size_t used;        /* bytes handed out in all blocks */
+    size_t blocks;      /* number of blocks */
+};
+
+#define ARENA_BLOCK_HEADER ARENA_ROUND(sizeof(struct arena_block))
+
+/**
+* Create an arena
+*
+* @param size - expected number of bytes that will be allocated.
+* The first block is made this large so that a good guess means
+* the arena uses a single malloc.
+*
+* @return new arena, or NULL if out of memory
+*/
+ARENA *arena_create(size_t size)
+{
+    struct arena_block *block;
+    ARENA *arena;
+    size_t total;
+
+    total = ARENA_BLOCK_HEADER + ARENA_ROUND(sizeof(ARENA)) +
+        ARENA_ROUND(size);
+    if (total < ARENA_MIN_BLOCK) {
+        total = ARENA_MIN_BLOCK;
+    }
+    block = malloc(total);
+    if (!block) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = total;
+    block->used = ARENA_BLOCK_HEADER + ARENA_ROUND(sizeof(ARENA));
+    arena = (ARENA *)((char *)block + ARENA_BLOCK_HEADER);
+    arena->current = block;
+    arena->size = total;
+    arena->used = block->used;
+    arena->blocks = 1;
+
+    return arena;
+}
+
+/**
+* Release an arena and everything allocated from it
+*
+* @param arena - arena, may be NULL
+*/
+void arena_free(ARENA *arena)
+{
+    struct arena_block *block;
+    struct arena_block *next;
+
+    if (!arena) {
+        return;
+    }
+    /* the first block holds the arena, so it goes last */
+    for (block = arena->current; block; block = next) {
+        next = block->next;
+        free(block);
+    }
+}
+
+/**
+* Move the blocks of one arena into another, so that everything
+* allocated from either is released by arena_free of the first.
+* Nothing is copied.
+*
+* @param arena - arena that takes the blocks
+* @param other - arena to empty, which must not be used afterwards
+*/
+void arena_adopt(ARENA *arena, ARENA *other)
+{
+    struct arena_block *last;
+
+    if (!arena || !other || (arena == other)) {
+        return;
+    }
+    /* the first block of other holds it, and is last in its list */
+    for (last = other->current; last->next; last = last->next) {
+    }
+    /* behind the current block, so allocation carries on there */
+    last->next = arena->current->next;
+    arena->current->next = other->current;
+    arena->size += other->size;
+    arena->used += other->used;
+    arena->blocks += other->blocks;
+}
+
+/**
+* Allocate memory from an arena
+*
+* @param arena - arena
+* @param size - number of bytes
+*
+* @return aligned memory, or NULL if out of memory.  The memory is
+* released by arena_free.
+*/
+void *arena_alloc(ARENA *arena, size_t size)
+{
+    struct arena_block *block;
+    size_t total;
+    size_t start;
+    void *p;
+
+    if (!arena) {
+        return NULL;
+    }
+    size = ARENA_ROUND(size ? size : 1);
+    block = arena->current;
+    /* strings are packed, so realign the start */
+    start = ARENA_ROUND(block->used);
+    if ((start > block->size) || ((block->size - start) < size)) {
+        total = block->size * 2;
+        if (total > ARENA_MAX_BLOCK) {
+            total = ARENA_MAX_BLOCK;
+        }
+        if (total < ARENA_BLOCK_HEADER + size) {
+            total = ARENA_BLOCK_HEADER + size;
+        }
+        block = malloc(total);
+        if (!block) {
+            return NULL;
+        }
+        block->next = arena->current;
+        block->size = total;
+        block->used = ARENA_BLOCK_HEADER;
+        arena->current = block;
+        arena->size += total;
+        arena->used += ARENA_BLOCK_HEADER;
+        arena->blocks++;
+        start = block->used;
+    }
+    p = (char *)block + start;
+    arena->used += (start - block->used) + size;
+    block->used = start + size;
+
+    return p;
+}
+
+/**
+* Allocate zeroed memory from an arena
+*
+* @param arena - arena
+* @param count - number of items
+* @param size - size of each item
+*
+* @return aligned zeroed memory, or NULL if out of memory
+*/
+void *arena_calloc(ARENA *arena, size_t count, size_t size)
+{
+    void *p;
+
+    if (size && (count > ((size_t)-1) / size)) {
+        return NULL;
+    }
+    p = arena_alloc(arena, count * size);
+    if (p) {
+        memset(p, 0, count * size);
+    }
+
+    return p;
+}
+
+/**
+* Copy characters into an arena as a C string
+*
+* @param arena - arena
+* @param str - characters
+* @param len - number of characters
+*
+* @return null-terminated copy, or NULL if out of memory
+*/
+char *arena_strndup(ARENA *arena, const char *str, size_t len)
+{
+    char *copy;
+
+    if (!arena || (!str && len)) {
+        return NULL;
+    }
+    /* strings need no alignment, so pack them */
+    if ((arena->current->size - arena->current->used) > len) {
+        copy = (char *)arena->current + arena->current->used;
+        arena->current->used += len + 1;
+        arena->used += len + 1;
+    } else {
+        copy = arena_alloc(arena, len + 1);
+        if (!copy) {
+            return NULL;
+        }
+    }
+    if (len) {
+        memcpy(copy, str, len);
+    }
+    copy[len] = '\0';
+
+    return copy;
+}
+
+/**
+* Bytes of memory held by an arena
+*
+* @param arena - arena
+*
+* @return number of bytes allocated with malloc
+*/
+size_t arena_size(const ARENA *arena)
+{
+    return arena ? arena->size : 0;
+}
+
+/**
+* Bytes of memory in use in an arena
+*
+* @param arena - arena
+*
+* @return number of bytes handed out, including bookkeeping
+*/
+size_t arena_used(const ARENA *arena)
+{
+    return arena ? arena->used : 0;
+}
+
+/**
+* Number of blocks in an arena
+*
+* @param arena - arena
+*
+* @return number of mallocs made by the arena
+*/
+size_t arena_blocks(const ARENA *arena)
+{
+    return arena ? arena->blocks : 0;
+}
@@ -0,0 +1,36 @@
+/**
+* @file
+* @author Steve Karg
+* @brief Bump allocator whose memory is released all at once
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct arena ARENA;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    ARENA *arena_create(size_t size);
+    void arena_free(ARENA *arena);
+    void arena_adopt(ARENA *arena,
+        ARENA *other);
+    void *arena_alloc(ARENA *arena,
+        size_t size);
+    void *arena_calloc(ARENA *arena,
+        size_t count,
+        size_t size);
+    char *arena_strndup(ARENA *arena,
+        const char *str,
+        size_t len);
+    size_t arena_size(const ARENA *arena);
+    size_t arena_used(const ARENA *arena);
+    size_t arena_blocks(const ARENA *arena);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* ARENA_H */
@@ -26,6 +26,11 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+/* copy_file_range is a GNU extension */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE
+#endif
+
 /* includes */
 #include <stdio.h>
 #include <stdlib.h>
@@ -35,15 +40,20 @@
 #if defined(__BORLANDC__)
   #include <alloc.h>
   #include <mem.h>
-#elif defined(_MSC_VER)
-  #define strcmpi _stricmp
-#else
-  #define strcmpi strcasecmp
+#endif
+#if defined(__linux__)
+  #include <fcntl.h>
+  #include <unistd.h>
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/sendfile.h>
 #endif
 
 #include "profile.h"
+#include "profile_sync.h"
 #include "rmspace.h"
 #include "stptok.h"
+#include "strfold.h"
 
 //#define TEST
 #ifdef TEST
@@ -51,32 +61,442 @@
   #include "ctest.h"
 #endif
 
-/* constants for copy file */
-#define BLOCKSIZE 512
-typedef char DATA;
+#if defined(__linux__)
+/**
+ * Copy the rest of a regular file inside the kernel, without passing
+ * the data through this process
+ *
+ * @param dest - destination file descriptor, at the place to write
+ * @param source - source file descriptor
+ * @param pOffset - place to read from in the source, moved forward
+ *
+ * @return TRUE if everything was copied, FALSE if the rest has to be
+ *  copied through a buffer
+ */
+static BOOL filecopy_kernel(
+  int dest,
+  int source,
+  off_t *pOffset)
+{
+  struct stat source_stat;
+
+  if ((fstat(source,&source_stat) != 0) || !S_ISREG(source_stat.st_mode))
+    return (FALSE);
+  /* copy_file_range can share the blocks on file systems that allow it */
+  while ((*pOffset < source_stat.st_size) &&
+    (copy_file_range(source,pOffset,dest,NULL,
+    (size_t)(source_stat.st_size - *pOffset),0) > 0))
+  {
+  }
+  /* sendfile works between more kinds of file systems */
+  while ((*pOffset < source_stat.st_size) &&
+    (sendfile(dest,source,pOffset,
+    (size_t)(source_stat.st_size - *pOffset)) > 0))
+  {
+  }
+
+  return (*pOffset >= source_stat.st_size);
+}
+#endif
+
 /**
- * Binary copy of one file to another
+ * Binary copy of one file to another, from the position of the source
+ * to the position of the destination.  On Linux the kernel copies the
+ * data; otherwise, or where the kernel cannot, it is copied through a
+ * buffer of PROFILE_COPY_BLOCKSIZE bytes.
  *
  * @param pDest - destination file handle
  * @param pSource - source file handle
+ *
+ * @return TRUE if everything was copied
  */
-static void filecopy(
+BOOL profile_filecopy(
   FILE *pDest,
   FILE *pSource)
 {
-  DATA block[BLOCKSIZE] = {0}; /* holds data for file copy */
-  int num_read = 0;  /* number of bytes read when copying file */
+  char *pBlock = NULL; /* holds data for file copy */
+  size_t num_read = 0; /* number of bytes read when copying file */
+  BOOL status = TRUE;
+#if defined(__linux__)
+  off_t offset = 0; /* where the kernel copy reads from */
+  BOOL copied = FALSE;
+#endif
+
+  if (!pDest || !pSource)
+    return (FALSE);
+#if defined(__linux__)
+  offset = ftello(pSource);
+  if ((offset >= 0) && (fflush(pSource) == 0) && (fflush(pDest) == 0))
+  {
+    copied = filecopy_kernel(fileno(pDest),fileno(pSource),&offset);
+    /* both streams go on from where the kernel stopped */
+    if ((fseeko(pSource,offset,SEEK_SET) != 0) ||
+      (fseeko(pDest,lseek(fileno(pDest),0,SEEK_CUR),SEEK_SET) != 0))
+      return (FALSE);
+    if (copied)
+      return (TRUE);
+  }
+#endif
+  pBlock = malloc(PROFILE_COPY_BLOCKSIZE);
+  if (!pBlock)
+    return (FALSE);
+  while ((num_read = fread(pBlock,1,PROFILE_COPY_BLOCKSIZE,pSource)) > 0)
+  {
+    if (fwrite(pBlock,1,num_read,pDest) != num_read)
+    {
+      status = FALSE;
+      break;
+    }
+  }
+  if (ferror(pSource))
+    status = FALSE;
+  free(pBlock);
+
+  return (status);
+}
+
+/* where the lines of an INI file are read from */
+struct profile_source
+{
+  FILE *pFile; /* stream, or NULL to read from pBuffer */
+  const char *pBuffer; /* INI text, which need not be null-terminated */
+  size_t nLength; /* number of characters in pBuffer */
+  size_t offset; /* next character to read from pBuffer */
+};
+
+/* where the lines of an INI file are written to */
+struct profile_sink
+{
+  FILE *pFile; /* stream, or NULL to write to pBuffer */
+  char *pBuffer; /* receives the INI text */
+  size_t nSize; /* size of pBuffer */
+  size_t len; /* number of characters written, including any
+    that did not fit in pBuffer */
+};
+
+/**
+ * Read a line the same way as fgets, from a file or from memory
+ *
+ * @param pLine - buffer that receives the line
+ * @param size - size of the buffer
+ * @param pSource - where to read from
+ *
+ * @return pLine, or NULL at the end of the text
+ */
+static char *profile_gets(
+  char *pLine,
+  int size,
+  struct profile_source *pSource)
+{
+  const char *pStart; /* first character of the line */
+  const char *pEnd; /* newline that ends the line */
+  size_t len; /* number of characters to copy */
+
+  if (pSource->pFile)
+    return (fgets(pLine,size,pSource->pFile));
+  if ((size < 1) || (pSource->offset >= pSource->nLength))
+    return (NULL);
+  pStart = pSource->pBuffer + pSource->offset;
+  len = pSource->nLength - pSource->offset;
+  if (len > (size_t)(size - 1))
+    len = (size_t)(size - 1);
+  pEnd = memchr(pStart,'\n',len);
+  if (pEnd)
+    len = (size_t)(pEnd - pStart) + 1;
+  memcpy(pLine,pStart,len);
+  pLine[len] = '\0';
+  pSource->offset += len;
+
+  return (pLine);
+}
+
+/**
+ * Write formatted text to a file or to memory.  Text that does
+ * not fit in memory is counted but not stored.
+ *
+ * @param pSink - where to write
+ * @param pFormat - printf format
+ */
+static void profile_printf(
+  struct profile_sink *pSink,
+  const char *pFormat,
+  ...)
+{
+  va_list args;
+  int len;
+
+  va_start(args,pFormat);
+  if (pSink->pFile)
+    (void)vfprintf(pSink->pFile,pFormat,args);
+  else
+  {
+    if (pSink->len < pSink->nSize)
+      len = vsnprintf(pSink->pBuffer + pSink->len,pSink->nSize - pSink->len,
+        pFormat,args);
+    else
+      len = vsnprintf(NULL,0,pFormat,args);
+    if (len > 0)
+      pSink->len += (size_t)len;
+  }
+  va_end(args);
+}
+
+/**
+ * Cleans up the string after the '=' of a key line and copies
+ * it to the return buffer, truncating it to fit.
+ *
+ * @param pReturnedString - buffer that receives the string
+ * @param nSize - size of the buffer
+ * @param pLine - string after the '=', which gets modified
+ *
+ * @return number of characters copied, not including the null
+ */
+static size_t profile_copy_value(
+  char *pReturnedString,
+  size_t nSize,
+  char *pLine)
+{
+  size_t len = 0; /* length of string */
+
+  /* cleanup return string */
+  rmtrail(pLine);
+  rmlead(pLine);
+  (void)rmquotes(pLine);
+  /* count what's left */
+  len = strlen(pLine);
+  /* copy as much as we can, then truncate */
+  if (len >= nSize)
+    len = nSize - 1; /* less the null */
+  strncpy(pReturnedString,pLine,len);
+  pReturnedString[len] = '\0';
+
+  return (len);
+}
+
+/**
+ * Copies the default string to the return buffer and cleans it up.
+ *
+ * @param pReturnedString - buffer that receives the string
+ * @param nSize - size of the buffer
+ * @param pDefault - default string
+ *
+ * @return number of characters copied, not including the null
+ */
+static size_t profile_copy_default(
+  char *pReturnedString,
+  size_t nSize,
+  const char *pDefault)
+{
+  (void)strncpy(pReturnedString,pDefault,nSize);
+  pReturnedString[nSize-1] = '\0';
+  /* cleanup return string */
+  rmtrail(pReturnedString);
+  rmlead(pReturnedString);
+  (void)rmquotes(pReturnedString);
+  /* count what's left */
+  return (strlen(pReturnedString));
+}
+
+/**
+ * Copies the lines of an INI file with one string written to it.
+ * This is the work of WritePrivateProfileString.
+ *
+ * @param pAppName - section name
+ * @param pKeyName - key name, or NULL to delete the section
+ * @param pString - string to write, or NULL to delete the key
+ * @param pSource - lines of the existing file
+ * @param pSink - receives the lines of the new file
+ *
+ * @return TRUE if the string was written or the key was deleted
+ */
+static BOOL profile_write(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  struct profile_source *pSource,
+  struct profile_sink *pSink)
+{
+  BOOL status = FALSE; /* return value */
+  char line[MAX_LINE_LEN] = {""}; /* line in file */
+  char copy_line[MAX_LINE_LEN] = {""}; /* copy of line in file */
+  char token[MAX_LINE_LEN] = {""}; /* for tokenizing */
+  BOOL found = FALSE; /* true if key is found */
+  BOOL section = FALSE; /* true if section is found */
+  size_t app_len = 0; /* length of section name */
+  size_t key_len = 0; /* length of key name */
+  size_t len = 0; /* length of name in file */
 
-  if (pDest && pSource)
+  app_len = strlen(pAppName);
+  if (pKeyName)
+    key_len = strlen(pKeyName);
+  while (profile_gets(line,sizeof(line),pSource) != NULL)
   {
-    while ((num_read = fread(block,sizeof(DATA),
-      BLOCKSIZE,pSource)) == BLOCKSIZE)
+    /* remove leading and trailing white space */
+    rmtrail(line);
+    rmlead(line);
+    /* comment */
+    if ((line[0] == ';') ||
+        (found))
     {
-      fwrite(block,sizeof(DATA),num_read,pDest);
+      /* write line to new file */
+      profile_printf(pSink,"%s\n",line);
     }
-    /* write remaining stuff */
-    fwrite(block,sizeof(DATA),num_read,pDest);
+    /* inside my section */
+    else if (section)
+    {
+      /* comments */
+      if (line[0] == ';')
+      {
+        /* write line to new file */
+        profile_printf(pSink,"%s\n",line);
+      }
+      /* new section */
+      else if (line[0] == '[')
+      {
+        /* write out data since we didn't find it */
+        if (pKeyName && pString)
+          profile_printf(pSink,"%s=%s\n",pKeyName,pString);
+        found = TRUE;
+        status = TRUE;
+        /* write out this line, too! */
+        profile_printf(pSink,"%s\n",line);
+      }
+      /* delete section by not writing line to temp file */
+      else if (!pKeyName)
+      {
+        /* do nothing */
+      }
+      /* finish processing the file */
+      else if (found)
+      {
+        /* write line to new file */
+        profile_printf(pSink,"%s\n",line);
+      }
+      /* search */
+      else
+      {
+        strncpy(copy_line,line,sizeof(copy_line)-1);
+        (void)stptok(copy_line,token,sizeof(token),"=");
+        len = rmtrail(token);
+        if ((len == key_len) && strfold_equal(token,pKeyName,len))
+        {
+          status = TRUE;
+          found = TRUE;
+          /* overwrite the line that was read in or remove it by
+             not writing it out if pString is NULL */
+          if (pString)
+            profile_printf(pSink,"%s=%s\n",pKeyName,pString);
+        }
+        else
+        {
+          /* write the un-matched key line out to the temp file */
+          profile_printf(pSink,"%s\n",line);
+        }
+      }
+    }
+    /* look for section */
+    else if (line[0] == '[')
+    {
+      strncpy(copy_line,line,sizeof(copy_line)-1);
+      if (rmbrackets(copy_line))
+      {
+        // it's my section!
+        if ((strlen(copy_line) == app_len) &&
+          strfold_equal(copy_line,pAppName,app_len))
+        {
+          section = TRUE;
+          // delete the section name if the KEY is NULL.
+          if (pKeyName)
+            profile_printf(pSink,"%s\n",line);
+        }
+        else
+          profile_printf(pSink,"%s\n",line);
+      }
+    }
+    else
+    {
+      /* write line to new file */
+      profile_printf(pSink,"%s\n",line);
+    }
+  }
+  /* append to the end of the temp file */
+  if (!section && pKeyName)
+  {
+    profile_printf(pSink,"[%s]\n",pAppName);
+  }
+  if (!found && pKeyName && pString)
+  {
+    profile_printf(pSink,"%s=%s\n",pKeyName,pString);
+    status = TRUE;
+  }
+
+  return (status);
+}
+
+/**
+ * Open a new file next to the file it will replace, so that it can
+ * be renamed over it
+ *
+ * @param pFileName - name of the file to replace
+ * @param pTempName - receives the name of the new file
+ * @param nSize - size of pTempName
+ *
+ * @return stream, or NULL if the file cannot be made
+ */
+static FILE *profile_temp_open(
+  const char *pFileName,
+  char *pTempName,
+  size_t nSize)
+{
+  FILE *pFile = NULL; /* stream handle */
+#if defined(__linux__)
+  struct stat file_stat;
+  int fd;
+
+  /* the process and the stack keep names unique between writers */
+  snprintf(pTempName,nSize,"%s.%ld.%lx.tmp",pFileName,(long)getpid(),
+    (unsigned long)(size_t)&pFile);
+  fd = open(pTempName,O_WRONLY | O_CREAT | O_EXCL,0666);
+  if (fd < 0)
+    return (NULL);
+  /* keep the permissions of the file being replaced */
+  if (stat(pFileName,&file_stat) == 0)
+    (void)fchmod(fd,file_stat.st_mode & 07777);
+  pFile = fdopen(fd,"wb");
+  if (!pFile)
+  {
+    close(fd);
+    remove(pTempName);
   }
+#else
+  snprintf(pTempName,nSize,"%s.tmp",pFileName);
+  pFile = fopen(pTempName,"wb");
+#endif
+
+  return (pFile);
+}
+
+/**
+ * Put a new file in the place of an old one
+ *
+ * @param pTempName - name of the new file
+ * @param pFileName - name of the file to replace
+ *
+ * @return TRUE if the file was replaced
+ */
+static BOOL profile_rename(
+  const char *pTempName,
+  const char *pFileName)
+{
+  if (rename(pTempName,pFileName) == 0)
+    return (TRUE);
+#if defined(_WIN32)
+  /* rename does not replace a file here */
+  if ((remove(pFileName) == 0) && (rename(pTempName,pFileName) == 0))
+    return (TRUE);
+#endif
+
+  return (FALSE);
 }
 
 /**
@@ -121,13 +541,13 @@ BOOL WritePrivateProfileString(
     const char *pFileName)
 {
   FILE *pFile; /* stream handle */
-  FILE *pTempFile; /* stream handle */
+  FILE *pTempFile = NULL; /* stream handle */
+  char *pTempName = NULL; /* name of the new file */
+  size_t nTempSize = 0; /* size of pTempName */
+  BOOL replaced = FALSE; /* TRUE if the new file took the old one's place */
   BOOL status = FALSE; /* return value */
-  char line[MAX_LINE_LEN] = {""}; /* line in file */
-  char copy_line[MAX_LINE_LEN] = {""}; /* copy of line in file */
-  char token[MAX_LINE_LEN] = {""}; /* for tokenizing */
-  BOOL found = FALSE; /* true if key is found */
-  BOOL section = FALSE; /* true if section is found */
+  struct profile_source source = {NULL,NULL,0,0}; /* existing file */
+  struct profile_sink sink = {NULL,NULL,0,0}; /* new file contents */
 
   /* flush cache - since we have no cache, just return */
   if (!pAppName && !pKeyName && !pString)
@@ -137,7 +557,7 @@ BOOL WritePrivateProfileString(
   if (!pAppName || !pFileName)
     return (status);
 
-  pFile = fopen(pFileName,"r+");
+  pFile = fopen(pFileName,"r");
   if (!pFile)
   {
     if (pString && pKeyName)
@@ -148,253 +568,158 @@ BOOL WritePrivateProfileString(
       {
         fprintf(pFile,"[%s]\n",pAppName);
         fprintf(pFile,"%s=%s\n",pKeyName,pString);
-        fclose(pFile);
-        status = TRUE;
+        status = profile_sync_stream(pFile,PROFILE_SYNC_DEFAULT);
+        if (fclose(pFile) != 0)
+          status = FALSE;
+        if (status)
+          status = profile_sync_dir(pFileName,PROFILE_SYNC_DEFAULT);
       }
     }
   }
   else
   {
-    /* open a temp file to use as a buffer */
-    pTempFile = tmpfile();
+    /* the new file is written next to the old one and renamed over
+       it, so that a crash leaves one or the other whole */
+    nTempSize = strlen(pFileName) + 64;
+    pTempName = malloc(nTempSize);
+    if (pTempName)
+      pTempFile = profile_temp_open(pFileName,pTempName,nTempSize);
     /* process! */
     if (pTempFile)
     {
-      while (fgets(line,sizeof(line),pFile) != NULL)
-      {
-        /* remove leading and trailing white space */
-        rmtrail(line);
-        rmlead(line);
-        /* comment */
-        if ((line[0] == ';') ||
-            (found))
-        {
-          /* write line to new file */
-          fprintf(pTempFile,"%s\n",line);
-        }
-        /* inside my section */
-        else if (section)
-        {
-          /* comments */
-          if (line[0] == ';')
-          {
-            /* write line to new file */
-            fprintf(pTempFile,"%s\n",line);
-          }
-          /* new section */
-          else if (line[0] == '[')
-          {
-            /* write out data since we didn't find it */
-            if (pKeyName && pString)
-              fprintf(pTempFile,"%s=%s\n",pKeyName,pString);
-            found = TRUE;
-            status = TRUE;
-            /* write out this line, too! */
-            fprintf(pTempFile,"%s\n",line);
-          }
-          /* delete section by not writing line to temp file */
-          else if (!pKeyName)
-          {
-            /* do nothing */
-          }
-          /* finish processing the file */
-          else if (found)
-          {
-            /* write line to new file */
-            fprintf(pTempFile,"%s\n",line);
-          }
-          /* search */
-          else
-          {
-            strncpy(copy_line,line,sizeof(copy_line)-1);
-            (void)stptok(copy_line,token,sizeof(token),"=");
-            rmtrail(token);
-            if (strcmpi(token,pKeyName) == 0)
-            {
-              status = TRUE;
-              found = TRUE;
-              /* overwrite the line that was read in or remove it by
-                 not writing it out if pString is NULL */
-              if (pString)
-                fprintf(pTempFile,"%s=%s\n",pKeyName,pString);
-            }
-            else
-            {
-              /* write the un-matched key line out to the temp file */
-              fprintf(pTempFile,"%s\n",line);
-            }
-          }
-        }
-        /* look for section */
-        else if (line[0] == '[')
-        {
-          strncpy(copy_line,line,sizeof(copy_line)-1);
-          if (rmbrackets(copy_line))
-          {
-            // it's my section!
-            if (strcmpi(pAppName,copy_line) == 0)
-            {
-              section = TRUE;
-              // delete the section name if the KEY is NULL.
-              if (pKeyName)
-                fprintf(pTempFile,"%s\n",line);
-            }
-            else
-              fprintf(pTempFile,"%s\n",line);
-          }
-        }
-        else
-        {
-          /* write line to new file */
-          fprintf(pTempFile,"%s\n",line);
-        }
-      }
-      /* append to the end of the temp file */
-      if (!section && pKeyName)
-      {
-        fprintf(pTempFile,"[%s]\n",pAppName);
-      }
-      if (!found && pKeyName && pString)
-      {
-        fprintf(pTempFile,"%s=%s\n",pKeyName,pString);
-        status = TRUE;
-      }
+      source.pFile = pFile;
+      sink.pFile = pTempFile;
+      status = profile_write(pAppName,pKeyName,pString,&source,&sink);
       /* finished! */
       fclose(pFile);
-      /* copy the temp file data over the existing file */
-      pFile = fopen(pFileName,"wb");
-      if (pFile)
-      {
-        rewind(pTempFile);
-        filecopy(pFile,pTempFile);
-        fclose(pFile);
-      }
-      fclose(pTempFile);
+      /* the file is written even when nothing was found to change */
+      replaced = !ferror(pTempFile);
+      /* the new contents reach the disk before the rename can */
+      if (!profile_sync_stream(pTempFile,PROFILE_SYNC_DEFAULT))
+        replaced = FALSE;
+      if (fclose(pTempFile) != 0)
+        replaced = FALSE;
+      if (replaced)
+        replaced = profile_rename(pTempName,pFileName);
+      if (!replaced)
+        remove(pTempName);
+      else
+        replaced = profile_sync_dir(pFileName,PROFILE_SYNC_DEFAULT);
+      if (!replaced)
+        status = FALSE;
     }
     /* unable to open temp file */
     else
     {
       fclose(pFile);
     }
+    free(pTempName);
   }
   return (status);
 }
 
 /**
- * Processes the INI file.
- * Win32 replacement function
+ * Writes a string into INI text held in memory.  The text is
+ * changed the same way WritePrivateProfileString changes a file,
+ * and the result is written to another buffer.
  *
- * @param pAppName (IN) Points to a null-terminated string
- *  that specifies the section containing the key name.
- *  If this parameter is NULL, the GetPrivateProfileString
- *  function copies all section names in the file to the
- *  supplied buffer.
- * @param pKeyName (IN) Pointer to the null-terminated string
- *  containing the key name whose associated string is
- *  to be retrieved. If this parameter is NULL, all key
- *  names in the section specified by the lpAppName
- *  parameter are copied to the buffer specified by
- *  the pReturnedString parameter.
- * @param pDefault (IN) Pointer to a null-terminated default
- *  string. If the pKeyName key cannot be found in the
- *  initialization file, GetPrivateProfileString copies
- *  the default string to the pReturnedString buffer.
- *  This parameter cannot be NULL. Avoid specifying a
- *  default string with trailing blank characters.
- *  The function inserts a null character in the
- *  pReturnedString buffer to strip any trailing blanks.
- * @param pReturnedString (OUT) Pointer to the buffer that
- *  receives the retrieved string.
- * @param nSize (IN) Specifies the size, in characters, of the
- *  buffer pointed to by the pReturnedString parameter.
- * @param pFileName (IN) Pointer to a null-terminated string
- *  that names the initialization file. If this parameter
- *  does not contain a full path to the file, Windows
- *  searches for the file in the Windows directory.
+ * @param pAppName (IN) section name, as for WritePrivateProfileString
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to write, or NULL to delete the key
+ * @param pBuffer (IN) INI text, which need not be null-terminated
+ * @param nLength (IN) number of characters in pBuffer
+ * @param pOutBuffer (OUT) receives the changed INI text and a null.
+ *  It must not overlap pBuffer.
+ * @param nOutSize (IN) size of pOutBuffer
+ * @param pnOutLength (OUT) receives the number of characters in the
+ *  changed INI text, not including the null, even when it does not
+ *  fit.  May be NULL.
  *
- * @return If the function succeeds, the return value is the
- *   number of characters copied to the buffer, not
- *   including the terminating null character.
- *   If neither pAppName nor pKeyName is NULL and the
- *   supplied destination buffer is too small to hold the
- *   requested string, the string is truncated and followed
- *   by a null character, and the return value is equal
- *   to nSize minus one.
- *   If either pAppName or pKeyName is NULL and the
- *   supplied destination buffer is too small to hold
- *   all the strings, the last string is truncated and
- *   followed by two null characters. In this case,
- *   the return value is equal to nSize minus two.
+ * @return TRUE if the string was written and the changed text fit
+ *  in pOutBuffer, otherwise FALSE.
+ */
+BOOL WritePrivateProfileStringToBuffer(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  const char *pBuffer,
+  size_t nLength,
+  char *pOutBuffer,
+  size_t nOutSize,
+  size_t *pnOutLength)
+{
+  BOOL status = FALSE; /* return value */
+  struct profile_source source = {NULL,NULL,0,0}; /* existing text */
+  struct profile_sink sink = {NULL,NULL,0,0}; /* changed text */
+
+  if (pnOutLength)
+    *pnOutLength = 0;
+  if (!pAppName || (!pBuffer && nLength) || (!pOutBuffer && nOutSize))
+    return (status);
+  source.pBuffer = pBuffer;
+  source.nLength = nLength;
+  sink.pBuffer = pOutBuffer;
+  sink.nSize = nOutSize;
+  if (nOutSize)
+    pOutBuffer[0] = '\0';
+  status = profile_write(pAppName,pKeyName,pString,&source,&sink);
+  if (pnOutLength)
+    *pnOutLength = sink.len;
+  if (sink.len >= nOutSize)
+    status = FALSE;
+
+  return (status);
+}
+
+/**
+ * Processes the lines of an INI file.
+ * This is the work of GetPrivateProfileString.
  *
- * @section DESCRIPTION
+ * @param pAppName - section name, or NULL for all section names
+ * @param pKeyName - key name, or NULL for all key names
+ * @param pDefault - default string
+ * @param pReturnedString - buffer that receives the string
+ * @param nSize - size of the buffer
+ * @param pSource - lines of the file, or NULL if there is no file
+ * @param pFound - set to TRUE if the key was found and has a value,
+ *  or NULL
  *
- * The GetPrivateProfileString function searches the
- * specified initialization file for a key that matches
- * the name specified by the pKeyName parameter under
- * the section heading specified by the pAppName parameter.
- * If it finds the key, the function copies the
- * corresponding string to the buffer. If the key does
- * not exist, the function copies the default character
- * string specified by the pDefault parameter. A section
- * in the initialization file must have the following form:
- * {@code
- *  [section]
- *  key=string
- *  .
- *  .
- *  .
- * }
- * If pAppName is NULL, GetPrivateProfileString copies
- * all section names in the specified file to the supplied
- * buffer.
- * If pKeyName is NULL, the function copies all
- * key names in the specified section to the supplied
- * buffer. An application can use this method to enumerate
- * all of the sections and keys in a file. In either case,
- * each string is followed by a null character and the
- * final string is followed by a second null character.
- * If the supplied destination buffer is too small to hold
- * all the strings, the last string is truncated and
- * followed by two null characters.
- * If the string associated with pKeyName is enclosed
- * in single or double quotation marks, the marks are
- * discarded when the GetPrivateProfileString function
- * retrieves the string.
- * The GetPrivateProfileString function is not case-sensitive;
- * the strings can be a combination of uppercase and
- * lowercase letters.
- ******************************************************************/
-size_t GetPrivateProfileString(
-    const char *pAppName,
-    const char *pKeyName,
-    const char *pDefault,
-    char *pReturnedString,
-    size_t nSize,
-    const char *pFileName)
+ * @return number of characters copied to the buffer
+ */
+static size_t profile_get(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  struct profile_source *pSource,
+  BOOL *pFound)
 {
   size_t count = 0; /* number of characters placed into return string */
   size_t len = 0; /* length of string */
-  FILE *pFile = NULL; /* stream handle */
   BOOL use_default = FALSE; /* TRUE if we need to copy default string */
   char line[MAX_LINE_LEN] = {""}; /* line in file */
   char token[MAX_LINE_LEN] = {""}; /* for tokenizing */
   char *pLine = NULL; /* points to line in file */
   BOOL section = FALSE; /* true if section is found */
   BOOL found_in_section = FALSE; /* true if key is found in section */
+  size_t app_len = 0; /* length of section name */
+  size_t key_len = 0; /* length of key name */
 
-  if (!pReturnedString || !pFileName)
-    return (count);
+  if (pAppName)
+    app_len = strlen(pAppName);
+  if (pKeyName)
+    key_len = strlen(pKeyName);
 
   /* initialize the return string */
   pReturnedString[0] = '\0';
 
-  pFile = fopen(pFileName,"r");
-  if (pFile)
+  if (pSource)
   {
     /* load all section names to ReturnString */
     if (!pAppName)
     {
-      while (fgets(line,sizeof(line),pFile) != NULL)
+      while (profile_gets(line,sizeof(line),pSource) != NULL)
       {
         /* remove leading and trailing white space */
         rmtrail(line);
@@ -428,7 +753,7 @@ size_t GetPrivateProfileString(
     /* find section name */
     else
     {
-      while (fgets(line,sizeof(line),pFile) != NULL)
+      while (profile_gets(line,sizeof(line),pSource) != NULL)
       {
         /* remove leading and trailing white space */
         rmtrail(line);
@@ -446,6 +771,11 @@ size_t GetPrivateProfileString(
           {
             /* do nothing */
           }
+          /* blank line - there is no key name to tokenize */
+          else if (!line[0])
+          {
+            /* do nothing */
+          }
           /* new section */
           else if (line[0] == '[')
           {
@@ -459,32 +789,16 @@ size_t GetPrivateProfileString(
           else if (pKeyName)
           {
             (void)stptok(line,token,sizeof(token),"=");
-            rmtrail(token);
+            len = rmtrail(token);
             /* found? */
-            if (strcmpi(token,pKeyName) == 0)
+            if ((len == key_len) && strfold_equal(token,pKeyName,len))
             {
               pLine = strchr(line,'=');
               if (pLine)
               {
                 found_in_section = TRUE;
                 pLine++;
-                /* cleanup return string */
-                rmtrail(pLine);
-                rmlead(pLine);
-                (void)rmquotes(pLine);
-                /* count what's left */
-                len = strlen(pLine);
-                if (len < nSize)
-                {
-                  strncpy(pReturnedString,pLine, len);
-                }
-                /* copy as much as we can, then truncate */
-                else
-                {
-                  len = nSize - 1; /* less the null */
-                  strncpy(pReturnedString,pLine,len);
-                }
-                count = len;
+                count = profile_copy_value(pReturnedString,nSize,pLine);
               }
               /* stop reading the file */
               break;
@@ -521,7 +835,8 @@ size_t GetPrivateProfileString(
         {
           if (rmbrackets(line))
           {
-            if (strcmpi(pAppName,line) == 0)
+            if ((strlen(line) == app_len) &&
+              strfold_equal(line,pAppName,app_len))
               section = TRUE;
           }
         }
@@ -537,7 +852,6 @@ size_t GetPrivateProfileString(
       /* this pointer should be pointing to the start of next string */
       pReturnedString[0] = '\0';
     }
-    fclose(pFile);
   }
   // if the file does not exist, return the default
   else
@@ -548,16 +862,376 @@ size_t GetPrivateProfileString(
     use_default = TRUE;
 
   if (use_default && pDefault)
+    count = profile_copy_default(pReturnedString,nSize,pDefault);
+  if (pFound)
+    *pFound = (pAppName && pKeyName && !use_default) ? TRUE : FALSE;
+
+  return (count);
+}
+
+/**
+ * Processes the INI file.
+ * Win32 replacement function
+ *
+ * @param pAppName (IN) Points to a null-terminated string
+ *  that specifies the section containing the key name.
+ *  If this parameter is NULL, the GetPrivateProfileString
+ *  function copies all section names in the file to the
+ *  supplied buffer.
+ * @param pKeyName (IN) Pointer to the null-terminated string
+ *  containing the key name whose associated string is
+ *  to be retrieved. If this parameter is NULL, all key
+ *  names in the section specified by the lpAppName
+ *  parameter are copied to the buffer specified by
+ *  the pReturnedString parameter.
+ * @param pDefault (IN) Pointer to a null-terminated default
+ *  string. If the pKeyName key cannot be found in the
+ *  initialization file, GetPrivateProfileString copies
+ *  the default string to the pReturnedString buffer.
+ *  This parameter cannot be NULL. Avoid specifying a
+ *  default string with trailing blank characters.
+ *  The function inserts a null character in the
+ *  pReturnedString buffer to strip any trailing blanks.
+ * @param pReturnedString (OUT) Pointer to the buffer that
+ *  receives the retrieved string.
+ * @param nSize (IN) Specifies the size, in characters, of the
+ *  buffer pointed to by the pReturnedString parameter.
+ * @param pFileName (IN) Pointer to a null-terminated string
+ *  that names the initialization file. If this parameter
+ *  does not contain a full path to the file, Windows
+ *  searches for the file in the Windows directory.
+ *
+ * @return If the function succeeds, the return value is the
+ *   number of characters copied to the buffer, not
+ *   including the terminating null character.
+ *   If neither pAppName nor pKeyName is NULL and the
+ *   supplied destination buffer is too small to hold the
+ *   requested string, the string is truncated and followed
+ *   by a null character, and the return value is equal
+ *   to nSize minus one.
+ *   If either pAppName or pKeyName is NULL and the
+ *   supplied destination buffer is too small to hold
+ *   all the strings, the last string is truncated and
+ *   followed by two null characters. In this case,
+ *   the return value is equal to nSize minus two.
+ *
+ * @section DESCRIPTION
+ *
+ * The GetPrivateProfileString function searches the
+ * specified initialization file for a key that matches
+ * the name specified by the pKeyName parameter under
+ * the section heading specified by the pAppName parameter.
+ * If it finds the key, the function copies the
+ * corresponding string to the buffer. If the key does
+ * not exist, the function copies the default character
+ * string specified by the pDefault parameter. A section
+ * in the initialization file must have the following form:
+ * {@code
+ *  [section]
+ *  key=string
+ *  .
+ *  .
+ *  .
+ * }
+ * If pAppName is NULL, GetPrivateProfileString copies
+ * all section names in the specified file to the supplied
+ * buffer.
+ * If pKeyName is NULL, the function copies all
+ * key names in the specified section to the supplied
+ * buffer. An application can use this method to enumerate
+ * all of the sections and keys in a file. In either case,
+ * each string is followed by a null character and the
+ * final string is followed by a second null character.
+ * If the supplied destination buffer is too small to hold
+ * all the strings, the last string is truncated and
+ * followed by two null characters.
+ * If the string associated with pKeyName is enclosed
+ * in single or double quotation marks, the marks are
+ * discarded when the GetPrivateProfileString function
+ * retrieves the string.
+ * The GetPrivateProfileString function is not case-sensitive;
+ * the strings can be a combination of uppercase and
+ * lowercase letters.
+ ******************************************************************/
+size_t GetPrivateProfileString(
+    const char *pAppName,
+    const char *pKeyName,
+    const char *pDefault,
+    char *pReturnedString,
+    size_t nSize,
+    const char *pFileName)
+{
+  size_t count = 0; /* number of characters placed into return string */
+  FILE *pFile = NULL; /* stream handle */
+  struct profile_source source = {NULL,NULL,0,0}; /* lines of the file */
+
+  if (!pReturnedString || !pFileName)
+    return (count);
+
+  pFile = fopen(pFileName,"r");
+  if (pFile)
   {
-    (void)strncpy(pReturnedString,pDefault,nSize);
-    pReturnedString[nSize-1] = '\0';
-    /* cleanup return string */
-    rmtrail(pReturnedString);
-    rmlead(pReturnedString);
-    (void)rmquotes(pReturnedString);
-    /* count what's left */
-    count = strlen(pReturnedString);
+    source.pFile = pFile;
+    count = profile_get(pAppName,pKeyName,pDefault,pReturnedString,nSize,
+      &source,NULL);
+    fclose(pFile);
   }
+  // if the file does not exist, return the default
+  else
+    count = profile_get(pAppName,pKeyName,pDefault,pReturnedString,nSize,
+      NULL,NULL);
 
   return (count);
 }
+
+/**
+ * Retrieves a string from INI text held in memory, the same way
+ * GetPrivateProfileString retrieves it from a file.  The text is
+ * read in place and is not changed.
+ *
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ * @param pBuffer (IN) INI text, which need not be null-terminated
+ * @param nLength (IN) number of characters in pBuffer
+ *
+ * @return number of characters copied to the buffer, the same
+ *  as GetPrivateProfileString
+ */
+size_t GetPrivateProfileStringFromBuffer(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pBuffer,
+  size_t nLength)
+{
+  struct profile_source source = {NULL,NULL,0,0}; /* lines of the text */
+
+  if (!pReturnedString || (!pBuffer && nLength))
+    return (0);
+  source.pBuffer = pBuffer;
+  source.nLength = nLength;
+
+  return (profile_get(pAppName,pKeyName,pDefault,pReturnedString,nSize,
+    &source,NULL));
+}
+
+/* lookup states for GetPrivateProfileStringBatch */
+#define BATCH_WAITING 0 /* section not seen yet */
+#define BATCH_ACTIVE 1 /* inside the section */
+#define BATCH_DONE 2 /* section ended or key has no value */
+#define BATCH_FOUND 3 /* key found */
+
+/* per request working data for GetPrivateProfileStringBatch */
+struct batch_state
+{
+  unsigned char state;
+  unsigned app_hash; /* strfold_hash of the section name */
+  unsigned key_hash; /* strfold_hash of the key name */
+  size_t app_len; /* length of the section name */
+  size_t key_len; /* length of the key name */
+};
+
+/**
+ * Looks up one request of GetPrivateProfileStringBatch with a scan of
+ * its own, for when there is no memory for the single pass.
+ *
+ * @param pRequest - lookup
+ * @param pFileName - initialization filename
+ *
+ * @return TRUE if the request was found in the file
+ */
+static BOOL batch_lookup(
+  PROFILE_REQUEST *pRequest,
+  const char *pFileName)
+{
+  FILE *pFile = NULL; /* stream handle */
+  struct profile_source source = {NULL,NULL,0,0}; /* lines of the file */
+  BOOL found = FALSE;
+
+  pRequest->count = 0;
+  if (!pRequest->pReturnedString || !pRequest->nSize)
+    return (FALSE);
+  /* not looked up, the same as in the single pass */
+  if (!pRequest->pAppName || !pRequest->pKeyName)
+  {
+    pRequest->pReturnedString[0] = '\0';
+    if (pRequest->pDefault)
+      pRequest->count = profile_copy_default(pRequest->pReturnedString,
+        pRequest->nSize,pRequest->pDefault);
+    return (FALSE);
+  }
+  pFile = pFileName ? fopen(pFileName,"r") : NULL;
+  source.pFile = pFile;
+  pRequest->count = profile_get(pRequest->pAppName,pRequest->pKeyName,
+    pRequest->pDefault,pRequest->pReturnedString,pRequest->nSize,
+    pFile ? &source : NULL,&found);
+  if (pFile)
+    fclose(pFile);
+
+  return (found);
+}
+
+/**
+ * Retrieves many strings from an INI file in a single pass.
+ * Each request gets the same result that GetPrivateProfileString
+ * would give for its pAppName, pKeyName, pDefault, pReturnedString
+ * and nSize, with the number of characters copied to the buffer
+ * stored in its count member.  Requests with a NULL pAppName or
+ * pKeyName are not looked up and get the default string.
+ *
+ * The file is read once from the top and reading stops as soon
+ * as every request has been found or its section has ended.
+ *
+ * @param pRequest (IN/OUT) array of lookups
+ * @param nCount (IN) number of lookups in the array
+ * @param pFileName (IN) Pointer to a null-terminated string
+ *  that names the initialization file.
+ *
+ * @return number of requests that were found in the file
+ */
+size_t GetPrivateProfileStringBatch(
+  PROFILE_REQUEST *pRequest,
+  size_t nCount,
+  const char *pFileName)
+{
+  size_t found = 0; /* number of requests found in the file */
+  size_t pending = 0; /* number of requests not DONE */
+  size_t active = 0; /* number of requests that are ACTIVE */
+  size_t i = 0;
+  FILE *pFile = NULL; /* stream handle */
+  struct batch_state *pState = NULL; /* state of each request */
+  unsigned hash = 0; /* hash of name in file */
+  size_t len = 0; /* length of name in file */
+  char line[MAX_LINE_LEN] = {""}; /* line in file */
+  char value[MAX_LINE_LEN] = {""}; /* copy of line in file */
+  char token[MAX_LINE_LEN] = {""}; /* for tokenizing */
+  char *pLine = NULL; /* points to line in file */
+
+  if (!pRequest || !nCount)
+    return (found);
+  pState = calloc(nCount,sizeof(struct batch_state));
+  if (!pState)
+  {
+    /* no memory - one scan per request */
+    for (i = 0; i < nCount; i++)
+    {
+      if (batch_lookup(&pRequest[i],pFileName))
+        found++;
+    }
+    return (found);
+  }
+  for (i = 0; i < nCount; i++)
+  {
+    pRequest[i].count = 0;
+    if (pRequest[i].pReturnedString && pRequest[i].nSize)
+      pRequest[i].pReturnedString[0] = '\0';
+    if (pRequest[i].pAppName && pRequest[i].pKeyName &&
+      pRequest[i].pReturnedString && pRequest[i].nSize)
+    {
+      /* hash once so most names in the file are rejected by hash */
+      pState[i].app_len = strlen(pRequest[i].pAppName);
+      pState[i].app_hash = strfold_hash(pRequest[i].pAppName,
+        pState[i].app_len);
+      pState[i].key_len = strlen(pRequest[i].pKeyName);
+      pState[i].key_hash = strfold_hash(pRequest[i].pKeyName,
+        pState[i].key_len);
+      pending++;
+    }
+    else
+      pState[i].state = BATCH_DONE;
+  }
+
+  pFile = pFileName ? fopen(pFileName,"r") : NULL;
+  if (pFile)
+  {
+    while (pending && (fgets(line,sizeof(line),pFile) != NULL))
+    {
+      /* remove leading and trailing white space */
+      rmtrail(line);
+      rmlead(line);
+      /* comment */
+      if (line[0] == ';')
+      {
+        /* do nothing */
+      }
+      /* new section ends the active requests */
+      else if (line[0] == '[')
+      {
+        for (i = 0; active && (i < nCount); i++)
+        {
+          if (pState[i].state == BATCH_ACTIVE)
+          {
+            pState[i].state = BATCH_DONE;
+            pending--;
+            active--;
+          }
+        }
+        if (rmbrackets(line))
+        {
+          len = strlen(line);
+          hash = strfold_hash(line,len);
+          for (i = 0; i < nCount; i++)
+          {
+            if ((pState[i].state == BATCH_WAITING) &&
+              (pState[i].app_hash == hash) &&
+              (pState[i].app_len == len) &&
+              strfold_equal(pRequest[i].pAppName,line,len))
+            {
+              pState[i].state = BATCH_ACTIVE;
+              active++;
+            }
+          }
+        }
+      }
+      /* search, skipping blank lines */
+      else if (active && line[0])
+      {
+        (void)stptok(line,token,sizeof(token),"=");
+        len = rmtrail(token);
+        hash = strfold_hash(token,len);
+        for (i = 0; i < nCount; i++)
+        {
+          if ((pState[i].state == BATCH_ACTIVE) &&
+            (pState[i].key_hash == hash) &&
+            (pState[i].key_len == len) &&
+            strfold_equal(pRequest[i].pKeyName,token,len))
+          {
+            pState[i].state = BATCH_DONE;
+            pending--;
+            active--;
+            pLine = strchr(line,'=');
+            if (pLine)
+            {
+              /* the copy gets cleaned up, so each request gets a copy */
+              strcpy(value,pLine + 1);
+              pRequest[i].count = profile_copy_value(
+                pRequest[i].pReturnedString,pRequest[i].nSize,value);
+              pState[i].state = BATCH_FOUND;
+              found++;
+            }
+          }
+        }
+      }
+    }
+    fclose(pFile);
+  }
+
+  /* key or section not found - return default */
+  for (i = 0; i < nCount; i++)
+  {
+    if ((pState[i].state != BATCH_FOUND) && pRequest[i].pDefault &&
+      pRequest[i].pReturnedString && pRequest[i].nSize)
+    {
+      pRequest[i].count = profile_copy_default(pRequest[i].pReturnedString,
+        pRequest[i].nSize,pRequest[i].pDefault);
+    }
+  }
+  free(pState);
+
+  return (found);
+}
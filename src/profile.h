@@ -22,6 +22,22 @@
   #define MAX_LINE_LEN 255
   #endif
 
+  /* size of the buffer used when the kernel cannot copy a file */
+  #ifndef PROFILE_COPY_BLOCKSIZE
+  #define PROFILE_COPY_BLOCKSIZE 65536
+  #endif
+
+  /* one lookup for GetPrivateProfileStringBatch */
+  typedef struct profile_request
+  {
+    const char *pAppName;	// points to section name
+    const char *pKeyName;	// points to key name
+    const char *pDefault;	// points to default string
+    char *pReturnedString;	// points to destination buffer
+    size_t nSize;	// size of destination buffer
+    size_t count;	// number of characters copied to the buffer
+  } PROFILE_REQUEST;
+
   #ifdef __cplusplus
   extern "C" {
   #endif /* __cplusplus */
@@ -40,6 +56,34 @@
     size_t nSize,	// size of destination buffer
     const char *pFileName); 	// points to initialization filename
 
+  size_t GetPrivateProfileStringFromBuffer(
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize,	// size of destination buffer
+    const char *pBuffer,	// points to INI text
+    size_t nLength); 	// number of characters of INI text
+
+  BOOL WritePrivateProfileStringToBuffer(
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString,	// pointer to string to add
+    const char *pBuffer,	// points to INI text
+    size_t nLength,	// number of characters of INI text
+    char *pOutBuffer,	// points to buffer for the changed INI text
+    size_t nOutSize,	// size of the buffer for the changed INI text
+    size_t *pnOutLength); 	// receives the length of the changed INI text
+
+  size_t GetPrivateProfileStringBatch(
+    PROFILE_REQUEST *pRequest,	// points to array of lookups
+    size_t nCount,	// number of lookups
+    const char *pFileName); 	// points to initialization filename
+
+  BOOL profile_filecopy(
+    FILE *pDest,	// destination file handle
+    FILE *pSource); 	// source file handle
+
   #ifdef __cplusplus
   }
   #endif /* __cplusplus */
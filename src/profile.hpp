@@ -0,0 +1,466 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief C++17 wrapper for parsed INI documents, header only
+ *
+ * A document owns a PROFILE_DOC and frees it when it goes out of
+ * scope; it can be moved but not copied.  A cache_handle pins the
+ * cached document of a file (profile_cache.h) the same way.  Both are
+ * views, and a view does the lookups: names are passed as
+ * std::string_view and need not end with a null, and values come back
+ * as std::string_view pointing into the document, so a lookup copies
+ * nothing and allocates nothing.  A value stays valid until the
+ * document is changed or released.
+ *
+ * get<T>() converts a value with std::from_chars, and returns the
+ * default when the key is missing or the whole value does not convert.
+ * {@code
+ * auto doc = profile::document::load("device.ini");
+ * auto port = doc.get<unsigned>("Network", "Port", 47808);
+ * for (auto section : doc)
+ *   for (auto entry : section)
+ *     std::cout << entry.key() << '=' << entry.value() << '\n';
+ * }
+ */
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_doc.h"
+#include "strfold.h"
+
+namespace profile
+{
+  /**
+   * Convert the text of a value, with nothing left over
+   *
+   * @param text - value
+   * @param result - receives the value when it converts
+   *
+   * @return true if the whole text converted
+   */
+  template <class T>
+  bool convert(std::string_view text, T &result) noexcept
+  {
+    static_assert(std::is_arithmetic_v<T>,
+      "get<T> converts to string_view, bool, and arithmetic types");
+    const char *first = text.data();
+    const char *last = text.data() + text.size();
+    std::from_chars_result status;
+
+    if constexpr (std::is_same_v<T, bool>)
+    {
+      static constexpr const char *yes[] = {"1", "true", "yes", "on"};
+      static constexpr const char *no[] = {"0", "false", "no", "off"};
+
+      for (std::size_t i = 0; i < std::size(yes); i++)
+      {
+        if (strfold_cmp(first, text.size(), yes[i],
+          std::char_traits<char>::length(yes[i])) == 0)
+        {
+          result = true;
+          return true;
+        }
+        if (strfold_cmp(first, text.size(), no[i],
+          std::char_traits<char>::length(no[i])) == 0)
+        {
+          result = false;
+          return true;
+        }
+      }
+      return false;
+    }
+    else
+    {
+      if ((first != last) && (*first == '+'))
+        first++;
+      if constexpr (std::is_integral_v<T>)
+      {
+        if (((last - first) > 2) && (first[0] == '0') &&
+          ((first[1] == 'x') || (first[1] == 'X')))
+          status = std::from_chars(first + 2, last, result, 16);
+        else
+          status = std::from_chars(first, last, result);
+      }
+      else
+        status = std::from_chars(first, last, result);
+      return (status.ec == std::errc()) && (status.ptr == last) &&
+        (first != last);
+    }
+  }
+
+  /* a key and its value */
+  class entry
+  {
+  public:
+    explicit entry(const PROFILE_ENTRY *pEntry) noexcept :
+      entry_(pEntry)
+    {
+    }
+
+    std::string_view key() const noexcept
+    {
+      return profile_entry_key(entry_);
+    }
+
+    /* the value, empty for a line without '=' */
+    std::string_view value() const noexcept
+    {
+      const char *pValue = profile_entry_value(entry_);
+
+      return pValue ? std::string_view(pValue) : std::string_view();
+    }
+
+    bool has_value() const noexcept
+    {
+      return profile_entry_value(entry_) != nullptr;
+    }
+
+    template <class T = std::string_view>
+    T get(T def = T()) const noexcept
+    {
+      if constexpr (std::is_same_v<T, std::string_view>)
+        return has_value() ? value() : def;
+      else
+      {
+        T result = def;
+
+        return convert(value(), result) ? result : def;
+      }
+    }
+
+    const PROFILE_ENTRY *native() const noexcept
+    {
+      return entry_;
+    }
+
+  private:
+    const PROFILE_ENTRY *entry_;
+  };
+
+  /**
+   * Iterator over a list of the document, in file order
+   */
+  template <class Item, class Node, Node *(*Next)(const Node *)>
+  class list_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Item;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Item;
+
+    explicit list_iterator(const Node *pNode = nullptr) noexcept :
+      node_(pNode)
+    {
+    }
+
+    Item operator*() const noexcept
+    {
+      return Item(node_);
+    }
+
+    list_iterator &operator++() noexcept
+    {
+      node_ = Next(node_);
+      return *this;
+    }
+
+    list_iterator operator++(int) noexcept
+    {
+      list_iterator previous = *this;
+
+      node_ = Next(node_);
+      return previous;
+    }
+
+    bool operator==(const list_iterator &other) const noexcept
+    {
+      return node_ == other.node_;
+    }
+
+    bool operator!=(const list_iterator &other) const noexcept
+    {
+      return node_ != other.node_;
+    }
+
+  private:
+    const Node *node_;
+  };
+
+  /* a section, and a range of its entries */
+  class section
+  {
+  public:
+    using iterator =
+      list_iterator<entry, PROFILE_ENTRY, profile_entry_next>;
+
+    explicit section(const PROFILE_SECTION *pSection) noexcept :
+      section_(pSection)
+    {
+    }
+
+    std::string_view name() const noexcept
+    {
+      return profile_section_name(section_);
+    }
+
+    std::size_t size() const noexcept
+    {
+      return profile_section_entry_count(section_);
+    }
+
+    iterator begin() const noexcept
+    {
+      return iterator(profile_section_first(section_));
+    }
+
+    iterator end() const noexcept
+    {
+      return iterator();
+    }
+
+    const PROFILE_SECTION *native() const noexcept
+    {
+      return section_;
+    }
+
+  private:
+    const PROFILE_SECTION *section_;
+  };
+
+  /* lookups in a document that belongs to someone else */
+  class view
+  {
+  public:
+    using iterator =
+      list_iterator<section, PROFILE_SECTION, profile_section_next>;
+
+    explicit view(const PROFILE_DOC *pDoc = nullptr) noexcept : doc_(pDoc)
+    {
+    }
+
+    explicit operator bool() const noexcept
+    {
+      return doc_ != nullptr;
+    }
+
+    std::optional<section> find_section(std::string_view app) const
+      noexcept
+    {
+      const PROFILE_SECTION *pSection =
+        profile_doc_section_n(doc_, app.data(), app.size());
+
+      if (!pSection)
+        return std::nullopt;
+      return section(pSection);
+    }
+
+    std::optional<entry> find(std::string_view app, std::string_view key)
+      const noexcept
+    {
+      const PROFILE_ENTRY *pEntry = profile_doc_entry_n(doc_, app.data(),
+        app.size(), key.data(), key.size());
+
+      if (!pEntry)
+        return std::nullopt;
+      return entry(pEntry);
+    }
+
+    bool contains(std::string_view app, std::string_view key) const
+      noexcept
+    {
+      return find(app, key).has_value();
+    }
+
+    /**
+     * Value of a key, converted to T: std::string_view, which points
+     * into the document, bool, or an arithmetic type
+     *
+     * @param app - section name
+     * @param key - key name
+     * @param def - returned if the key is missing, has no value, or
+     *  does not convert
+     *
+     * @return value
+     */
+    template <class T = std::string_view>
+    T get(std::string_view app, std::string_view key, T def = T()) const
+      noexcept
+    {
+      std::optional<entry> found = find(app, key);
+
+      return found ? found->get<T>(def) : def;
+    }
+
+    /* a default given as a string literal gives a std::string_view */
+    std::string_view get(std::string_view app, std::string_view key,
+      const char *def) const noexcept
+    {
+      return get<std::string_view>(app, key, def ? def : "");
+    }
+
+    std::size_t size() const noexcept
+    {
+      return profile_doc_section_count(doc_);
+    }
+
+    iterator begin() const noexcept
+    {
+      return iterator(profile_doc_first(doc_));
+    }
+
+    iterator end() const noexcept
+    {
+      return iterator();
+    }
+
+    /* the text of the document, as it would be written */
+    std::string str() const
+    {
+      std::string text(profile_doc_serialize(doc_, nullptr, 0), '\0');
+
+      profile_doc_serialize(doc_, text.data(), text.size() + 1);
+      return text;
+    }
+
+    const PROFILE_DOC *native() const noexcept
+    {
+      return doc_;
+    }
+
+  protected:
+    const PROFILE_DOC *doc_;
+  };
+
+  /* a document that is freed when it goes out of scope */
+  class document : public view
+  {
+  public:
+    /* an empty document, or none if out of memory */
+    document() noexcept : view(profile_doc_create())
+    {
+    }
+
+    /* take over a document from the C API */
+    explicit document(PROFILE_DOC *pDoc) noexcept : view(pDoc)
+    {
+    }
+
+    document(const document &) = delete;
+    document &operator=(const document &) = delete;
+
+    document(document &&other) noexcept : view(other.release())
+    {
+    }
+
+    document &operator=(document &&other) noexcept
+    {
+      if (this != &other)
+      {
+        profile_doc_free(native());
+        doc_ = other.release();
+      }
+      return *this;
+    }
+
+    ~document()
+    {
+      profile_doc_free(native());
+    }
+
+    /* parse a file; false when tested if it cannot be read */
+    static document load(const char *pFileName) noexcept
+    {
+      return document(profile_doc_load(pFileName));
+    }
+
+    static document parse(std::string_view text) noexcept
+    {
+      return document(profile_doc_load_buffer(text.data(), text.size()));
+    }
+
+    /**
+     * Change the document the way WritePrivateProfileString changes
+     * a file.  Values already looked up stay valid.
+     *
+     * @param app - section name
+     * @param key - key name, or nullptr to delete the section
+     * @param value - string, or nullptr to delete the key
+     *
+     * @return true if written or deleted
+     */
+    bool set(const char *app, const char *key, const char *value) noexcept
+    {
+      return profile_doc_set(native(), app, key, value);
+    }
+
+    PROFILE_DOC *native() const noexcept
+    {
+      return const_cast<PROFILE_DOC *>(doc_);
+    }
+
+    /* give the document back to the C API */
+    PROFILE_DOC *release() noexcept
+    {
+      PROFILE_DOC *pDoc = native();
+
+      doc_ = nullptr;
+      return pDoc;
+    }
+  };
+
+  /* the cached document of a file, pinned while the handle lives */
+  class cache_handle : public view
+  {
+  public:
+    /* read the file into the cache if needed; false if it cannot be */
+    explicit cache_handle(const char *pFileName) noexcept :
+      view(nullptr), handle_(profile_cache_open(pFileName))
+    {
+      doc_ = profile_cache_doc(handle_);
+    }
+
+    cache_handle(const cache_handle &) = delete;
+    cache_handle &operator=(const cache_handle &) = delete;
+
+    cache_handle(cache_handle &&other) noexcept :
+      view(other.doc_), handle_(std::exchange(other.handle_, nullptr))
+    {
+      other.doc_ = nullptr;
+    }
+
+    cache_handle &operator=(cache_handle &&other) noexcept
+    {
+      if (this != &other)
+      {
+        profile_cache_close(handle_);
+        handle_ = std::exchange(other.handle_, nullptr);
+        doc_ = std::exchange(other.doc_, nullptr);
+      }
+      return *this;
+    }
+
+    ~cache_handle()
+    {
+      profile_cache_close(handle_);
+    }
+
+  private:
+    PROFILE_CACHE_HANDLE *handle_;
+  };
+} // namespace profile
+
+#endif /* PROFILE_HPP */
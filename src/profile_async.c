@@ -0,0 +1,785 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Asynchronous reads and write-behind for the profile functions
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Writes are copied into a queue and committed by a single background
+ * writer thread using WritePrivateProfileString.  A later write to the
+ * same file, section and key that is still waiting in the queue replaces
+ * the earlier one, so a burst of updates to one key costs one rewrite.
+ *
+ * Each queued write returns a ticket.  Tickets are handed out in queue
+ * order and the writer completes the queue in order, so waiting for a
+ * ticket is simply waiting for the completed ticket count to reach it.
+ * {@code
+ * profile_async_init();
+ * ticket = WritePrivateProfileStringAsync("app","key","value","my.ini",
+ *   NULL, NULL);
+ * profile_async_wait(ticket);
+ * profile_async_cleanup();
+ * }
+ *
+ * Reads are queued to a pool of reader threads that run
+ * GetPrivateProfileString into the caller's buffer and then call the
+ * caller's function, so many lookups can be in flight at once and a
+ * thread running an event loop never waits on the file.  A read first
+ * waits for the writes queued before it, so it sees them, and no read
+ * runs while the writer is rewriting a file.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "profile_async.h"
+#include "strfold.h"
+
+/* number of hash buckets used to find writes that can be coalesced */
+#define ASYNC_HASH_BUCKETS 256
+
+/* number of reader threads */
+#ifndef PROFILE_ASYNC_READERS
+#define PROFILE_ASYNC_READERS 4
+#endif
+
+/* callback to run when a queued write completes */
+struct async_waiter
+{
+  PROFILE_ASYNC_CALLBACK pCallback;
+  void *pContext;
+  struct async_waiter *pNext;
+};
+
+/* one queued write */
+struct async_entry
+{
+  struct async_entry *pNext; /* queue order */
+  struct async_entry *pHashNext; /* same file and section bucket */
+  unsigned long ticket; /* position in the queue */
+  unsigned hash; /* hash of file and section names */
+  BOOL hashed; /* TRUE while later writes may coalesce into us */
+  char *pAppName;
+  char *pKeyName;
+  char *pString;
+  char *pFileName;
+  struct async_waiter *pWaiters;
+};
+
+/* protects the writer state */
+static pthread_mutex_t Writer_Lock = PTHREAD_MUTEX_INITIALIZER;
+/* signaled when the queue gets an entry */
+static pthread_cond_t Writer_Work = PTHREAD_COND_INITIALIZER;
+/* signaled when an entry is completed */
+static pthread_cond_t Writer_Done = PTHREAD_COND_INITIALIZER;
+
+/* the writer thread and its queue */
+static struct
+{
+  pthread_t thread;
+  BOOL running;
+  BOOL stopping;
+  struct async_entry *pHead;
+  struct async_entry *pTail;
+  struct async_entry *pBucket[ASYNC_HASH_BUCKETS];
+  unsigned long last_ticket; /* last ticket handed out */
+  unsigned long done_ticket; /* last ticket completed */
+  size_t pending; /* number of entries in the queue or in flight */
+} Writer;
+
+/* one queued read */
+struct async_read
+{
+  struct async_read *pNext; /* queue order */
+  unsigned long ticket; /* last write queued before the read */
+  char *pAppName;
+  char *pKeyName;
+  char *pDefault;
+  char *pFileName;
+  char *pReturnedString; /* the caller's buffer */
+  size_t nSize;
+  PROFILE_ASYNC_READ_CALLBACK pCallback;
+  void *pContext;
+};
+
+/* protects the reader state */
+static pthread_mutex_t Reader_Lock = PTHREAD_MUTEX_INITIALIZER;
+/* signaled when the queue gets a read */
+static pthread_cond_t Reader_Work = PTHREAD_COND_INITIALIZER;
+/* signaled when a read is completed */
+static pthread_cond_t Reader_Done = PTHREAD_COND_INITIALIZER;
+
+/* a write rewrites the file in place, so reads wait for it */
+static pthread_rwlock_t File_Lock = PTHREAD_RWLOCK_INITIALIZER;
+
+/* the reader threads and their queue */
+static struct
+{
+  pthread_t thread[PROFILE_ASYNC_READERS];
+  unsigned running; /* number of threads started */
+  BOOL stopping;
+  struct async_read *pHead;
+  struct async_read *pTail;
+  size_t pending; /* number of reads in the queue or in flight */
+} Reader;
+
+/**
+ * Duplicate a C string into the heap
+ *
+ * @param str - C string, may be NULL
+ * @param pOk - set to FALSE if memory could not be allocated
+ *
+ * @return copy of the string, or NULL if str is NULL or on error
+ */
+static char *async_strdup(
+  const char *str,
+  BOOL *pOk)
+{
+  char *pCopy = NULL;
+  size_t len = 0;
+
+  if (str)
+  {
+    len = strlen(str) + 1;
+    pCopy = malloc(len);
+    if (pCopy)
+      memcpy(pCopy,str,len);
+    else
+      *pOk = FALSE;
+  }
+
+  return (pCopy);
+}
+
+/**
+ * Compare two optional C strings
+ *
+ * @param a - C string, may be NULL
+ * @param b - C string, may be NULL
+ * @param nocase - TRUE to ignore case
+ *
+ * @return TRUE if both are NULL or both are equal
+ */
+static BOOL async_same(
+  const char *a,
+  const char *b,
+  BOOL nocase)
+{
+  size_t len;
+
+  if (!a || !b)
+    return (a == b);
+  if (!nocase)
+    return (strcmp(a,b) == 0);
+  len = strlen(a);
+
+  return ((strlen(b) == len) && strfold_equal(a,b,len));
+}
+
+/**
+ * Hash the filename and the case-independent section name
+ *
+ * @param pAppName - section name
+ * @param pFileName - initialization filename
+ *
+ * @return hash value
+ */
+static unsigned async_hash(
+  const char *pAppName,
+  const char *pFileName)
+{
+  unsigned hash = STRFOLD_HASH_INIT; /* FNV-1a */
+
+  while (*pFileName)
+  {
+    hash ^= (unsigned char)*pFileName++;
+    hash *= 16777619U;
+  }
+
+  return (strfold_hash_more(hash,pAppName,strlen(pAppName)));
+}
+
+/**
+ * Remove an entry from its hash bucket so nothing coalesces into it.
+ * Called with the lock held.
+ *
+ * @param pEntry - queued entry
+ */
+static void async_unhash(
+  struct async_entry *pEntry)
+{
+  struct async_entry **ppLink;
+
+  if (!pEntry->hashed)
+    return;
+  ppLink = &Writer.pBucket[pEntry->hash % ASYNC_HASH_BUCKETS];
+  while (*ppLink)
+  {
+    if (*ppLink == pEntry)
+    {
+      *ppLink = pEntry->pHashNext;
+      break;
+    }
+    ppLink = &(*ppLink)->pHashNext;
+  }
+  pEntry->pHashNext = NULL;
+  pEntry->hashed = FALSE;
+}
+
+/**
+ * Release an entry and its waiters
+ *
+ * @param pEntry - entry that is no longer queued
+ */
+static void async_entry_free(
+  struct async_entry *pEntry)
+{
+  struct async_waiter *pWaiter;
+
+  while (pEntry->pWaiters)
+  {
+    pWaiter = pEntry->pWaiters;
+    pEntry->pWaiters = pWaiter->pNext;
+    free(pWaiter);
+  }
+  free(pEntry->pAppName);
+  free(pEntry->pKeyName);
+  free(pEntry->pString);
+  free(pEntry->pFileName);
+  free(pEntry);
+}
+
+/**
+ * Background writer: commits the queue in order.
+ *
+ * @param pArg - unused
+ *
+ * @return NULL
+ */
+static void *async_writer(
+  void *pArg)
+{
+  struct async_entry *pEntry;
+  struct async_waiter *pWaiter;
+  BOOL status;
+
+  (void)pArg;
+  pthread_mutex_lock(&Writer_Lock);
+  for (;;)
+  {
+    while (!Writer.pHead && !Writer.stopping)
+      pthread_cond_wait(&Writer_Work,&Writer_Lock);
+    if (!Writer.pHead)
+      break;
+    pEntry = Writer.pHead;
+    Writer.pHead = pEntry->pNext;
+    if (!Writer.pHead)
+      Writer.pTail = NULL;
+    /* writes from now on must queue behind this one */
+    async_unhash(pEntry);
+    pthread_mutex_unlock(&Writer_Lock);
+
+    pthread_rwlock_wrlock(&File_Lock);
+    status = WritePrivateProfileString(pEntry->pAppName,
+      pEntry->pKeyName,pEntry->pString,pEntry->pFileName);
+    pthread_rwlock_unlock(&File_Lock);
+    for (pWaiter = pEntry->pWaiters; pWaiter; pWaiter = pWaiter->pNext)
+      pWaiter->pCallback(status,pWaiter->pContext);
+
+    pthread_mutex_lock(&Writer_Lock);
+    Writer.done_ticket = pEntry->ticket;
+    Writer.pending--;
+    pthread_cond_broadcast(&Writer_Done);
+    async_entry_free(pEntry);
+  }
+  pthread_mutex_unlock(&Writer_Lock);
+
+  return (NULL);
+}
+
+/**
+ * Release a read
+ *
+ * @param pRead - read that is no longer queued
+ */
+static void async_read_free(
+  struct async_read *pRead)
+{
+  free(pRead->pAppName);
+  free(pRead->pKeyName);
+  free(pRead->pDefault);
+  free(pRead->pFileName);
+  free(pRead);
+}
+
+/**
+ * Reader thread: takes reads from the queue until it is stopped
+ * and the queue is empty.
+ *
+ * @param pArg - unused
+ *
+ * @return NULL
+ */
+static void *async_reader(
+  void *pArg)
+{
+  struct async_read *pRead;
+  size_t count;
+
+  (void)pArg;
+  pthread_mutex_lock(&Reader_Lock);
+  for (;;)
+  {
+    while (!Reader.pHead && !Reader.stopping)
+      pthread_cond_wait(&Reader_Work,&Reader_Lock);
+    if (!Reader.pHead)
+      break;
+    pRead = Reader.pHead;
+    Reader.pHead = pRead->pNext;
+    if (!Reader.pHead)
+      Reader.pTail = NULL;
+    pthread_mutex_unlock(&Reader_Lock);
+
+    /* read what was written before the read was queued */
+    profile_async_wait(pRead->ticket);
+    pthread_rwlock_rdlock(&File_Lock);
+    count = GetPrivateProfileString(pRead->pAppName,pRead->pKeyName,
+      pRead->pDefault,pRead->pReturnedString,pRead->nSize,
+      pRead->pFileName);
+    pthread_rwlock_unlock(&File_Lock);
+    pRead->pCallback(count,pRead->pContext);
+    async_read_free(pRead);
+
+    pthread_mutex_lock(&Reader_Lock);
+    Reader.pending--;
+    if (!Reader.pending)
+      pthread_cond_broadcast(&Reader_Done);
+  }
+  pthread_mutex_unlock(&Reader_Lock);
+
+  return (NULL);
+}
+
+/**
+ * Start the background writer thread and the reader threads
+ *
+ * @return TRUE if the writer and at least one reader are running
+ */
+BOOL profile_async_init(void)
+{
+  BOOL status = TRUE;
+
+  pthread_mutex_lock(&Writer_Lock);
+  if (!Writer.running)
+  {
+    Writer.stopping = FALSE;
+    if (pthread_create(&Writer.thread,NULL,async_writer,NULL) == 0)
+      Writer.running = TRUE;
+    else
+      status = FALSE;
+  }
+  pthread_mutex_unlock(&Writer_Lock);
+
+  pthread_mutex_lock(&Reader_Lock);
+  if (!Reader.running)
+  {
+    Reader.stopping = FALSE;
+    while ((Reader.running < PROFILE_ASYNC_READERS) &&
+      (pthread_create(&Reader.thread[Reader.running],NULL,async_reader,
+      NULL) == 0))
+    {
+      Reader.running++;
+    }
+    if (!Reader.running)
+      status = FALSE;
+  }
+  pthread_mutex_unlock(&Reader_Lock);
+
+  return (status);
+}
+
+/**
+ * Complete everything still queued and stop the background threads
+ */
+void profile_async_cleanup(void)
+{
+  unsigned i;
+
+  /* reads first, since they may be waiting on queued writes */
+  pthread_mutex_lock(&Reader_Lock);
+  if (Reader.running)
+  {
+    Reader.stopping = TRUE;
+    pthread_cond_broadcast(&Reader_Work);
+    pthread_mutex_unlock(&Reader_Lock);
+    for (i = 0; i < Reader.running; i++)
+      pthread_join(Reader.thread[i],NULL);
+    pthread_mutex_lock(&Reader_Lock);
+    Reader.running = 0;
+  }
+  pthread_mutex_unlock(&Reader_Lock);
+
+  pthread_mutex_lock(&Writer_Lock);
+  if (!Writer.running)
+  {
+    pthread_mutex_unlock(&Writer_Lock);
+    return;
+  }
+  Writer.stopping = TRUE;
+  pthread_cond_signal(&Writer_Work);
+  pthread_mutex_unlock(&Writer_Lock);
+
+  pthread_join(Writer.thread,NULL);
+
+  pthread_mutex_lock(&Writer_Lock);
+  Writer.running = FALSE;
+  pthread_cond_broadcast(&Writer_Done);
+  pthread_mutex_unlock(&Writer_Lock);
+}
+
+/**
+ * Queues a string to be written to an INI file by the background
+ * writer.  The parameters have the same meaning as for
+ * WritePrivateProfileString, and the strings are copied so the
+ * caller may reuse them as soon as this function returns.
+ * If the same file, section and key is already waiting in the queue,
+ * the queued string is replaced and the earlier ticket is returned.
+ * If all three parameters are NULL, the function waits for the
+ * queue to be written, like the cache flush of the Win32 function.
+ * If the writer is not running the string is written immediately.
+ *
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to add, or NULL to delete the key
+ * @param pFileName (IN) initialization filename
+ * @param pCallback (IN) optional function called from the writer
+ *  thread with the result of the write, or with FALSE before this
+ *  function returns if the write could not be queued for lack of memory
+ * @param pContext (IN) passed to pCallback
+ *
+ * @return ticket to pass to profile_async_wait, or zero if there
+ *  is nothing to wait for.
+ */
+unsigned long WritePrivateProfileStringAsync(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  const char *pFileName,
+  PROFILE_ASYNC_CALLBACK pCallback,
+  void *pContext)
+{
+  struct async_entry *pEntry = NULL;
+  struct async_entry *pNext = NULL;
+  struct async_waiter *pWaiter = NULL;
+  char *pCopy = NULL;
+  unsigned long ticket = 0;
+  unsigned hash = 0;
+  BOOL ok = TRUE;
+  BOOL status = FALSE;
+
+  /* flush cache */
+  if (!pAppName && !pKeyName && !pString)
+  {
+    profile_async_flush();
+    return (ticket);
+  }
+  /* undefined behavior */
+  if (!pAppName || !pFileName)
+    return (ticket);
+
+  if (pCallback)
+  {
+    pWaiter = malloc(sizeof(struct async_waiter));
+    if (pWaiter)
+    {
+      pWaiter->pCallback = pCallback;
+      pWaiter->pContext = pContext;
+      pWaiter->pNext = NULL;
+    }
+    else
+      ok = FALSE;
+  }
+  hash = async_hash(pAppName,pFileName);
+
+  pthread_mutex_lock(&Writer_Lock);
+  if (ok && Writer.running && !Writer.stopping)
+  {
+    pEntry = Writer.pBucket[hash % ASYNC_HASH_BUCKETS];
+    while (pEntry)
+    {
+      pNext = pEntry->pHashNext;
+      if ((pEntry->hash == hash) &&
+        async_same(pEntry->pFileName,pFileName,FALSE) &&
+        async_same(pEntry->pAppName,pAppName,TRUE))
+      {
+        if (!pKeyName)
+        {
+          /* deleting the section: keep earlier writes in front of it */
+          async_unhash(pEntry);
+        }
+        else if (pEntry->pKeyName &&
+          async_same(pEntry->pKeyName,pKeyName,TRUE))
+        {
+          break;
+        }
+      }
+      pEntry = pNext;
+    }
+    if (pEntry)
+    {
+      /* coalesce with the queued write */
+      pCopy = async_strdup(pString,&ok);
+      if (ok)
+      {
+        free(pEntry->pString);
+        pEntry->pString = pCopy;
+      }
+    }
+    else
+    {
+      pEntry = calloc(1,sizeof(struct async_entry));
+      if (pEntry)
+      {
+        pEntry->pAppName = async_strdup(pAppName,&ok);
+        pEntry->pKeyName = async_strdup(pKeyName,&ok);
+        pEntry->pString = async_strdup(pString,&ok);
+        pEntry->pFileName = async_strdup(pFileName,&ok);
+        if (ok)
+        {
+          pEntry->ticket = ++Writer.last_ticket;
+          pEntry->hash = hash;
+          if (pKeyName)
+          {
+            pEntry->hashed = TRUE;
+            pEntry->pHashNext = Writer.pBucket[hash % ASYNC_HASH_BUCKETS];
+            Writer.pBucket[hash % ASYNC_HASH_BUCKETS] = pEntry;
+          }
+          if (Writer.pTail)
+            Writer.pTail->pNext = pEntry;
+          else
+            Writer.pHead = pEntry;
+          Writer.pTail = pEntry;
+          Writer.pending++;
+          pthread_cond_signal(&Writer_Work);
+        }
+        else
+        {
+          async_entry_free(pEntry);
+          pEntry = NULL;
+        }
+      }
+    }
+    if (pEntry && ok)
+    {
+      if (pWaiter)
+      {
+        pWaiter->pNext = pEntry->pWaiters;
+        pEntry->pWaiters = pWaiter;
+        pWaiter = NULL;
+      }
+      ticket = pEntry->ticket;
+    }
+    pthread_mutex_unlock(&Writer_Lock);
+  }
+  else
+  {
+    pthread_mutex_unlock(&Writer_Lock);
+    if (ok)
+    {
+      /* no writer - write through */
+      status = WritePrivateProfileString(pAppName,pKeyName,pString,
+        pFileName);
+      if (pCallback)
+        pCallback(status,pContext);
+    }
+  }
+  free(pWaiter);
+  if (!ok && pCallback)
+    pCallback(FALSE,pContext);
+
+  return (ticket);
+}
+
+/**
+ * Block until the write identified by a ticket has completed
+ * and its callbacks have run.
+ *
+ * @param ticket - value returned by WritePrivateProfileStringAsync
+ */
+void profile_async_wait(
+  unsigned long ticket)
+{
+  pthread_mutex_lock(&Writer_Lock);
+  while (Writer.running && (Writer.done_ticket < ticket))
+    pthread_cond_wait(&Writer_Done,&Writer_Lock);
+  pthread_mutex_unlock(&Writer_Lock);
+}
+
+/**
+ * Block until every write queued before this call has completed.
+ */
+void profile_async_flush(void)
+{
+  unsigned long ticket;
+
+  pthread_mutex_lock(&Writer_Lock);
+  ticket = Writer.last_ticket;
+  pthread_mutex_unlock(&Writer_Lock);
+  profile_async_wait(ticket);
+}
+
+/**
+ * Number of writes queued or in flight
+ *
+ * @return number of entries not yet completed
+ */
+size_t profile_async_pending(void)
+{
+  size_t pending;
+
+  pthread_mutex_lock(&Writer_Lock);
+  pending = Writer.pending;
+  pthread_mutex_unlock(&Writer_Lock);
+
+  return (pending);
+}
+
+/**
+ * Queues a read of a string from an INI file to the reader threads.
+ * The parameters have the same meaning as for GetPrivateProfileString,
+ * and the names and default are copied, but the buffer is written by a
+ * reader thread, so it must stay valid until pCallback is called.
+ * A read waits for the writes queued before it, so it sees them.
+ * If the readers are not running the string is read immediately and
+ * pCallback is called before this function returns.
+ *
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) destination buffer
+ * @param nSize (IN) size of destination buffer
+ * @param pFileName (IN) initialization filename
+ * @param pCallback (IN) function called with the count of characters
+ *  that GetPrivateProfileString returned
+ * @param pContext (IN) passed to pCallback
+ *
+ * @return TRUE if the read was queued or done, FALSE if out of memory
+ *  or pCallback is NULL, in which case pCallback is not called
+ */
+BOOL GetPrivateProfileStringAsync(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pFileName,
+  PROFILE_ASYNC_READ_CALLBACK pCallback,
+  void *pContext)
+{
+  struct async_read *pRead = NULL;
+  size_t count = 0;
+  BOOL ok = TRUE;
+
+  if (!pCallback)
+    return (FALSE);
+  pRead = calloc(1,sizeof(struct async_read));
+  if (!pRead)
+    return (FALSE);
+  pRead->pAppName = async_strdup(pAppName,&ok);
+  pRead->pKeyName = async_strdup(pKeyName,&ok);
+  pRead->pDefault = async_strdup(pDefault,&ok);
+  pRead->pFileName = async_strdup(pFileName,&ok);
+  pRead->pReturnedString = pReturnedString;
+  pRead->nSize = nSize;
+  pRead->pCallback = pCallback;
+  pRead->pContext = pContext;
+  if (!ok)
+  {
+    async_read_free(pRead);
+    return (FALSE);
+  }
+
+  pthread_mutex_lock(&Writer_Lock);
+  pRead->ticket = Writer.last_ticket;
+  pthread_mutex_unlock(&Writer_Lock);
+
+  pthread_mutex_lock(&Reader_Lock);
+  if (Reader.running && !Reader.stopping)
+  {
+    if (Reader.pTail)
+      Reader.pTail->pNext = pRead;
+    else
+      Reader.pHead = pRead;
+    Reader.pTail = pRead;
+    Reader.pending++;
+    pthread_cond_signal(&Reader_Work);
+    pRead = NULL;
+  }
+  pthread_mutex_unlock(&Reader_Lock);
+
+  if (pRead)
+  {
+    /* no readers - read through */
+    profile_async_wait(pRead->ticket);
+    pthread_rwlock_rdlock(&File_Lock);
+    count = GetPrivateProfileString(pAppName,pKeyName,pDefault,
+      pReturnedString,nSize,pFileName);
+    pthread_rwlock_unlock(&File_Lock);
+    async_read_free(pRead);
+    pCallback(count,pContext);
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Block until every read queued has completed and its callback
+ * has returned.
+ */
+void profile_async_drain(void)
+{
+  pthread_mutex_lock(&Reader_Lock);
+  while (Reader.pending)
+    pthread_cond_wait(&Reader_Done,&Reader_Lock);
+  pthread_mutex_unlock(&Reader_Lock);
+}
+
+/**
+ * Number of reads queued or in flight
+ *
+ * @return number of reads not yet completed
+ */
+size_t profile_async_reads_pending(void)
+{
+  size_t pending;
+
+  pthread_mutex_lock(&Reader_Lock);
+  pending = Reader.pending;
+  pthread_mutex_unlock(&Reader_Lock);
+
+  return (pending);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Asynchronous reads and write-behind for the profile functions
+ */
+#ifndef PROFILE_ASYNC_H
+#define PROFILE_ASYNC_H
+
+#include "profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /* called from the writer thread once a queued write is on disk */
+  typedef void (*PROFILE_ASYNC_CALLBACK)(
+    BOOL status,	// return value of WritePrivateProfileString
+    void *pContext); 	// caller supplied context
+
+  /* called from a reader thread once a queued read is done */
+  typedef void (*PROFILE_ASYNC_READ_CALLBACK)(
+    size_t count,	// return value of GetPrivateProfileString
+    void *pContext); 	// caller supplied context
+
+  BOOL profile_async_init(void);
+  void profile_async_cleanup(void);
+
+  unsigned long WritePrivateProfileStringAsync(
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString,	// pointer to string to add
+    const char *pFileName,	// pointer to initialization filename
+    PROFILE_ASYNC_CALLBACK pCallback,	// optional completion callback
+    void *pContext); 	// context passed to the callback
+
+  void profile_async_wait(unsigned long ticket);
+  void profile_async_flush(void);
+  size_t profile_async_pending(void);
+
+  BOOL GetPrivateProfileStringAsync(
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// destination, valid until the callback
+    size_t nSize,	// size of destination buffer
+    const char *pFileName,	// points to initialization filename
+    PROFILE_ASYNC_READ_CALLBACK pCallback,	// completion callback
+    void *pContext); 	// context passed to the callback
+
+  void profile_async_drain(void);
+  size_t profile_async_reads_pending(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_ASYNC_H */
@@ -0,0 +1,239 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief C++20 coroutine wrappers for the asynchronous profile functions
+ *
+ * profile::get_async and profile::write_async return awaitables that
+ * queue GetPrivateProfileStringAsync and WritePrivateProfileStringAsync
+ * when awaited, and resume the coroutine once the read or write is
+ * done.  By default the coroutine resumes on the reader or writer
+ * thread.  An event loop that wants its coroutines back on its own
+ * thread passes a scheduler: a function object called with the
+ * std::coroutine_handle<> from the I/O thread, that posts it to the
+ * loop and resumes it there.  Nothing is allocated besides the queued
+ * request of the C functions.
+ * {@code
+ * task lookup(char (&buffer)[64])
+ * {
+ *   std::string_view port = co_await profile::get_async("Network",
+ *     "Port", "47808", buffer, "device.ini", post_to_loop);
+ *   bool written = co_await profile::write_async("Network", "Port",
+ *     "47809", "device.ini", post_to_loop);
+ * }
+ * }
+ */
+#ifndef PROFILE_ASYNC_HPP
+#define PROFILE_ASYNC_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+#include "profile.h"
+#include "profile_async.h"
+
+namespace profile
+{
+  /* the default scheduler: resume on the thread that completed the I/O */
+  struct resume_inline
+  {
+    void operator()(std::coroutine_handle<> handle) const
+    {
+      handle.resume();
+    }
+  };
+
+  namespace detail
+  {
+    /**
+     * What the awaitables share: the coroutine to resume, and a flag
+     * that the completion and await_suspend both set, so whichever
+     * comes second resumes the coroutine.  A completion that comes
+     * first means the coroutine never suspends.
+     */
+    template <class Scheduler>
+    class async_operation
+    {
+    public:
+      explicit async_operation(Scheduler scheduler) :
+        scheduler_(std::move(scheduler))
+      {
+      }
+
+      async_operation(const async_operation &) = delete;
+      async_operation &operator=(const async_operation &) = delete;
+
+      bool await_ready() const noexcept
+      {
+        return false;
+      }
+
+    protected:
+      /* after queueing: false to carry on without suspending */
+      bool suspend(std::coroutine_handle<> handle) noexcept
+      {
+        handle_ = handle;
+        return !done_.exchange(true, std::memory_order_acq_rel);
+      }
+
+      /* from the I/O thread, once the result is stored */
+      void complete()
+      {
+        if (done_.exchange(true, std::memory_order_acq_rel))
+        {
+          /* resuming may destroy this, so nothing of it is used after */
+          Scheduler scheduler = std::move(scheduler_);
+
+          scheduler(handle_);
+        }
+      }
+
+    private:
+      Scheduler scheduler_;
+      std::coroutine_handle<> handle_;
+      std::atomic<bool> done_{false};
+    };
+  } // namespace detail
+
+  /* co_await gives the value read, as a view of the caller's buffer */
+  template <class Scheduler = resume_inline>
+  class get_awaitable : public detail::async_operation<Scheduler>
+  {
+  public:
+    get_awaitable(const char *app, const char *key, const char *def,
+      char *buffer, std::size_t size, const char *file,
+      Scheduler scheduler) :
+      detail::async_operation<Scheduler>(std::move(scheduler)), app_(app),
+      key_(key), def_(def), buffer_(buffer), size_(size), file_(file)
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+      if (!GetPrivateProfileStringAsync(app_, key_, def_, buffer_, size_,
+        file_, &get_awaitable::callback, this))
+        return false;
+      return this->suspend(handle);
+    }
+
+    /* empty if the read could not be queued */
+    std::string_view await_resume() const noexcept
+    {
+      return std::string_view(buffer_, count_);
+    }
+
+  private:
+    static void callback(size_t count, void *pContext)
+    {
+      get_awaitable *self = static_cast<get_awaitable *>(pContext);
+
+      self->count_ = count;
+      self->complete();
+    }
+
+    const char *app_;
+    const char *key_;
+    const char *def_;
+    char *buffer_;
+    std::size_t size_;
+    const char *file_;
+    std::size_t count_ = 0;
+  };
+
+  /* co_await gives the result of WritePrivateProfileString */
+  template <class Scheduler = resume_inline>
+  class write_awaitable : public detail::async_operation<Scheduler>
+  {
+  public:
+    write_awaitable(const char *app, const char *key, const char *value,
+      const char *file, Scheduler scheduler) :
+      detail::async_operation<Scheduler>(std::move(scheduler)), app_(app),
+      key_(key), value_(value), file_(file)
+    {
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept
+    {
+      /* these are not queued, and there is no callback */
+      if (!app_ || !file_)
+        return false;
+      /* otherwise the callback always runs, even on failure */
+      (void)WritePrivateProfileStringAsync(app_, key_, value_, file_,
+        &write_awaitable::callback, this);
+      return this->suspend(handle);
+    }
+
+    bool await_resume() const noexcept
+    {
+      return status_;
+    }
+
+  private:
+    static void callback(BOOL status, void *pContext)
+    {
+      write_awaitable *self = static_cast<write_awaitable *>(pContext);
+
+      self->status_ = status != FALSE;
+      self->complete();
+    }
+
+    const char *app_;
+    const char *key_;
+    const char *value_;
+    const char *file_;
+    bool status_ = false;
+  };
+
+  /**
+   * Read a string from an INI file without blocking the caller
+   *
+   * @param app - section name
+   * @param key - key name
+   * @param def - default string
+   * @param buffer - receives the string, and must outlive the co_await
+   * @param file - initialization filename
+   * @param scheduler - resumes the coroutine, on the I/O thread by default
+   *
+   * @return awaitable giving the string as a view of buffer
+   */
+  template <std::size_t N, class Scheduler = resume_inline>
+  get_awaitable<Scheduler> get_async(const char *app, const char *key,
+    const char *def, char (&buffer)[N], const char *file,
+    Scheduler scheduler = Scheduler())
+  {
+    return get_awaitable<Scheduler>(app, key, def, buffer, N, file,
+      std::move(scheduler));
+  }
+
+  template <class Scheduler = resume_inline>
+  get_awaitable<Scheduler> get_async(const char *app, const char *key,
+    const char *def, char *buffer, std::size_t size, const char *file,
+    Scheduler scheduler = Scheduler())
+  {
+    return get_awaitable<Scheduler>(app, key, def, buffer, size, file,
+      std::move(scheduler));
+  }
+
+  /**
+   * Write a string to an INI file without blocking the caller
+   *
+   * @param app - section name
+   * @param key - key name, or nullptr to delete the section
+   * @param value - string, or nullptr to delete the key
+   * @param file - initialization filename
+   * @param scheduler - resumes the coroutine, on the I/O thread by default
+   *
+   * @return awaitable giving true if the write succeeded
+   */
+  template <class Scheduler = resume_inline>
+  write_awaitable<Scheduler> write_async(const char *app, const char *key,
+    const char *value, const char *file, Scheduler scheduler = Scheduler())
+  {
+    return write_awaitable<Scheduler>(app, key, value, file,
+      std::move(scheduler));
+  }
+} // namespace profile
+
+#endif /* PROFILE_ASYNC_HPP */
@@ -0,0 +1,773 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Cache of parsed INI files, by file name
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * The cache keeps one parsed document per INI file, found by the file
+ * name as given.  Each document remembers the size and change time the
+ * file had when it was read, and GetPrivateProfileStringCached compares
+ * them with a stat of the file, so a file changed by any writer is read
+ * again instead of answering from the old copy.
+ *
+ * The cache may be given a budget of bytes with
+ * profile_cache_set_budget().  Each file is charged the memory of its
+ * document, and when the total goes over the budget, files are evicted
+ * in CLOCK order: the cached files form a ring, a lookup that finds a
+ * file only sets its referenced flag, and the hand of the clock evicts the first
+ * file it finds that was not referenced since it last went by, clearing
+ * the flags it passes.  This keeps close to least-recently-used order
+ * without moving anything on a hit.  The file read last is never the
+ * one evicted, so a file larger than the budget is still answered from.
+ *
+ * profile_cache_open() pins a file's document for a handle, and the
+ * clock passes over it until profile_cache_close().  A pinned document
+ * that is replaced, invalidated or cleared leaves the cache at once, but
+ * is freed only when its last handle is closed, so a handle may read it
+ * without the lock.
+ *
+ * The cache is shared by all threads and protected by one mutex, which
+ * is held while a lookup copies its answer out of a document.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+/* initial number of hash buckets - must be a power of two */
+#define CACHE_HASH_BUCKETS 256
+
+/* one cached file */
+struct cache_entry
+{
+  char *pFileName;
+  unsigned hash; /* hash of the file name */
+  PROFILE_DOC *pDoc;
+  PROFILE_IO_STAT file_stat; /* the file when it was read */
+  size_t bytes; /* memory charged to the budget */
+  unsigned pins; /* number of open handles */
+  BOOL referenced; /* used since the clock hand went by */
+  BOOL cached; /* FALSE once it left the cache */
+  struct cache_entry *pHashNext;
+  struct cache_entry *pClockNext; /* ring of cached files */
+  struct cache_entry *pClockPrev;
+};
+
+static pthread_mutex_t Cache_Lock = PTHREAD_MUTEX_INITIALIZER;
+static struct cache_entry **Cache_Bucket = NULL;
+static size_t Cache_Size = 0; /* number of buckets */
+static size_t Cache_Count = 0; /* number of cached files */
+static struct cache_entry *Cache_Hand = NULL; /* next file the clock sees */
+static size_t Cache_Bytes = 0; /* memory of the cached files */
+static size_t Cache_Budget = 0; /* 0 for no limit */
+static size_t Cache_Pinned = 0; /* cached files with open handles */
+static unsigned long long Cache_Hits = 0;
+static unsigned long long Cache_Misses = 0;
+static unsigned long long Cache_Evictions = 0;
+
+/**
+ * Hash a file name.  File names are compared exactly.
+ *
+ * @param pFileName - file name
+ *
+ * @return FNV-1a hash
+ */
+static unsigned cache_hash(
+  const char *pFileName)
+{
+  const unsigned char *s = (const unsigned char *)pFileName;
+  unsigned hash = 2166136261U;
+
+  while (*s)
+  {
+    hash ^= *s++;
+    hash *= 16777619U;
+  }
+
+  return (hash);
+}
+
+/**
+ * Find a cached file.  The caller holds Cache_Lock.
+ *
+ * @param pFileName - file name
+ * @param hash - cache_hash of the file name
+ *
+ * @return link that points to the entry, or to NULL if not cached
+ */
+static struct cache_entry **cache_find(
+  const char *pFileName,
+  unsigned hash)
+{
+  struct cache_entry **ppEntry;
+
+  if (!Cache_Size)
+    return (NULL);
+  ppEntry = &Cache_Bucket[hash & (Cache_Size - 1)];
+  while (*ppEntry)
+  {
+    if (((*ppEntry)->hash == hash) &&
+      (strcmp((*ppEntry)->pFileName,pFileName) == 0))
+      break;
+    ppEntry = &(*ppEntry)->pHashNext;
+  }
+
+  return (ppEntry);
+}
+
+/**
+ * Make room for one more file.  The caller holds Cache_Lock.
+ *
+ * @return TRUE if there is room
+ */
+static BOOL cache_reserve(void)
+{
+  struct cache_entry **ppBucket;
+  struct cache_entry *pEntry;
+  struct cache_entry *pNext;
+  size_t size;
+  size_t i;
+
+  if (Cache_Count < Cache_Size)
+    return (TRUE);
+  size = Cache_Size ? Cache_Size * 2 : CACHE_HASH_BUCKETS;
+  ppBucket = calloc(size,sizeof(struct cache_entry *));
+  if (!ppBucket)
+    return (FALSE);
+  for (i = 0; i < Cache_Size; i++)
+  {
+    for (pEntry = Cache_Bucket[i]; pEntry; pEntry = pNext)
+    {
+      pNext = pEntry->pHashNext;
+      pEntry->pHashNext = ppBucket[pEntry->hash & (size - 1)];
+      ppBucket[pEntry->hash & (size - 1)] = pEntry;
+    }
+  }
+  free(Cache_Bucket);
+  Cache_Bucket = ppBucket;
+  Cache_Size = size;
+
+  return (TRUE);
+}
+
+/**
+ * Release a cache entry and its document
+ *
+ * @param pEntry - entry that is no longer in the table
+ */
+static void cache_entry_free(
+  struct cache_entry *pEntry)
+{
+  profile_doc_free(pEntry->pDoc);
+  free(pEntry->pFileName);
+  free(pEntry);
+}
+
+/**
+ * Free a list of entries linked by pHashNext, once the lock is released
+ *
+ * @param pEntry - first entry, or NULL
+ */
+static void cache_free_list(
+  struct cache_entry *pEntry)
+{
+  struct cache_entry *pNext;
+
+  for (; pEntry; pEntry = pNext)
+  {
+    pNext = pEntry->pHashNext;
+    cache_entry_free(pEntry);
+  }
+}
+
+/**
+ * Add an entry to the table and to the ring, just behind the hand,
+ * so the clock sees it last.  The caller holds Cache_Lock and has
+ * made room in the table.
+ *
+ * @param ppLink - link in the table where the entry goes
+ * @param pEntry - entry
+ */
+static void cache_link(
+  struct cache_entry **ppLink,
+  struct cache_entry *pEntry)
+{
+  pEntry->pHashNext = *ppLink;
+  *ppLink = pEntry;
+  if (Cache_Hand)
+  {
+    pEntry->pClockNext = Cache_Hand;
+    pEntry->pClockPrev = Cache_Hand->pClockPrev;
+    Cache_Hand->pClockPrev->pClockNext = pEntry;
+    Cache_Hand->pClockPrev = pEntry;
+  }
+  else
+  {
+    pEntry->pClockNext = pEntry;
+    pEntry->pClockPrev = pEntry;
+    Cache_Hand = pEntry;
+  }
+  pEntry->cached = TRUE;
+  Cache_Count++;
+  Cache_Bytes += pEntry->bytes;
+  if (pEntry->pins)
+    Cache_Pinned++;
+}
+
+/**
+ * Take an entry out of the table and the ring.  The caller holds
+ * Cache_Lock, and frees the entry unless a handle still has it.
+ *
+ * @param ppLink - link in the table that points to the entry
+ *
+ * @return the entry
+ */
+static struct cache_entry *cache_unlink(
+  struct cache_entry **ppLink)
+{
+  struct cache_entry *pEntry = *ppLink;
+
+  *ppLink = pEntry->pHashNext;
+  pEntry->pHashNext = NULL;
+  if (pEntry->pClockNext == pEntry)
+    Cache_Hand = NULL;
+  else
+  {
+    if (Cache_Hand == pEntry)
+      Cache_Hand = pEntry->pClockNext;
+    pEntry->pClockPrev->pClockNext = pEntry->pClockNext;
+    pEntry->pClockNext->pClockPrev = pEntry->pClockPrev;
+  }
+  pEntry->pClockNext = NULL;
+  pEntry->pClockPrev = NULL;
+  pEntry->cached = FALSE;
+  Cache_Count--;
+  Cache_Bytes -= pEntry->bytes;
+  if (pEntry->pins)
+    Cache_Pinned--;
+
+  return (pEntry);
+}
+
+/**
+ * Take an entry out of the cache, and queue it to be freed unless a
+ * handle still has it.  The caller holds Cache_Lock.
+ *
+ * @param ppLink - link in the table that points to the entry
+ * @param ppFree - list of entries to free after the lock is released
+ */
+static void cache_drop(
+  struct cache_entry **ppLink,
+  struct cache_entry **ppFree)
+{
+  struct cache_entry *pEntry = cache_unlink(ppLink);
+
+  if (!pEntry->pins)
+  {
+    pEntry->pHashNext = *ppFree;
+    *ppFree = pEntry;
+  }
+}
+
+/**
+ * Evict files in CLOCK order until the cache is within its budget.
+ * The caller holds Cache_Lock.
+ *
+ * @param pKeep - entry that must stay, or NULL
+ * @param ppFree - list of entries to free after the lock is released
+ */
+static void cache_evict(
+  const struct cache_entry *pKeep,
+  struct cache_entry **ppFree)
+{
+  struct cache_entry *pEntry;
+  size_t steps = 0;
+
+  /* two turns of the clock clear every flag; more finds nothing */
+  while (Cache_Budget && (Cache_Bytes > Cache_Budget) && Cache_Hand &&
+    (steps++ <= 2 * Cache_Count))
+  {
+    pEntry = Cache_Hand;
+    if ((pEntry == pKeep) || pEntry->pins)
+      Cache_Hand = pEntry->pClockNext;
+    else if (pEntry->referenced)
+    {
+      pEntry->referenced = FALSE;
+      Cache_Hand = pEntry->pClockNext;
+    }
+    else
+    {
+      cache_drop(cache_find(pEntry->pFileName,pEntry->hash),ppFree);
+      Cache_Evictions++;
+      steps = 0;
+    }
+  }
+}
+
+/**
+ * Add a parsed file to the cache, replacing any earlier copy.
+ * Other files may be evicted to keep within the budget.
+ *
+ * @param pFileName (IN) file name, as it will be looked up
+ * @param pDoc (IN) document, which the cache owns from now on,
+ *  even if the call fails
+ * @param pStat (IN) the file when it was read, so a later change
+ *  can be noticed
+ *
+ * @return TRUE if the document was cached
+ */
+BOOL profile_cache_insert(
+  const char *pFileName,
+  PROFILE_DOC *pDoc,
+  const PROFILE_IO_STAT *pStat)
+{
+  struct cache_entry **ppEntry;
+  struct cache_entry *pEntry;
+  struct cache_entry *pFree = NULL;
+  size_t len;
+
+  if (!pFileName || !pDoc || !pStat)
+  {
+    profile_doc_free(pDoc);
+    return (FALSE);
+  }
+  len = strlen(pFileName) + 1;
+  pEntry = calloc(1,sizeof(struct cache_entry));
+  if (pEntry)
+    pEntry->pFileName = malloc(len);
+  if (!pEntry || !pEntry->pFileName)
+  {
+    free(pEntry);
+    profile_doc_free(pDoc);
+    return (FALSE);
+  }
+  memcpy(pEntry->pFileName,pFileName,len);
+  pEntry->hash = cache_hash(pFileName);
+  pEntry->pDoc = pDoc;
+  pEntry->file_stat = *pStat;
+  pEntry->bytes = profile_doc_memory(pDoc) + sizeof(struct cache_entry) +
+    len;
+  pthread_mutex_lock(&Cache_Lock);
+  ppEntry = cache_find(pFileName,pEntry->hash);
+  if (ppEntry && *ppEntry)
+  {
+    /* take the place of the old copy */
+    cache_drop(ppEntry,&pFree);
+    ppEntry = NULL;
+  }
+  if (cache_reserve())
+  {
+    cache_link(&Cache_Bucket[pEntry->hash & (Cache_Size - 1)],pEntry);
+    cache_evict(pEntry,&pFree);
+    pEntry = NULL;
+  }
+  pthread_mutex_unlock(&Cache_Lock);
+  cache_free_list(pFree);
+  if (pEntry)
+  {
+    cache_entry_free(pEntry);
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Read and parse a file into the cache
+ *
+ * @param pFileName (IN) file name
+ *
+ * @return TRUE if the file was read and cached
+ */
+BOOL profile_cache_load(
+  const char *pFileName)
+{
+  PROFILE_IO_STAT file_stat;
+  PROFILE_DOC *pDoc;
+
+  if (!pFileName)
+    return (FALSE);
+  /* stat first, so a change while reading is seen next time */
+  if (!profile_io_stat(profile_io_posix(),pFileName,&file_stat))
+    return (FALSE);
+  pDoc = profile_doc_load(pFileName);
+  if (!pDoc)
+    return (FALSE);
+
+  return (profile_cache_insert(pFileName,pDoc,&file_stat));
+}
+
+/**
+ * Check whether a file is in the cache
+ *
+ * @param pFileName (IN) file name
+ *
+ * @return TRUE if a parsed copy is cached
+ */
+BOOL profile_cache_contains(
+  const char *pFileName)
+{
+  struct cache_entry **ppEntry;
+  BOOL status = FALSE;
+
+  if (!pFileName)
+    return (status);
+  pthread_mutex_lock(&Cache_Lock);
+  ppEntry = cache_find(pFileName,cache_hash(pFileName));
+  status = (ppEntry && *ppEntry);
+  pthread_mutex_unlock(&Cache_Lock);
+
+  return (status);
+}
+
+/**
+ * Drop the cached copy of a file
+ *
+ * @param pFileName (IN) file name
+ */
+void profile_cache_invalidate(
+  const char *pFileName)
+{
+  struct cache_entry **ppEntry;
+  struct cache_entry *pFree = NULL;
+
+  if (!pFileName)
+    return;
+  pthread_mutex_lock(&Cache_Lock);
+  ppEntry = cache_find(pFileName,cache_hash(pFileName));
+  if (ppEntry && *ppEntry)
+    cache_drop(ppEntry,&pFree);
+  pthread_mutex_unlock(&Cache_Lock);
+  cache_free_list(pFree);
+}
+
+/**
+ * Drop every cached file.  The statistics are kept.
+ */
+void profile_cache_clear(void)
+{
+  struct cache_entry *pFree = NULL;
+  size_t i;
+
+  pthread_mutex_lock(&Cache_Lock);
+  for (i = 0; i < Cache_Size; i++)
+  {
+    while (Cache_Bucket[i])
+      cache_drop(&Cache_Bucket[i],&pFree);
+  }
+  free(Cache_Bucket);
+  Cache_Bucket = NULL;
+  Cache_Size = 0;
+  pthread_mutex_unlock(&Cache_Lock);
+  cache_free_list(pFree);
+}
+
+/**
+ * Number of cached files
+ *
+ * @return number of files
+ */
+size_t profile_cache_count(void)
+{
+  size_t count;
+
+  pthread_mutex_lock(&Cache_Lock);
+  count = Cache_Count;
+  pthread_mutex_unlock(&Cache_Lock);
+
+  return (count);
+}
+
+/**
+ * Limit the memory of the cached documents, evicting files at once
+ * if the cache is over the new budget.  Files pinned by handles
+ * are not evicted, and may keep the cache over its budget.
+ *
+ * @param nBytes (IN) number of bytes, or 0 for no limit
+ */
+void profile_cache_set_budget(
+  size_t nBytes)
+{
+  struct cache_entry *pFree = NULL;
+
+  pthread_mutex_lock(&Cache_Lock);
+  Cache_Budget = nBytes;
+  cache_evict(NULL,&pFree);
+  pthread_mutex_unlock(&Cache_Lock);
+  cache_free_list(pFree);
+}
+
+/**
+ * Report how well the cache is doing.  A hit is a lookup or open that
+ * was answered from a cached document, and a miss one that read the
+ * file, because it was not cached or had changed.
+ *
+ * @param pStats (OUT) receives the statistics
+ */
+void profile_cache_stats(
+  PROFILE_CACHE_STATS *pStats)
+{
+  if (!pStats)
+    return;
+  pthread_mutex_lock(&Cache_Lock);
+  pStats->hits = Cache_Hits;
+  pStats->misses = Cache_Misses;
+  pStats->evictions = Cache_Evictions;
+  pStats->count = Cache_Count;
+  pStats->bytes = Cache_Bytes;
+  pStats->pinned = Cache_Pinned;
+  pStats->budget = Cache_Budget;
+  pthread_mutex_unlock(&Cache_Lock);
+}
+
+/**
+ * Set the hit, miss, and eviction counts back to zero
+ */
+void profile_cache_reset_stats(void)
+{
+  pthread_mutex_lock(&Cache_Lock);
+  Cache_Hits = 0;
+  Cache_Misses = 0;
+  Cache_Evictions = 0;
+  pthread_mutex_unlock(&Cache_Lock);
+}
+
+/**
+ * Find the cached copy of a file that is up to date, reading the file
+ * into the cache if needed, and call back with the lock held.
+ *
+ * @param pFileName - file name
+ * @param pStat - the file as it is now
+ * @param pfnUse - called with the entry, under Cache_Lock
+ * @param pContext - passed to pfnUse
+ *
+ * @return TRUE if pfnUse was called
+ */
+static BOOL cache_use(
+  const char *pFileName,
+  const PROFILE_IO_STAT *pStat,
+  void (*pfnUse)(struct cache_entry *pEntry, void *pContext),
+  void *pContext)
+{
+  struct cache_entry **ppEntry;
+  struct cache_entry *pEntry;
+  unsigned hash;
+  BOOL found = FALSE;
+  unsigned tries;
+
+  hash = cache_hash(pFileName);
+  for (tries = 0; !found && (tries < 2); tries++)
+  {
+    pthread_mutex_lock(&Cache_Lock);
+    ppEntry = cache_find(pFileName,hash);
+    pEntry = ppEntry ? *ppEntry : NULL;
+    /* a copy that was just read is used even if the file moved on */
+    if (pEntry && (tries ||
+      ((pEntry->file_stat.size == pStat->size) &&
+      (pEntry->file_stat.mtime == pStat->mtime))))
+    {
+      /* a file read just now counts as used only when used again,
+         so files read once are the first to go */
+      if (tries == 0)
+      {
+        Cache_Hits++;
+        pEntry->referenced = TRUE;
+      }
+      pfnUse(pEntry,pContext);
+      found = TRUE;
+    }
+    else if (tries == 0)
+      Cache_Misses++;
+    pthread_mutex_unlock(&Cache_Lock);
+    if (!found && (tries == 0) && !profile_cache_load(pFileName))
+      break;
+  }
+
+  return (found);
+}
+
+/* what GetPrivateProfileStringCached asks of a document */
+struct cache_lookup
+{
+  const char *pAppName;
+  const char *pKeyName;
+  const char *pDefault;
+  char *pReturnedString;
+  size_t nSize;
+  size_t count;
+};
+
+/**
+ * Copy the answer of a lookup out of a cached document
+ *
+ * @param pEntry - cached file
+ * @param pContext - struct cache_lookup
+ */
+static void cache_get(
+  struct cache_entry *pEntry,
+  void *pContext)
+{
+  struct cache_lookup *pLookup = pContext;
+
+  pLookup->count = profile_doc_get(pEntry->pDoc,pLookup->pAppName,
+    pLookup->pKeyName,pLookup->pDefault,pLookup->pReturnedString,
+    pLookup->nSize);
+}
+
+/**
+ * Pin a cached document for a handle
+ *
+ * @param pEntry - cached file
+ * @param pContext - receives the entry
+ */
+static void cache_pin(
+  struct cache_entry *pEntry,
+  void *pContext)
+{
+  if (pEntry->pins++ == 0)
+    Cache_Pinned++;
+  *(struct cache_entry **)pContext = pEntry;
+}
+
+/**
+ * Open a handle on the parsed document of a file, reading it into the
+ * cache if it is not there or has changed.  The document is not
+ * evicted or freed until the handle is closed, and stays as it was
+ * even if the file changes.
+ *
+ * @param pFileName (IN) file name
+ *
+ * @return handle, or NULL if the file cannot be read
+ */
+PROFILE_CACHE_HANDLE *profile_cache_open(
+  const char *pFileName)
+{
+  PROFILE_IO_STAT file_stat;
+  struct cache_entry *pEntry = NULL;
+
+  if (!pFileName ||
+    !profile_io_stat(profile_io_posix(),pFileName,&file_stat))
+    return (NULL);
+  if (!cache_use(pFileName,&file_stat,cache_pin,&pEntry))
+    return (NULL);
+
+  return ((PROFILE_CACHE_HANDLE *)pEntry);
+}
+
+/**
+ * Document of an open handle
+ *
+ * @param pHandle (IN) handle from profile_cache_open()
+ *
+ * @return document, which must not be changed
+ */
+const PROFILE_DOC *profile_cache_doc(
+  const PROFILE_CACHE_HANDLE *pHandle)
+{
+  return (pHandle ? ((const struct cache_entry *)pHandle)->pDoc : NULL);
+}
+
+/**
+ * Close a handle, letting its document be evicted, or freed if it
+ * already left the cache.
+ *
+ * @param pHandle (IN) handle from profile_cache_open(), or NULL
+ */
+void profile_cache_close(
+  PROFILE_CACHE_HANDLE *pHandle)
+{
+  struct cache_entry *pEntry = (struct cache_entry *)pHandle;
+  struct cache_entry *pFree = NULL;
+
+  if (!pEntry)
+    return;
+  pthread_mutex_lock(&Cache_Lock);
+  if (--pEntry->pins == 0)
+  {
+    if (pEntry->cached)
+    {
+      Cache_Pinned--;
+      cache_evict(NULL,&pFree);
+    }
+    else
+      pFree = pEntry;
+  }
+  pthread_mutex_unlock(&Cache_Lock);
+  cache_free_list(pFree);
+}
+
+/**
+ * Retrieves a string the same way as GetPrivateProfileString, from
+ * the cached copy of the file.  A file that is not cached, or that
+ * changed since it was cached, is read into the cache first.
+ *
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ * @param pFileName (IN) initialization filename
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t GetPrivateProfileStringCached(
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pFileName)
+{
+  PROFILE_IO_STAT file_stat;
+  struct cache_lookup lookup;
+
+  if (!pReturnedString || !pFileName)
+    return (0);
+  if (!profile_io_stat(profile_io_posix(),pFileName,&file_stat))
+  {
+    /* no file - the default */
+    profile_cache_invalidate(pFileName);
+    return (GetPrivateProfileString(pAppName,pKeyName,pDefault,
+      pReturnedString,nSize,pFileName));
+  }
+  lookup.pAppName = pAppName;
+  lookup.pKeyName = pKeyName;
+  lookup.pDefault = pDefault;
+  lookup.pReturnedString = pReturnedString;
+  lookup.nSize = nSize;
+  lookup.count = 0;
+  if (cache_use(pFileName,&file_stat,cache_get,&lookup))
+    return (lookup.count);
+
+  /* out of memory - read the file the slow way */
+  return (GetPrivateProfileString(pAppName,pKeyName,pDefault,
+    pReturnedString,nSize,pFileName));
+}
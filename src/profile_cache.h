@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Cache of parsed INI files, by file name
+ */
+#ifndef PROFILE_CACHE_H
+#define PROFILE_CACHE_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+/* a document pinned in the cache */
+typedef struct profile_cache_handle PROFILE_CACHE_HANDLE;
+
+/* how the cache is doing, from profile_cache_stats */
+typedef struct profile_cache_stats
+{
+  unsigned long long hits; /* answered from a cached document */
+  unsigned long long misses; /* the file had to be read */
+  unsigned long long evictions; /* files dropped to keep to the budget */
+  size_t count; /* number of cached files */
+  size_t bytes; /* memory of the cached documents */
+  size_t pinned; /* cached files with open handles */
+  size_t budget; /* limit on bytes, 0 for none */
+} PROFILE_CACHE_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  BOOL profile_cache_insert(
+    const char *pFileName,
+    PROFILE_DOC *pDoc,
+    const PROFILE_IO_STAT *pStat);
+  BOOL profile_cache_load(const char *pFileName);
+  BOOL profile_cache_contains(const char *pFileName);
+  void profile_cache_invalidate(const char *pFileName);
+  void profile_cache_clear(void);
+  size_t profile_cache_count(void);
+  void profile_cache_set_budget(size_t nBytes);
+  void profile_cache_stats(PROFILE_CACHE_STATS *pStats);
+  void profile_cache_reset_stats(void);
+
+  PROFILE_CACHE_HANDLE *profile_cache_open(const char *pFileName);
+  const PROFILE_DOC *profile_cache_doc(const PROFILE_CACHE_HANDLE *pHandle);
+  void profile_cache_close(PROFILE_CACHE_HANDLE *pHandle);
+
+  size_t GetPrivateProfileStringCached(
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize,	// size of destination buffer
+    const char *pFileName); 	// points to initialization filename
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_CACHE_H */
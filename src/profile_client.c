@@ -0,0 +1,619 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Client of the INI lookup daemon
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * A client sends its lookups and writes to the daemon
+ * (profile_daemon.h) and copies the answers into the caller's buffers,
+ * so it never opens or parses an INI file itself.  A batch goes in as
+ * few requests as the message size allows, one round trip each.
+ *
+ * When the daemon can't be reached, a lookup gives the default string
+ * as for an empty file and a write fails.  The next call connects
+ * again, so a client outlives a restart of the daemon.  A client may
+ * be used by several threads; its lock is held for each round trip.
+ */
+
+/* includes */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "profile.h"
+#include "profile_client.h"
+#include "profile_daemon.h"
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+/* a lookup or write, as the daemon sees it */
+struct client_op
+{
+  unsigned char op; /* PROFILE_DAEMON_GET or _SET */
+  const char *pAppName;
+  const char *pKeyName;
+  const char *pString; /* default string, or string to write */
+  char *pReturnedString;
+  size_t nSize;
+  size_t count; /* characters copied to the buffer */
+  BOOL status; /* TRUE if the daemon served the file */
+};
+
+struct profile_client
+{
+  char *pSocketName;
+  int fd; /* -1 while not connected */
+  unsigned char *pMessage; /* request, then answer */
+  size_t nMessage; /* bytes allocated */
+  pthread_mutex_t lock;
+};
+
+/**
+ * Connect to the daemon if not connected
+ *
+ * @param pClient - client
+ *
+ * @return TRUE if connected
+ */
+static BOOL client_connect(
+  PROFILE_CLIENT *pClient)
+{
+  struct sockaddr_un addr;
+
+  if (pClient->fd >= 0)
+    return (TRUE);
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,pClient->pSocketName);
+  pClient->fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (pClient->fd < 0)
+    return (FALSE);
+  if (connect(pClient->fd,(struct sockaddr *)&addr,sizeof(addr)) != 0)
+  {
+    close(pClient->fd);
+    pClient->fd = -1;
+    return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Connect to a daemon.
+ *
+ * @param pSocketName (IN) path of the daemon's socket
+ *
+ * @return client, or NULL if the daemon isn't running
+ */
+PROFILE_CLIENT *profile_client_connect(
+  const char *pSocketName)
+{
+  PROFILE_CLIENT *pClient = NULL;
+
+  if (!pSocketName ||
+    (strlen(pSocketName) >= sizeof(((struct sockaddr_un *)0)->sun_path)))
+    return (NULL);
+  pClient = calloc(1,sizeof(PROFILE_CLIENT));
+  if (!pClient)
+    return (NULL);
+  pClient->fd = -1;
+  pthread_mutex_init(&pClient->lock,NULL);
+  pClient->pSocketName = malloc(strlen(pSocketName) + 1);
+  if (!pClient->pSocketName)
+  {
+    profile_client_close(pClient);
+    return (NULL);
+  }
+  strcpy(pClient->pSocketName,pSocketName);
+  if (!client_connect(pClient))
+  {
+    profile_client_close(pClient);
+    return (NULL);
+  }
+
+  return (pClient);
+}
+
+/**
+ * Disconnect from the daemon and free the client.
+ *
+ * @param pClient (IN) client, or NULL
+ */
+void profile_client_close(
+  PROFILE_CLIENT *pClient)
+{
+  if (!pClient)
+    return;
+  if (pClient->fd >= 0)
+    close(pClient->fd);
+  pthread_mutex_destroy(&pClient->lock);
+  free(pClient->pMessage);
+  free(pClient->pSocketName);
+  free(pClient);
+}
+
+/**
+ * Number of bytes that a string takes in a request
+ *
+ * @param pString - string, or NULL
+ *
+ * @return number of bytes
+ */
+static size_t client_string_size(
+  const char *pString)
+{
+  return (sizeof(uint32_t) + (pString ? strlen(pString) + 1 : 0));
+}
+
+/**
+ * Copy a 32-bit number into a request
+ *
+ * @param ppData - next byte of the request, moved forward
+ * @param value - number
+ */
+static void client_put_u32(
+  unsigned char **ppData,
+  uint32_t value)
+{
+  memcpy(*ppData,&value,sizeof(value));
+  *ppData += sizeof(value);
+}
+
+/**
+ * Copy a string into a request
+ *
+ * @param ppData - next byte of the request, moved forward
+ * @param pString - string, or NULL
+ */
+static void client_put_string(
+  unsigned char **ppData,
+  const char *pString)
+{
+  size_t len = 0;
+
+  if (!pString)
+  {
+    client_put_u32(ppData,(uint32_t)PROFILE_DAEMON_NULL);
+    return;
+  }
+  len = strlen(pString);
+  client_put_u32(ppData,(uint32_t)len);
+  memcpy(*ppData,pString,len + 1);
+  *ppData += len + 1;
+}
+
+/**
+ * Take a 32-bit number from an answer
+ *
+ * @param ppData - next byte of the answer, moved forward
+ * @param pnLeft - number of bytes left in the answer, updated
+ * @param pValue - receives the number
+ *
+ * @return FALSE if the answer ended
+ */
+static BOOL client_get_u32(
+  const unsigned char **ppData,
+  size_t *pnLeft,
+  uint32_t *pValue)
+{
+  if (*pnLeft < sizeof(*pValue))
+    return (FALSE);
+  memcpy(pValue,*ppData,sizeof(*pValue));
+  *ppData += sizeof(*pValue);
+  *pnLeft -= sizeof(*pValue);
+
+  return (TRUE);
+}
+
+/**
+ * Make sure the message buffer holds a number of bytes
+ *
+ * @param pClient - client
+ * @param nSize - number of bytes
+ *
+ * @return TRUE if it does
+ */
+static BOOL client_reserve(
+  PROFILE_CLIENT *pClient,
+  size_t nSize)
+{
+  unsigned char *pMessage = NULL;
+
+  if (nSize <= pClient->nMessage)
+    return (TRUE);
+  pMessage = realloc(pClient->pMessage,nSize);
+  if (!pMessage)
+    return (FALSE);
+  pClient->pMessage = pMessage;
+  pClient->nMessage = nSize;
+
+  return (TRUE);
+}
+
+/**
+ * Send or receive all of a number of bytes
+ *
+ * @param fd - socket
+ * @param pData - bytes
+ * @param nLength - number of bytes
+ * @param sending - TRUE to send, FALSE to receive
+ *
+ * @return TRUE if they were all sent or received
+ */
+static BOOL client_transfer(
+  int fd,
+  unsigned char *pData,
+  size_t nLength,
+  BOOL sending)
+{
+  ssize_t done = 0;
+
+  while (nLength)
+  {
+    if (sending)
+      done = send(fd,pData,nLength,MSG_NOSIGNAL);
+    else
+      done = recv(fd,pData,nLength,0);
+    if ((done < 0) && (errno == EINTR))
+      continue;
+    if (done <= 0)
+      return (FALSE);
+    pData += done;
+    nLength -= (size_t)done;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Send some operations to the daemon in one request and take their
+ * answers.  The client's lock is held.
+ *
+ * @param pClient - client
+ * @param pOps - operations
+ * @param nCount - number of operations
+ * @param nLength - size of the request, without its length
+ * @param pFileName - initialization filename
+ *
+ * @return TRUE if the daemon answered
+ */
+static BOOL client_round_trip(
+  PROFILE_CLIENT *pClient,
+  struct client_op *pOps,
+  size_t nCount,
+  size_t nLength,
+  const char *pFileName)
+{
+  unsigned char *pData = NULL;
+  const unsigned char *pAnswer = NULL;
+  size_t left = 0;
+  size_t i = 0;
+  uint32_t length = 0;
+  uint32_t value = 0;
+  uint32_t count = 0;
+
+  if (!client_reserve(pClient,sizeof(uint32_t) + nLength))
+    return (FALSE);
+  pData = pClient->pMessage;
+  client_put_u32(&pData,(uint32_t)nLength);
+  client_put_u32(&pData,(uint32_t)nCount);
+  for (i = 0; i < nCount; i++)
+  {
+    *pData++ = pOps[i].op;
+    client_put_string(&pData,pFileName);
+    client_put_string(&pData,pOps[i].pAppName);
+    client_put_string(&pData,pOps[i].pKeyName);
+    client_put_string(&pData,pOps[i].pString);
+    if (pOps[i].op == PROFILE_DAEMON_GET)
+      client_put_u32(&pData,(uint32_t)pOps[i].nSize);
+  }
+  if (!client_transfer(pClient->fd,pClient->pMessage,
+    sizeof(uint32_t) + nLength,TRUE) ||
+    !client_transfer(pClient->fd,(unsigned char *)&length,
+    sizeof(length),FALSE) ||
+    (length > PROFILE_DAEMON_MAX_MESSAGE) ||
+    !client_reserve(pClient,length) ||
+    !client_transfer(pClient->fd,pClient->pMessage,length,FALSE))
+    return (FALSE);
+  pAnswer = pClient->pMessage;
+  left = length;
+  if (!client_get_u32(&pAnswer,&left,&count) || (count != nCount))
+    return (FALSE);
+  for (i = 0; i < nCount; i++)
+  {
+    if (left < 1)
+      return (FALSE);
+    pOps[i].status = *pAnswer++ ? TRUE : FALSE;
+    left--;
+    if (pOps[i].op != PROFILE_DAEMON_GET)
+      continue;
+    if (!client_get_u32(&pAnswer,&left,&value))
+      return (FALSE);
+    pOps[i].count = value;
+    if (!client_get_u32(&pAnswer,&left,&value) || (value > left) ||
+      (value > pOps[i].nSize))
+      return (FALSE);
+    if (value)
+      memcpy(pOps[i].pReturnedString,pAnswer,value);
+    pAnswer += value;
+    left -= value;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Send operations to the daemon, in as few requests as the message
+ * size allows.  When a request fails, the ones after it are not sent.
+ *
+ * @param pClient - client
+ * @param pOps - operations
+ * @param nCount - number of operations
+ * @param pFileName - initialization filename
+ *
+ * @return number of operations, from the first, that the daemon
+ *  answered
+ */
+static size_t client_exchange(
+  PROFILE_CLIENT *pClient,
+  struct client_op *pOps,
+  size_t nCount,
+  const char *pFileName)
+{
+  size_t file_size = client_string_size(pFileName);
+  size_t request = 0;
+  size_t answer = 0;
+  size_t size = 0;
+  size_t start = 0;
+  size_t i = 0;
+  BOOL status = TRUE;
+
+  for (i = 0; i < nCount; i++)
+  {
+    if (pOps[i].nSize > PROFILE_DAEMON_MAX_SIZE)
+      pOps[i].nSize = PROFILE_DAEMON_MAX_SIZE;
+  }
+  pthread_mutex_lock(&pClient->lock);
+  status = client_connect(pClient);
+  while (status && (start < nCount))
+  {
+    request = sizeof(uint32_t);
+    answer = sizeof(uint32_t);
+    for (i = start; i < nCount; i++)
+    {
+      size = 1 + file_size + client_string_size(pOps[i].pAppName) +
+        client_string_size(pOps[i].pKeyName) +
+        client_string_size(pOps[i].pString);
+      if (pOps[i].op == PROFILE_DAEMON_GET)
+        size += sizeof(uint32_t);
+      if ((request + size > PROFILE_DAEMON_MAX_MESSAGE) ||
+        (answer + 9 + pOps[i].nSize > PROFILE_DAEMON_MAX_MESSAGE))
+        break;
+      request += size;
+      answer += 9 + pOps[i].nSize;
+    }
+    if (i == start)
+      status = FALSE; /* too large to send at all */
+    else
+      status = client_round_trip(pClient,&pOps[start],i - start,request,
+        pFileName);
+    if (status)
+      start = i;
+  }
+  if (!status && (pClient->fd >= 0))
+  {
+    /* the stream is out of step; start again next time */
+    close(pClient->fd);
+    pClient->fd = -1;
+  }
+  pthread_mutex_unlock(&pClient->lock);
+
+  return (start);
+}
+
+/**
+ * Look up many strings in an INI file in one round trip.  Each request
+ * gets the same result that GetPrivateProfileString would give for its
+ * pAppName, pKeyName, pDefault, pReturnedString and nSize, with the
+ * number of characters copied to the buffer stored in its count member.
+ *
+ * @param pClient (IN) connection to the daemon
+ * @param pRequest (IN/OUT) array of lookups
+ * @param nCount (IN) number of lookups in the array
+ * @param pFileName (IN) Pointer to a null-terminated string
+ *  that names the initialization file, as the daemon was given it.
+ *
+ * @return TRUE if the daemon serves the file and answered every
+ *  lookup, FALSE if some of the answers are the defaults
+ */
+BOOL profile_client_get_batch(
+  PROFILE_CLIENT *pClient,
+  PROFILE_REQUEST *pRequest,
+  size_t nCount,
+  const char *pFileName)
+{
+  struct client_op *pOps = NULL;
+  size_t answered = 0;
+  size_t i = 0;
+  BOOL status = FALSE;
+
+  if (!pRequest)
+    return (FALSE);
+  if (pClient && nCount)
+    pOps = calloc(nCount,sizeof(struct client_op));
+  for (i = 0; pOps && (i < nCount); i++)
+  {
+    pOps[i].op = PROFILE_DAEMON_GET;
+    pOps[i].pAppName = pRequest[i].pAppName;
+    pOps[i].pKeyName = pRequest[i].pKeyName;
+    pOps[i].pString = pRequest[i].pDefault;
+    pOps[i].pReturnedString = pRequest[i].pReturnedString;
+    pOps[i].nSize = pRequest[i].pReturnedString ? pRequest[i].nSize : 0;
+  }
+  if (pOps)
+    answered = client_exchange(pClient,pOps,nCount,pFileName);
+  status = (pOps && (answered == nCount)) ? TRUE : FALSE;
+  for (i = 0; i < answered; i++)
+  {
+    pRequest[i].count = pOps[i].count;
+    if (!pOps[i].status)
+      status = FALSE;
+  }
+  /* no daemon, or it went away part way - the defaults */
+  for (i = answered; i < nCount; i++)
+  {
+    pRequest[i].count = pRequest[i].pReturnedString ?
+      GetPrivateProfileStringFromBuffer(pRequest[i].pAppName,
+      pRequest[i].pKeyName,pRequest[i].pDefault,
+      pRequest[i].pReturnedString,pRequest[i].nSize,"",0) : 0;
+  }
+  free(pOps);
+
+  return (status);
+}
+
+/**
+ * Make many changes to an INI file in one round trip.  The daemon
+ * makes them in order, each as WritePrivateProfileString would, and
+ * stores its result in the status member.  A batch too large for one
+ * message is sent in several; if one of them fails, the changes of the
+ * earlier ones keep their results and the rest are reported as not made.
+ *
+ * @param pClient (IN) connection to the daemon
+ * @param pWrite (IN/OUT) array of changes
+ * @param nCount (IN) number of changes in the array
+ * @param pFileName (IN) Pointer to a null-terminated string
+ *  that names the initialization file, as the daemon was given it.
+ *
+ * @return number of changes that were made
+ */
+size_t profile_client_set_batch(
+  PROFILE_CLIENT *pClient,
+  PROFILE_CLIENT_WRITE *pWrite,
+  size_t nCount,
+  const char *pFileName)
+{
+  struct client_op *pOps = NULL;
+  size_t made = 0;
+  size_t i = 0;
+  size_t answered = 0;
+
+  if (!pWrite)
+    return (0);
+  if (pClient && nCount)
+    pOps = calloc(nCount,sizeof(struct client_op));
+  for (i = 0; pOps && (i < nCount); i++)
+  {
+    pOps[i].op = PROFILE_DAEMON_SET;
+    pOps[i].pAppName = pWrite[i].pAppName;
+    pOps[i].pKeyName = pWrite[i].pKeyName;
+    pOps[i].pString = pWrite[i].pString;
+  }
+  if (pOps)
+    answered = client_exchange(pClient,pOps,nCount,pFileName);
+  /* changes in a request that got no answer may or may not be made */
+  for (i = 0; i < nCount; i++)
+  {
+    pWrite[i].status = (i < answered) ? pOps[i].status : FALSE;
+    if (pWrite[i].status)
+      made++;
+  }
+  free(pOps);
+
+  return (made);
+}
+
+/**
+ * Retrieves a string from an INI file through the daemon, with the
+ * same results as GetPrivateProfileString.
+ *
+ * @param pClient (IN) connection to the daemon
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ * @param pFileName (IN) initialization filename
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t GetPrivateProfileStringClient(
+  PROFILE_CLIENT *pClient,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pFileName)
+{
+  PROFILE_REQUEST request;
+
+  request.pAppName = pAppName;
+  request.pKeyName = pKeyName;
+  request.pDefault = pDefault;
+  request.pReturnedString = pReturnedString;
+  request.nSize = nSize;
+  request.count = 0;
+  (void)profile_client_get_batch(pClient,&request,1,pFileName);
+
+  return (request.count);
+}
+
+/**
+ * Changes a string in an INI file through the daemon, with the
+ * same results as WritePrivateProfileString.
+ *
+ * @param pClient (IN) connection to the daemon
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to write, or NULL to delete the key
+ * @param pFileName (IN) initialization filename
+ *
+ * @return TRUE if the change was made
+ */
+BOOL WritePrivateProfileStringClient(
+  PROFILE_CLIENT *pClient,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  const char *pFileName)
+{
+  PROFILE_CLIENT_WRITE change;
+
+  change.pAppName = pAppName;
+  change.pKeyName = pKeyName;
+  change.pString = pString;
+  change.status = FALSE;
+
+  return (profile_client_set_batch(pClient,&change,1,pFileName) == 1);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Client of the INI lookup daemon
+ */
+#ifndef PROFILE_CLIENT_H
+#define PROFILE_CLIENT_H
+
+#include <stddef.h>
+#include "profile.h"
+
+typedef struct profile_client PROFILE_CLIENT;
+
+/* one change for profile_client_set_batch */
+typedef struct profile_client_write
+{
+  const char *pAppName;	// pointer to section name
+  const char *pKeyName;	// pointer to key name
+  const char *pString;	// pointer to string to add
+  BOOL status;	// result of the write
+} PROFILE_CLIENT_WRITE;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_CLIENT *profile_client_connect(const char *pSocketName);
+  void profile_client_close(PROFILE_CLIENT *pClient);
+
+  BOOL profile_client_get_batch(
+    PROFILE_CLIENT *pClient,
+    PROFILE_REQUEST *pRequest,
+    size_t nCount,
+    const char *pFileName);
+  size_t profile_client_set_batch(
+    PROFILE_CLIENT *pClient,
+    PROFILE_CLIENT_WRITE *pWrite,
+    size_t nCount,
+    const char *pFileName);
+
+  size_t GetPrivateProfileStringClient(
+    PROFILE_CLIENT *pClient,	// points to the daemon connection
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize,	// size of destination buffer
+    const char *pFileName); 	// points to initialization filename
+
+  BOOL WritePrivateProfileStringClient(
+    PROFILE_CLIENT *pClient,	// points to the daemon connection
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString,	// pointer to string to add
+    const char *pFileName); 	// pointer to initialization filename
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_CLIENT_H */
@@ -0,0 +1,810 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Daemon that answers INI lookups over a unix socket
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * The daemon keeps the INI files it was given parsed in the profile
+ * cache (profile_cache.h), which reads a file again when its size or
+ * time stamp changes, and answers batches of lookups and writes from
+ * clients (profile_client.h) on a unix stream socket.  Clients never
+ * parse a file, and since one thread serves every client, writes to a
+ * file are made one at a time, in the order they arrived.
+ *
+ * Each request and each answer is a 32-bit length, in the byte order
+ * of the host, followed by that many bytes:
+ *
+ *  - a request holds a 32-bit number of operations, then for each one
+ *    a byte for the operation (PROFILE_DAEMON_GET or _SET), the file
+ *    name, section name, key name, and default or new string, and for
+ *    a lookup the 32-bit size of the caller's buffer.
+ *  - a string is a 32-bit length, or PROFILE_DAEMON_NULL for NULL,
+ *    then its characters and a null character.
+ *  - an answer holds the number of operations, then for each one a
+ *    status byte, and for a lookup the 32-bit count returned by
+ *    GetPrivateProfileString and the bytes of the buffer to copy.
+ *
+ * Only files added with profile_daemon_add_file() are served, by the
+ * same name.  A lookup in any other file answers as if it were empty
+ * with a status of FALSE, and a write to it fails.
+ *
+ * A client may send many requests before it reads any answers.  Once
+ * PROFILE_DAEMON_MAX_MESSAGE bytes of answers are waiting for it, the
+ * daemon stops answering and reading until they are sent, so memory
+ * per client stays bounded.
+ */
+
+/* includes */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_daemon.h"
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+/* bytes waiting to be handled or sent */
+struct daemon_buffer
+{
+  unsigned char *pData;
+  size_t nLength; /* number of bytes in use */
+  size_t nSize; /* number of bytes allocated */
+};
+
+/* a connected client */
+struct daemon_client
+{
+  int fd;
+  struct daemon_buffer in; /* requests read so far */
+  struct daemon_buffer out; /* answers not yet sent */
+  size_t sent; /* bytes of the answers that were sent */
+};
+
+/* reads the fields of a request */
+struct daemon_cursor
+{
+  const unsigned char *pData;
+  size_t nLeft;
+  BOOL valid; /* FALSE once the request was found to be malformed */
+};
+
+struct profile_daemon
+{
+  char *pSocketName;
+  int listen_fd;
+  int stop_fd[2]; /* written to stop the daemon */
+  char **ppFiles; /* files that are served, sorted */
+  size_t nFiles;
+  struct daemon_client *pClients;
+  size_t nClients;
+  char *pAnswer; /* buffer for one lookup */
+  size_t nAnswerUsed; /* bytes of it that are not zero */
+};
+
+/**
+ * Make room in a buffer
+ *
+ * @param pBuffer - buffer
+ * @param nMore - number of bytes to add
+ *
+ * @return TRUE if there is room
+ */
+static BOOL daemon_reserve(
+  struct daemon_buffer *pBuffer,
+  size_t nMore)
+{
+  unsigned char *pData = NULL;
+  size_t size = pBuffer->nSize ? pBuffer->nSize : 256;
+
+  if (pBuffer->nLength + nMore <= pBuffer->nSize)
+    return (TRUE);
+  while (size < pBuffer->nLength + nMore)
+    size *= 2;
+  pData = realloc(pBuffer->pData,size);
+  if (!pData)
+    return (FALSE);
+  pBuffer->pData = pData;
+  pBuffer->nSize = size;
+
+  return (TRUE);
+}
+
+/**
+ * Append bytes to a buffer
+ *
+ * @param pBuffer - buffer
+ * @param pData - bytes to add
+ * @param nLength - number of bytes
+ *
+ * @return TRUE if they were added
+ */
+static BOOL daemon_put(
+  struct daemon_buffer *pBuffer,
+  const void *pData,
+  size_t nLength)
+{
+  if (!daemon_reserve(pBuffer,nLength))
+    return (FALSE);
+  if (nLength)
+    memcpy(pBuffer->pData + pBuffer->nLength,pData,nLength);
+  pBuffer->nLength += nLength;
+
+  return (TRUE);
+}
+
+/**
+ * Append a 32-bit number to a buffer
+ *
+ * @param pBuffer - buffer
+ * @param value - number
+ *
+ * @return TRUE if it was added
+ */
+static BOOL daemon_put_u32(
+  struct daemon_buffer *pBuffer,
+  uint32_t value)
+{
+  return (daemon_put(pBuffer,&value,sizeof(value)));
+}
+
+/**
+ * Read a 32-bit number from a request
+ *
+ * @param pCursor - position in the request
+ *
+ * @return the number, or 0 if the request ended
+ */
+static uint32_t daemon_get_u32(
+  struct daemon_cursor *pCursor)
+{
+  uint32_t value = 0;
+
+  if (pCursor->nLeft < sizeof(value))
+  {
+    pCursor->valid = FALSE;
+    return (0);
+  }
+  memcpy(&value,pCursor->pData,sizeof(value));
+  pCursor->pData += sizeof(value);
+  pCursor->nLeft -= sizeof(value);
+
+  return (value);
+}
+
+/**
+ * Read a string from a request
+ *
+ * @param pCursor - position in the request
+ *
+ * @return the string, which stays in the request, or NULL
+ */
+static const char *daemon_get_string(
+  struct daemon_cursor *pCursor)
+{
+  const char *pString = NULL;
+  uint32_t len = daemon_get_u32(pCursor);
+
+  if (!pCursor->valid || (len == PROFILE_DAEMON_NULL))
+    return (NULL);
+  if ((pCursor->nLeft <= len) || (pCursor->pData[len] != '\0'))
+  {
+    pCursor->valid = FALSE;
+    return (NULL);
+  }
+  pString = (const char *)pCursor->pData;
+  pCursor->pData += len + 1;
+  pCursor->nLeft -= len + 1;
+
+  return (pString);
+}
+
+/**
+ * Compare two file names for qsort and bsearch
+ *
+ * @param pA - pointer to a file name
+ * @param pB - pointer to a file name
+ *
+ * @return less than, equal to, or more than zero
+ */
+static int daemon_compare(
+  const void *pA,
+  const void *pB)
+{
+  return (strcmp(*(char * const *)pA,*(char * const *)pB));
+}
+
+/**
+ * Find out if a file is served
+ *
+ * @param pDaemon - daemon
+ * @param pFileName - file name from a request
+ *
+ * @return TRUE if it was added to the daemon
+ */
+static BOOL daemon_serves(
+  const PROFILE_DAEMON *pDaemon,
+  const char *pFileName)
+{
+  if (!pFileName || !pDaemon->nFiles)
+    return (FALSE);
+
+  return (bsearch(&pFileName,pDaemon->ppFiles,pDaemon->nFiles,
+    sizeof(char *),daemon_compare) ? TRUE : FALSE);
+}
+
+/**
+ * Create a daemon listening on a unix socket.  A socket file that
+ * no daemon answers on is replaced.  Any other kind of file at the
+ * path is left alone, and no daemon is created.
+ *
+ * @param pSocketName (IN) path of the socket
+ *
+ * @return daemon, or NULL if the socket is in use or cannot be made
+ */
+PROFILE_DAEMON *profile_daemon_create(
+  const char *pSocketName)
+{
+  PROFILE_DAEMON *pDaemon = NULL;
+  struct sockaddr_un addr;
+  struct stat st;
+  int fd = -1;
+
+  if (!pSocketName || (strlen(pSocketName) >= sizeof(addr.sun_path)))
+    return (NULL);
+  memset(&addr,0,sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path,pSocketName);
+  /* don't take the socket of a daemon that is running */
+  fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if (fd < 0)
+    return (NULL);
+  if (connect(fd,(struct sockaddr *)&addr,sizeof(addr)) == 0)
+  {
+    close(fd);
+    return (NULL);
+  }
+  close(fd);
+  pDaemon = calloc(1,sizeof(PROFILE_DAEMON));
+  if (!pDaemon)
+    return (NULL);
+  pDaemon->listen_fd = -1;
+  pDaemon->stop_fd[0] = -1;
+  pDaemon->stop_fd[1] = -1;
+  pDaemon->pSocketName = malloc(strlen(pSocketName) + 1);
+  pDaemon->pAnswer = calloc(1,PROFILE_DAEMON_MAX_SIZE);
+  if (!pDaemon->pSocketName || !pDaemon->pAnswer ||
+    (pipe(pDaemon->stop_fd) != 0))
+  {
+    profile_daemon_free(pDaemon);
+    return (NULL);
+  }
+  strcpy(pDaemon->pSocketName,pSocketName);
+  /* a stale socket is replaced; anything else there makes bind fail */
+  if ((lstat(pSocketName,&st) == 0) && S_ISSOCK(st.st_mode))
+    unlink(pSocketName);
+  pDaemon->listen_fd = socket(AF_UNIX,SOCK_STREAM,0);
+  if ((pDaemon->listen_fd < 0) ||
+    (fcntl(pDaemon->listen_fd,F_SETFL,O_NONBLOCK) != 0) ||
+    (bind(pDaemon->listen_fd,(struct sockaddr *)&addr,sizeof(addr)) != 0))
+  {
+    /* not ours to remove */
+    free(pDaemon->pSocketName);
+    pDaemon->pSocketName = NULL;
+    profile_daemon_free(pDaemon);
+    return (NULL);
+  }
+  if (listen(pDaemon->listen_fd,SOMAXCONN) != 0)
+  {
+    profile_daemon_free(pDaemon);
+    return (NULL);
+  }
+
+  return (pDaemon);
+}
+
+/**
+ * Serve an INI file, and load it into the cache if it exists.
+ * Call this before profile_daemon_run().
+ *
+ * @param pDaemon (IN) daemon
+ * @param pFileName (IN) name of the file, as clients will give it
+ *
+ * @return TRUE if the file is served
+ */
+BOOL profile_daemon_add_file(
+  PROFILE_DAEMON *pDaemon,
+  const char *pFileName)
+{
+  char **ppFiles = NULL;
+  char *pCopy = NULL;
+
+  if (!pDaemon || !pFileName)
+    return (FALSE);
+  if (daemon_serves(pDaemon,pFileName))
+    return (TRUE);
+  ppFiles = realloc(pDaemon->ppFiles,
+    (pDaemon->nFiles + 1) * sizeof(char *));
+  if (!ppFiles)
+    return (FALSE);
+  pDaemon->ppFiles = ppFiles;
+  pCopy = malloc(strlen(pFileName) + 1);
+  if (!pCopy)
+    return (FALSE);
+  strcpy(pCopy,pFileName);
+  ppFiles[pDaemon->nFiles++] = pCopy;
+  qsort(ppFiles,pDaemon->nFiles,sizeof(char *),daemon_compare);
+  (void)profile_cache_load(pFileName);
+
+  return (TRUE);
+}
+
+/**
+ * Answer one lookup
+ *
+ * @param pDaemon - daemon
+ * @param pCursor - position of the lookup in the request
+ * @param pOut - answers to the client
+ *
+ * @return TRUE if the lookup was well formed and answered
+ */
+static BOOL daemon_get(
+  PROFILE_DAEMON *pDaemon,
+  struct daemon_cursor *pCursor,
+  struct daemon_buffer *pOut)
+{
+  const char *pFileName = daemon_get_string(pCursor);
+  const char *pAppName = daemon_get_string(pCursor);
+  const char *pKeyName = daemon_get_string(pCursor);
+  const char *pDefault = daemon_get_string(pCursor);
+  size_t nSize = daemon_get_u32(pCursor);
+  size_t count = 0;
+  size_t len = 0;
+  unsigned char status = TRUE;
+
+  if (!pCursor->valid)
+    return (FALSE);
+  if (nSize > PROFILE_DAEMON_MAX_SIZE)
+    nSize = PROFILE_DAEMON_MAX_SIZE;
+  /* bytes past the answer are sent as zeros */
+  memset(pDaemon->pAnswer,0,pDaemon->nAnswerUsed);
+  if (nSize < 2)
+  {
+    /* too small for a list and its two nulls, as in profile_doc_get */
+    status = daemon_serves(pDaemon,pFileName);
+  }
+  else if (daemon_serves(pDaemon,pFileName))
+    count = GetPrivateProfileStringCached(pAppName,pKeyName,pDefault,
+      pDaemon->pAnswer,nSize,pFileName);
+  else
+  {
+    count = GetPrivateProfileStringFromBuffer(pAppName,pKeyName,pDefault,
+      pDaemon->pAnswer,nSize,"",0);
+    status = FALSE;
+  }
+  /* the answer and its one or two null characters */
+  len = count + 2;
+  if (len > nSize)
+    len = nSize;
+  pDaemon->nAnswerUsed = len;
+
+  return (daemon_put(pOut,&status,1) &&
+    daemon_put_u32(pOut,(uint32_t)count) &&
+    daemon_put_u32(pOut,(uint32_t)len) &&
+    daemon_put(pOut,pDaemon->pAnswer,len));
+}
+
+/**
+ * Make one write
+ *
+ * @param pDaemon - daemon
+ * @param pCursor - position of the write in the request
+ * @param pOut - answers to the client
+ *
+ * @return TRUE if the write was well formed and answered
+ */
+static BOOL daemon_set(
+  PROFILE_DAEMON *pDaemon,
+  struct daemon_cursor *pCursor,
+  struct daemon_buffer *pOut)
+{
+  const char *pFileName = daemon_get_string(pCursor);
+  const char *pAppName = daemon_get_string(pCursor);
+  const char *pKeyName = daemon_get_string(pCursor);
+  const char *pString = daemon_get_string(pCursor);
+  unsigned char status = FALSE;
+
+  if (!pCursor->valid)
+    return (FALSE);
+  if (daemon_serves(pDaemon,pFileName))
+  {
+    status = WritePrivateProfileString(pAppName,pKeyName,pString,
+      pFileName) ? TRUE : FALSE;
+    profile_cache_invalidate(pFileName);
+  }
+
+  return (daemon_put(pOut,&status,1));
+}
+
+/**
+ * Handle one request and queue its answer
+ *
+ * @param pDaemon - daemon
+ * @param pRequest - request, without its length
+ * @param nLength - number of bytes in the request
+ * @param pOut - answers to the client
+ *
+ * @return FALSE if the request was malformed or the answer too large
+ */
+static BOOL daemon_request(
+  PROFILE_DAEMON *pDaemon,
+  const unsigned char *pRequest,
+  size_t nLength,
+  struct daemon_buffer *pOut)
+{
+  struct daemon_cursor cursor;
+  size_t start = pOut->nLength;
+  uint32_t count = 0;
+  uint32_t i = 0;
+  BOOL status = TRUE;
+
+  cursor.pData = pRequest;
+  cursor.nLeft = nLength;
+  cursor.valid = TRUE;
+  count = daemon_get_u32(&cursor);
+  /* the length is filled in at the end */
+  status = cursor.valid && daemon_put_u32(pOut,0) &&
+    daemon_put_u32(pOut,count);
+  for (i = 0; status && (i < count); i++)
+  {
+    if (cursor.nLeft < 1)
+      status = FALSE;
+    else if (*cursor.pData == PROFILE_DAEMON_GET)
+    {
+      cursor.pData++;
+      cursor.nLeft--;
+      status = daemon_get(pDaemon,&cursor,pOut);
+    }
+    else if (*cursor.pData == PROFILE_DAEMON_SET)
+    {
+      cursor.pData++;
+      cursor.nLeft--;
+      status = daemon_set(pDaemon,&cursor,pOut);
+    }
+    else
+      status = FALSE;
+    if (pOut->nLength - start - sizeof(uint32_t) >
+      PROFILE_DAEMON_MAX_MESSAGE)
+      status = FALSE;
+  }
+  if (!status || cursor.nLeft)
+    return (FALSE);
+  nLength = pOut->nLength - start - sizeof(uint32_t);
+  count = (uint32_t)nLength;
+  memcpy(pOut->pData + start,&count,sizeof(count));
+
+  return (TRUE);
+}
+
+/**
+ * Send what a client can take of its answers
+ *
+ * @param pClient - client
+ *
+ * @return FALSE if the client went away
+ */
+static BOOL daemon_flush(
+  struct daemon_client *pClient)
+{
+  ssize_t sent = 0;
+
+  while (pClient->sent < pClient->out.nLength)
+  {
+    sent = send(pClient->fd,pClient->out.pData + pClient->sent,
+      pClient->out.nLength - pClient->sent,MSG_NOSIGNAL);
+    if (sent > 0)
+      pClient->sent += (size_t)sent;
+    else if ((sent < 0) && (errno == EINTR))
+      continue;
+    else if ((sent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+      return (TRUE);
+    else
+      return (FALSE);
+  }
+  pClient->out.nLength = 0;
+  pClient->sent = 0;
+
+  return (TRUE);
+}
+
+/**
+ * Answer the whole requests a client has sent, until the answers that
+ * wait to be sent reach PROFILE_DAEMON_MAX_MESSAGE bytes.  The other
+ * requests stay in the input until those answers have been sent.
+ *
+ * @param pDaemon - daemon
+ * @param pClient - client
+ *
+ * @return FALSE if the client broke the protocol
+ */
+static BOOL daemon_answer(
+  PROFILE_DAEMON *pDaemon,
+  struct daemon_client *pClient)
+{
+  uint32_t length = 0;
+  size_t used = 0;
+
+  while ((pClient->out.nLength < PROFILE_DAEMON_MAX_MESSAGE) &&
+    (pClient->in.nLength - used >= sizeof(length)))
+  {
+    memcpy(&length,pClient->in.pData + used,sizeof(length));
+    if (length > PROFILE_DAEMON_MAX_MESSAGE)
+      return (FALSE);
+    if (pClient->in.nLength - used - sizeof(length) < length)
+      break;
+    if (!daemon_request(pDaemon,pClient->in.pData + used + sizeof(length),
+      length,&pClient->out))
+      return (FALSE);
+    used += sizeof(length) + length;
+  }
+  if (used)
+  {
+    memmove(pClient->in.pData,pClient->in.pData + used,
+      pClient->in.nLength - used);
+    pClient->in.nLength -= used;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Send what a client can take of its answers, answer the requests
+ * that waited for them, and read more once none are left.  Requests
+ * are not read or answered while answers are waiting, so a client that
+ * doesn't read its answers can't make the daemon hold more of them.
+ *
+ * @param pDaemon - daemon
+ * @param pClient - client
+ *
+ * @return FALSE if the client went away or broke the protocol
+ */
+static BOOL daemon_serve(
+  PROFILE_DAEMON *pDaemon,
+  struct daemon_client *pClient)
+{
+  ssize_t received = 0;
+  BOOL receive = TRUE; /* TRUE until the socket has been read */
+
+  for (;;)
+  {
+    if (!daemon_flush(pClient))
+      return (FALSE);
+    if (pClient->out.nLength)
+      return (TRUE);
+    if (!daemon_answer(pDaemon,pClient))
+      return (FALSE);
+    if (pClient->out.nLength)
+      continue;
+    /* no whole request is left */
+    if (!receive)
+      return (TRUE);
+    receive = FALSE;
+    if (!daemon_reserve(&pClient->in,4096))
+      return (FALSE);
+    received = recv(pClient->fd,pClient->in.pData + pClient->in.nLength,
+      pClient->in.nSize - pClient->in.nLength,0);
+    if (received == 0)
+      return (FALSE);
+    if (received < 0)
+      return ((errno == EINTR) || (errno == EAGAIN) ||
+        (errno == EWOULDBLOCK));
+    pClient->in.nLength += (size_t)received;
+  }
+}
+
+/**
+ * Disconnect a client
+ *
+ * @param pDaemon - daemon
+ * @param index - index of the client
+ */
+static void daemon_drop(
+  PROFILE_DAEMON *pDaemon,
+  size_t index)
+{
+  struct daemon_client *pClient = &pDaemon->pClients[index];
+
+  close(pClient->fd);
+  free(pClient->in.pData);
+  free(pClient->out.pData);
+  pDaemon->nClients--;
+  pDaemon->pClients[index] = pDaemon->pClients[pDaemon->nClients];
+}
+
+/**
+ * Accept the clients that are waiting to connect
+ *
+ * @param pDaemon - daemon
+ */
+static void daemon_accept(
+  PROFILE_DAEMON *pDaemon)
+{
+  struct daemon_client *pClients = NULL;
+  int fd = -1;
+
+  for (;;)
+  {
+    fd = accept(pDaemon->listen_fd,NULL,NULL);
+    if (fd < 0)
+      break;
+    pClients = realloc(pDaemon->pClients,
+      (pDaemon->nClients + 1) * sizeof(struct daemon_client));
+    if (!pClients || (fcntl(fd,F_SETFL,O_NONBLOCK) != 0))
+    {
+      if (pClients)
+        pDaemon->pClients = pClients;
+      close(fd);
+      continue;
+    }
+    pDaemon->pClients = pClients;
+    memset(&pClients[pDaemon->nClients],0,sizeof(struct daemon_client));
+    pClients[pDaemon->nClients].fd = fd;
+    pDaemon->nClients++;
+  }
+}
+
+/**
+ * Serve clients until profile_daemon_stop() is called.
+ *
+ * @param pDaemon (IN) daemon
+ *
+ * @return TRUE if it was stopped, FALSE if it failed
+ */
+BOOL profile_daemon_run(
+  PROFILE_DAEMON *pDaemon)
+{
+  struct pollfd *pPoll = NULL;
+  struct pollfd *pNew = NULL;
+  size_t nPoll = 0;
+  size_t nClients = 0;
+  size_t i = 0;
+  char stop = 0;
+  BOOL status = TRUE;
+
+  if (!pDaemon)
+    return (FALSE);
+  for (;;)
+  {
+    nClients = pDaemon->nClients;
+    if (nPoll < nClients + 2)
+    {
+      pNew = realloc(pPoll,(nClients + 2) * sizeof(struct pollfd));
+      if (!pNew)
+      {
+        status = FALSE;
+        break;
+      }
+      pPoll = pNew;
+      nPoll = nClients + 2;
+    }
+    pPoll[0].fd = pDaemon->stop_fd[0];
+    pPoll[0].events = POLLIN;
+    pPoll[1].fd = pDaemon->listen_fd;
+    pPoll[1].events = POLLIN;
+    for (i = 0; i < nClients; i++)
+    {
+      pPoll[i + 2].fd = pDaemon->pClients[i].fd;
+      pPoll[i + 2].events = pDaemon->pClients[i].out.nLength ?
+        POLLOUT : POLLIN;
+    }
+    if (poll(pPoll,nClients + 2,-1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      status = FALSE;
+      break;
+    }
+    if (pPoll[0].revents)
+    {
+      if (read(pDaemon->stop_fd[0],&stop,1) < 0)
+        status = FALSE;
+      break;
+    }
+    /* clients from the end, since dropping one moves the last */
+    for (i = nClients; i > 0; i--)
+    {
+      if (pPoll[i + 1].revents &&
+        !daemon_serve(pDaemon,&pDaemon->pClients[i - 1]))
+        daemon_drop(pDaemon,i - 1);
+    }
+    if (pPoll[1].revents)
+      daemon_accept(pDaemon);
+  }
+  free(pPoll);
+
+  return (status);
+}
+
+/**
+ * Make profile_daemon_run() return.  This may be called from another
+ * thread or from a signal handler.
+ *
+ * @param pDaemon (IN) daemon
+ */
+void profile_daemon_stop(
+  PROFILE_DAEMON *pDaemon)
+{
+  char stop = 0;
+  ssize_t written = 0;
+
+  if (pDaemon)
+    written = write(pDaemon->stop_fd[1],&stop,1);
+  (void)written;
+}
+
+/**
+ * Disconnect every client, remove the socket, and free the daemon.
+ *
+ * @param pDaemon (IN) daemon, or NULL
+ */
+void profile_daemon_free(
+  PROFILE_DAEMON *pDaemon)
+{
+  size_t i = 0;
+
+  if (!pDaemon)
+    return;
+  while (pDaemon->nClients)
+    daemon_drop(pDaemon,pDaemon->nClients - 1);
+  free(pDaemon->pClients);
+  if (pDaemon->listen_fd >= 0)
+    close(pDaemon->listen_fd);
+  if (pDaemon->pSocketName)
+    unlink(pDaemon->pSocketName);
+  if (pDaemon->stop_fd[0] >= 0)
+    close(pDaemon->stop_fd[0]);
+  if (pDaemon->stop_fd[1] >= 0)
+    close(pDaemon->stop_fd[1]);
+  for (i = 0; i < pDaemon->nFiles; i++)
+  {
+    profile_cache_invalidate(pDaemon->ppFiles[i]);
+    free(pDaemon->ppFiles[i]);
+  }
+  free(pDaemon->ppFiles);
+  free(pDaemon->pSocketName);
+  free(pDaemon->pAnswer);
+  free(pDaemon);
+}
@@ -0,0 +1,44 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Daemon that answers INI lookups over a unix socket
+ */
+#ifndef PROFILE_DAEMON_H
+#define PROFILE_DAEMON_H
+
+#include <stddef.h>
+#include "profile.h"
+
+/* operations in a request */
+#define PROFILE_DAEMON_GET 'G'
+#define PROFILE_DAEMON_SET 'S'
+/* length that stands for a NULL string */
+#define PROFILE_DAEMON_NULL 0xFFFFFFFFUL
+
+/* largest request or answer, not counting its length */
+#ifndef PROFILE_DAEMON_MAX_MESSAGE
+#define PROFILE_DAEMON_MAX_MESSAGE (1024UL * 1024UL)
+#endif
+/* largest buffer that one lookup may fill */
+#ifndef PROFILE_DAEMON_MAX_SIZE
+#define PROFILE_DAEMON_MAX_SIZE 65536UL
+#endif
+
+typedef struct profile_daemon PROFILE_DAEMON;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_DAEMON *profile_daemon_create(const char *pSocketName);
+  BOOL profile_daemon_add_file(
+    PROFILE_DAEMON *pDaemon,
+    const char *pFileName);
+  BOOL profile_daemon_run(PROFILE_DAEMON *pDaemon);
+  void profile_daemon_stop(PROFILE_DAEMON *pDaemon);
+  void profile_daemon_free(PROFILE_DAEMON *pDaemon);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_DAEMON_H */
@@ -0,0 +1,427 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief C++20 tables of default values parsed from INI text at compile time
+ *
+ * profile::defaults<"...">, given INI text as a string literal, is a
+ * table of its sections, keys and values that the compiler builds.
+ * Lines are read with the same rules as GetPrivateProfileString: they
+ * are trimmed the way rmlead and rmtrail trim them, lines starting with
+ * ';' are comments, and a value has its enclosing quotes removed the
+ * way rmquotes removes them.  Only the first section of a given name
+ * and the first key of a given name within it are kept.
+ *
+ * The table holds the names and values only, each ending with a null,
+ * so neither the INI text nor any parsing code ends up in the program.
+ * Its keys are in a hash table with room to spare, so a lookup with
+ * names known at run time is usually a single probe, and a lookup in a
+ * constant expression is folded into its answer.
+ * {@code
+ * constexpr auto &Defaults = profile::defaults<R"ini(
+ * [Network]
+ * Port = 47808
+ * Name = "BACnet Router"
+ * )ini">;
+ * static_assert(Defaults.get("network", "port") == "47808");
+ * }
+ */
+#ifndef PROFILE_DEFAULTS_HPP
+#define PROFILE_DEFAULTS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace profile
+{
+  /* a string literal that can be a template argument */
+  template <std::size_t N>
+  struct fixed_string
+  {
+    char text[N];
+
+    consteval fixed_string(const char (&literal)[N])
+    {
+      for (std::size_t i = 0; i < N; i++)
+        text[i] = literal[i];
+    }
+
+    constexpr std::string_view view() const
+    {
+      return std::string_view(text, N - 1);
+    }
+  };
+
+  /* a key of a table, as returned by default_table::operator[] */
+  struct default_entry
+  {
+    std::string_view section;
+    std::string_view key;
+    std::string_view value; /* empty for a line without '=' */
+    bool has_value;
+  };
+
+  namespace detail
+  {
+    /* isspace in the "C" locale */
+    constexpr bool is_space(char c)
+    {
+      return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\v') ||
+        (c == '\f') || (c == '\r');
+    }
+
+    /* the same folding as strfold: only A to Z */
+    constexpr char fold(char c)
+    {
+      return ((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c - 'A' + 'a') :
+        c;
+    }
+
+    constexpr bool equal(std::string_view a, std::string_view b)
+    {
+      if (a.size() != b.size())
+        return false;
+      for (std::size_t i = 0; i < a.size(); i++)
+      {
+        if (fold(a[i]) != fold(b[i]))
+          return false;
+      }
+      return true;
+    }
+
+    /* FNV-1a of a folded name */
+    constexpr std::uint32_t hash(std::string_view name,
+      std::uint32_t value = 2166136261U)
+    {
+      for (char c : name)
+      {
+        value ^= static_cast<unsigned char>(fold(c));
+        value *= 16777619U;
+      }
+      return value;
+    }
+
+    constexpr std::uint32_t hash_pair(std::string_view app,
+      std::string_view key)
+    {
+      /* keep "ab","c" apart from "a","bc" */
+      return hash(key, (hash(app) ^ 0xFFU) * 16777619U);
+    }
+
+    /* string_view::find, which some compilers cannot run at compile
+       time on a template argument */
+    constexpr std::size_t find(std::string_view text, char c)
+    {
+      for (std::size_t i = 0; i < text.size(); i++)
+      {
+        if (text[i] == c)
+          return i;
+      }
+      return std::string_view::npos;
+    }
+
+    /* rmlead and rmtrail */
+    constexpr std::string_view trim(std::string_view text)
+    {
+      while (!text.empty() && is_space(text.front()))
+        text.remove_prefix(1);
+      while (!text.empty() && is_space(text.back()))
+        text.remove_suffix(1);
+      return text;
+    }
+
+    /* rmquotes */
+    constexpr std::string_view unquote(std::string_view text)
+    {
+      if ((text.size() > 1) &&
+        (((text.front() == '\'') && (text.back() == '\'')) ||
+        ((text.front() == '\"') && (text.back() == '\"'))))
+        return text.substr(1, text.size() - 2);
+      return text;
+    }
+
+    /* one line of INI text */
+    struct line
+    {
+      enum kind_type { blank, section, malformed, entry } kind;
+      std::string_view name;
+      std::string_view value;
+      bool has_value;
+    };
+
+    /* read a line the way profile_doc_parse does */
+    constexpr line parse_line(std::string_view text)
+    {
+      line result = {line::blank, {}, {}, false};
+      std::size_t equal_sign;
+
+      text = trim(text);
+      if (text.empty() || (text.front() == ';'))
+        return result;
+      if (text.front() == '[')
+      {
+        if ((text.size() > 1) && (text.back() == ']'))
+        {
+          result.kind = line::section;
+          result.name = text.substr(1, text.size() - 2);
+        }
+        else
+          result.kind = line::malformed;
+        return result;
+      }
+      result.kind = line::entry;
+      equal_sign = find(text, '=');
+      result.has_value = (equal_sign != std::string_view::npos);
+      result.name = trim(text.substr(0, equal_sign));
+      if (result.has_value)
+        result.value = unquote(trim(text.substr(equal_sign + 1)));
+      return result;
+    }
+
+    /* call a function for each line of the text */
+    template <class Function>
+    constexpr void for_each_line(std::string_view text, Function function)
+    {
+      std::size_t end;
+
+      while (!text.empty())
+      {
+        end = find(text, '\n');
+        if (end == std::string_view::npos)
+          end = text.size();
+        function(parse_line(text.substr(0, end)));
+        text.remove_prefix((end < text.size()) ? end + 1 : end);
+      }
+    }
+
+    /* room a table needs, counting repeated names as if they were new */
+    struct table_size
+    {
+      std::size_t sections;
+      std::size_t entries;
+      std::size_t chars;
+    };
+
+    constexpr table_size measure(std::string_view text)
+    {
+      table_size size = {0, 0, 0};
+      bool in_section = false;
+
+      for_each_line(text, [&](const line &current)
+      {
+        if (current.kind == line::section)
+        {
+          size.sections++;
+          size.chars += current.name.size() + 1;
+          in_section = true;
+        }
+        else if (current.kind == line::malformed)
+          in_section = false;
+        else if ((current.kind == line::entry) && in_section)
+        {
+          size.entries++;
+          size.chars += current.name.size() + current.value.size() + 2;
+        }
+      });
+      return size;
+    }
+
+    /* a power of two at least twice the keys, so one is always empty */
+    constexpr std::size_t bucket_count(std::size_t entries)
+    {
+      std::size_t buckets = 1;
+
+      while (buckets < (entries * 2))
+        buckets *= 2;
+      return buckets;
+    }
+  } // namespace detail
+
+  /**
+   * A table of sections, keys and values, built at compile time.
+   * Use profile::defaults<"..."> rather than naming this type.
+   */
+  template <std::size_t Sections, std::size_t Entries, std::size_t Chars>
+  class default_table
+  {
+  public:
+    consteval explicit default_table(std::string_view text)
+    {
+      std::size_t section = 0;
+      bool in_section = false;
+
+      detail::for_each_line(text, [&](const detail::line &current)
+      {
+        if (current.kind == detail::line::section)
+        {
+          /* a repeated section is skipped, keys and all */
+          in_section = !find_section(current.name, section);
+          if (in_section)
+          {
+            section = section_count_++;
+            sections_[section] = store(current.name);
+          }
+        }
+        else if (current.kind == detail::line::malformed)
+          in_section = false;
+        else if ((current.kind == detail::line::entry) && in_section)
+          add(section, current);
+      });
+    }
+
+    /* number of keys */
+    constexpr std::size_t size() const noexcept
+    {
+      return count_;
+    }
+
+    constexpr std::size_t section_count() const noexcept
+    {
+      return section_count_;
+    }
+
+    /* a key, in the order of the text */
+    constexpr default_entry operator[](std::size_t index) const noexcept
+    {
+      const record &item = records_[index];
+
+      return {text(sections_[item.section]), text(item.key),
+        text(item.value), item.has_value};
+    }
+
+    constexpr bool contains(std::string_view app, std::string_view key)
+      const noexcept
+    {
+      return find(app, key) < count_;
+    }
+
+    /**
+     * Value of a key.  The value ends with a null, so its data() can be
+     * passed to the C functions, as the pDefault of
+     * GetPrivateProfileString for example.
+     *
+     * @param app - section name, independent of case
+     * @param key - key name, independent of case
+     * @param def - returned if the key is missing or has no value
+     *
+     * @return value
+     */
+    constexpr std::string_view get(std::string_view app,
+      std::string_view key, std::string_view def = {}) const noexcept
+    {
+      std::size_t index = find(app, key);
+
+      return ((index < count_) && records_[index].has_value) ?
+        text(records_[index].value) : def;
+    }
+
+  private:
+    static constexpr std::size_t Buckets = detail::bucket_count(Entries);
+
+    /* where a string is in chars_ */
+    struct span
+    {
+      std::uint32_t offset;
+      std::uint32_t length;
+    };
+
+    struct record
+    {
+      std::uint32_t section; /* index in sections_ */
+      span key;
+      span value;
+      bool has_value;
+    };
+
+    constexpr std::string_view text(span where) const noexcept
+    {
+      return std::string_view(chars_.data() + where.offset, where.length);
+    }
+
+    constexpr span store(std::string_view value)
+    {
+      span where = {static_cast<std::uint32_t>(used_),
+        static_cast<std::uint32_t>(value.size())};
+
+      for (char c : value)
+        chars_[used_++] = c;
+      chars_[used_++] = '\0';
+      return where;
+    }
+
+    constexpr bool find_section(std::string_view app, std::size_t &index)
+      const noexcept
+    {
+      for (index = 0; index < section_count_; index++)
+      {
+        if (detail::equal(text(sections_[index]), app))
+          return true;
+      }
+      return false;
+    }
+
+    /* index of a key in records_, or count_ if it is not there */
+    constexpr std::size_t find(std::string_view app,
+      std::string_view key) const noexcept
+    {
+      std::size_t bucket = detail::hash_pair(app, key) & (Buckets - 1);
+      std::size_t index;
+
+      /* linear probing; there is always an empty bucket */
+      while (buckets_[bucket])
+      {
+        index = buckets_[bucket] - 1;
+        if (detail::equal(text(records_[index].key), key) &&
+          detail::equal(text(sections_[records_[index].section]), app))
+          return index;
+        bucket = (bucket + 1) & (Buckets - 1);
+      }
+      return count_;
+    }
+
+    constexpr void add(std::size_t section, const detail::line &current)
+    {
+      std::string_view app = text(sections_[section]);
+      std::size_t bucket;
+
+      /* only the first key of a name counts */
+      if (find(app, current.name) < count_)
+        return;
+      records_[count_] = {static_cast<std::uint32_t>(section),
+        store(current.name), store(current.value), current.has_value};
+      bucket = detail::hash_pair(app, current.name) & (Buckets - 1);
+      while (buckets_[bucket])
+        bucket = (bucket + 1) & (Buckets - 1);
+      buckets_[bucket] = static_cast<std::uint32_t>(++count_);
+    }
+
+    std::array<char, Chars> chars_ = {};
+    std::array<span, Sections> sections_ = {};
+    std::array<record, Entries> records_ = {};
+    std::array<std::uint32_t, Buckets> buckets_ = {}; /* index + 1 */
+    std::size_t used_ = 0;
+    std::size_t section_count_ = 0;
+    std::size_t count_ = 0;
+  };
+
+  /**
+   * Build a table from INI text at compile time
+   *
+   * @return table
+   */
+  template <fixed_string Text>
+  consteval auto make_defaults()
+  {
+    constexpr detail::table_size size = detail::measure(Text.view());
+
+    return default_table<size.sections, size.entries, size.chars>(
+      Text.view());
+  }
+
+  /* the table of INI text given as a string literal */
+  template <fixed_string Text>
+  inline constexpr auto defaults = make_defaults<Text>();
+} // namespace profile
+
+#endif /* PROFILE_DEFAULTS_HPP */
@@ -0,0 +1,495 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Differences between two versions of an INI file
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * Two documents are compared by looking up each section and key of one
+ * in the hash index of the other, with names matched the way
+ * GetPrivateProfileString matches them, so the cost is linear in the
+ * size of the two documents.  A section or key whose name only changed
+ * case is the same one, and a value is changed when its characters are.
+ *
+ * The changes are reported in two passes: first what is gone, in the
+ * order of the old document, then what is new or changed, in the order
+ * of the new one.  A section that was added or removed is reported
+ * first, then each of its keys.
+ *
+ * A watch keeps the last version of a file it has read.  Each poll
+ * stats the file, the same way the profile cache does, and only when
+ * the size or change time differ reads it again and tells the
+ * subscribers what changed.  A watch belongs to the thread that polls
+ * it, and the subscribers are called on that thread.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "profile_diff.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+/* one subscriber of a watch */
+struct watch_subscriber
+{
+  PROFILE_DIFF_CALLBACK pCallback; /* NULL once unsubscribed in a poll */
+  void *pContext;
+  struct watch_subscriber *pNext;
+};
+
+struct profile_watch
+{
+  char *pFileName;
+  PROFILE_DOC *pDoc; /* the file when it was last read, or NULL */
+  PROFILE_IO_STAT file_stat; /* the file when it was last read */
+  struct watch_subscriber *pSubscribers;
+  BOOL notifying; /* TRUE while a poll tells the subscribers */
+};
+
+/* a diff in progress */
+struct diff_state
+{
+  PROFILE_DIFF_CALLBACK pCallback;
+  void *pContext;
+  size_t count; /* number of changes so far */
+};
+
+/**
+ * Report one change
+ *
+ * @param pState - diff in progress
+ * @param type - PROFILE_DIFF_SECTION_ADDED and so on
+ * @param pAppName - section name
+ * @param pKeyName - key name, or NULL for a section
+ * @param pOldValue - value before, or NULL
+ * @param pNewValue - value after, or NULL
+ */
+static void diff_report(
+  struct diff_state *pState,
+  int type,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pOldValue,
+  const char *pNewValue)
+{
+  PROFILE_CHANGE change;
+
+  pState->count++;
+  if (!pState->pCallback)
+    return;
+  change.type = type;
+  change.pAppName = pAppName;
+  change.pKeyName = pKeyName;
+  change.pOldValue = pOldValue;
+  change.pNewValue = pNewValue;
+  pState->pCallback(&change,pState->pContext);
+}
+
+/**
+ * Report a section and every key in it
+ *
+ * @param pState - diff in progress
+ * @param pSection - section
+ * @param added - TRUE if the section was added, FALSE if removed
+ */
+static void diff_section(
+  struct diff_state *pState,
+  const PROFILE_SECTION *pSection,
+  BOOL added)
+{
+  const char *pAppName = profile_section_name(pSection);
+  PROFILE_ENTRY *pEntry;
+
+  diff_report(pState,added ? PROFILE_DIFF_SECTION_ADDED :
+    PROFILE_DIFF_SECTION_REMOVED,pAppName,NULL,NULL,NULL);
+  for (pEntry = profile_section_first(pSection); pEntry;
+    pEntry = profile_entry_next(pEntry))
+  {
+    if (added)
+      diff_report(pState,PROFILE_DIFF_KEY_ADDED,pAppName,
+        profile_entry_key(pEntry),NULL,profile_entry_value(pEntry));
+    else
+      diff_report(pState,PROFILE_DIFF_KEY_REMOVED,pAppName,
+        profile_entry_key(pEntry),profile_entry_value(pEntry),NULL);
+  }
+}
+
+/**
+ * Compare two values, either of which may be NULL for a line
+ * without '='
+ *
+ * @param pOld - value before
+ * @param pNew - value after
+ *
+ * @return TRUE if they are the same
+ */
+static BOOL diff_same_value(
+  const char *pOld,
+  const char *pNew)
+{
+  if (!pOld || !pNew)
+    return (pOld == pNew);
+
+  return (strcmp(pOld,pNew) == 0);
+}
+
+/**
+ * Find what changed from one version of an INI file to another, and
+ * report each change to a callback.  The names and values passed to
+ * the callback belong to the documents, and are valid while they are.
+ *
+ * @param pOld (IN) old version, or NULL for no file
+ * @param pNew (IN) new version, or NULL for no file
+ * @param pCallback (IN) called for each change, may be NULL to only
+ *  count them
+ * @param pContext (IN) passed to the callback
+ *
+ * @return number of changes; 0 if the versions are the same
+ */
+size_t profile_diff(
+  const PROFILE_DOC *pOld,
+  const PROFILE_DOC *pNew,
+  PROFILE_DIFF_CALLBACK pCallback,
+  void *pContext)
+{
+  struct diff_state state;
+  PROFILE_SECTION *pSection;
+  PROFILE_SECTION *pOther;
+  PROFILE_ENTRY *pEntry;
+  PROFILE_ENTRY *pMatch;
+  const char *pAppName;
+
+  state.pCallback = pCallback;
+  state.pContext = pContext;
+  state.count = 0;
+  /* what is gone */
+  for (pSection = profile_doc_first(pOld); pSection;
+    pSection = profile_section_next(pSection))
+  {
+    pAppName = profile_section_name(pSection);
+    pOther = pNew ? profile_doc_section(pNew,pAppName) : NULL;
+    if (!pOther)
+    {
+      diff_section(&state,pSection,FALSE);
+      continue;
+    }
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry))
+    {
+      if (!profile_doc_entry(pNew,pAppName,profile_entry_key(pEntry)))
+        diff_report(&state,PROFILE_DIFF_KEY_REMOVED,pAppName,
+          profile_entry_key(pEntry),profile_entry_value(pEntry),NULL);
+    }
+  }
+  /* what is new or changed */
+  for (pSection = profile_doc_first(pNew); pSection;
+    pSection = profile_section_next(pSection))
+  {
+    pAppName = profile_section_name(pSection);
+    pOther = pOld ? profile_doc_section(pOld,pAppName) : NULL;
+    if (!pOther)
+    {
+      diff_section(&state,pSection,TRUE);
+      continue;
+    }
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry))
+    {
+      pMatch = profile_doc_entry(pOld,pAppName,profile_entry_key(pEntry));
+      if (!pMatch)
+        diff_report(&state,PROFILE_DIFF_KEY_ADDED,pAppName,
+          profile_entry_key(pEntry),NULL,profile_entry_value(pEntry));
+      else if (!diff_same_value(profile_entry_value(pMatch),
+        profile_entry_value(pEntry)))
+        diff_report(&state,PROFILE_DIFF_KEY_CHANGED,pAppName,
+          profile_entry_key(pEntry),profile_entry_value(pMatch),
+          profile_entry_value(pEntry));
+    }
+  }
+
+  return (state.count);
+}
+
+/**
+ * Find what changed from one INI file to another, the same way as
+ * profile_diff.  A file that cannot be read counts as an empty one.
+ *
+ * @param pOldFileName (IN) old version
+ * @param pNewFileName (IN) new version
+ * @param pCallback (IN) called for each change, may be NULL
+ * @param pContext (IN) passed to the callback
+ *
+ * @return number of changes
+ */
+size_t profile_diff_files(
+  const char *pOldFileName,
+  const char *pNewFileName,
+  PROFILE_DIFF_CALLBACK pCallback,
+  void *pContext)
+{
+  PROFILE_DOC *pOld;
+  PROFILE_DOC *pNew;
+  size_t count;
+
+  pOld = pOldFileName ? profile_doc_load(pOldFileName) : NULL;
+  pNew = pNewFileName ? profile_doc_load(pNewFileName) : NULL;
+  count = profile_diff(pOld,pNew,pCallback,pContext);
+  profile_doc_free(pOld);
+  profile_doc_free(pNew);
+
+  return (count);
+}
+
+/**
+ * Start watching a file for changes.  The file is read now, and later
+ * changes are compared with this version.
+ *
+ * @param pFileName (IN) file name; the file need not exist yet
+ *
+ * @return watch, or NULL if out of memory
+ */
+PROFILE_WATCH *profile_watch_create(
+  const char *pFileName)
+{
+  PROFILE_WATCH *pWatch;
+  size_t len;
+
+  if (!pFileName)
+    return (NULL);
+  pWatch = calloc(1,sizeof(PROFILE_WATCH));
+  if (!pWatch)
+    return (NULL);
+  len = strlen(pFileName) + 1;
+  pWatch->pFileName = malloc(len);
+  if (!pWatch->pFileName)
+  {
+    free(pWatch);
+    return (NULL);
+  }
+  memcpy(pWatch->pFileName,pFileName,len);
+  /* stat first, so a change while reading is seen by the next poll */
+  if (profile_io_stat(profile_io_posix(),pFileName,&pWatch->file_stat))
+    pWatch->pDoc = profile_doc_load(pFileName);
+
+  return (pWatch);
+}
+
+/**
+ * Stop watching a file
+ *
+ * @param pWatch (IN) watch, may be NULL
+ */
+void profile_watch_free(
+  PROFILE_WATCH *pWatch)
+{
+  struct watch_subscriber *pSubscriber;
+
+  if (!pWatch)
+    return;
+  while (pWatch->pSubscribers)
+  {
+    pSubscriber = pWatch->pSubscribers;
+    pWatch->pSubscribers = pSubscriber->pNext;
+    free(pSubscriber);
+  }
+  profile_doc_free(pWatch->pDoc);
+  free(pWatch->pFileName);
+  free(pWatch);
+}
+
+/**
+ * Ask to be told of the changes a poll finds
+ *
+ * @param pWatch (IN) watch
+ * @param pCallback (IN) called for each change
+ * @param pContext (IN) passed to the callback
+ *
+ * @return TRUE if subscribed, FALSE if out of memory
+ */
+BOOL profile_watch_subscribe(
+  PROFILE_WATCH *pWatch,
+  PROFILE_DIFF_CALLBACK pCallback,
+  void *pContext)
+{
+  struct watch_subscriber *pSubscriber;
+  struct watch_subscriber **ppLink;
+
+  if (!pWatch || !pCallback)
+    return (FALSE);
+  pSubscriber = calloc(1,sizeof(struct watch_subscriber));
+  if (!pSubscriber)
+    return (FALSE);
+  pSubscriber->pCallback = pCallback;
+  pSubscriber->pContext = pContext;
+  /* subscribers are told in the order they subscribed */
+  for (ppLink = &pWatch->pSubscribers; *ppLink;
+    ppLink = &(*ppLink)->pNext)
+    ;
+  *ppLink = pSubscriber;
+
+  return (TRUE);
+}
+
+/**
+ * Stop being told of changes
+ *
+ * @param pWatch (IN) watch
+ * @param pCallback (IN) callback that was subscribed
+ * @param pContext (IN) context it was subscribed with
+ */
+void profile_watch_unsubscribe(
+  PROFILE_WATCH *pWatch,
+  PROFILE_DIFF_CALLBACK pCallback,
+  void *pContext)
+{
+  struct watch_subscriber **ppLink;
+  struct watch_subscriber *pSubscriber;
+
+  if (!pWatch || !pCallback)
+    return;
+  for (ppLink = &pWatch->pSubscribers; *ppLink;
+    ppLink = &(*ppLink)->pNext)
+  {
+    pSubscriber = *ppLink;
+    if ((pSubscriber->pCallback == pCallback) &&
+      (pSubscriber->pContext == pContext))
+    {
+      /* a callback may unsubscribe; the poll frees it when done */
+      if (pWatch->notifying)
+        pSubscriber->pCallback = NULL;
+      else
+      {
+        *ppLink = pSubscriber->pNext;
+        free(pSubscriber);
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * Free the subscribers that left while a poll told them of changes
+ *
+ * @param pWatch - watch
+ */
+static void watch_sweep(
+  PROFILE_WATCH *pWatch)
+{
+  struct watch_subscriber **ppLink;
+  struct watch_subscriber *pSubscriber;
+
+  ppLink = &pWatch->pSubscribers;
+  while (*ppLink)
+  {
+    pSubscriber = *ppLink;
+    if (pSubscriber->pCallback)
+      ppLink = &pSubscriber->pNext;
+    else
+    {
+      *ppLink = pSubscriber->pNext;
+      free(pSubscriber);
+    }
+  }
+}
+
+/**
+ * Pass a change on to every subscriber of a watch
+ *
+ * @param pChange - change
+ * @param pContext - watch
+ */
+static void watch_notify(
+  const PROFILE_CHANGE *pChange,
+  void *pContext)
+{
+  PROFILE_WATCH *pWatch = pContext;
+  struct watch_subscriber *pSubscriber;
+
+  for (pSubscriber = pWatch->pSubscribers; pSubscriber;
+    pSubscriber = pSubscriber->pNext)
+  {
+    if (pSubscriber->pCallback)
+      pSubscriber->pCallback(pChange,pSubscriber->pContext);
+  }
+}
+
+/**
+ * Check whether the file changed, and if so, read it again and tell
+ * the subscribers what changed.  A file that was removed has lost
+ * all of its sections.
+ *
+ * @param pWatch (IN) watch
+ *
+ * @return number of changes; 0 if the file is as it was
+ */
+size_t profile_watch_poll(
+  PROFILE_WATCH *pWatch)
+{
+  PROFILE_IO_STAT file_stat;
+  PROFILE_DOC *pDoc = NULL;
+  size_t count;
+
+  if (!pWatch)
+    return (0);
+  if (!profile_io_stat(profile_io_posix(),pWatch->pFileName,&file_stat))
+    file_stat.exists = FALSE;
+  if ((file_stat.exists == pWatch->file_stat.exists) &&
+    (!file_stat.exists ||
+    ((file_stat.size == pWatch->file_stat.size) &&
+    (file_stat.mtime == pWatch->file_stat.mtime))))
+    return (0);
+  if (file_stat.exists)
+  {
+    pDoc = profile_doc_load(pWatch->pFileName);
+    /* out of memory - try again on the next poll */
+    if (!pDoc)
+      return (0);
+  }
+  pWatch->notifying = TRUE;
+  count = profile_diff(pWatch->pDoc,pDoc,watch_notify,pWatch);
+  pWatch->notifying = FALSE;
+  watch_sweep(pWatch);
+  profile_doc_free(pWatch->pDoc);
+  pWatch->pDoc = pDoc;
+  pWatch->file_stat = file_stat;
+
+  return (count);
+}
+
+/**
+ * Version of the file the last poll read
+ *
+ * @param pWatch (IN) watch
+ *
+ * @return document, or NULL if there was no file
+ */
+const PROFILE_DOC *profile_watch_doc(
+  const PROFILE_WATCH *pWatch)
+{
+  return (pWatch ? pWatch->pDoc : NULL);
+}
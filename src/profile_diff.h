@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Differences between two versions of an INI file
+ */
+#ifndef PROFILE_DIFF_H
+#define PROFILE_DIFF_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_doc.h"
+
+/* kinds of change */
+#define PROFILE_DIFF_SECTION_ADDED 1
+#define PROFILE_DIFF_SECTION_REMOVED 2
+#define PROFILE_DIFF_KEY_ADDED 3
+#define PROFILE_DIFF_KEY_REMOVED 4
+#define PROFILE_DIFF_KEY_CHANGED 5
+
+/* one change, as passed to a PROFILE_DIFF_CALLBACK */
+typedef struct profile_change
+{
+  int type; /* PROFILE_DIFF_SECTION_ADDED and so on */
+  const char *pAppName; /* section name */
+  const char *pKeyName; /* key name, NULL for a section */
+  const char *pOldValue; /* value before, NULL if none */
+  const char *pNewValue; /* value after, NULL if none */
+} PROFILE_CHANGE;
+
+typedef struct profile_watch PROFILE_WATCH;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /* called for each change that was found */
+  typedef void (*PROFILE_DIFF_CALLBACK)(
+    const PROFILE_CHANGE *pChange,	// what changed
+    void *pContext); 	// caller supplied context
+
+  size_t profile_diff(
+    const PROFILE_DOC *pOld,
+    const PROFILE_DOC *pNew,
+    PROFILE_DIFF_CALLBACK pCallback,
+    void *pContext);
+  size_t profile_diff_files(
+    const char *pOldFileName,
+    const char *pNewFileName,
+    PROFILE_DIFF_CALLBACK pCallback,
+    void *pContext);
+
+  PROFILE_WATCH *profile_watch_create(const char *pFileName);
+  void profile_watch_free(PROFILE_WATCH *pWatch);
+  BOOL profile_watch_subscribe(
+    PROFILE_WATCH *pWatch,
+    PROFILE_DIFF_CALLBACK pCallback,
+    void *pContext);
+  void profile_watch_unsubscribe(
+    PROFILE_WATCH *pWatch,
+    PROFILE_DIFF_CALLBACK pCallback,
+    void *pContext);
+  size_t profile_watch_poll(PROFILE_WATCH *pWatch);
+  const PROFILE_DOC *profile_watch_doc(const PROFILE_WATCH *pWatch);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_DIFF_H */
@@ -0,0 +1,1716 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parsed, indexed in-memory copy of an INI file
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A document holds the sections and keys of an INI file after they have
+ * been cleaned up the same way GetPrivateProfileString does it: lines
+ * are trimmed, comments are skipped, section names have their brackets
+ * removed and values have their quotes removed.  Only the first section
+ * of a given name and the first key of a given name within it are kept,
+ * since those are the ones GetPrivateProfileString would find.
+ *
+ * Sections and keys are kept in file order for enumeration, and are
+ * also indexed by a case-independent hash so that a key lookup is a
+ * single probe of the key table.
+ *
+ * Everything in a document, including the document itself, is carved
+ * out of one arena.  Nothing is freed until the whole document is, so
+ * a hash table that grows leaves its old buckets behind in the arena.
+ * profile_doc_load sizes the arena from the file so that loading a file
+ * usually costs a single malloc.  When the intern pool is in use, the
+ * section and key names are not copied into the arena at all; they
+ * point into the pool, and keep the atom of the name for lookups.
+ *
+ * Most lookups of optional keys miss.  So that a miss doesn't have to
+ * walk a hash chain, the document keeps a bloom filter of the hashes of
+ * its section names, and each section one of the hashes of its keys.
+ * A name that is not in a filter is not in the document, and the
+ * lookup returns after a few bit tests.  A filter holds between 8 and
+ * 16 bits per name, and is rebuilt twice the size when it fills up.
+ * Deleting a name leaves its bits set, which only costs a probe.
+ */
+
+/* includes */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_intern.h"
+#include "profile_io.h"
+#include "arena.h"
+#include "strfold.h"
+
+/* initial number of hash buckets - must be a power of two */
+#define DOC_HASH_BUCKETS 16
+/* arena size for a document that is built up a piece at a time */
+#define DOC_ARENA_SIZE 4096
+
+/* fewest bits per name in a bloom filter before it grows */
+#define DOC_FILTER_BITS 8
+/* bits set for each name */
+#define DOC_FILTER_PROBES 3
+
+/* a bloom filter of name hashes */
+struct doc_filter
+{
+  uint64_t *pWords; /* NULL when there is no filter */
+  size_t bits; /* number of bits, a power of two */
+};
+
+struct profile_entry
+{
+  const char *pKeyName; /* in the arena or the intern pool */
+  size_t key_len; /* length of key name */
+  PROFILE_ATOM atom; /* atom of the key name, 0 if not interned */
+  char *pValue; /* NULL when the line has no '=' */
+  unsigned hash; /* profile_doc_hash of section and key name */
+  PROFILE_SECTION *pSection;
+  PROFILE_ENTRY *pNext; /* file order */
+  PROFILE_ENTRY *pHashNext;
+};
+
+struct profile_section
+{
+  const char *pAppName; /* in the arena or the intern pool */
+  size_t app_len; /* length of section name */
+  PROFILE_ATOM atom; /* atom of the section name, 0 if not interned */
+  unsigned hash; /* profile_doc_hash of section name */
+  size_t count; /* number of entries */
+  PROFILE_ENTRY *pFirst;
+  PROFILE_ENTRY *pLast;
+  PROFILE_SECTION *pNext; /* file order */
+  PROFILE_SECTION *pHashNext;
+  struct doc_filter keys; /* hashes of the entries */
+};
+
+/* a chained hash table that doubles when it gets full */
+struct doc_table
+{
+  void **ppBucket;
+  size_t size; /* number of buckets */
+  size_t count; /* number of items */
+};
+
+struct profile_doc
+{
+  ARENA *pArena; /* holds the document and everything in it */
+  BOOL interned; /* TRUE if names are in the intern pool */
+  size_t count; /* number of sections */
+  PROFILE_SECTION *pFirst;
+  PROFILE_SECTION *pLast;
+  struct doc_table sections;
+  struct doc_table entries;
+  struct doc_filter names; /* hashes of the section names */
+};
+
+/**
+ * Combine the hashes of a section name and a key name,
+ * the same way as profile_doc_hash.  Keeping the names apart
+ * lets an interned key be looked up without hashing it again.
+ *
+ * @param app_hash - strfold_hash of the section name
+ * @param key_hash - strfold_hash of the key name
+ *
+ * @return hash value
+ */
+static unsigned doc_hash_pair(
+  unsigned app_hash,
+  unsigned key_hash)
+{
+  return (((app_hash ^ 0x100) * 16777619U) ^ key_hash);
+}
+
+/**
+ * Hash a section name, or a section and key name pair,
+ * independent of case.
+ *
+ * @param pAppName - section name
+ * @param pKeyName - key name, or NULL to hash only the section name
+ *
+ * @return hash value
+ */
+unsigned profile_doc_hash(
+  const char *pAppName,
+  const char *pKeyName)
+{
+  unsigned hash = strfold_hash(pAppName,strlen(pAppName));
+
+  if (pKeyName)
+    hash = doc_hash_pair(hash,strfold_hash(pKeyName,strlen(pKeyName)));
+
+  return (hash);
+}
+
+/**
+ * Make room in a hash table for more items.
+ * The old buckets are left in the arena.
+ *
+ * @param pArena - arena of the document
+ * @param pTable - hash table
+ * @param count - number of items to make room for
+ * @param offset - offset of the hash value in an item
+ * @param link - offset of the chain pointer in an item
+ *
+ * @return TRUE if there is room
+ */
+static BOOL doc_table_reserve(
+  ARENA *pArena,
+  struct doc_table *pTable,
+  size_t count,
+  size_t offset,
+  size_t link)
+{
+  void **ppBucket;
+  void *pItem;
+  void *pNext;
+  size_t size;
+  size_t i;
+  unsigned hash;
+
+  if (pTable->count + count <= pTable->size)
+    return (TRUE);
+  size = pTable->size ? pTable->size * 2 : DOC_HASH_BUCKETS;
+  while (size < pTable->count + count)
+    size *= 2;
+  ppBucket = arena_calloc(pArena,size,sizeof(void *));
+  if (!ppBucket)
+    return (FALSE);
+  for (i = 0; i < pTable->size; i++)
+  {
+    for (pItem = pTable->ppBucket[i]; pItem; pItem = pNext)
+    {
+      pNext = *(void **)((char *)pItem + link);
+      hash = *(unsigned *)((char *)pItem + offset);
+      *(void **)((char *)pItem + link) = ppBucket[hash & (size - 1)];
+      ppBucket[hash & (size - 1)] = pItem;
+    }
+  }
+  pTable->ppBucket = ppBucket;
+  pTable->size = size;
+
+  return (TRUE);
+}
+
+/**
+ * Spread the bits of a hash, so that the filter does not use the
+ * same bits as the hash table
+ *
+ * @param hash - hash value
+ *
+ * @return mixed hash value
+ */
+static unsigned doc_filter_mix(
+  unsigned hash)
+{
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6BU;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35U;
+  hash ^= hash >> 16;
+
+  return (hash);
+}
+
+/**
+ * Set the bits of a hash in a bloom filter
+ *
+ * @param pFilter - filter
+ * @param hash - hash value of the name
+ */
+static void doc_filter_add(
+  struct doc_filter *pFilter,
+  unsigned hash)
+{
+  unsigned h1 = doc_filter_mix(hash);
+  unsigned h2 = ((h1 >> 16) | (h1 << 16)) | 1;
+  size_t bit;
+  unsigned i;
+
+  if (!pFilter->pWords)
+    return;
+  for (i = 0; i < DOC_FILTER_PROBES; i++)
+  {
+    bit = (h1 + i * h2) & (pFilter->bits - 1);
+    pFilter->pWords[bit / 64] |= (uint64_t)1 << (bit % 64);
+  }
+}
+
+/**
+ * Find out if a bloom filter may hold a hash
+ *
+ * @param pFilter - filter
+ * @param hash - hash value of the name
+ *
+ * @return FALSE if the name is certainly not there
+ */
+static BOOL doc_filter_test(
+  const struct doc_filter *pFilter,
+  unsigned hash)
+{
+  unsigned h1 = doc_filter_mix(hash);
+  unsigned h2 = ((h1 >> 16) | (h1 << 16)) | 1;
+  size_t bit;
+  unsigned i;
+
+  if (!pFilter->pWords)
+    return (TRUE);
+  for (i = 0; i < DOC_FILTER_PROBES; i++)
+  {
+    bit = (h1 + i * h2) & (pFilter->bits - 1);
+    if (!(pFilter->pWords[bit / 64] & ((uint64_t)1 << (bit % 64))))
+      return (FALSE);
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Make room in a bloom filter for a number of names.  When the filter
+ * is replaced, the caller adds every name to it again.  When there is
+ * no memory for it, the filter is dropped and lets every name through.
+ *
+ * @param pArena - arena of the document
+ * @param pFilter - filter
+ * @param count - number of names it will hold
+ *
+ * @return TRUE if the filter was replaced and is empty
+ */
+static BOOL doc_filter_reserve(
+  ARENA *pArena,
+  struct doc_filter *pFilter,
+  size_t count)
+{
+  size_t bits = 64;
+
+  if (pFilter->bits && (count * DOC_FILTER_BITS <= pFilter->bits))
+    return (FALSE);
+  while (bits < count * 2 * DOC_FILTER_BITS)
+    bits *= 2;
+  pFilter->pWords = arena_calloc(pArena,bits / 64,sizeof(uint64_t));
+  pFilter->bits = pFilter->pWords ? bits : 0;
+
+  return (pFilter->pWords ? TRUE : FALSE);
+}
+
+/**
+ * Create an empty document with room for a number of bytes of
+ * sections and keys before the arena grows.
+ *
+ * @param nSize - expected size of the names, values and index
+ *
+ * @return new document, or NULL if out of memory
+ */
+PROFILE_DOC *profile_doc_create_sized(
+  size_t nSize)
+{
+  ARENA *pArena;
+  PROFILE_DOC *pDoc;
+
+  pArena = arena_create(sizeof(PROFILE_DOC) + nSize);
+  if (!pArena)
+    return (NULL);
+  pDoc = arena_calloc(pArena,1,sizeof(PROFILE_DOC));
+  if (!pDoc)
+  {
+    arena_free(pArena);
+    return (NULL);
+  }
+  pDoc->pArena = pArena;
+  pDoc->interned = profile_intern_enabled();
+
+  return (pDoc);
+}
+
+/**
+ * Create an empty document
+ *
+ * @return new document, or NULL if out of memory
+ */
+PROFILE_DOC *profile_doc_create(void)
+{
+  return (profile_doc_create_sized(DOC_ARENA_SIZE));
+}
+
+/**
+ * Release a document and everything in it
+ *
+ * @param pDoc - document, may be NULL
+ */
+void profile_doc_free(
+  PROFILE_DOC *pDoc)
+{
+  if (pDoc)
+    arena_free(pDoc->pArena);
+}
+
+/**
+ * Bytes of memory held by a document
+ *
+ * @param pDoc - document
+ *
+ * @return number of bytes allocated for the document
+ */
+size_t profile_doc_memory(
+  const PROFILE_DOC *pDoc)
+{
+  return (pDoc ? arena_size(pDoc->pArena) : 0);
+}
+
+/**
+ * Number of allocations made for a document
+ *
+ * @param pDoc - document
+ *
+ * @return number of blocks in the arena of the document
+ */
+size_t profile_doc_blocks(
+  const PROFILE_DOC *pDoc)
+{
+  return (pDoc ? arena_blocks(pDoc->pArena) : 0);
+}
+
+/**
+ * Find a section by name and hash
+ *
+ * @param pDoc - document
+ * @param pAppName - start of the section name
+ * @param app_len - number of characters in the section name
+ * @param hash - strfold_hash of the section name
+ *
+ * @return section, or NULL if not found
+ */
+static PROFILE_SECTION *doc_find_section(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  size_t app_len,
+  unsigned hash)
+{
+  PROFILE_SECTION *pSection = NULL;
+
+  if (!pDoc->sections.size || !doc_filter_test(&pDoc->names,hash))
+    return (NULL);
+  pSection = pDoc->sections.ppBucket[hash & (pDoc->sections.size - 1)];
+  while (pSection)
+  {
+    if ((pSection->hash == hash) && (pSection->app_len == app_len) &&
+      strfold_equal(pSection->pAppName,pAppName,app_len))
+      break;
+    pSection = pSection->pHashNext;
+  }
+
+  return (pSection);
+}
+
+/**
+ * Find a key of a section by name and hash
+ *
+ * @param pDoc - document
+ * @param pSection - section
+ * @param pKeyName - start of the key name
+ * @param key_len - number of characters in the key name
+ * @param hash - doc_hash_pair of the section and key name
+ *
+ * @return entry, or NULL if not found
+ */
+static PROFILE_ENTRY *doc_find_entry(
+  const PROFILE_DOC *pDoc,
+  const PROFILE_SECTION *pSection,
+  const char *pKeyName,
+  size_t key_len,
+  unsigned hash)
+{
+  PROFILE_ENTRY *pEntry = NULL;
+
+  if (!pDoc->entries.size || !doc_filter_test(&pSection->keys,hash))
+    return (NULL);
+  pEntry = pDoc->entries.ppBucket[hash & (pDoc->entries.size - 1)];
+  while (pEntry)
+  {
+    /* a section name appears once, so the section can be compared */
+    if ((pEntry->hash == hash) && (pEntry->pSection == pSection) &&
+      (pEntry->key_len == key_len) &&
+      strfold_equal(pEntry->pKeyName,pKeyName,key_len))
+      break;
+    pEntry = pEntry->pHashNext;
+  }
+
+  return (pEntry);
+}
+
+/**
+ * Add a section to the end of the document unless it is there
+ *
+ * @param pDoc - document
+ * @param pAppName - start of the section name
+ * @param app_len - number of characters in the section name
+ * @param pAdded - set to TRUE if the section is new
+ *
+ * @return section, or NULL if out of memory
+ */
+static PROFILE_SECTION *doc_add_section(
+  PROFILE_DOC *pDoc,
+  const char *pAppName,
+  size_t app_len,
+  BOOL *pAdded)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_SECTION *pOther;
+  unsigned hash;
+  size_t index;
+
+  *pAdded = FALSE;
+  hash = strfold_hash(pAppName,app_len);
+  pSection = doc_find_section(pDoc,pAppName,app_len,hash);
+  if (pSection)
+    return (pSection);
+  if (!doc_table_reserve(pDoc->pArena,&pDoc->sections,1,
+    offsetof(PROFILE_SECTION,hash),offsetof(PROFILE_SECTION,pHashNext)))
+    return (NULL);
+  pSection = arena_calloc(pDoc->pArena,1,sizeof(PROFILE_SECTION));
+  if (!pSection)
+    return (NULL);
+  if (pDoc->interned)
+    pSection->pAppName =
+      profile_intern_string(pAppName,app_len,&pSection->atom,NULL);
+  else
+    pSection->pAppName = arena_strndup(pDoc->pArena,pAppName,app_len);
+  if (!pSection->pAppName)
+    return (NULL);
+  pSection->app_len = app_len;
+  pSection->hash = hash;
+  index = hash & (pDoc->sections.size - 1);
+  pSection->pHashNext = pDoc->sections.ppBucket[index];
+  pDoc->sections.ppBucket[index] = pSection;
+  pDoc->sections.count++;
+  if (pDoc->pLast)
+    pDoc->pLast->pNext = pSection;
+  else
+    pDoc->pFirst = pSection;
+  pDoc->pLast = pSection;
+  pDoc->count++;
+  if (doc_filter_reserve(pDoc->pArena,&pDoc->names,pDoc->count))
+  {
+    for (pOther = pDoc->pFirst; pOther; pOther = pOther->pNext)
+      doc_filter_add(&pDoc->names,pOther->hash);
+  }
+  else
+    doc_filter_add(&pDoc->names,hash);
+  *pAdded = TRUE;
+
+  return (pSection);
+}
+
+/**
+ * Add a key to the end of a section unless it is there
+ *
+ * @param pDoc - document that owns the section
+ * @param pSection - section
+ * @param pKeyName - start of the key name
+ * @param key_len - number of characters in the key name
+ * @param pValue - start of the value, or NULL for a line without '='
+ * @param value_len - number of characters in the value
+ *
+ * @return entry, or NULL if out of memory
+ */
+static PROFILE_ENTRY *doc_add_entry(
+  PROFILE_DOC *pDoc,
+  PROFILE_SECTION *pSection,
+  const char *pKeyName,
+  size_t key_len,
+  const char *pValue,
+  size_t value_len)
+{
+  PROFILE_ENTRY *pEntry;
+  PROFILE_ENTRY *pOther;
+  unsigned hash;
+  size_t index;
+
+  hash = doc_hash_pair(pSection->hash,strfold_hash(pKeyName,key_len));
+  pEntry = doc_find_entry(pDoc,pSection,pKeyName,key_len,hash);
+  if (pEntry)
+    return (pEntry);
+  if (!doc_table_reserve(pDoc->pArena,&pDoc->entries,1,
+    offsetof(PROFILE_ENTRY,hash),offsetof(PROFILE_ENTRY,pHashNext)))
+    return (NULL);
+  pEntry = arena_calloc(pDoc->pArena,1,sizeof(PROFILE_ENTRY));
+  if (!pEntry)
+    return (NULL);
+  if (pDoc->interned)
+    pEntry->pKeyName =
+      profile_intern_string(pKeyName,key_len,&pEntry->atom,NULL);
+  else
+    pEntry->pKeyName = arena_strndup(pDoc->pArena,pKeyName,key_len);
+  if (!pEntry->pKeyName)
+    return (NULL);
+  if (pValue)
+  {
+    pEntry->pValue = arena_strndup(pDoc->pArena,pValue,value_len);
+    if (!pEntry->pValue)
+      return (NULL);
+  }
+  pEntry->key_len = key_len;
+  pEntry->pSection = pSection;
+  pEntry->hash = hash;
+  index = hash & (pDoc->entries.size - 1);
+  pEntry->pHashNext = pDoc->entries.ppBucket[index];
+  pDoc->entries.ppBucket[index] = pEntry;
+  pDoc->entries.count++;
+  if (pSection->pLast)
+    pSection->pLast->pNext = pEntry;
+  else
+    pSection->pFirst = pEntry;
+  pSection->pLast = pEntry;
+  pSection->count++;
+  if (doc_filter_reserve(pDoc->pArena,&pSection->keys,pSection->count))
+  {
+    for (pOther = pSection->pFirst; pOther; pOther = pOther->pNext)
+      doc_filter_add(&pSection->keys,pOther->hash);
+  }
+  else
+    doc_filter_add(&pSection->keys,hash);
+
+  return (pEntry);
+}
+
+/**
+ * Find a section by a name that need not end with a null,
+ * independent of case
+ *
+ * @param pDoc - document
+ * @param pAppName - start of the section name
+ * @param app_len - number of characters in the section name
+ *
+ * @return section, or NULL if not found
+ */
+PROFILE_SECTION *profile_doc_section_n(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  size_t app_len)
+{
+  if (!pDoc || !pAppName)
+    return (NULL);
+
+  return (doc_find_section(pDoc,pAppName,app_len,
+    strfold_hash(pAppName,app_len)));
+}
+
+/**
+ * Find a section by name, independent of case
+ *
+ * @param pDoc - document
+ * @param pAppName - section name
+ *
+ * @return section, or NULL if not found
+ */
+PROFILE_SECTION *profile_doc_section(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName)
+{
+  if (!pAppName)
+    return (NULL);
+
+  return (profile_doc_section_n(pDoc,pAppName,strlen(pAppName)));
+}
+
+/**
+ * Find a key by section and key names that need not end with a null,
+ * independent of case
+ *
+ * @param pDoc - document
+ * @param pAppName - start of the section name
+ * @param app_len - number of characters in the section name
+ * @param pKeyName - start of the key name
+ * @param key_len - number of characters in the key name
+ *
+ * @return entry, or NULL if not found
+ */
+PROFILE_ENTRY *profile_doc_entry_n(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  size_t app_len,
+  const char *pKeyName,
+  size_t key_len)
+{
+  PROFILE_SECTION *pSection;
+
+  if (!pKeyName)
+    return (NULL);
+  pSection = profile_doc_section_n(pDoc,pAppName,app_len);
+  if (!pSection)
+    return (NULL);
+
+  return (doc_find_entry(pDoc,pSection,pKeyName,key_len,
+    doc_hash_pair(pSection->hash,strfold_hash(pKeyName,key_len))));
+}
+
+/**
+ * Find a key by section and key name, independent of case
+ *
+ * @param pDoc - document
+ * @param pAppName - section name
+ * @param pKeyName - key name
+ *
+ * @return entry, or NULL if not found
+ */
+PROFILE_ENTRY *profile_doc_entry(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  const char *pKeyName)
+{
+  if (!pAppName || !pKeyName)
+    return (NULL);
+
+  return (profile_doc_entry_n(pDoc,pAppName,strlen(pAppName),pKeyName,
+    strlen(pKeyName)));
+}
+
+/**
+ * Find the value of a key
+ *
+ * @param pDoc - document
+ * @param pAppName - section name
+ * @param pKeyName - key name
+ *
+ * @return value, or NULL if the key is not found or has no value
+ */
+const char *profile_doc_value(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  const char *pKeyName)
+{
+  PROFILE_ENTRY *pEntry = profile_doc_entry(pDoc,pAppName,pKeyName);
+
+  return (pEntry ? pEntry->pValue : NULL);
+}
+
+/**
+ * Find a section by the atom of its name
+ *
+ * @param pDoc - document
+ * @param app - atom of the section name, from profile_intern
+ *
+ * @return section, or NULL if not found
+ */
+PROFILE_SECTION *profile_doc_section_atom(
+  const PROFILE_DOC *pDoc,
+  PROFILE_ATOM app)
+{
+  PROFILE_SECTION *pSection = NULL;
+  const char *pAppName;
+  unsigned hash;
+
+  if (!pDoc || !pDoc->sections.size)
+    return (NULL);
+  pAppName = profile_intern_name(app);
+  if (!pAppName)
+    return (NULL);
+  if (!pDoc->interned)
+    return (profile_doc_section(pDoc,pAppName));
+  hash = profile_intern_hash(app);
+  if (!doc_filter_test(&pDoc->names,hash))
+    return (NULL);
+  pSection = pDoc->sections.ppBucket[hash & (pDoc->sections.size - 1)];
+  while (pSection && (pSection->atom != app))
+    pSection = pSection->pHashNext;
+
+  return (pSection);
+}
+
+/**
+ * Find a key by the atoms of its section and key names
+ *
+ * @param pDoc - document
+ * @param app - atom of the section name, from profile_intern
+ * @param key - atom of the key name, from profile_intern
+ *
+ * @return entry, or NULL if not found
+ */
+PROFILE_ENTRY *profile_doc_entry_atom(
+  const PROFILE_DOC *pDoc,
+  PROFILE_ATOM app,
+  PROFILE_ATOM key)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_ENTRY *pEntry = NULL;
+  unsigned hash;
+
+  pSection = profile_doc_section_atom(pDoc,app);
+  if (!pSection || !pDoc->entries.size || !profile_intern_name(key))
+    return (NULL);
+  if (!pDoc->interned)
+    return (profile_doc_entry(pDoc,pSection->pAppName,
+      profile_intern_name(key)));
+  hash = doc_hash_pair(pSection->hash,profile_intern_hash(key));
+  if (!doc_filter_test(&pSection->keys,hash))
+    return (NULL);
+  pEntry = pDoc->entries.ppBucket[hash & (pDoc->entries.size - 1)];
+  while (pEntry && ((pEntry->pSection != pSection) || (pEntry->atom != key)))
+    pEntry = pEntry->pHashNext;
+
+  return (pEntry);
+}
+
+/**
+ * Find the value of a key by the atoms of its section and key names
+ *
+ * @param pDoc - document
+ * @param app - atom of the section name, from profile_intern
+ * @param key - atom of the key name, from profile_intern
+ *
+ * @return value, or NULL if the key is not found or has no value
+ */
+const char *profile_doc_value_atom(
+  const PROFILE_DOC *pDoc,
+  PROFILE_ATOM app,
+  PROFILE_ATOM key)
+{
+  PROFILE_ENTRY *pEntry = profile_doc_entry_atom(pDoc,app,key);
+
+  return (pEntry ? pEntry->pValue : NULL);
+}
+
+/**
+ * Add a section to the end of the document.
+ * If the section already exists, it is returned unchanged.
+ *
+ * @param pDoc - document
+ * @param pAppName - section name
+ *
+ * @return section, or NULL if out of memory
+ */
+PROFILE_SECTION *profile_doc_add_section(
+  PROFILE_DOC *pDoc,
+  const char *pAppName)
+{
+  BOOL added;
+
+  if (!pDoc || !pAppName)
+    return (NULL);
+
+  return (doc_add_section(pDoc,pAppName,strlen(pAppName),&added));
+}
+
+/**
+ * Add a key to the end of a section.
+ * If the key already exists in the section, it is returned unchanged.
+ *
+ * @param pDoc - document that owns the section
+ * @param pSection - section
+ * @param pKeyName - key name
+ * @param pValue - value, or NULL for a line without '='
+ *
+ * @return entry, or NULL if out of memory
+ */
+PROFILE_ENTRY *profile_doc_add_entry(
+  PROFILE_DOC *pDoc,
+  PROFILE_SECTION *pSection,
+  const char *pKeyName,
+  const char *pValue)
+{
+  if (!pDoc || !pSection || !pKeyName)
+    return (NULL);
+
+  return (doc_add_entry(pDoc,pSection,pKeyName,strlen(pKeyName),
+    pValue,pValue ? strlen(pValue) : 0));
+}
+
+/**
+ * Add the sections and keys of one document that are missing from
+ * another, as if the source file were appended to the destination file.
+ *
+ * @param pDest - document that receives the sections and keys
+ * @param pSource - document to copy from
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+BOOL profile_doc_merge(
+  PROFILE_DOC *pDest,
+  const PROFILE_DOC *pSource)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_SECTION *pCopy;
+  PROFILE_ENTRY *pEntry;
+
+  if (!pDest)
+    return (FALSE);
+  for (pSection = pSource ? pSource->pFirst : NULL; pSection;
+    pSection = pSection->pNext)
+  {
+    pCopy = profile_doc_add_section(pDest,pSection->pAppName);
+    if (!pCopy)
+      return (FALSE);
+    for (pEntry = pSection->pFirst; pEntry; pEntry = pEntry->pNext)
+    {
+      if (!profile_doc_add_entry(pDest,pCopy,pEntry->pKeyName,
+        pEntry->pValue))
+        return (FALSE);
+    }
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Move the sections of one document that are missing from another into
+ * it, as if the source file were appended to the destination file.
+ * The sections and keys are linked into the destination as they are,
+ * and the arena of the source is joined to the arena of the
+ * destination, so only the hash tables are touched.
+ *
+ * @param pDest - document that receives the sections
+ * @param pSource - document to move from, which is freed even when
+ *  this fails
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+BOOL profile_doc_adopt(
+  PROFILE_DOC *pDest,
+  PROFILE_DOC *pSource)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_SECTION *pNext;
+  PROFILE_ENTRY *pEntry;
+  size_t index;
+  BOOL status;
+
+  if (!pDest)
+  {
+    profile_doc_free(pSource);
+    return (FALSE);
+  }
+  if (!pSource)
+    return (TRUE);
+  /* names that point into different places cannot be shared */
+  if (pDest->interned != pSource->interned)
+  {
+    status = profile_doc_merge(pDest,pSource);
+    profile_doc_free(pSource);
+    return (status);
+  }
+  /* so that nothing fails once the sections start moving */
+  if (!doc_table_reserve(pDest->pArena,&pDest->sections,pSource->count,
+    offsetof(PROFILE_SECTION,hash),offsetof(PROFILE_SECTION,pHashNext)) ||
+    !doc_table_reserve(pDest->pArena,&pDest->entries,
+    pSource->entries.count,offsetof(PROFILE_ENTRY,hash),
+    offsetof(PROFILE_ENTRY,pHashNext)))
+  {
+    profile_doc_free(pSource);
+    return (FALSE);
+  }
+  if (doc_filter_reserve(pDest->pArena,&pDest->names,
+    pDest->count + pSource->count))
+  {
+    for (pSection = pDest->pFirst; pSection; pSection = pSection->pNext)
+      doc_filter_add(&pDest->names,pSection->hash);
+  }
+  for (pSection = pSource->pFirst; pSection; pSection = pNext)
+  {
+    pNext = pSection->pNext;
+    /* a repeated section is hidden by the first one */
+    if (doc_find_section(pDest,pSection->pAppName,pSection->app_len,
+      pSection->hash))
+      continue;
+    index = pSection->hash & (pDest->sections.size - 1);
+    pSection->pHashNext = pDest->sections.ppBucket[index];
+    pDest->sections.ppBucket[index] = pSection;
+    pDest->sections.count++;
+    pSection->pNext = NULL;
+    if (pDest->pLast)
+      pDest->pLast->pNext = pSection;
+    else
+      pDest->pFirst = pSection;
+    pDest->pLast = pSection;
+    pDest->count++;
+    doc_filter_add(&pDest->names,pSection->hash);
+    /* the entry hashes are of the section name, so they carry over */
+    for (pEntry = pSection->pFirst; pEntry; pEntry = pEntry->pNext)
+    {
+      index = pEntry->hash & (pDest->entries.size - 1);
+      pEntry->pHashNext = pDest->entries.ppBucket[index];
+      pDest->entries.ppBucket[index] = pEntry;
+      pDest->entries.count++;
+    }
+  }
+  arena_adopt(pDest->pArena,pSource->pArena);
+
+  return (TRUE);
+}
+
+/**
+ * Remove leading and trailing white space from part of a string,
+ * the same way as rmlead and rmtrail.
+ *
+ * @param ppBegin - start of the characters, moved forward
+ * @param ppEnd - one past the last character, moved back
+ */
+static void doc_trim(
+  const char **ppBegin,
+  const char **ppEnd)
+{
+  while ((*ppBegin < *ppEnd) && isspace((unsigned char)**ppBegin))
+    (*ppBegin)++;
+  while ((*ppEnd > *ppBegin) && isspace((unsigned char)(*ppEnd)[-1]))
+    (*ppEnd)--;
+}
+
+/**
+ * Parse INI text into a document.  Sections and keys that are
+ * already in the document are kept, as if the text were appended
+ * to the file the document was loaded from.
+ *
+ * @param pDoc - document
+ * @param pBuffer - INI text, which need not be null-terminated
+ * @param nLength - number of characters in pBuffer
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+BOOL profile_doc_parse(
+  PROFILE_DOC *pDoc,
+  const char *pBuffer,
+  size_t nLength)
+{
+  const char *pLine = pBuffer; /* start of line */
+  const char *pLimit = pBuffer + nLength; /* end of buffer */
+  const char *pBegin; /* start of trimmed text */
+  const char *pEnd; /* end of trimmed text */
+  const char *pEqual; /* key and value separator */
+  const char *pValue; /* start of value */
+  PROFILE_SECTION *pSection = NULL; /* section being loaded */
+  BOOL added = FALSE; /* TRUE if the section is new */
+  BOOL has_value = FALSE; /* TRUE if the key line has an '=' */
+  BOOL status = TRUE;
+
+  if (!pDoc || (!pBuffer && nLength))
+    return (FALSE);
+  while (status && (pLine < pLimit))
+  {
+    pEnd = memchr(pLine,'\n',(size_t)(pLimit - pLine));
+    if (!pEnd)
+      pEnd = pLimit;
+    pBegin = pLine;
+    pLine = (pEnd < pLimit) ? pEnd + 1 : pLimit;
+    doc_trim(&pBegin,&pEnd);
+    /* blank lines and comments */
+    if ((pBegin == pEnd) || (*pBegin == ';'))
+      continue;
+    if (*pBegin == '[')
+    {
+      /* a new section ends the current one, even if it is malformed */
+      pSection = NULL;
+      if (((pEnd - pBegin) > 1) && (pEnd[-1] == ']'))
+      {
+        pSection = doc_add_section(pDoc,pBegin + 1,
+          (size_t)(pEnd - pBegin - 2),&added);
+        if (!pSection)
+          status = FALSE;
+        else if (!added)
+          pSection = NULL;
+      }
+    }
+    else if (pSection)
+    {
+      pEqual = memchr(pBegin,'=',(size_t)(pEnd - pBegin));
+      has_value = (pEqual != NULL);
+      pValue = pEqual ? pEqual + 1 : pEnd;
+      if (!pEqual)
+        pEqual = pEnd;
+      while ((pEqual > pBegin) && isspace((unsigned char)pEqual[-1]))
+        pEqual--;
+      doc_trim(&pValue,&pEnd);
+      /* remove enclosing quotes the same way as rmquotes */
+      if (((pEnd - pValue) > 1) &&
+        (((*pValue == '\'') && (pEnd[-1] == '\'')) ||
+        ((*pValue == '\"') && (pEnd[-1] == '\"'))))
+      {
+        pValue++;
+        pEnd--;
+      }
+      if (!doc_add_entry(pDoc,pSection,pBegin,(size_t)(pEqual - pBegin),
+        has_value ? pValue : NULL,(size_t)(pEnd - pValue)))
+        status = FALSE;
+    }
+  }
+
+  return (status);
+}
+
+/**
+ * Read a whole file into the heap
+ *
+ * @param pFileName - name of the file
+ * @param pnLength - receives the number of characters read
+ *
+ * @return file contents, to be released with free, or NULL if the
+ *  file cannot be read.  The contents are not null-terminated.
+ */
+char *profile_doc_read_file(
+  const char *pFileName,
+  size_t *pnLength)
+{
+  FILE *pFile = NULL; /* stream handle */
+  char *pBuffer = NULL; /* file contents */
+  char *pGrow = NULL;
+  size_t size = 0; /* size of buffer */
+  size_t len = 0; /* number of characters in the buffer */
+  size_t num_read = 0;
+
+  if (!pFileName || !pnLength)
+    return (NULL);
+  pFile = fopen(pFileName,"rb");
+  if (!pFile)
+    return (NULL);
+  do
+  {
+    if (len == size)
+    {
+      size = size ? size * 2 : 4096;
+      pGrow = realloc(pBuffer,size);
+      if (!pGrow)
+      {
+        free(pBuffer);
+        pBuffer = NULL;
+        break;
+      }
+      pBuffer = pGrow;
+    }
+    num_read = fread(pBuffer + len,1,size - len,pFile);
+    len += num_read;
+  } while (num_read);
+  fclose(pFile);
+  *pnLength = len;
+
+  return (pBuffer);
+}
+
+/**
+ * Estimate the arena size needed for some INI text: the text itself,
+ * and for every line a section or entry, its alignment, and the hash
+ * buckets it may cause, counting the buckets left behind by growth.
+ *
+ * @param pBuffer - INI text
+ * @param nLength - number of characters in pBuffer
+ *
+ * @return number of bytes
+ */
+static size_t doc_estimate(
+  const char *pBuffer,
+  size_t nLength)
+{
+  const char *pLine = pBuffer;
+  const char *pLimit = pBuffer + nLength;
+  size_t lines = 1;
+
+  while (pLine && (pLine = memchr(pLine,'\n',(size_t)(pLimit - pLine))))
+  {
+    lines++;
+    pLine++;
+  }
+
+  return (nLength + lines * (sizeof(PROFILE_SECTION) + 6 * sizeof(void *)) +
+    2 * DOC_HASH_BUCKETS * sizeof(void *));
+}
+
+/**
+ * Parse INI text held in memory into a new document.  The text is
+ * read in place and may be released once the document is made.
+ *
+ * @param pBuffer - INI text, which need not be null-terminated
+ * @param nLength - number of characters in pBuffer
+ *
+ * @return new document, or NULL if out of memory
+ */
+PROFILE_DOC *profile_doc_load_buffer(
+  const char *pBuffer,
+  size_t nLength)
+{
+  PROFILE_DOC *pDoc = NULL;
+
+  if (!pBuffer && nLength)
+    return (NULL);
+  pDoc = profile_doc_create_sized(doc_estimate(pBuffer,nLength));
+  if (pDoc && !profile_doc_parse(pDoc,pBuffer,nLength))
+  {
+    profile_doc_free(pDoc);
+    pDoc = NULL;
+  }
+
+  return (pDoc);
+}
+
+/**
+ * Load and parse an INI file read through a backend.  The contents
+ * are parsed where the backend holds them, so with profile_io_mmap
+ * the file is never copied.
+ *
+ * @param pIo - backend
+ * @param pFileName - name of the initialization file
+ *
+ * @return new document, or NULL if the file cannot be read
+ */
+PROFILE_DOC *profile_doc_load_io(
+  const PROFILE_IO *pIo,
+  const char *pFileName)
+{
+  PROFILE_DOC *pDoc = NULL;
+  const char *pBuffer = NULL;
+  void *pHandle = NULL;
+  size_t len = 0;
+
+  if (!pIo || !pFileName)
+    return (NULL);
+  pHandle = pIo->pOps->open(pIo->pContext,pFileName,PROFILE_IO_READ);
+  if (!pHandle)
+    return (NULL);
+  pBuffer = pIo->pOps->map(pHandle,&len);
+  pDoc = profile_doc_load_buffer(pBuffer,len);
+  pIo->pOps->close(pHandle);
+
+  return (pDoc);
+}
+
+/**
+ * Load and parse an INI file
+ *
+ * @param pFileName - name of the initialization file
+ *
+ * @return new document, or NULL if the file cannot be read
+ */
+PROFILE_DOC *profile_doc_load(
+  const char *pFileName)
+{
+  PROFILE_DOC *pDoc = NULL;
+  char *pBuffer = NULL; /* file contents */
+  size_t len = 0; /* number of characters in the buffer */
+
+  pBuffer = profile_doc_read_file(pFileName,&len);
+  if (!pBuffer)
+    return (NULL);
+  pDoc = profile_doc_load_buffer(pBuffer,len);
+  free(pBuffer);
+
+  return (pDoc);
+}
+
+/**
+ * Append a name to a list of null-terminated names, truncating
+ * the same way GetPrivateProfileString does.
+ *
+ * @param ppReturnedString - next free character, moved forward
+ * @param pCount - number of characters used so far, updated
+ * @param nSize - size of the buffer
+ * @param pName - name to append
+ *
+ * @return FALSE if the list is full
+ */
+static BOOL doc_list_append(
+  char **ppReturnedString,
+  size_t *pCount,
+  size_t nSize,
+  const char *pName)
+{
+  size_t len = strlen(pName);
+  BOOL status = TRUE;
+
+  if ((len + *pCount + 2) >= nSize)
+  {
+    /* copy as much as we can, then truncate */
+    len = nSize - 2 - *pCount;
+    status = FALSE;
+  }
+  memcpy(*ppReturnedString,pName,len);
+  (*ppReturnedString)[len] = '\0';
+  len++; /* add null */
+  *ppReturnedString += len;
+  *pCount += len;
+
+  return (status);
+}
+
+/**
+ * Copy a value out of the document with the same results as
+ * GetPrivateProfileString would give for the file it was loaded from.
+ *
+ * @param pDoc (IN) document, or NULL for an empty document
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ *
+ * @return number of characters copied to the buffer, not including
+ *  the terminating null character.
+ */
+size_t profile_doc_get(
+  const PROFILE_DOC *pDoc,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  size_t count = 0; /* number of characters placed into return string */
+  size_t len = 0; /* length of string */
+  char *pList = pReturnedString; /* next name in a list */
+  PROFILE_SECTION *pSection = NULL;
+  PROFILE_ENTRY *pEntry = NULL;
+  const char *pValue = NULL;
+  BOOL use_default = FALSE;
+
+  if (!pReturnedString || (nSize < 2))
+  {
+    if (pReturnedString && nSize)
+      pReturnedString[0] = '\0';
+    return (count);
+  }
+  pReturnedString[0] = '\0';
+  if (!pAppName)
+  {
+    for (pSection = pDoc ? pDoc->pFirst : NULL; pSection;
+      pSection = pSection->pNext)
+    {
+      if (!doc_list_append(&pList,&count,nSize,pSection->pAppName))
+        break;
+    }
+  }
+  else
+  {
+    pSection = profile_doc_section(pDoc,pAppName);
+    if (!pSection)
+      use_default = TRUE;
+    else if (pKeyName)
+    {
+      pValue = profile_doc_value(pDoc,pAppName,pKeyName);
+      if (pValue)
+      {
+        len = strlen(pValue);
+        if (len >= nSize)
+          len = nSize - 1; /* less the null */
+        memcpy(pReturnedString,pValue,len);
+        pReturnedString[len] = '\0';
+        count = len;
+      }
+      else
+        use_default = TRUE;
+    }
+    else if (!pSection->pFirst)
+      use_default = TRUE;
+    else
+    {
+      for (pEntry = pSection->pFirst; pEntry; pEntry = pEntry->pNext)
+      {
+        if (!doc_list_append(&pList,&count,nSize,pEntry->pKeyName))
+          break;
+      }
+    }
+  }
+  if ((!pKeyName || !pAppName) && !use_default)
+  {
+    /* count doesn't include last 2 nulls */
+    if (count)
+      count--;
+    pList[0] = '\0';
+  }
+  if (use_default && pDefault)
+  {
+    /* cleanup the default the same way as GetPrivateProfileString */
+    pValue = pDefault;
+    len = strlen(pValue);
+    if (len >= nSize)
+      len = nSize - 1;
+    while (len && isspace((unsigned char)pValue[len - 1]))
+      len--;
+    while (len && isspace((unsigned char)*pValue))
+    {
+      pValue++;
+      len--;
+    }
+    if ((len > 1) &&
+      (((*pValue == '\'') && (pValue[len - 1] == '\'')) ||
+      ((*pValue == '\"') && (pValue[len - 1] == '\"'))))
+    {
+      pValue++;
+      len -= 2;
+    }
+    memmove(pReturnedString,pValue,len);
+    pReturnedString[len] = '\0';
+    count = len;
+  }
+
+  return (count);
+}
+
+/**
+ * Remove an item from a hash table chain
+ *
+ * @param pTable - hash table
+ * @param pItem - item to remove
+ * @param hash - hash value of the item
+ * @param link - offset of the chain pointer in an item
+ */
+static void doc_table_remove(
+  struct doc_table *pTable,
+  void *pItem,
+  unsigned hash,
+  size_t link)
+{
+  void **ppLink = &pTable->ppBucket[hash & (pTable->size - 1)];
+
+  while (*ppLink)
+  {
+    if (*ppLink == pItem)
+    {
+      *ppLink = *(void **)((char *)pItem + link);
+      pTable->count--;
+      break;
+    }
+    ppLink = (void **)((char *)*ppLink + link);
+  }
+}
+
+/**
+ * Change a document the same way WritePrivateProfileString changes
+ * a file.  Memory of removed items stays in the arena until the
+ * document is freed.
+ *
+ * @param pDoc - document
+ * @param pAppName - section name
+ * @param pKeyName - key name, or NULL to delete the section
+ * @param pString - string to write, or NULL to delete the key
+ *
+ * @return TRUE if the string was written, or the key or section
+ *  was deleted; FALSE if it was not there or out of memory
+ */
+BOOL profile_doc_set(
+  PROFILE_DOC *pDoc,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_SECTION **ppSection;
+  PROFILE_ENTRY *pEntry;
+  PROFILE_ENTRY **ppEntry;
+  char *pValue;
+
+  if (!pDoc || !pAppName)
+    return (FALSE);
+  if (pKeyName && pString)
+  {
+    pSection = profile_doc_add_section(pDoc,pAppName);
+    if (!pSection)
+      return (FALSE);
+    pEntry = profile_doc_entry(pDoc,pAppName,pKeyName);
+    if (!pEntry)
+      return (profile_doc_add_entry(pDoc,pSection,pKeyName,pString) != NULL);
+    pValue = arena_strndup(pDoc->pArena,pString,strlen(pString));
+    if (!pValue)
+      return (FALSE);
+    pEntry->pValue = pValue;
+    return (TRUE);
+  }
+  pSection = profile_doc_section(pDoc,pAppName);
+  if (!pSection)
+    return (FALSE);
+  if (pKeyName)
+  {
+    pEntry = profile_doc_entry(pDoc,pAppName,pKeyName);
+    if (!pEntry)
+      return (FALSE);
+    doc_table_remove(&pDoc->entries,pEntry,pEntry->hash,
+      offsetof(PROFILE_ENTRY,pHashNext));
+    pSection->pLast = NULL;
+    for (ppEntry = &pSection->pFirst; *ppEntry;
+      ppEntry = &(*ppEntry)->pNext)
+    {
+      if (*ppEntry == pEntry)
+        *ppEntry = pEntry->pNext;
+      if (!*ppEntry)
+        break;
+      pSection->pLast = *ppEntry;
+    }
+    pSection->count--;
+    return (TRUE);
+  }
+  for (pEntry = pSection->pFirst; pEntry; pEntry = pEntry->pNext)
+    doc_table_remove(&pDoc->entries,pEntry,pEntry->hash,
+      offsetof(PROFILE_ENTRY,pHashNext));
+  doc_table_remove(&pDoc->sections,pSection,pSection->hash,
+    offsetof(PROFILE_SECTION,pHashNext));
+  pDoc->pLast = NULL;
+  for (ppSection = &pDoc->pFirst; *ppSection;
+    ppSection = &(*ppSection)->pNext)
+  {
+    if (*ppSection == pSection)
+      *ppSection = pSection->pNext;
+    if (!*ppSection)
+      break;
+    pDoc->pLast = *ppSection;
+  }
+  pDoc->count--;
+
+  return (TRUE);
+}
+
+/**
+ * Append text to a buffer, counting what does not fit
+ *
+ * @param pBuffer - buffer
+ * @param nSize - size of the buffer
+ * @param pCount - number of characters so far, updated
+ * @param pText - characters to append
+ * @param len - number of characters to append
+ */
+static void doc_emit(
+  char *pBuffer,
+  size_t nSize,
+  size_t *pCount,
+  const char *pText,
+  size_t len)
+{
+  size_t room = 0;
+
+  if (*pCount < nSize)
+  {
+    room = nSize - *pCount - 1;
+    memcpy(pBuffer + *pCount,pText,(len < room) ? len : room);
+  }
+  *pCount += len;
+}
+
+/**
+ * Check whether a value must be quoted to read back the same
+ *
+ * @param pValue - value
+ * @param len - number of characters in the value
+ *
+ * @return TRUE if the value has white space at either end,
+ *  or is enclosed in quotes that would be removed
+ */
+static BOOL doc_needs_quotes(
+  const char *pValue,
+  size_t len)
+{
+  if (len == 0)
+    return (FALSE);
+  if (isspace((unsigned char)pValue[0]) ||
+    isspace((unsigned char)pValue[len - 1]))
+    return (TRUE);
+
+  return ((len > 1) &&
+    (((pValue[0] == '\'') && (pValue[len - 1] == '\'')) ||
+    ((pValue[0] == '\"') && (pValue[len - 1] == '\"'))));
+}
+
+/**
+ * Write a document as INI text into a buffer.  Reading the text
+ * back gives the same sections, keys and values.
+ *
+ * @param pDoc - document
+ * @param pBuffer - buffer that receives the text and a null,
+ *  may be NULL when nSize is zero
+ * @param nSize - size of the buffer
+ *
+ * @return number of characters in the whole text, not including
+ *  the null.  If this is nSize or more, the text was truncated.
+ */
+size_t profile_doc_serialize(
+  const PROFILE_DOC *pDoc,
+  char *pBuffer,
+  size_t nSize)
+{
+  PROFILE_SECTION *pSection;
+  PROFILE_ENTRY *pEntry;
+  size_t count = 0;
+  size_t len;
+
+  if (!pBuffer)
+    nSize = 0;
+  for (pSection = pDoc ? pDoc->pFirst : NULL; pSection;
+    pSection = pSection->pNext)
+  {
+    doc_emit(pBuffer,nSize,&count,"[",1);
+    doc_emit(pBuffer,nSize,&count,pSection->pAppName,pSection->app_len);
+    doc_emit(pBuffer,nSize,&count,"]\n",2);
+    for (pEntry = pSection->pFirst; pEntry; pEntry = pEntry->pNext)
+    {
+      doc_emit(pBuffer,nSize,&count,pEntry->pKeyName,pEntry->key_len);
+      if (pEntry->pValue)
+      {
+        len = strlen(pEntry->pValue);
+        doc_emit(pBuffer,nSize,&count,"=",1);
+        if (doc_needs_quotes(pEntry->pValue,len))
+        {
+          doc_emit(pBuffer,nSize,&count,"\"",1);
+          doc_emit(pBuffer,nSize,&count,pEntry->pValue,len);
+          doc_emit(pBuffer,nSize,&count,"\"",1);
+        }
+        else
+          doc_emit(pBuffer,nSize,&count,pEntry->pValue,len);
+      }
+      doc_emit(pBuffer,nSize,&count,"\n",1);
+    }
+  }
+  if (nSize)
+    pBuffer[(count < nSize) ? count : nSize - 1] = '\0';
+
+  return (count);
+}
+
+/**
+ * Number of sections in a document
+ *
+ * @param pDoc - document
+ *
+ * @return number of sections
+ */
+size_t profile_doc_section_count(
+  const PROFILE_DOC *pDoc)
+{
+  return (pDoc ? pDoc->count : 0);
+}
+
+/**
+ * First section of a document in file order
+ *
+ * @param pDoc - document
+ *
+ * @return section, or NULL if there are none
+ */
+PROFILE_SECTION *profile_doc_first(
+  const PROFILE_DOC *pDoc)
+{
+  return (pDoc ? pDoc->pFirst : NULL);
+}
+
+/**
+ * Next section in file order
+ *
+ * @param pSection - section
+ *
+ * @return section, or NULL at the end
+ */
+PROFILE_SECTION *profile_section_next(
+  const PROFILE_SECTION *pSection)
+{
+  return (pSection ? pSection->pNext : NULL);
+}
+
+/**
+ * Name of a section
+ *
+ * @param pSection - section
+ *
+ * @return section name without brackets
+ */
+const char *profile_section_name(
+  const PROFILE_SECTION *pSection)
+{
+  return (pSection ? pSection->pAppName : NULL);
+}
+
+/**
+ * Number of keys in a section
+ *
+ * @param pSection - section
+ *
+ * @return number of keys
+ */
+size_t profile_section_entry_count(
+  const PROFILE_SECTION *pSection)
+{
+  return (pSection ? pSection->count : 0);
+}
+
+/**
+ * First key of a section in file order
+ *
+ * @param pSection - section
+ *
+ * @return entry, or NULL if there are none
+ */
+PROFILE_ENTRY *profile_section_first(
+  const PROFILE_SECTION *pSection)
+{
+  return (pSection ? pSection->pFirst : NULL);
+}
+
+/**
+ * Next key in file order
+ *
+ * @param pEntry - entry
+ *
+ * @return entry, or NULL at the end of the section
+ */
+PROFILE_ENTRY *profile_entry_next(
+  const PROFILE_ENTRY *pEntry)
+{
+  return (pEntry ? pEntry->pNext : NULL);
+}
+
+/**
+ * Section that a key belongs to
+ *
+ * @param pEntry - entry
+ *
+ * @return section
+ */
+PROFILE_SECTION *profile_entry_section(
+  const PROFILE_ENTRY *pEntry)
+{
+  return (pEntry ? pEntry->pSection : NULL);
+}
+
+/**
+ * Name of a key
+ *
+ * @param pEntry - entry
+ *
+ * @return key name
+ */
+const char *profile_entry_key(
+  const PROFILE_ENTRY *pEntry)
+{
+  return (pEntry ? pEntry->pKeyName : NULL);
+}
+
+/**
+ * Value of a key
+ *
+ * @param pEntry - entry
+ *
+ * @return value with quotes removed, or NULL if the line has no '='
+ */
+const char *profile_entry_value(
+  const PROFILE_ENTRY *pEntry)
+{
+  return (pEntry ? pEntry->pValue : NULL);
+}
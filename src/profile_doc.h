@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parsed, indexed in-memory copy of an INI file
+ */
+#ifndef PROFILE_DOC_H
+#define PROFILE_DOC_H
+
+#include "profile.h"
+#include "profile_intern.h"
+#include "profile_io.h"
+
+typedef struct profile_doc PROFILE_DOC;
+typedef struct profile_section PROFILE_SECTION;
+typedef struct profile_entry PROFILE_ENTRY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_DOC *profile_doc_create(void);
+  PROFILE_DOC *profile_doc_create_sized(size_t nSize);
+  PROFILE_DOC *profile_doc_load(const char *pFileName);
+  PROFILE_DOC *profile_doc_load_buffer(
+    const char *pBuffer,
+    size_t nLength);
+  PROFILE_DOC *profile_doc_load_io(
+    const PROFILE_IO *pIo,
+    const char *pFileName);
+  char *profile_doc_read_file(
+    const char *pFileName,
+    size_t *pnLength);
+  void profile_doc_free(PROFILE_DOC *pDoc);
+  size_t profile_doc_memory(const PROFILE_DOC *pDoc);
+  size_t profile_doc_blocks(const PROFILE_DOC *pDoc);
+  BOOL profile_doc_parse(
+    PROFILE_DOC *pDoc,
+    const char *pBuffer,
+    size_t nLength);
+
+  PROFILE_SECTION *profile_doc_add_section(
+    PROFILE_DOC *pDoc,
+    const char *pAppName);
+  PROFILE_ENTRY *profile_doc_add_entry(
+    PROFILE_DOC *pDoc,
+    PROFILE_SECTION *pSection,
+    const char *pKeyName,
+    const char *pValue);
+
+  PROFILE_SECTION *profile_doc_section(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName);
+  PROFILE_ENTRY *profile_doc_entry(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName,
+    const char *pKeyName);
+  const char *profile_doc_value(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName,
+    const char *pKeyName);
+  PROFILE_SECTION *profile_doc_section_n(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName,
+    size_t app_len);
+  PROFILE_ENTRY *profile_doc_entry_n(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName,
+    size_t app_len,
+    const char *pKeyName,
+    size_t key_len);
+  PROFILE_SECTION *profile_doc_section_atom(
+    const PROFILE_DOC *pDoc,
+    PROFILE_ATOM app);
+  PROFILE_ENTRY *profile_doc_entry_atom(
+    const PROFILE_DOC *pDoc,
+    PROFILE_ATOM app,
+    PROFILE_ATOM key);
+  const char *profile_doc_value_atom(
+    const PROFILE_DOC *pDoc,
+    PROFILE_ATOM app,
+    PROFILE_ATOM key);
+  BOOL profile_doc_merge(
+    PROFILE_DOC *pDest,
+    const PROFILE_DOC *pSource);
+  BOOL profile_doc_adopt(
+    PROFILE_DOC *pDest,
+    PROFILE_DOC *pSource);
+  BOOL profile_doc_set(
+    PROFILE_DOC *pDoc,
+    const char *pAppName,
+    const char *pKeyName,
+    const char *pString);
+  size_t profile_doc_serialize(
+    const PROFILE_DOC *pDoc,
+    char *pBuffer,
+    size_t nSize);
+  size_t profile_doc_get(
+    const PROFILE_DOC *pDoc,
+    const char *pAppName,
+    const char *pKeyName,
+    const char *pDefault,
+    char *pReturnedString,
+    size_t nSize);
+
+  size_t profile_doc_section_count(const PROFILE_DOC *pDoc);
+  PROFILE_SECTION *profile_doc_first(const PROFILE_DOC *pDoc);
+  PROFILE_SECTION *profile_section_next(const PROFILE_SECTION *pSection);
+  const char *profile_section_name(const PROFILE_SECTION *pSection);
+  size_t profile_section_entry_count(const PROFILE_SECTION *pSection);
+  PROFILE_ENTRY *profile_section_first(const PROFILE_SECTION *pSection);
+  PROFILE_ENTRY *profile_entry_next(const PROFILE_ENTRY *pEntry);
+  PROFILE_SECTION *profile_entry_section(const PROFILE_ENTRY *pEntry);
+  const char *profile_entry_key(const PROFILE_ENTRY *pEntry);
+  const char *profile_entry_value(const PROFILE_ENTRY *pEntry);
+
+  unsigned profile_doc_hash(
+    const char *pAppName,
+    const char *pKeyName);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_DOC_H */
@@ -0,0 +1,462 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Sorted index of keys for prefix and wildcard queries
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * An index holds every entry of a document twice over, in two sorted
+ * arrays: one ordered by section name and then key name, for queries
+ * within a section, and one ordered by key name and then section name,
+ * for queries across all of them.  Names are compared with case folded,
+ * the way GetPrivateProfileString matches them, so the keys that start
+ * with a given prefix sit next to each other in both arrays.  A prefix
+ * query is two binary searches for the ends of that run, and costs
+ * O(log n + k) for k matches instead of a walk of every key.
+ *
+ * A pattern may use '*' for any run of characters and '?' for any one
+ * character.  The characters before the first wildcard narrow the
+ * search the same way a prefix does, and only the keys in that run are
+ * matched against the rest of the pattern.  A pattern that starts with
+ * a wildcard has to look at every key in range.
+ *
+ * An index does not change once it is made, so any number of threads
+ * may query it.  It describes the document at the time it was made, and
+ * has to be made again after the document changes.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_index.h"
+#include "strfold.h"
+
+/* one entry of the document */
+struct index_record
+{
+  PROFILE_ENTRY *pEntry;
+  const char *pKeyName;
+  size_t key_len;
+  const char *pAppName;
+  size_t app_len;
+};
+
+struct profile_index
+{
+  size_t count; /* number of entries */
+  struct index_record *pRecords; /* by section name, then key name */
+  const struct index_record **ppByKey; /* by key name, then section name */
+};
+
+/* what a query looks for */
+struct index_query
+{
+  const char *pAppName; /* section name, or NULL for any */
+  size_t app_len;
+  const char *pPrefix; /* characters every key starts with */
+  size_t prefix_len;
+  const char *pPattern; /* pattern to match, or NULL for the prefix */
+};
+
+/**
+ * Compare two entries by section name, then key name, for qsort
+ *
+ * @param a - struct index_record
+ * @param b - struct index_record
+ *
+ * @return less than, equal to, or more than zero
+ */
+static int index_compare_section(
+  const void *a,
+  const void *b)
+{
+  const struct index_record *pA = a;
+  const struct index_record *pB = b;
+  int diff;
+
+  diff = strfold_cmp(pA->pAppName,pA->app_len,pB->pAppName,pB->app_len);
+  if (diff == 0)
+    diff = strfold_cmp(pA->pKeyName,pA->key_len,pB->pKeyName,pB->key_len);
+
+  return (diff);
+}
+
+/**
+ * Compare two entries by key name, then section name, for qsort
+ *
+ * @param a - pointer to a struct index_record pointer
+ * @param b - pointer to a struct index_record pointer
+ *
+ * @return less than, equal to, or more than zero
+ */
+static int index_compare_key(
+  const void *a,
+  const void *b)
+{
+  const struct index_record *pA = *(const struct index_record * const *)a;
+  const struct index_record *pB = *(const struct index_record * const *)b;
+  int diff;
+
+  diff = strfold_cmp(pA->pKeyName,pA->key_len,pB->pKeyName,pB->key_len);
+  if (diff == 0)
+    diff = strfold_cmp(pA->pAppName,pA->app_len,pB->pAppName,pB->app_len);
+
+  return (diff);
+}
+
+/**
+ * Index the entries of a document
+ *
+ * @param pDoc (IN) document, which must not be freed while the
+ *  index is in use
+ *
+ * @return index, or NULL if out of memory
+ */
+PROFILE_INDEX *profile_index_create(
+  const PROFILE_DOC *pDoc)
+{
+  PROFILE_INDEX *pIndex;
+  PROFILE_SECTION *pSection;
+  PROFILE_ENTRY *pEntry;
+  struct index_record *pRecord;
+  size_t count = 0;
+  size_t i;
+
+  if (!pDoc)
+    return (NULL);
+  for (pSection = profile_doc_first(pDoc); pSection;
+    pSection = profile_section_next(pSection))
+    count += profile_section_entry_count(pSection);
+  pIndex = calloc(1,sizeof(PROFILE_INDEX));
+  if (!pIndex)
+    return (NULL);
+  if (count)
+  {
+    pIndex->pRecords = malloc(count * sizeof(struct index_record));
+    pIndex->ppByKey = malloc(count * sizeof(struct index_record *));
+    if (!pIndex->pRecords || !pIndex->ppByKey)
+    {
+      profile_index_free(pIndex);
+      return (NULL);
+    }
+  }
+  pRecord = pIndex->pRecords;
+  for (pSection = profile_doc_first(pDoc); pSection;
+    pSection = profile_section_next(pSection))
+  {
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry))
+    {
+      pRecord->pEntry = pEntry;
+      pRecord->pKeyName = profile_entry_key(pEntry);
+      pRecord->key_len = strlen(pRecord->pKeyName);
+      pRecord->pAppName = profile_section_name(pSection);
+      pRecord->app_len = strlen(pRecord->pAppName);
+      pRecord++;
+    }
+  }
+  pIndex->count = count;
+  if (count)
+  {
+    qsort(pIndex->pRecords,count,sizeof(struct index_record),
+      index_compare_section);
+    for (i = 0; i < count; i++)
+      pIndex->ppByKey[i] = &pIndex->pRecords[i];
+    qsort(pIndex->ppByKey,count,sizeof(struct index_record *),
+      index_compare_key);
+  }
+
+  return (pIndex);
+}
+
+/**
+ * Release an index.  The document is not changed.
+ *
+ * @param pIndex (IN) index, may be NULL
+ */
+void profile_index_free(
+  PROFILE_INDEX *pIndex)
+{
+  if (pIndex)
+  {
+    free(pIndex->pRecords);
+    free(pIndex->ppByKey);
+    free(pIndex);
+  }
+}
+
+/**
+ * Number of entries in an index
+ *
+ * @param pIndex (IN) index
+ *
+ * @return number of entries
+ */
+size_t profile_index_count(
+  const PROFILE_INDEX *pIndex)
+{
+  return (pIndex ? pIndex->count : 0);
+}
+
+/**
+ * Compare an entry with a query, in the order of the array searched
+ *
+ * @param pRecord - entry
+ * @param pQuery - query; the section name is compared first if given
+ *
+ * @return less than zero if the entry comes before the matches,
+ *  zero if it is in their run, more than zero if it comes after
+ */
+static int index_compare_query(
+  const struct index_record *pRecord,
+  const struct index_query *pQuery)
+{
+  size_t len;
+  int diff = 0;
+
+  if (pQuery->pAppName)
+    diff = strfold_cmp(pRecord->pAppName,pRecord->app_len,
+      pQuery->pAppName,pQuery->app_len);
+  if (diff == 0)
+  {
+    /* only the start of the key has to match the prefix */
+    len = pRecord->key_len < pQuery->prefix_len ?
+      pRecord->key_len : pQuery->prefix_len;
+    diff = strfold_cmp(pRecord->pKeyName,len,pQuery->pPrefix,
+      pQuery->prefix_len);
+  }
+
+  return (diff);
+}
+
+/**
+ * Entry at a position of the array a query searches
+ *
+ * @param pIndex - index
+ * @param pQuery - query
+ * @param i - position
+ *
+ * @return entry
+ */
+static const struct index_record *index_at(
+  const PROFILE_INDEX *pIndex,
+  const struct index_query *pQuery,
+  size_t i)
+{
+  return (pQuery->pAppName ? &pIndex->pRecords[i] : pIndex->ppByKey[i]);
+}
+
+/**
+ * Binary search for one end of the run of entries a query looks at
+ *
+ * @param pIndex - index
+ * @param pQuery - query
+ * @param after - FALSE for the first entry of the run,
+ *  TRUE for the first entry after it
+ *
+ * @return position in the array
+ */
+static size_t index_bound(
+  const PROFILE_INDEX *pIndex,
+  const struct index_query *pQuery,
+  BOOL after)
+{
+  size_t low = 0;
+  size_t high = pIndex->count;
+  size_t middle;
+  int diff;
+
+  while (low < high)
+  {
+    middle = low + (high - low) / 2;
+    diff = index_compare_query(index_at(pIndex,pQuery,middle),pQuery);
+    if ((diff < 0) || (after && (diff == 0)))
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return (low);
+}
+
+/**
+ * Match a name against a pattern, with case folded
+ *
+ * @param pPattern - pattern, where '*' is any run of characters
+ *  and '?' is any one character
+ * @param pName - name
+ * @param len - number of characters in the name
+ *
+ * @return TRUE if the whole name matches
+ */
+static BOOL index_match(
+  const char *pPattern,
+  const char *pName,
+  size_t len)
+{
+  const char *pStar = NULL; /* pattern after the last '*' */
+  size_t retry = 0; /* where that '*' will match up to next */
+  size_t i = 0;
+
+  while (i < len)
+  {
+    if (*pPattern == '*')
+    {
+      pStar = ++pPattern;
+      retry = i;
+    }
+    else if (*pPattern && ((*pPattern == '?') ||
+      (strfold_char(*pPattern) == strfold_char(pName[i]))))
+    {
+      pPattern++;
+      i++;
+    }
+    else if (pStar)
+    {
+      /* let the '*' take one more character */
+      pPattern = pStar;
+      i = ++retry;
+    }
+    else
+      return (FALSE);
+  }
+  while (*pPattern == '*')
+    pPattern++;
+
+  return (*pPattern == 0);
+}
+
+/**
+ * Collect the entries that match a query
+ *
+ * @param pIndex - index
+ * @param pQuery - query
+ * @param ppEntries - array that receives the entries, may be NULL
+ * @param nMax - number of entries the array holds
+ *
+ * @return number of entries that match, which may be more than nMax
+ */
+static size_t index_query(
+  const PROFILE_INDEX *pIndex,
+  const struct index_query *pQuery,
+  PROFILE_ENTRY **ppEntries,
+  size_t nMax)
+{
+  const struct index_record *pRecord;
+  size_t first;
+  size_t last;
+  size_t count = 0;
+
+  if (!pIndex->count)
+    return (count);
+  first = index_bound(pIndex,pQuery,FALSE);
+  last = index_bound(pIndex,pQuery,TRUE);
+  for (; first < last; first++)
+  {
+    pRecord = index_at(pIndex,pQuery,first);
+    if (pQuery->pPattern && !index_match(pQuery->pPattern,
+      pRecord->pKeyName,pRecord->key_len))
+      continue;
+    if (ppEntries && (count < nMax))
+      ppEntries[count] = pRecord->pEntry;
+    count++;
+  }
+
+  return (count);
+}
+
+/**
+ * Find the entries whose key names start with a prefix.  Entries are
+ * returned in order of key name, with case folded, and entries of
+ * different sections with the same key name in order of section name.
+ *
+ * @param pIndex (IN) index
+ * @param pAppName (IN) section name, or NULL for every section
+ * @param pPrefix (IN) prefix; an empty prefix matches every key
+ * @param ppEntries (OUT) array that receives the entries, may be NULL
+ *  to only count them
+ * @param nMax (IN) number of entries the array holds
+ *
+ * @return number of entries that match, which is more than nMax
+ *  if the array was too small
+ */
+size_t profile_index_prefix(
+  const PROFILE_INDEX *pIndex,
+  const char *pAppName,
+  const char *pPrefix,
+  PROFILE_ENTRY **ppEntries,
+  size_t nMax)
+{
+  struct index_query query;
+
+  if (!pIndex || !pPrefix)
+    return (0);
+  query.pAppName = pAppName;
+  query.app_len = pAppName ? strlen(pAppName) : 0;
+  query.pPrefix = pPrefix;
+  query.prefix_len = strlen(pPrefix);
+  query.pPattern = NULL;
+
+  return (index_query(pIndex,&query,ppEntries,nMax));
+}
+
+/**
+ * Find the entries whose key names match a pattern, in the same order
+ * as profile_index_prefix.  A '*' in the pattern matches any run of
+ * characters and a '?' any one character, and letters match either
+ * case.  So "Channel.*" finds every key that starts with "Channel.".
+ *
+ * @param pIndex (IN) index
+ * @param pAppName (IN) section name, or NULL for every section
+ * @param pPattern (IN) pattern
+ * @param ppEntries (OUT) array that receives the entries, may be NULL
+ *  to only count them
+ * @param nMax (IN) number of entries the array holds
+ *
+ * @return number of entries that match, which is more than nMax
+ *  if the array was too small
+ */
+size_t profile_index_glob(
+  const PROFILE_INDEX *pIndex,
+  const char *pAppName,
+  const char *pPattern,
+  PROFILE_ENTRY **ppEntries,
+  size_t nMax)
+{
+  struct index_query query;
+
+  if (!pIndex || !pPattern)
+    return (0);
+  query.pAppName = pAppName;
+  query.app_len = pAppName ? strlen(pAppName) : 0;
+  query.pPrefix = pPattern;
+  query.prefix_len = strcspn(pPattern,"*?");
+  query.pPattern = pPattern;
+
+  return (index_query(pIndex,&query,ppEntries,nMax));
+}
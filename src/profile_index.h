@@ -0,0 +1,39 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Sorted index of keys for prefix and wildcard queries
+ */
+#ifndef PROFILE_INDEX_H
+#define PROFILE_INDEX_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_doc.h"
+
+typedef struct profile_index PROFILE_INDEX;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_INDEX *profile_index_create(const PROFILE_DOC *pDoc);
+  void profile_index_free(PROFILE_INDEX *pIndex);
+  size_t profile_index_count(const PROFILE_INDEX *pIndex);
+
+  size_t profile_index_prefix(
+    const PROFILE_INDEX *pIndex,
+    const char *pAppName,
+    const char *pPrefix,
+    PROFILE_ENTRY **ppEntries,
+    size_t nMax);
+  size_t profile_index_glob(
+    const PROFILE_INDEX *pIndex,
+    const char *pAppName,
+    const char *pPattern,
+    PROFILE_ENTRY **ppEntries,
+    size_t nMax);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_INDEX_H */
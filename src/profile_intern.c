@@ -0,0 +1,436 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Shared pool of section and key names
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * Many INI files tend to use the same few section and key names.  Once
+ * profile_intern_init has been called, documents store their names in
+ * this pool instead of keeping private copies, so each spelling of a
+ * name is kept once for the whole program.
+ *
+ * Every name belongs to an atom, a small number shared by all the
+ * spellings of the name that differ only in case, the same way that
+ * GetPrivateProfileString matches names.  A name that was interned
+ * ahead of time can be looked up in a document by its atom, which
+ * turns the name compare into an integer compare.
+ * {@code
+ * profile_intern_init();
+ * key = profile_intern("Key1");
+ * app = profile_intern("Section1");
+ * value = profile_doc_value_atom(pDoc,app,key);
+ * profile_intern_cleanup();
+ * }
+ *
+ * The pool only grows.  profile_intern_cleanup releases it, and must
+ * not be called while any document that uses it is still around.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "profile_intern.h"
+#include "arena.h"
+#include "strfold.h"
+
+/* initial number of hash buckets - must be a power of two */
+#define INTERN_HASH_BUCKETS 256
+/* first arena block of the pool */
+#define INTERN_ARENA_SIZE 16384
+/* atoms are kept in pages that never move */
+#define INTERN_PAGE_SIZE 256
+#define INTERN_MAX_PAGES 4096
+
+/* one spelling of a name */
+struct intern_name
+{
+  const char *pName;
+  size_t len; /* number of characters in pName */
+  unsigned hash; /* strfold_hash of the name */
+  PROFILE_ATOM atom;
+  struct intern_name *pHashNext;
+};
+
+/* all the spellings of a name that differ only in case */
+struct intern_atom
+{
+  const char *pName; /* first spelling */
+  unsigned hash; /* strfold_hash of the name */
+};
+
+static pthread_mutex_t Intern_Lock = PTHREAD_MUTEX_INITIALIZER;
+/* written under Intern_Lock, and read with __atomic_load_n without it */
+static BOOL Intern_Enabled = FALSE;
+static ARENA *Intern_Arena = NULL;
+static struct intern_name **Intern_Bucket = NULL;
+static size_t Intern_Size = 0; /* number of buckets */
+static size_t Intern_Names = 0; /* number of spellings */
+static struct intern_atom *Atom_Page[INTERN_MAX_PAGES];
+static size_t Atom_Count = 0; /* number of atoms */
+
+/**
+ * Find one spelling of a name.  The caller holds Intern_Lock.
+ *
+ * @param pName - start of the name
+ * @param len - number of characters in the name
+ * @param hash - strfold_hash of the name
+ * @param pAtom - receives the atom of the name if any spelling
+ *  of it is in the pool, or 0 if none is
+ *
+ * @return the exact spelling, or NULL if it is not in the pool
+ */
+static struct intern_name *intern_lookup(
+  const char *pName,
+  size_t len,
+  unsigned hash,
+  PROFILE_ATOM *pAtom)
+{
+  struct intern_name *pNode;
+
+  *pAtom = 0;
+  for (pNode = Intern_Bucket[hash & (Intern_Size - 1)]; pNode;
+    pNode = pNode->pHashNext)
+  {
+    if ((pNode->hash != hash) || (pNode->len != len))
+      continue;
+    if (memcmp(pNode->pName,pName,len) == 0)
+    {
+      *pAtom = pNode->atom;
+      return (pNode);
+    }
+    if (strfold_equal(pNode->pName,pName,len))
+      *pAtom = pNode->atom;
+  }
+
+  return (NULL);
+}
+
+/**
+ * Make room for one more spelling.  The caller holds Intern_Lock.
+ *
+ * @return TRUE if there is room
+ */
+static BOOL intern_reserve(void)
+{
+  struct intern_name **ppBucket;
+  struct intern_name *pNode;
+  struct intern_name *pNext;
+  size_t size;
+  size_t i;
+
+  if (Intern_Names < Intern_Size)
+    return (TRUE);
+  size = Intern_Size * 2;
+  ppBucket = calloc(size,sizeof(struct intern_name *));
+  if (!ppBucket)
+    return (FALSE);
+  for (i = 0; i < Intern_Size; i++)
+  {
+    for (pNode = Intern_Bucket[i]; pNode; pNode = pNext)
+    {
+      pNext = pNode->pHashNext;
+      pNode->pHashNext = ppBucket[pNode->hash & (size - 1)];
+      ppBucket[pNode->hash & (size - 1)] = pNode;
+    }
+  }
+  free(Intern_Bucket);
+  Intern_Bucket = ppBucket;
+  Intern_Size = size;
+
+  return (TRUE);
+}
+
+/**
+ * Start a new atom.  The caller holds Intern_Lock.
+ *
+ * @param pName - first spelling, already in the pool
+ * @param hash - strfold_hash of the name
+ *
+ * @return new atom, or 0 if out of memory or atoms
+ */
+static PROFILE_ATOM intern_new_atom(
+  const char *pName,
+  unsigned hash)
+{
+  size_t page = Atom_Count / INTERN_PAGE_SIZE;
+  struct intern_atom *pAtom;
+
+  if (page >= INTERN_MAX_PAGES)
+    return (0);
+  if (!Atom_Page[page])
+  {
+    Atom_Page[page] = arena_alloc(Intern_Arena,
+      INTERN_PAGE_SIZE * sizeof(struct intern_atom));
+    if (!Atom_Page[page])
+      return (0);
+  }
+  pAtom = &Atom_Page[page][Atom_Count % INTERN_PAGE_SIZE];
+  pAtom->pName = pName;
+  pAtom->hash = hash;
+  Atom_Count++;
+
+  return ((PROFILE_ATOM)Atom_Count);
+}
+
+/**
+ * Start sharing section and key names between documents.
+ * Documents created after this call use the pool.
+ *
+ * @return TRUE if the pool is ready
+ */
+BOOL profile_intern_init(void)
+{
+  BOOL status = TRUE;
+
+  pthread_mutex_lock(&Intern_Lock);
+  if (!Intern_Enabled)
+  {
+    Intern_Arena = arena_create(INTERN_ARENA_SIZE);
+    Intern_Bucket = calloc(INTERN_HASH_BUCKETS,sizeof(struct intern_name *));
+    if (Intern_Arena && Intern_Bucket)
+    {
+      Intern_Size = INTERN_HASH_BUCKETS;
+      __atomic_store_n(&Intern_Enabled,TRUE,__ATOMIC_RELEASE);
+    }
+    else
+    {
+      arena_free(Intern_Arena);
+      free(Intern_Bucket);
+      Intern_Arena = NULL;
+      Intern_Bucket = NULL;
+      status = FALSE;
+    }
+  }
+  pthread_mutex_unlock(&Intern_Lock);
+
+  return (status);
+}
+
+/**
+ * Release the pool.  Every document that uses it must be freed first.
+ */
+void profile_intern_cleanup(void)
+{
+  pthread_mutex_lock(&Intern_Lock);
+  __atomic_store_n(&Intern_Enabled,FALSE,__ATOMIC_RELEASE);
+  arena_free(Intern_Arena);
+  free(Intern_Bucket);
+  Intern_Arena = NULL;
+  Intern_Bucket = NULL;
+  Intern_Size = 0;
+  Intern_Names = 0;
+  memset(Atom_Page,0,sizeof(Atom_Page));
+  Atom_Count = 0;
+  pthread_mutex_unlock(&Intern_Lock);
+}
+
+/**
+ * Check whether documents share their names
+ *
+ * @return TRUE between profile_intern_init and profile_intern_cleanup
+ */
+BOOL profile_intern_enabled(void)
+{
+  return (__atomic_load_n(&Intern_Enabled,__ATOMIC_ACQUIRE));
+}
+
+/**
+ * Get the shared copy of a spelling of a name, adding it if needed
+ *
+ * @param pName (IN) start of the name, which need not be null-terminated
+ * @param len (IN) number of characters in the name
+ * @param pAtom (OUT) receives the atom of the name, may be NULL
+ * @param pHash (OUT) receives the strfold_hash of the name, may be NULL
+ *
+ * @return null-terminated shared copy that lasts until
+ *  profile_intern_cleanup, or NULL if the pool is not in use
+ *  or out of memory
+ */
+const char *profile_intern_string(
+  const char *pName,
+  size_t len,
+  PROFILE_ATOM *pAtom,
+  unsigned *pHash)
+{
+  struct intern_name *pNode = NULL;
+  PROFILE_ATOM atom = 0;
+  unsigned hash;
+  char *pCopy;
+
+  if (!pName || !__atomic_load_n(&Intern_Enabled,__ATOMIC_ACQUIRE))
+    return (NULL);
+  hash = strfold_hash(pName,len);
+  pthread_mutex_lock(&Intern_Lock);
+  if (Intern_Enabled)
+  {
+    pNode = intern_lookup(pName,len,hash,&atom);
+    if (!pNode && intern_reserve())
+    {
+      pNode = arena_alloc(Intern_Arena,sizeof(struct intern_name));
+      pCopy = arena_strndup(Intern_Arena,pName,len);
+      if (pNode && pCopy && !atom)
+        atom = intern_new_atom(pCopy,hash);
+      if (pNode && pCopy && atom)
+      {
+        pNode->pName = pCopy;
+        pNode->len = len;
+        pNode->hash = hash;
+        pNode->atom = atom;
+        pNode->pHashNext = Intern_Bucket[hash & (Intern_Size - 1)];
+        Intern_Bucket[hash & (Intern_Size - 1)] = pNode;
+        Intern_Names++;
+      }
+      else
+        pNode = NULL;
+    }
+  }
+  pthread_mutex_unlock(&Intern_Lock);
+  if (!pNode)
+    return (NULL);
+  if (pAtom)
+    *pAtom = pNode->atom;
+  if (pHash)
+    *pHash = hash;
+
+  return (pNode->pName);
+}
+
+/**
+ * Intern a name
+ *
+ * @param pName (IN) section or key name
+ *
+ * @return atom shared by every spelling of the name that differs
+ *  only in case, or 0 if the pool is not in use or out of memory
+ */
+PROFILE_ATOM profile_intern(
+  const char *pName)
+{
+  PROFILE_ATOM atom = 0;
+
+  if (pName && !profile_intern_string(pName,strlen(pName),&atom,NULL))
+    atom = 0;
+
+  return (atom);
+}
+
+/**
+ * Find the atom of a name without adding it
+ *
+ * @param pName (IN) section or key name
+ *
+ * @return atom, or 0 if no spelling of the name is in the pool
+ */
+PROFILE_ATOM profile_intern_find(
+  const char *pName)
+{
+  PROFILE_ATOM atom = 0;
+  size_t len;
+  unsigned hash;
+
+  if (!pName || !__atomic_load_n(&Intern_Enabled,__ATOMIC_ACQUIRE))
+    return (0);
+  len = strlen(pName);
+  hash = strfold_hash(pName,len);
+  pthread_mutex_lock(&Intern_Lock);
+  if (Intern_Enabled)
+    (void)intern_lookup(pName,len,hash,&atom);
+  pthread_mutex_unlock(&Intern_Lock);
+
+  return (atom);
+}
+
+/**
+ * Get the atom record.  Atoms never move, so no lock is needed
+ * for an atom that came from the pool.
+ *
+ * @param atom - atom
+ *
+ * @return atom record, or NULL if atom is not valid
+ */
+static const struct intern_atom *intern_atom(
+  PROFILE_ATOM atom)
+{
+  size_t index;
+
+  if (!atom || !__atomic_load_n(&Intern_Enabled,__ATOMIC_ACQUIRE))
+    return (NULL);
+  index = (size_t)atom - 1;
+  if ((index / INTERN_PAGE_SIZE) >= INTERN_MAX_PAGES)
+    return (NULL);
+  if (!Atom_Page[index / INTERN_PAGE_SIZE])
+    return (NULL);
+
+  return (&Atom_Page[index / INTERN_PAGE_SIZE][index % INTERN_PAGE_SIZE]);
+}
+
+/**
+ * Get the name of an atom
+ *
+ * @param atom (IN) atom from profile_intern
+ *
+ * @return first spelling of the name that was interned, or NULL
+ */
+const char *profile_intern_name(
+  PROFILE_ATOM atom)
+{
+  const struct intern_atom *pAtom = intern_atom(atom);
+
+  return (pAtom ? pAtom->pName : NULL);
+}
+
+/**
+ * Get the hash of an atom
+ *
+ * @param atom (IN) atom from profile_intern
+ *
+ * @return strfold_hash of the name of the atom, or 0
+ */
+unsigned profile_intern_hash(
+  PROFILE_ATOM atom)
+{
+  const struct intern_atom *pAtom = intern_atom(atom);
+
+  return (pAtom ? pAtom->hash : 0);
+}
+
+/**
+ * Number of names in the pool
+ *
+ * @return number of atoms
+ */
+size_t profile_intern_count(void)
+{
+  size_t count;
+
+  pthread_mutex_lock(&Intern_Lock);
+  count = Atom_Count;
+  pthread_mutex_unlock(&Intern_Lock);
+
+  return (count);
+}
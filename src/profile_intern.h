@@ -0,0 +1,38 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Shared pool of section and key names
+ */
+#ifndef PROFILE_INTERN_H
+#define PROFILE_INTERN_H
+
+#include <stddef.h>
+#include "profile.h"
+
+/* names that differ only in case have the same atom; 0 is no atom */
+typedef unsigned PROFILE_ATOM;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  BOOL profile_intern_init(void);
+  void profile_intern_cleanup(void);
+  BOOL profile_intern_enabled(void);
+
+  PROFILE_ATOM profile_intern(const char *pName);
+  PROFILE_ATOM profile_intern_find(const char *pName);
+  const char *profile_intern_name(PROFILE_ATOM atom);
+  unsigned profile_intern_hash(PROFILE_ATOM atom);
+  size_t profile_intern_count(void);
+
+  const char *profile_intern_string(
+    const char *pName,
+    size_t len,
+    PROFILE_ATOM *pAtom,
+    unsigned *pHash);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_INTERN_H */
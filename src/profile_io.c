@@ -0,0 +1,1103 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Pluggable file access for INI files
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * A backend is a small table of operations: open a file, get all of its
+ * contents, write new contents, commit them, and stat the file.  Four
+ * backends are built in:
+ *
+ *  - posix reads with read(2) and commits by renaming a temporary file
+ *    over the old one, so readers see either the old or the new file.
+ *  - mmap maps the file instead of reading it, and commits like posix.
+ *  - stdio reads with fread and commits by copying a tmpfile over the
+ *    old file, the same way WritePrivateProfileString does.
+ *  - memory keeps files in the heap, by name, and never touches the
+ *    file system.  Each one made by profile_io_memory_create is its
+ *    own set of files.
+ *
+ * Callers choose a backend for each call, and may supply their own.
+ * {@code
+ * PROFILE_IO *pIo = profile_io_memory_create();
+ * WritePrivateProfileStringIo(pIo,"app","key","value","my.ini");
+ * GetPrivateProfileStringIo(pIo,"app","key","",buf,sizeof(buf),"my.ini");
+ * profile_io_memory_free(pIo);
+ * }
+ */
+
+/* includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_sync.h"
+
+/* size of the first buffer used to read a file */
+#define IO_BLOCKSIZE 4096
+
+/* a file opened to read: its whole contents */
+struct io_reader
+{
+  char *pBuffer; /* contents, from malloc or mmap */
+  size_t nLength; /* number of bytes in pBuffer */
+  BOOL mapped; /* TRUE if pBuffer came from mmap */
+};
+
+/* a file opened to write with the posix or mmap backends */
+struct io_fd_writer
+{
+  struct io_reader reader; /* so the handle can be closed like a reader */
+  int fd; /* temporary file */
+  char *pFileName; /* file to replace */
+  char *pTempName; /* temporary file next to it */
+};
+
+/* a file opened to write with the stdio backend */
+struct io_stdio_writer
+{
+  struct io_reader reader;
+  FILE *pTempFile;
+  char *pFileName;
+};
+
+/* one file of the memory backend */
+struct io_memory_file
+{
+  char *pFileName;
+  char *pBuffer;
+  size_t nLength;
+  long long mtime; /* change counter */
+  struct io_memory_file *pNext;
+};
+
+/* the files of the memory backend */
+struct io_memory
+{
+  PROFILE_IO io;
+  pthread_mutex_t lock;
+  struct io_memory_file *pFirst;
+  long long clock; /* bumped on every commit */
+};
+
+/* a file opened with the memory backend */
+struct io_memory_handle
+{
+  struct io_reader reader; /* copy of the contents, or new contents */
+  size_t nSize; /* size of reader.pBuffer when writing */
+  int mode;
+  struct io_memory *pMemory;
+  char *pFileName;
+};
+
+/**
+ * Copy a string into the heap
+ *
+ * @param pString - string
+ *
+ * @return copy, or NULL if out of memory
+ */
+static char *io_strdup(
+  const char *pString)
+{
+  size_t len = strlen(pString) + 1;
+  char *pCopy = malloc(len);
+
+  if (pCopy)
+    memcpy(pCopy,pString,len);
+
+  return (pCopy);
+}
+
+/**
+ * Stat a file in the file system
+ *
+ * @param pContext - unused
+ * @param pFileName - name of the file
+ * @param pStat - receives what is known about the file
+ *
+ * @return TRUE if the file exists
+ */
+static BOOL io_file_stat(
+  void *pContext,
+  const char *pFileName,
+  PROFILE_IO_STAT *pStat)
+{
+  struct stat file_stat;
+
+  (void)pContext;
+  memset(pStat,0,sizeof(PROFILE_IO_STAT));
+  if (stat(pFileName,&file_stat) != 0)
+    return (FALSE);
+  pStat->exists = TRUE;
+  pStat->size = (size_t)file_stat.st_size;
+  pStat->mtime = (long long)file_stat.st_mtime * 1000000000LL;
+#if defined(__linux__)
+  pStat->mtime += file_stat.st_mtim.tv_nsec;
+#endif
+
+  return (TRUE);
+}
+
+/**
+ * Contents of a file opened to read
+ *
+ * @param pHandle - handle from open
+ * @param pnLength - receives the number of bytes
+ *
+ * @return contents, which are not null-terminated
+ */
+static const char *io_map(
+  void *pHandle,
+  size_t *pnLength)
+{
+  struct io_reader *pReader = pHandle;
+
+  *pnLength = pReader->nLength;
+
+  return (pReader->pBuffer);
+}
+
+/**
+ * Release the contents of a file opened to read
+ *
+ * @param pReader - reader
+ */
+static void io_reader_release(
+  struct io_reader *pReader)
+{
+  if (pReader->mapped)
+  {
+    if (pReader->nLength)
+      (void)munmap(pReader->pBuffer,pReader->nLength);
+  }
+  else
+    free(pReader->pBuffer);
+  pReader->pBuffer = NULL;
+  pReader->nLength = 0;
+}
+
+/**
+ * Read everything from a file descriptor into the heap
+ *
+ * @param fd - file descriptor
+ * @param pReader - receives the contents
+ *
+ * @return TRUE if successful
+ */
+static BOOL io_fd_read_all(
+  int fd,
+  struct io_reader *pReader)
+{
+  struct stat file_stat;
+  size_t size = IO_BLOCKSIZE;
+  char *pGrow;
+  ssize_t num_read;
+
+  if ((fstat(fd,&file_stat) == 0) && (file_stat.st_size > 0))
+    size = (size_t)file_stat.st_size + 1;
+  pReader->pBuffer = malloc(size);
+  if (!pReader->pBuffer)
+    return (FALSE);
+  for (;;)
+  {
+    if (pReader->nLength == size)
+    {
+      size *= 2;
+      pGrow = realloc(pReader->pBuffer,size);
+      if (!pGrow)
+        return (FALSE);
+      pReader->pBuffer = pGrow;
+    }
+    num_read = read(fd,pReader->pBuffer + pReader->nLength,
+      size - pReader->nLength);
+    if (num_read > 0)
+      pReader->nLength += (size_t)num_read;
+    else if ((num_read < 0) && (errno == EINTR))
+      continue;
+    else
+      return (num_read == 0);
+  }
+}
+
+/**
+ * Open a temporary file next to the file it will replace
+ *
+ * @param pFileName - name of the file to replace
+ *
+ * @return writer, or NULL if the temporary file cannot be made
+ */
+static struct io_fd_writer *io_fd_writer_open(
+  const char *pFileName)
+{
+  struct io_fd_writer *pWriter;
+  struct stat file_stat;
+  size_t len;
+
+  pWriter = calloc(1,sizeof(struct io_fd_writer));
+  if (!pWriter)
+    return (NULL);
+  len = strlen(pFileName) + 64;
+  pWriter->pFileName = io_strdup(pFileName);
+  pWriter->pTempName = malloc(len);
+  if (!pWriter->pFileName || !pWriter->pTempName)
+  {
+    free(pWriter->pFileName);
+    free(pWriter->pTempName);
+    free(pWriter);
+    return (NULL);
+  }
+  /* the handle address keeps names unique within the process */
+  snprintf(pWriter->pTempName,len,"%s.%ld.%lx.tmp",pFileName,
+    (long)getpid(),(unsigned long)(size_t)pWriter);
+  pWriter->fd = open(pWriter->pTempName,O_WRONLY | O_CREAT | O_EXCL,0666);
+  if (pWriter->fd < 0)
+  {
+    free(pWriter->pFileName);
+    free(pWriter->pTempName);
+    free(pWriter);
+    return (NULL);
+  }
+  /* keep the permissions of the file being replaced */
+  if (stat(pFileName,&file_stat) == 0)
+    (void)fchmod(pWriter->fd,file_stat.st_mode & 07777);
+
+  return (pWriter);
+}
+
+/**
+ * Open a file with the posix or mmap backend
+ *
+ * @param pContext - non-NULL to map the file instead of reading it
+ * @param pFileName - name of the file
+ * @param mode - PROFILE_IO_READ or PROFILE_IO_WRITE
+ *
+ * @return handle, or NULL if the file cannot be opened
+ */
+static void *io_fd_open(
+  void *pContext,
+  const char *pFileName,
+  int mode)
+{
+  struct io_reader *pReader;
+  struct stat file_stat;
+  void *pMap;
+  int fd;
+
+  if (mode == PROFILE_IO_WRITE)
+    return (io_fd_writer_open(pFileName));
+  /* readers are writers that never write, so close can tell them apart */
+  pReader = calloc(1,sizeof(struct io_fd_writer));
+  if (!pReader)
+    return (NULL);
+  ((struct io_fd_writer *)pReader)->fd = -1;
+  fd = open(pFileName,O_RDONLY);
+  if (fd < 0)
+  {
+    free(pReader);
+    return (NULL);
+  }
+  if (pContext && (fstat(fd,&file_stat) == 0) &&
+    S_ISREG(file_stat.st_mode))
+  {
+    pReader->mapped = TRUE;
+    if (file_stat.st_size > 0)
+    {
+      pMap = mmap(NULL,(size_t)file_stat.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+      if (pMap == MAP_FAILED)
+        pReader->mapped = FALSE;
+      else
+      {
+        pReader->pBuffer = pMap;
+        pReader->nLength = (size_t)file_stat.st_size;
+      }
+    }
+  }
+  if (!pReader->mapped && !io_fd_read_all(fd,pReader))
+  {
+    io_reader_release(pReader);
+    free(pReader);
+    pReader = NULL;
+  }
+  (void)close(fd);
+
+  return (pReader);
+}
+
+/**
+ * Append to the temporary file of the posix or mmap backend
+ *
+ * @param pHandle - handle opened to write
+ * @param pBuffer - bytes to write
+ * @param nLength - number of bytes
+ *
+ * @return TRUE if all the bytes were written
+ */
+static BOOL io_fd_write(
+  void *pHandle,
+  const char *pBuffer,
+  size_t nLength)
+{
+  struct io_fd_writer *pWriter = pHandle;
+  ssize_t num_written;
+
+  if (pWriter->fd < 0)
+    return (FALSE);
+  while (nLength)
+  {
+    num_written = write(pWriter->fd,pBuffer,nLength);
+    if (num_written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return (FALSE);
+    }
+    pBuffer += num_written;
+    nLength -= (size_t)num_written;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Close a handle of the posix or mmap backend
+ *
+ * @param pHandle - handle
+ */
+static void io_fd_close(
+  void *pHandle)
+{
+  struct io_fd_writer *pWriter = pHandle;
+
+  if (!pWriter)
+    return;
+  if (pWriter->fd >= 0)
+  {
+    (void)close(pWriter->fd);
+    (void)unlink(pWriter->pTempName);
+  }
+  io_reader_release(&pWriter->reader);
+  free(pWriter->pFileName);
+  free(pWriter->pTempName);
+  free(pWriter);
+}
+
+/**
+ * Rename the temporary file of the posix or mmap backend over the
+ * file, then close the handle
+ *
+ * @param pHandle - handle opened to write
+ *
+ * @return TRUE if the file was replaced
+ */
+static BOOL io_fd_commit(
+  void *pHandle)
+{
+  struct io_fd_writer *pWriter = pHandle;
+  BOOL status = FALSE;
+
+  if (pWriter->fd >= 0)
+  {
+    /* the new contents reach the disk before the rename can */
+    status = profile_sync_fd(pWriter->fd,PROFILE_SYNC_DEFAULT);
+    if (close(pWriter->fd) != 0)
+      status = FALSE;
+    pWriter->fd = -1;
+    if (status)
+      status = (rename(pWriter->pTempName,pWriter->pFileName) == 0);
+    if (!status)
+      (void)unlink(pWriter->pTempName);
+    else
+      status = profile_sync_dir(pWriter->pFileName,PROFILE_SYNC_DEFAULT);
+  }
+  io_fd_close(pWriter);
+
+  return (status);
+}
+
+/**
+ * Open a file with the stdio backend
+ *
+ * @param pContext - unused
+ * @param pFileName - name of the file
+ * @param mode - PROFILE_IO_READ or PROFILE_IO_WRITE
+ *
+ * @return handle, or NULL if the file cannot be opened
+ */
+static void *io_stdio_open(
+  void *pContext,
+  const char *pFileName,
+  int mode)
+{
+  struct io_stdio_writer *pWriter;
+  FILE *pFile;
+  char *pGrow;
+  size_t size = 0;
+  size_t num_read = 0;
+
+  (void)pContext;
+  pWriter = calloc(1,sizeof(struct io_stdio_writer));
+  if (!pWriter)
+    return (NULL);
+  if (mode == PROFILE_IO_WRITE)
+  {
+    pWriter->pFileName = io_strdup(pFileName);
+    pWriter->pTempFile = tmpfile();
+    if (!pWriter->pFileName || !pWriter->pTempFile)
+    {
+      if (pWriter->pTempFile)
+        fclose(pWriter->pTempFile);
+      free(pWriter->pFileName);
+      free(pWriter);
+      return (NULL);
+    }
+    return (pWriter);
+  }
+  pFile = fopen(pFileName,"rb");
+  if (!pFile)
+  {
+    free(pWriter);
+    return (NULL);
+  }
+  do
+  {
+    if (pWriter->reader.nLength == size)
+    {
+      size = size ? size * 2 : IO_BLOCKSIZE;
+      pGrow = realloc(pWriter->reader.pBuffer,size);
+      if (!pGrow)
+      {
+        free(pWriter->reader.pBuffer);
+        free(pWriter);
+        fclose(pFile);
+        return (NULL);
+      }
+      pWriter->reader.pBuffer = pGrow;
+    }
+    num_read = fread(pWriter->reader.pBuffer + pWriter->reader.nLength,1,
+      size - pWriter->reader.nLength,pFile);
+    pWriter->reader.nLength += num_read;
+  } while (num_read);
+  fclose(pFile);
+
+  return (pWriter);
+}
+
+/**
+ * Append to the tmpfile of the stdio backend
+ *
+ * @param pHandle - handle opened to write
+ * @param pBuffer - bytes to write
+ * @param nLength - number of bytes
+ *
+ * @return TRUE if all the bytes were written
+ */
+static BOOL io_stdio_write(
+  void *pHandle,
+  const char *pBuffer,
+  size_t nLength)
+{
+  struct io_stdio_writer *pWriter = pHandle;
+
+  if (!pWriter->pTempFile)
+    return (FALSE);
+
+  return (fwrite(pBuffer,1,nLength,pWriter->pTempFile) == nLength);
+}
+
+/**
+ * Close a handle of the stdio backend
+ *
+ * @param pHandle - handle
+ */
+static void io_stdio_close(
+  void *pHandle)
+{
+  struct io_stdio_writer *pWriter = pHandle;
+
+  if (!pWriter)
+    return;
+  if (pWriter->pTempFile)
+    fclose(pWriter->pTempFile);
+  free(pWriter->reader.pBuffer);
+  free(pWriter->pFileName);
+  free(pWriter);
+}
+
+/**
+ * Copy the tmpfile of the stdio backend over the file,
+ * then close the handle
+ *
+ * @param pHandle - handle opened to write
+ *
+ * @return TRUE if the file was replaced
+ */
+static BOOL io_stdio_commit(
+  void *pHandle)
+{
+  struct io_stdio_writer *pWriter = pHandle;
+  FILE *pFile = NULL;
+  BOOL status = FALSE;
+
+  if (pWriter->pTempFile)
+    pFile = fopen(pWriter->pFileName,"wb");
+  if (pFile)
+  {
+    rewind(pWriter->pTempFile);
+    status = profile_filecopy(pFile,pWriter->pTempFile);
+    if (!profile_sync_stream(pFile,PROFILE_SYNC_DEFAULT))
+      status = FALSE;
+    if (fclose(pFile) != 0)
+      status = FALSE;
+  }
+  io_stdio_close(pWriter);
+
+  return (status);
+}
+
+/**
+ * Find a file of the memory backend.  The caller holds the lock.
+ *
+ * @param pMemory - memory backend
+ * @param pFileName - name of the file
+ *
+ * @return file, or NULL if there is none
+ */
+static struct io_memory_file *io_memory_find(
+  struct io_memory *pMemory,
+  const char *pFileName)
+{
+  struct io_memory_file *pFile;
+
+  for (pFile = pMemory->pFirst; pFile; pFile = pFile->pNext)
+  {
+    if (strcmp(pFile->pFileName,pFileName) == 0)
+      break;
+  }
+
+  return (pFile);
+}
+
+/**
+ * Open a file with the memory backend.  A file opened to read is
+ * copied, so it is not changed by a later commit.
+ *
+ * @param pContext - memory backend
+ * @param pFileName - name of the file
+ * @param mode - PROFILE_IO_READ or PROFILE_IO_WRITE
+ *
+ * @return handle, or NULL if the file does not exist
+ */
+static void *io_memory_open(
+  void *pContext,
+  const char *pFileName,
+  int mode)
+{
+  struct io_memory *pMemory = pContext;
+  struct io_memory_handle *pHandle;
+  struct io_memory_file *pFile;
+
+  pHandle = calloc(1,sizeof(struct io_memory_handle));
+  if (!pHandle)
+    return (NULL);
+  pHandle->mode = mode;
+  pHandle->pMemory = pMemory;
+  if (mode == PROFILE_IO_WRITE)
+  {
+    pHandle->pFileName = io_strdup(pFileName);
+    if (!pHandle->pFileName)
+    {
+      free(pHandle);
+      pHandle = NULL;
+    }
+    return (pHandle);
+  }
+  pthread_mutex_lock(&pMemory->lock);
+  pFile = io_memory_find(pMemory,pFileName);
+  if (pFile)
+  {
+    pHandle->reader.pBuffer = malloc(pFile->nLength + 1);
+    if (pHandle->reader.pBuffer)
+    {
+      memcpy(pHandle->reader.pBuffer,pFile->pBuffer,pFile->nLength);
+      pHandle->reader.nLength = pFile->nLength;
+    }
+  }
+  pthread_mutex_unlock(&pMemory->lock);
+  if (!pHandle->reader.pBuffer)
+  {
+    free(pHandle);
+    pHandle = NULL;
+  }
+
+  return (pHandle);
+}
+
+/**
+ * Append to the new contents of a file of the memory backend
+ *
+ * @param pHandle - handle opened to write
+ * @param pBuffer - bytes to write
+ * @param nLength - number of bytes
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL io_memory_write(
+  void *pHandle,
+  const char *pBuffer,
+  size_t nLength)
+{
+  struct io_memory_handle *pMemoryHandle = pHandle;
+  struct io_reader *pReader = &pMemoryHandle->reader;
+  size_t size = pMemoryHandle->nSize;
+  char *pGrow;
+
+  if (pMemoryHandle->mode != PROFILE_IO_WRITE)
+    return (FALSE);
+  while ((size - pReader->nLength) < nLength)
+    size = size ? size * 2 : IO_BLOCKSIZE;
+  if (size != pMemoryHandle->nSize)
+  {
+    pGrow = realloc(pReader->pBuffer,size);
+    if (!pGrow)
+      return (FALSE);
+    pReader->pBuffer = pGrow;
+    pMemoryHandle->nSize = size;
+  }
+  if (nLength)
+    memcpy(pReader->pBuffer + pReader->nLength,pBuffer,nLength);
+  pReader->nLength += nLength;
+
+  return (TRUE);
+}
+
+/**
+ * Close a handle of the memory backend
+ *
+ * @param pHandle - handle
+ */
+static void io_memory_close(
+  void *pHandle)
+{
+  struct io_memory_handle *pMemoryHandle = pHandle;
+
+  if (!pMemoryHandle)
+    return;
+  free(pMemoryHandle->reader.pBuffer);
+  free(pMemoryHandle->pFileName);
+  free(pMemoryHandle);
+}
+
+/**
+ * Make the new contents the file of the memory backend,
+ * then close the handle
+ *
+ * @param pHandle - handle opened to write
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL io_memory_commit(
+  void *pHandle)
+{
+  struct io_memory_handle *pMemoryHandle = pHandle;
+  struct io_memory *pMemory = pMemoryHandle->pMemory;
+  struct io_memory_file *pFile;
+  BOOL status = FALSE;
+
+  if (pMemoryHandle->mode != PROFILE_IO_WRITE)
+  {
+    io_memory_close(pMemoryHandle);
+    return (status);
+  }
+  pthread_mutex_lock(&pMemory->lock);
+  pFile = io_memory_find(pMemory,pMemoryHandle->pFileName);
+  if (!pFile)
+  {
+    pFile = calloc(1,sizeof(struct io_memory_file));
+    if (pFile)
+    {
+      /* the handle gives its name to the new file */
+      pFile->pFileName = pMemoryHandle->pFileName;
+      pMemoryHandle->pFileName = NULL;
+      pFile->pNext = pMemory->pFirst;
+      pMemory->pFirst = pFile;
+    }
+  }
+  if (pFile)
+  {
+    free(pFile->pBuffer);
+    pFile->pBuffer = pMemoryHandle->reader.pBuffer;
+    pFile->nLength = pMemoryHandle->reader.nLength;
+    pFile->mtime = ++pMemory->clock;
+    pMemoryHandle->reader.pBuffer = NULL;
+    status = TRUE;
+  }
+  pthread_mutex_unlock(&pMemory->lock);
+  io_memory_close(pMemoryHandle);
+
+  return (status);
+}
+
+/**
+ * Stat a file of the memory backend
+ *
+ * @param pContext - memory backend
+ * @param pFileName - name of the file
+ * @param pStat - receives what is known about the file
+ *
+ * @return TRUE if the file exists
+ */
+static BOOL io_memory_stat(
+  void *pContext,
+  const char *pFileName,
+  PROFILE_IO_STAT *pStat)
+{
+  struct io_memory *pMemory = pContext;
+  struct io_memory_file *pFile;
+
+  memset(pStat,0,sizeof(PROFILE_IO_STAT));
+  pthread_mutex_lock(&pMemory->lock);
+  pFile = io_memory_find(pMemory,pFileName);
+  if (pFile)
+  {
+    pStat->exists = TRUE;
+    pStat->size = pFile->nLength;
+    pStat->mtime = pFile->mtime;
+  }
+  pthread_mutex_unlock(&pMemory->lock);
+
+  return (pStat->exists);
+}
+
+static const PROFILE_IO_OPS IO_Fd_Ops = {
+  io_fd_open,io_map,io_fd_write,io_fd_commit,io_fd_close,io_file_stat
+};
+static const PROFILE_IO_OPS IO_Stdio_Ops = {
+  io_stdio_open,io_map,io_stdio_write,io_stdio_commit,io_stdio_close,
+  io_file_stat
+};
+static const PROFILE_IO_OPS IO_Memory_Ops = {
+  io_memory_open,io_map,io_memory_write,io_memory_commit,io_memory_close,
+  io_memory_stat
+};
+/* the context of the mmap backend only has to be non-NULL */
+static int IO_Map_Files = 1;
+static const PROFILE_IO IO_Posix = {&IO_Fd_Ops,NULL};
+static const PROFILE_IO IO_Mmap = {&IO_Fd_Ops,&IO_Map_Files};
+static const PROFILE_IO IO_Stdio = {&IO_Stdio_Ops,NULL};
+
+/**
+ * Backend that uses read(2) and write(2), and replaces files by
+ * renaming a temporary file over them
+ *
+ * @return backend
+ */
+const PROFILE_IO *profile_io_posix(void)
+{
+  return (&IO_Posix);
+}
+
+/**
+ * Backend that maps files to read them, and writes like
+ * profile_io_posix
+ *
+ * @return backend
+ */
+const PROFILE_IO *profile_io_mmap(void)
+{
+  return (&IO_Mmap);
+}
+
+/**
+ * Backend that uses stdio streams, and replaces files by copying
+ * a tmpfile over them, the same as WritePrivateProfileString
+ *
+ * @return backend
+ */
+const PROFILE_IO *profile_io_stdio(void)
+{
+  return (&IO_Stdio);
+}
+
+/**
+ * Create a backend that keeps its files in memory
+ *
+ * @return new backend with no files, or NULL if out of memory
+ */
+PROFILE_IO *profile_io_memory_create(void)
+{
+  struct io_memory *pMemory;
+
+  pMemory = calloc(1,sizeof(struct io_memory));
+  if (!pMemory)
+    return (NULL);
+  if (pthread_mutex_init(&pMemory->lock,NULL) != 0)
+  {
+    free(pMemory);
+    return (NULL);
+  }
+  pMemory->io.pOps = &IO_Memory_Ops;
+  pMemory->io.pContext = pMemory;
+
+  return (&pMemory->io);
+}
+
+/**
+ * Release a memory backend and all of its files
+ *
+ * @param pIo - backend from profile_io_memory_create, may be NULL
+ */
+void profile_io_memory_free(
+  PROFILE_IO *pIo)
+{
+  struct io_memory *pMemory;
+  struct io_memory_file *pFile;
+
+  if (!pIo)
+    return;
+  pMemory = pIo->pContext;
+  while (pMemory->pFirst)
+  {
+    pFile = pMemory->pFirst;
+    pMemory->pFirst = pFile->pNext;
+    free(pFile->pFileName);
+    free(pFile->pBuffer);
+    free(pFile);
+  }
+  pthread_mutex_destroy(&pMemory->lock);
+  free(pMemory);
+}
+
+/**
+ * Read a whole file through a backend into the heap
+ *
+ * @param pIo (IN) backend
+ * @param pFileName (IN) name of the file
+ * @param pnLength (OUT) receives the number of bytes read
+ *
+ * @return contents, to be released with free, or NULL if the file
+ *  cannot be read.  The contents are not null-terminated.
+ */
+char *profile_io_read(
+  const PROFILE_IO *pIo,
+  const char *pFileName,
+  size_t *pnLength)
+{
+  const char *pContents;
+  char *pBuffer = NULL;
+  void *pHandle;
+  size_t len = 0;
+
+  if (!pIo || !pFileName || !pnLength)
+    return (NULL);
+  pHandle = pIo->pOps->open(pIo->pContext,pFileName,PROFILE_IO_READ);
+  if (!pHandle)
+    return (NULL);
+  pContents = pIo->pOps->map(pHandle,&len);
+  /* one extra byte so an empty file is not NULL */
+  pBuffer = malloc(len + 1);
+  if (pBuffer)
+  {
+    if (len)
+      memcpy(pBuffer,pContents,len);
+    *pnLength = len;
+  }
+  pIo->pOps->close(pHandle);
+
+  return (pBuffer);
+}
+
+/**
+ * Replace the contents of a file through a backend
+ *
+ * @param pIo (IN) backend
+ * @param pFileName (IN) name of the file
+ * @param pBuffer (IN) new contents
+ * @param nLength (IN) number of bytes in pBuffer
+ *
+ * @return TRUE if the file was replaced
+ */
+BOOL profile_io_replace(
+  const PROFILE_IO *pIo,
+  const char *pFileName,
+  const char *pBuffer,
+  size_t nLength)
+{
+  void *pHandle;
+
+  if (!pIo || !pFileName || (!pBuffer && nLength))
+    return (FALSE);
+  pHandle = pIo->pOps->open(pIo->pContext,pFileName,PROFILE_IO_WRITE);
+  if (!pHandle)
+    return (FALSE);
+  if (!pIo->pOps->write(pHandle,pBuffer,nLength))
+  {
+    pIo->pOps->close(pHandle);
+    return (FALSE);
+  }
+
+  return (pIo->pOps->commit(pHandle));
+}
+
+/**
+ * Stat a file through a backend
+ *
+ * @param pIo (IN) backend
+ * @param pFileName (IN) name of the file
+ * @param pStat (OUT) receives what is known about the file
+ *
+ * @return TRUE if the file exists
+ */
+BOOL profile_io_stat(
+  const PROFILE_IO *pIo,
+  const char *pFileName,
+  PROFILE_IO_STAT *pStat)
+{
+  if (!pIo || !pFileName || !pStat)
+    return (FALSE);
+
+  return (pIo->pOps->stat(pIo->pContext,pFileName,pStat));
+}
+
+/**
+ * Retrieves a string from an INI file read through a backend.
+ * The results are the same as GetPrivateProfileString.
+ *
+ * @param pIo (IN) backend
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ * @param pFileName (IN) initialization filename
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t GetPrivateProfileStringIo(
+  const PROFILE_IO *pIo,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pFileName)
+{
+  const char *pContents = NULL;
+  void *pHandle = NULL;
+  size_t len = 0;
+  size_t count = 0;
+
+  if (!pIo || !pReturnedString || !pFileName)
+    return (count);
+  pHandle = pIo->pOps->open(pIo->pContext,pFileName,PROFILE_IO_READ);
+  if (pHandle)
+    pContents = pIo->pOps->map(pHandle,&len);
+  /* a missing file reads as empty, which gives the default */
+  count = GetPrivateProfileStringFromBuffer(pAppName,pKeyName,pDefault,
+    pReturnedString,nSize,pContents ? pContents : "",len);
+  if (pHandle)
+    pIo->pOps->close(pHandle);
+
+  return (count);
+}
+
+/**
+ * Writes a string to an INI file through a backend.
+ * The file is changed the same way as WritePrivateProfileString
+ * changes it, and the new contents are committed at once.
+ *
+ * @param pIo (IN) backend
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to write, or NULL to delete the key
+ * @param pFileName (IN) initialization filename
+ *
+ * @return TRUE if the string was written and committed
+ */
+BOOL WritePrivateProfileStringIo(
+  const PROFILE_IO *pIo,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  const char *pFileName)
+{
+  const char *pContents = "";
+  void *pHandle = NULL;
+  char *pOutBuffer = NULL;
+  size_t len = 0;
+  size_t size = 0;
+  size_t out_len = 0;
+  BOOL status = FALSE;
+
+  if (!pIo || !pAppName || !pFileName)
+    return (status);
+  pHandle = pIo->pOps->open(pIo->pContext,pFileName,PROFILE_IO_READ);
+  if (!pHandle)
+  {
+    /* a new file is only made to hold a string */
+    if (!pKeyName || !pString)
+      return (status);
+  }
+  else
+    pContents = pIo->pOps->map(pHandle,&len);
+  /* room for the text, the newlines added to long lines, and the
+     new section and key, so one pass is nearly always enough */
+  size = len + (len / (MAX_LINE_LEN - 2)) + strlen(pAppName) +
+    (pKeyName ? strlen(pKeyName) : 0) + (pString ? strlen(pString) : 0) + 8;
+  pOutBuffer = malloc(size);
+  if (pOutBuffer)
+  {
+    status = WritePrivateProfileStringToBuffer(pAppName,pKeyName,pString,
+      pContents,len,pOutBuffer,size,&out_len);
+    if (!status && (out_len >= size))
+    {
+      free(pOutBuffer);
+      size = out_len + 1;
+      pOutBuffer = malloc(size);
+      if (pOutBuffer)
+        status = WritePrivateProfileStringToBuffer(pAppName,pKeyName,
+          pString,pContents,len,pOutBuffer,size,&out_len);
+    }
+  }
+  if (pHandle)
+    pIo->pOps->close(pHandle);
+  /* a delete that found nothing still rewrites, like the file version */
+  if (pOutBuffer && (out_len < size))
+  {
+    if (!profile_io_replace(pIo,pFileName,pOutBuffer,out_len))
+      status = FALSE;
+  }
+  free(pOutBuffer);
+
+  return (status);
+}
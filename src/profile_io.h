@@ -0,0 +1,92 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Pluggable file access for INI files
+ */
+#ifndef PROFILE_IO_H
+#define PROFILE_IO_H
+
+#include <stddef.h>
+#include "profile.h"
+
+/* open modes */
+#define PROFILE_IO_READ 0
+#define PROFILE_IO_WRITE 1
+
+/* what stat reports about a file */
+typedef struct profile_io_stat
+{
+  BOOL exists; /* FALSE if there is no such file */
+  size_t size; /* number of bytes */
+  long long mtime; /* time of last change, in nanoseconds */
+} PROFILE_IO_STAT;
+
+/* operations of a backend */
+typedef struct profile_io_ops
+{
+  /* open a file to read all of it, or to write new contents;
+     returns NULL if the file cannot be opened */
+  void *(*open)(void *pContext, const char *pFileName, int mode);
+  /* contents of a file opened to read, valid until close */
+  const char *(*map)(void *pHandle, size_t *pnLength);
+  /* append to the new contents of a file opened to write */
+  BOOL (*write)(void *pHandle, const char *pBuffer, size_t nLength);
+  /* replace the file with the new contents and close the handle */
+  BOOL (*commit)(void *pHandle);
+  /* close a handle; new contents that were not committed are dropped */
+  void (*close)(void *pHandle);
+  BOOL (*stat)(void *pContext, const char *pFileName,
+    PROFILE_IO_STAT *pStat);
+} PROFILE_IO_OPS;
+
+/* a backend: its operations and their context */
+typedef struct profile_io
+{
+  const PROFILE_IO_OPS *pOps;
+  void *pContext;
+} PROFILE_IO;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  const PROFILE_IO *profile_io_posix(void);
+  const PROFILE_IO *profile_io_mmap(void);
+  const PROFILE_IO *profile_io_stdio(void);
+  PROFILE_IO *profile_io_memory_create(void);
+  void profile_io_memory_free(PROFILE_IO *pIo);
+
+  char *profile_io_read(
+    const PROFILE_IO *pIo,
+    const char *pFileName,
+    size_t *pnLength);
+  BOOL profile_io_replace(
+    const PROFILE_IO *pIo,
+    const char *pFileName,
+    const char *pBuffer,
+    size_t nLength);
+  BOOL profile_io_stat(
+    const PROFILE_IO *pIo,
+    const char *pFileName,
+    PROFILE_IO_STAT *pStat);
+
+  size_t GetPrivateProfileStringIo(
+    const PROFILE_IO *pIo,	// points to the backend
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize,	// size of destination buffer
+    const char *pFileName); 	// points to initialization filename
+
+  BOOL WritePrivateProfileStringIo(
+    const PROFILE_IO *pIo,	// points to the backend
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString,	// pointer to string to add
+    const char *pFileName); 	// pointer to initialization filename
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_IO_H */
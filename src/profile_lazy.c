@@ -0,0 +1,994 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief INI files whose sections are parsed when first used
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * Loading only finds the section headers.  It looks for each '[' with
+ * memchr, and keeps the ones that start a line and end it with ']' the
+ * way rmbrackets expects, along with where the section ends: at the
+ * next line that starts with '[', as in GetPrivateProfileString.
+ *
+ * The body of a section is parsed into a document (profile_doc.h) the
+ * first time the section is used, so the cost of a file follows the
+ * sections a program reads.  When a section name is repeated, only
+ * the first section with the name is used, as in a document.
+ *
+ * A lazy file may be used by several threads.  Its lock is held while
+ * a section is parsed and while a lookup copies its answer.
+ *
+ * profile_lazy_load keeps the file open, and reads the text of a
+ * section with pread when the section is parsed, so the memory used
+ * follows the sections that are used and not the size of the file.
+ * The headers are found by reading the file a block at a time.  The
+ * file is not mapped, so one truncated under it cannot raise SIGBUS.
+ *
+ * After a section is read, the open file is checked with fstat against
+ * its size and time of last change when it was indexed; nothing else
+ * costs a system call.  A file rewritten in place is indexed again, and
+ * from then on its sections are parsed from the new text.  Sections and
+ * values returned before stay valid until profile_lazy_free.  A file
+ * replaced by rename has not changed: the file that is open is the old
+ * one, and its text is still whole.
+ *
+ * profile_lazy_load_io does the same with the mmap backend.  The other
+ * backends hold a copy of the text in the open handle, which does not
+ * change, and the sections are parsed from that copy.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+#include "profile_lazy.h"
+#include "strfold.h"
+
+/* size of the first block used to find the headers of a file */
+#define LAZY_BLOCKSIZE 65536
+/* times a file that keeps changing is read again */
+#define LAZY_RETRIES 3
+
+/* a section header that was found */
+struct lazy_section
+{
+  size_t name; /* start of the name in the names */
+  size_t nLength; /* number of characters in the name */
+  unsigned hash; /* strfold_hash of the name */
+  size_t start; /* start of the header line */
+  size_t end; /* start of the line after the section */
+  BOOL parsed; /* TRUE once it is in the document */
+  struct lazy_section *pHashNext;
+};
+
+/* a document of text that the file no longer has */
+struct lazy_retired
+{
+  PROFILE_DOC *pDoc;
+  struct lazy_retired *pNext;
+};
+
+/* an INI file and the sections parsed so far */
+struct profile_lazy
+{
+  const PROFILE_IO *pIo; /* backend that holds the text, or NULL */
+  void *pHandle; /* open handle of the file */
+  char *pCopy; /* copy of the text when there is no handle */
+  const char *pText; /* NULL when the sections are read from fd */
+  size_t nLength;
+  int fd; /* file the sections are read from, or -1 */
+  PROFILE_IO_STAT file_stat; /* of fd when it was indexed */
+  char *pNames; /* section names, each null-terminated */
+  size_t nNames; /* number of bytes used in pNames */
+  size_t nNamesSize; /* number of bytes in pNames */
+  struct lazy_section *pSection; /* in file order, first of each name */
+  size_t nSections;
+  size_t nSectionsSize; /* number of entries in pSection */
+  struct lazy_section **ppBucket; /* by name */
+  size_t nBuckets; /* a power of two */
+  size_t nParsed;
+  PROFILE_DOC *pDoc; /* the sections that were parsed */
+  struct lazy_retired *pRetired; /* documents of earlier texts */
+  pthread_mutex_t lock;
+};
+
+/**
+ * Find a section by name
+ *
+ * @param pLazy - lazy file
+ * @param pName - name
+ * @param len - number of characters in the name
+ *
+ * @return section, or NULL if there is none
+ */
+static struct lazy_section *lazy_find(
+  const PROFILE_LAZY *pLazy,
+  const char *pName,
+  size_t len)
+{
+  struct lazy_section *pSection;
+  unsigned hash;
+
+  if (!pLazy->nBuckets)
+    return (NULL);
+  hash = strfold_hash(pName,len);
+  for (pSection = pLazy->ppBucket[hash & (pLazy->nBuckets - 1)]; pSection;
+    pSection = pSection->pHashNext)
+  {
+    if ((pSection->hash == hash) && (pSection->nLength == len) &&
+      strfold_equal(pLazy->pNames + pSection->name,pName,len))
+      break;
+  }
+
+  return (pSection);
+}
+
+/**
+ * Add a section header to the index
+ *
+ * @param pLazy - lazy file
+ * @param pName - name, in the text
+ * @param len - number of characters in the name
+ * @param start - start of the header line in the file
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL lazy_add(
+  PROFILE_LAZY *pLazy,
+  const char *pName,
+  size_t len,
+  size_t start)
+{
+  struct lazy_section *pSection;
+  char *pNames;
+  size_t size;
+
+  if (pLazy->nSections == pLazy->nSectionsSize)
+  {
+    size = pLazy->nSectionsSize ? pLazy->nSectionsSize * 2 : 16;
+    pSection = realloc(pLazy->pSection,size * sizeof(struct lazy_section));
+    if (!pSection)
+      return (FALSE);
+    pLazy->pSection = pSection;
+    pLazy->nSectionsSize = size;
+  }
+  if (pLazy->nNames + len + 1 > pLazy->nNamesSize)
+  {
+    for (size = pLazy->nNamesSize ? pLazy->nNamesSize : 256;
+      size < pLazy->nNames + len + 1; size *= 2)
+    {
+    }
+    pNames = realloc(pLazy->pNames,size);
+    if (!pNames)
+      return (FALSE);
+    pLazy->pNames = pNames;
+    pLazy->nNamesSize = size;
+  }
+  pSection = &pLazy->pSection[pLazy->nSections++];
+  memset(pSection,0,sizeof(struct lazy_section));
+  pSection->name = pLazy->nNames;
+  memcpy(pLazy->pNames + pLazy->nNames,pName,len);
+  pLazy->pNames[pLazy->nNames + len] = '\0';
+  pLazy->nNames += len + 1;
+  pSection->nLength = len;
+  pSection->hash = strfold_hash(pName,len);
+  pSection->start = start;
+
+  return (TRUE);
+}
+
+/**
+ * Find the section headers of whole lines of the text
+ *
+ * @param pLazy - lazy file
+ * @param pText - lines of the text
+ * @param nLength - number of characters in pText
+ * @param base - where pText starts in the file
+ * @param pOpen - TRUE while the last section has not ended
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL lazy_scan(
+  PROFILE_LAZY *pLazy,
+  const char *pText,
+  size_t nLength,
+  size_t base,
+  BOOL *pOpen)
+{
+  const char *pLimit = pText + nLength;
+  const char *pBracket = pText;
+  const char *pLine; /* start of the line of the bracket */
+  const char *pHeader; /* the bracket that starts the line */
+  const char *pEnd; /* end of the trimmed line */
+
+  while ((pBracket < pLimit) &&
+    ((pBracket = memchr(pBracket,'[',(size_t)(pLimit - pBracket))) != NULL))
+  {
+    /* only a '[' at the start of a line, after any spaces */
+    pLine = pBracket;
+    while ((pLine > pText) && (pLine[-1] != '\n') &&
+      isspace((unsigned char)pLine[-1]))
+      pLine--;
+    if ((pLine > pText) && (pLine[-1] != '\n'))
+    {
+      pBracket++;
+      continue;
+    }
+    pEnd = memchr(pBracket,'\n',(size_t)(pLimit - pBracket));
+    if (!pEnd)
+      pEnd = pLimit;
+    /* any '[' line ends the section before it */
+    if (*pOpen)
+    {
+      pLazy->pSection[pLazy->nSections - 1].end = base +
+        (size_t)(pLine - pText);
+      *pOpen = FALSE;
+    }
+    pHeader = pBracket;
+    pBracket = pEnd;
+    while ((pEnd > pHeader) && isspace((unsigned char)pEnd[-1]))
+      pEnd--;
+    if (((pEnd - pHeader) < 2) || (pEnd[-1] != ']'))
+      continue;
+    if (!lazy_add(pLazy,pHeader + 1,(size_t)(pEnd - pHeader - 2),
+      base + (size_t)(pLine - pText)))
+      return (FALSE);
+    *pOpen = TRUE;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Put the sections that were found in the buckets
+ *
+ * @param pLazy - lazy file with its sections
+ * @param nLength - length of the file, where an open section ends
+ * @param open - TRUE if the last section has not ended
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL lazy_hash(
+  PROFILE_LAZY *pLazy,
+  size_t nLength,
+  BOOL open)
+{
+  struct lazy_section *pSection;
+  size_t i;
+
+  if (open)
+    pLazy->pSection[pLazy->nSections - 1].end = nLength;
+  /* a bucket for every section, rounded up to a power of two */
+  for (pLazy->nBuckets = 16; pLazy->nBuckets < pLazy->nSections;
+    pLazy->nBuckets *= 2)
+  {
+  }
+  pLazy->ppBucket = calloc(pLazy->nBuckets,sizeof(struct lazy_section *));
+  if (!pLazy->ppBucket)
+  {
+    pLazy->nBuckets = 0;
+    return (FALSE);
+  }
+  for (i = 0; i < pLazy->nSections; i++)
+  {
+    pSection = &pLazy->pSection[i];
+    /* the first section with a name wins */
+    if (lazy_find(pLazy,pLazy->pNames + pSection->name,pSection->nLength))
+      continue;
+    pSection->pHashNext = pLazy->ppBucket[pSection->hash &
+      (pLazy->nBuckets - 1)];
+    pLazy->ppBucket[pSection->hash & (pLazy->nBuckets - 1)] = pSection;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Forget the sections that were found
+ *
+ * @param pLazy - lazy file
+ */
+static void lazy_reset(
+  PROFILE_LAZY *pLazy)
+{
+  free(pLazy->ppBucket);
+  free(pLazy->pSection);
+  free(pLazy->pNames);
+  pLazy->ppBucket = NULL;
+  pLazy->nBuckets = 0;
+  pLazy->pSection = NULL;
+  pLazy->nSections = 0;
+  pLazy->nSectionsSize = 0;
+  pLazy->pNames = NULL;
+  pLazy->nNames = 0;
+  pLazy->nNamesSize = 0;
+  pLazy->nParsed = 0;
+}
+
+/**
+ * Size and time of last change of an open file
+ *
+ * @param fd - file descriptor
+ * @param pStat - receives the size and time
+ *
+ * @return TRUE if successful
+ */
+static BOOL lazy_stat(
+  int fd,
+  PROFILE_IO_STAT *pStat)
+{
+  struct stat file_stat;
+
+  memset(pStat,0,sizeof(PROFILE_IO_STAT));
+  if (fstat(fd,&file_stat) != 0)
+    return (FALSE);
+  pStat->exists = TRUE;
+  pStat->size = (size_t)file_stat.st_size;
+  pStat->mtime = (long long)file_stat.st_mtime * 1000000000LL;
+#if defined(__linux__)
+  pStat->mtime += file_stat.st_mtim.tv_nsec;
+#endif
+
+  return (TRUE);
+}
+
+/**
+ * Find out if the open file changed since it was indexed
+ *
+ * @param pLazy - lazy file read from fd
+ *
+ * @return TRUE if it changed, or cannot be checked
+ */
+static BOOL lazy_changed(
+  PROFILE_LAZY *pLazy)
+{
+  PROFILE_IO_STAT file_stat;
+
+  return (!lazy_stat(pLazy->fd,&file_stat) ||
+    (file_stat.size != pLazy->file_stat.size) ||
+    (file_stat.mtime != pLazy->file_stat.mtime));
+}
+
+/**
+ * Read part of the open file
+ *
+ * @param fd - file descriptor
+ * @param pBuffer - receives the bytes
+ * @param nLength - number of bytes to read
+ * @param offset - where to read from
+ *
+ * @return number of bytes read, which is short at the end of the file,
+ *  or -1 if the read failed
+ */
+static ssize_t lazy_read(
+  int fd,
+  char *pBuffer,
+  size_t nLength,
+  size_t offset)
+{
+  size_t count = 0;
+  ssize_t num_read;
+
+  while (count < nLength)
+  {
+    num_read = pread(fd,pBuffer + count,nLength - count,
+      (off_t)(offset + count));
+    if (num_read > 0)
+      count += (size_t)num_read;
+    else if ((num_read < 0) && (errno == EINTR))
+      continue;
+    else if (num_read < 0)
+      return (-1);
+    else
+      break;
+  }
+
+  return ((ssize_t)count);
+}
+
+/**
+ * Find the section headers of the open file, a block of whole lines
+ * at a time.  The caller has reset the index.
+ *
+ * @param pLazy - lazy file read from fd
+ *
+ * @return TRUE if successful, FALSE if the file cannot be read or out
+ *  of memory
+ */
+static BOOL lazy_index_file(
+  PROFILE_LAZY *pLazy)
+{
+  PROFILE_IO_STAT file_stat;
+  char *pBuffer;
+  char *pGrow;
+  size_t size = LAZY_BLOCKSIZE;
+  size_t base = 0;
+  size_t len;
+  ssize_t num_read = 0;
+  BOOL open = FALSE;
+  BOOL status = FALSE;
+  int tries;
+
+  pBuffer = malloc(size);
+  if (!pBuffer)
+    return (FALSE);
+  for (tries = 0; !status && (tries < LAZY_RETRIES); tries++)
+  {
+    lazy_reset(pLazy);
+    base = 0;
+    open = FALSE;
+    if (!lazy_stat(pLazy->fd,&pLazy->file_stat))
+    {
+      num_read = -1;
+      break;
+    }
+    for (;;)
+    {
+      num_read = lazy_read(pLazy->fd,pBuffer,size,base);
+      if (num_read <= 0)
+        break;
+      /* stop at the last end of line, so the next block starts a line */
+      for (len = (size_t)num_read; (len > 0) && (pBuffer[len - 1] != '\n');
+        len--)
+      {
+      }
+      if (!len && ((size_t)num_read == size))
+      {
+        /* a line longer than the block */
+        pGrow = realloc(pBuffer,size * 2);
+        if (!pGrow)
+        {
+          num_read = -1;
+          break;
+        }
+        pBuffer = pGrow;
+        size *= 2;
+        continue;
+      }
+      if (!len)
+        len = (size_t)num_read;
+      if (!lazy_scan(pLazy,pBuffer,len,base,&open))
+      {
+        num_read = -1;
+        break;
+      }
+      base += len;
+    }
+    if (num_read < 0)
+      break;
+    /* the file changed while it was read, so read it again */
+    status = lazy_stat(pLazy->fd,&file_stat) &&
+      (file_stat.size == pLazy->file_stat.size) &&
+      (file_stat.mtime == pLazy->file_stat.mtime) &&
+      (base == file_stat.size);
+  }
+  free(pBuffer);
+  if (num_read < 0)
+  {
+    lazy_reset(pLazy);
+    return (FALSE);
+  }
+  /* a file that kept changing is used as it was last read */
+  pLazy->nLength = base;
+
+  return (lazy_hash(pLazy,base,open));
+}
+
+/**
+ * Index the open file again after it changed.  The document of the
+ * old text is kept, since its sections and values may be in use.
+ * The caller holds the lock.
+ *
+ * @param pLazy - lazy file read from fd
+ *
+ * @return TRUE if successful, FALSE if out of memory or the file
+ *  cannot be read, in which case no section is found
+ */
+static BOOL lazy_reindex(
+  PROFILE_LAZY *pLazy)
+{
+  struct lazy_retired *pRetired;
+  PROFILE_DOC *pDoc;
+
+  pRetired = malloc(sizeof(struct lazy_retired));
+  pDoc = profile_doc_create();
+  if (!pRetired || !pDoc)
+  {
+    free(pRetired);
+    profile_doc_free(pDoc);
+    return (FALSE);
+  }
+  pRetired->pDoc = pLazy->pDoc;
+  pRetired->pNext = pLazy->pRetired;
+  pLazy->pRetired = pRetired;
+  pLazy->pDoc = pDoc;
+
+  return (lazy_index_file(pLazy));
+}
+
+/**
+ * Finish making a lazy file once its text or file is in place
+ *
+ * @param pLazy - lazy file with its text or file
+ *
+ * @return pLazy, or NULL if out of memory or the file cannot be read,
+ *  in which case it is released
+ */
+static PROFILE_LAZY *lazy_open(
+  PROFILE_LAZY *pLazy)
+{
+  BOOL open = FALSE;
+  BOOL status;
+
+  pLazy->pDoc = profile_doc_create();
+  if (pLazy->fd >= 0)
+    status = lazy_index_file(pLazy);
+  else
+    status = lazy_scan(pLazy,pLazy->pText,pLazy->nLength,0,&open) &&
+      lazy_hash(pLazy,pLazy->nLength,open);
+  if (!pLazy->pDoc || !status ||
+    (pthread_mutex_init(&pLazy->lock,NULL) != 0))
+  {
+    profile_doc_free(pLazy->pDoc);
+    lazy_reset(pLazy);
+    if (pLazy->fd >= 0)
+      (void)close(pLazy->fd);
+    if (pLazy->pHandle)
+      pLazy->pIo->pOps->close(pLazy->pHandle);
+    free(pLazy->pCopy);
+    free(pLazy);
+    return (NULL);
+  }
+
+  return (pLazy);
+}
+
+/**
+ * Make a lazy file of text in the heap
+ *
+ * @param pCopy - text, which the lazy file takes over
+ * @param nLength - number of characters in pCopy
+ *
+ * @return new lazy file, or NULL if out of memory, in which case the
+ *  text is released
+ */
+static PROFILE_LAZY *lazy_open_copy(
+  char *pCopy,
+  size_t nLength)
+{
+  PROFILE_LAZY *pLazy;
+
+  pLazy = calloc(1,sizeof(PROFILE_LAZY));
+  if (!pLazy)
+  {
+    free(pCopy);
+    return (NULL);
+  }
+  pLazy->fd = -1;
+  pLazy->pCopy = pCopy;
+  pLazy->pText = pCopy;
+  pLazy->nLength = nLength;
+
+  return (lazy_open(pLazy));
+}
+
+/**
+ * Open an INI file and find its sections.  The file stays open until
+ * profile_lazy_free(), and the text of a section is read from it when
+ * the section is used for the first time.  A file that is rewritten
+ * in place is indexed again.
+ *
+ * @param pFileName (IN) initialization filename
+ *
+ * @return new lazy file, or NULL if the file cannot be read
+ */
+PROFILE_LAZY *profile_lazy_load(
+  const char *pFileName)
+{
+  PROFILE_LAZY *pLazy;
+
+  if (!pFileName)
+    return (NULL);
+  pLazy = calloc(1,sizeof(PROFILE_LAZY));
+  if (!pLazy)
+    return (NULL);
+  pLazy->fd = open(pFileName,O_RDONLY);
+  if (pLazy->fd < 0)
+  {
+    free(pLazy);
+    return (NULL);
+  }
+
+  return (lazy_open(pLazy));
+}
+
+/**
+ * Open an INI file through a backend and find its sections.  With the
+ * mmap backend the file is read a section at a time, as with
+ * profile_lazy_load(), instead of mapped.  The other backends hold a
+ * copy of the text while the file is open, and the sections are
+ * parsed from it whatever happens to the file.
+ *
+ * @param pIo (IN) backend
+ * @param pFileName (IN) initialization filename
+ *
+ * @return new lazy file, or NULL if the file cannot be read
+ */
+PROFILE_LAZY *profile_lazy_load_io(
+  const PROFILE_IO *pIo,
+  const char *pFileName)
+{
+  PROFILE_LAZY *pLazy;
+
+  if (!pIo || !pFileName)
+    return (NULL);
+  if (pIo == profile_io_mmap())
+    return (profile_lazy_load(pFileName));
+  pLazy = calloc(1,sizeof(PROFILE_LAZY));
+  if (!pLazy)
+    return (NULL);
+  pLazy->fd = -1;
+  pLazy->pIo = pIo;
+  pLazy->pHandle = pIo->pOps->open(pIo->pContext,pFileName,
+    PROFILE_IO_READ);
+  if (!pLazy->pHandle)
+  {
+    free(pLazy);
+    return (NULL);
+  }
+  pLazy->pText = pIo->pOps->map(pLazy->pHandle,&pLazy->nLength);
+  if (!pLazy->pText)
+    pLazy->pText = "";
+
+  return (lazy_open(pLazy));
+}
+
+/**
+ * Find the sections of INI text held in memory.  The text is copied.
+ *
+ * @param pBuffer (IN) INI text, which need not be null-terminated
+ * @param nLength (IN) number of characters in pBuffer
+ *
+ * @return new lazy file, or NULL if out of memory
+ */
+PROFILE_LAZY *profile_lazy_load_buffer(
+  const char *pBuffer,
+  size_t nLength)
+{
+  char *pCopy;
+
+  if (!pBuffer && nLength)
+    return (NULL);
+  /* one extra byte so an empty text is not NULL */
+  pCopy = malloc(nLength + 1);
+  if (!pCopy)
+    return (NULL);
+  if (nLength)
+    memcpy(pCopy,pBuffer,nLength);
+
+  return (lazy_open_copy(pCopy,nLength));
+}
+
+/**
+ * Release a lazy file, and close its file
+ *
+ * @param pLazy (IN) lazy file, or NULL
+ */
+void profile_lazy_free(
+  PROFILE_LAZY *pLazy)
+{
+  struct lazy_retired *pRetired;
+
+  if (!pLazy)
+    return;
+  pthread_mutex_destroy(&pLazy->lock);
+  profile_doc_free(pLazy->pDoc);
+  while (pLazy->pRetired)
+  {
+    pRetired = pLazy->pRetired;
+    pLazy->pRetired = pRetired->pNext;
+    profile_doc_free(pRetired->pDoc);
+    free(pRetired);
+  }
+  lazy_reset(pLazy);
+  if (pLazy->fd >= 0)
+    (void)close(pLazy->fd);
+  if (pLazy->pHandle)
+    pLazy->pIo->pOps->close(pLazy->pHandle);
+  free(pLazy->pCopy);
+  free(pLazy);
+}
+
+/**
+ * Number of section headers in the file, counting repeated names
+ *
+ * @param pLazy (IN) lazy file
+ *
+ * @return number of sections
+ */
+size_t profile_lazy_section_count(
+  const PROFILE_LAZY *pLazy)
+{
+  return (pLazy ? pLazy->nSections : 0);
+}
+
+/**
+ * Number of sections parsed so far
+ *
+ * @param pLazy (IN) lazy file
+ *
+ * @return number of sections
+ */
+size_t profile_lazy_parsed_count(
+  PROFILE_LAZY *pLazy)
+{
+  size_t count;
+
+  if (!pLazy)
+    return (0);
+  pthread_mutex_lock(&pLazy->lock);
+  count = pLazy->nParsed;
+  pthread_mutex_unlock(&pLazy->lock);
+
+  return (count);
+}
+
+/**
+ * Bytes held for the sections parsed so far and the index
+ *
+ * @param pLazy (IN) lazy file
+ *
+ * @return number of bytes, not counting the text of the file
+ */
+size_t profile_lazy_memory(
+  PROFILE_LAZY *pLazy)
+{
+  struct lazy_retired *pRetired;
+  size_t size;
+
+  if (!pLazy)
+    return (0);
+  pthread_mutex_lock(&pLazy->lock);
+  size = profile_doc_memory(pLazy->pDoc) + pLazy->nNamesSize +
+    (pLazy->nSectionsSize * sizeof(struct lazy_section)) +
+    (pLazy->nBuckets * sizeof(struct lazy_section *));
+  for (pRetired = pLazy->pRetired; pRetired; pRetired = pRetired->pNext)
+    size += profile_doc_memory(pRetired->pDoc);
+  pthread_mutex_unlock(&pLazy->lock);
+
+  return (size);
+}
+
+/**
+ * Make sure a section is in the document.  The caller holds the lock.
+ *
+ * @param pLazy - lazy file
+ * @param pAppName - section name
+ *
+ * @return TRUE if the section is there, FALSE if the file has no
+ *  such section or out of memory
+ */
+static BOOL lazy_parse(
+  PROFILE_LAZY *pLazy,
+  const char *pAppName)
+{
+  struct lazy_section *pSection;
+  char *pRead = NULL;
+  size_t len;
+  BOOL status;
+  int tries;
+
+  /* a parsed section is answered without the text */
+  if (profile_doc_section(pLazy->pDoc,pAppName))
+    return (TRUE);
+  for (tries = 0; ; tries++)
+  {
+    pSection = lazy_find(pLazy,pAppName,strlen(pAppName));
+    if (!pSection)
+      return (FALSE);
+    if (pSection->parsed)
+      return (TRUE);
+    if (pLazy->fd < 0)
+      break;
+    len = pSection->end - pSection->start;
+    pRead = malloc(len + 1);
+    if (!pRead)
+      return (FALSE);
+    /* checked after the read, so a change while reading is seen too */
+    if ((lazy_read(pLazy->fd,pRead,len,pSection->start) == (ssize_t)len) &&
+      !lazy_changed(pLazy))
+      break;
+    free(pRead);
+    pRead = NULL;
+    if ((tries == LAZY_RETRIES) || !lazy_reindex(pLazy))
+      return (FALSE);
+  }
+  /* the header line and the body, as if it were a file of its own */
+  if (pRead)
+    status = profile_doc_parse(pLazy->pDoc,pRead,len);
+  else
+    status = profile_doc_parse(pLazy->pDoc,pLazy->pText + pSection->start,
+      pSection->end - pSection->start);
+  free(pRead);
+  if (!status)
+    return (FALSE);
+  pSection->parsed = TRUE;
+  pLazy->nParsed++;
+
+  return (TRUE);
+}
+
+/**
+ * List the section names of a file read from fd, the same way as
+ * GetPrivateProfileString, from its index.  The caller holds the lock.
+ *
+ * @param pLazy - lazy file read from fd
+ * @param pKeyName - key name
+ * @param pDefault - default string
+ * @param pReturnedString - buffer that receives the names
+ * @param nSize - size of the buffer
+ *
+ * @return number of characters copied to the buffer
+ */
+static size_t lazy_list(
+  PROFILE_LAZY *pLazy,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  char *pHeaders;
+  size_t len = 0;
+  size_t count;
+  size_t i;
+
+  if (lazy_changed(pLazy))
+    (void)lazy_reindex(pLazy);
+  /* a header line of each name, with brackets and an end of line */
+  pHeaders = malloc(pLazy->nNames + (pLazy->nSections * 2) + 1);
+  if (!pHeaders)
+    return (GetPrivateProfileStringFromBuffer(NULL,pKeyName,pDefault,
+      pReturnedString,nSize,"",0));
+  for (i = 0; i < pLazy->nSections; i++)
+  {
+    pHeaders[len++] = '[';
+    memcpy(pHeaders + len,pLazy->pNames + pLazy->pSection[i].name,
+      pLazy->pSection[i].nLength);
+    len += pLazy->pSection[i].nLength;
+    pHeaders[len++] = ']';
+    pHeaders[len++] = '\n';
+  }
+  count = GetPrivateProfileStringFromBuffer(NULL,pKeyName,pDefault,
+    pReturnedString,nSize,pHeaders,len);
+  free(pHeaders);
+
+  return (count);
+}
+
+/**
+ * Find a section, parsing it if it is used for the first time
+ *
+ * @param pLazy (IN) lazy file
+ * @param pAppName (IN) section name
+ *
+ * @return section, valid until profile_lazy_free(), or NULL
+ */
+PROFILE_SECTION *profile_lazy_section(
+  PROFILE_LAZY *pLazy,
+  const char *pAppName)
+{
+  PROFILE_SECTION *pSection = NULL;
+
+  if (!pLazy || !pAppName)
+    return (NULL);
+  pthread_mutex_lock(&pLazy->lock);
+  if (lazy_parse(pLazy,pAppName))
+    pSection = profile_doc_section(pLazy->pDoc,pAppName);
+  pthread_mutex_unlock(&pLazy->lock);
+
+  return (pSection);
+}
+
+/**
+ * Find the value of a key, parsing its section if it is used for
+ * the first time
+ *
+ * @param pLazy (IN) lazy file
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name
+ *
+ * @return value, valid until profile_lazy_free(), or NULL if the key
+ *  is not found or has no '='
+ */
+const char *profile_lazy_value(
+  PROFILE_LAZY *pLazy,
+  const char *pAppName,
+  const char *pKeyName)
+{
+  const char *pValue = NULL;
+
+  if (!pLazy || !pAppName || !pKeyName)
+    return (NULL);
+  pthread_mutex_lock(&pLazy->lock);
+  if (lazy_parse(pLazy,pAppName))
+    pValue = profile_doc_value(pLazy->pDoc,pAppName,pKeyName);
+  pthread_mutex_unlock(&pLazy->lock);
+
+  return (pValue);
+}
+
+/**
+ * Retrieves a string the same way as GetPrivateProfileString,
+ * parsing the section if it is used for the first time
+ *
+ * @param pLazy (IN) lazy file
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t profile_lazy_get(
+  PROFILE_LAZY *pLazy,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  size_t count;
+
+  if (!pLazy)
+    return (0);
+  pthread_mutex_lock(&pLazy->lock);
+  /* every section name is in the index, and none needs parsing */
+  if (!pAppName)
+  {
+    if (pLazy->fd >= 0)
+      count = lazy_list(pLazy,pKeyName,pDefault,pReturnedString,nSize);
+    else
+      count = GetPrivateProfileStringFromBuffer(pAppName,pKeyName,pDefault,
+        pReturnedString,nSize,pLazy->pText,pLazy->nLength);
+    pthread_mutex_unlock(&pLazy->lock);
+    return (count);
+  }
+  (void)lazy_parse(pLazy,pAppName);
+  count = profile_doc_get(pLazy->pDoc,pAppName,pKeyName,pDefault,
+    pReturnedString,nSize);
+  pthread_mutex_unlock(&pLazy->lock);
+
+  return (count);
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief INI files whose sections are parsed when first used
+ */
+#ifndef PROFILE_LAZY_H
+#define PROFILE_LAZY_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+typedef struct profile_lazy PROFILE_LAZY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_LAZY *profile_lazy_load(const char *pFileName);
+  PROFILE_LAZY *profile_lazy_load_io(
+    const PROFILE_IO *pIo,
+    const char *pFileName);
+  PROFILE_LAZY *profile_lazy_load_buffer(
+    const char *pBuffer,
+    size_t nLength);
+  void profile_lazy_free(PROFILE_LAZY *pLazy);
+
+  size_t profile_lazy_section_count(const PROFILE_LAZY *pLazy);
+  size_t profile_lazy_parsed_count(PROFILE_LAZY *pLazy);
+  size_t profile_lazy_memory(PROFILE_LAZY *pLazy);
+
+  PROFILE_SECTION *profile_lazy_section(
+    PROFILE_LAZY *pLazy,
+    const char *pAppName);
+  const char *profile_lazy_value(
+    PROFILE_LAZY *pLazy,
+    const char *pAppName,
+    const char *pKeyName);
+  size_t profile_lazy_get(
+    PROFILE_LAZY *pLazy,
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize); 	// size of destination buffer
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_LAZY_H */
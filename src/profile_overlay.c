@@ -0,0 +1,346 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Layered lookups across an ordered list of INI files
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * An overlay resolves a key the way a chain of GetPrivateProfileString
+ * calls over local.ini, site.ini and defaults.ini would: the first file
+ * that has the key wins.  Each file is parsed once into its own layer
+ * document, and the layers are merged into one document so a lookup is
+ * a single hash probe no matter how many layers there are.
+ *
+ * When a file changes, only its layer is parsed again.  The merged
+ * document is then rebuilt from the layers already in memory.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+#include "profile_overlay.h"
+
+/* one file of the overlay */
+struct overlay_layer
+{
+  char *pFileName;
+  PROFILE_DOC *pDoc; /* NULL when the file does not exist */
+  PROFILE_IO_STAT file_stat; /* the file when it was loaded */
+};
+
+struct profile_overlay
+{
+  size_t count; /* number of layers */
+  struct overlay_layer *pLayer; /* highest priority first */
+  PROFILE_DOC *pMerged; /* all layers, NULL when it must be rebuilt */
+};
+
+/**
+ * Load or reload the document for one layer
+ *
+ * @param pLayer - layer
+ *
+ * @return FALSE if the file exists but could not be loaded
+ */
+static BOOL overlay_load(
+  struct overlay_layer *pLayer)
+{
+  profile_doc_free(pLayer->pDoc);
+  pLayer->pDoc = NULL;
+  memset(&pLayer->file_stat,0,sizeof(pLayer->file_stat));
+  /* stat first, so a change while reading is seen next time */
+  if (!profile_io_stat(profile_io_posix(),pLayer->pFileName,
+    &pLayer->file_stat))
+  {
+    /* no file */
+    memset(&pLayer->file_stat,0,sizeof(pLayer->file_stat));
+    return (TRUE);
+  }
+  pLayer->pDoc = profile_doc_load(pLayer->pFileName);
+
+  return (pLayer->pDoc != NULL);
+}
+
+/**
+ * Add a layer below the layers already merged.  A key of a higher
+ * layer hides the same key here, except a key line without '=': that
+ * has no value, so GetPrivateProfileString would go on to this layer.
+ *
+ * @param pDest - merged document
+ * @param pSource - layer document, may be NULL
+ *
+ * @return TRUE if successful, FALSE if out of memory
+ */
+static BOOL overlay_merge(
+  PROFILE_DOC *pDest,
+  const PROFILE_DOC *pSource)
+{
+  const PROFILE_SECTION *pSection;
+  PROFILE_SECTION *pCopy;
+  const PROFILE_ENTRY *pEntry;
+  const PROFILE_ENTRY *pHigher;
+  const char *pAppName;
+  const char *pValue;
+
+  for (pSection = profile_doc_first(pSource); pSection;
+    pSection = profile_section_next(pSection))
+  {
+    pAppName = profile_section_name(pSection);
+    pCopy = profile_doc_add_section(pDest,pAppName);
+    if (!pCopy)
+      return (FALSE);
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry))
+    {
+      pValue = profile_entry_value(pEntry);
+      pHigher = profile_doc_entry(pDest,pAppName,profile_entry_key(pEntry));
+      if (!pHigher)
+      {
+        if (!profile_doc_add_entry(pDest,pCopy,profile_entry_key(pEntry),
+          pValue))
+          return (FALSE);
+      }
+      else if (!profile_entry_value(pHigher) && pValue)
+      {
+        if (!profile_doc_set(pDest,pAppName,profile_entry_key(pEntry),
+          pValue))
+          return (FALSE);
+      }
+    }
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Build the merged document from the layers
+ *
+ * @param pOverlay - overlay
+ *
+ * @return merged document, or NULL if out of memory
+ */
+static PROFILE_DOC *overlay_merged(
+  PROFILE_OVERLAY *pOverlay)
+{
+  size_t i;
+
+  if (pOverlay->pMerged)
+    return (pOverlay->pMerged);
+  pOverlay->pMerged = profile_doc_create();
+  for (i = 0; pOverlay->pMerged && (i < pOverlay->count); i++)
+  {
+    if (!overlay_merge(pOverlay->pMerged,pOverlay->pLayer[i].pDoc))
+    {
+      profile_doc_free(pOverlay->pMerged);
+      pOverlay->pMerged = NULL;
+    }
+  }
+
+  return (pOverlay->pMerged);
+}
+
+/**
+ * Create an overlay of INI files and load them
+ *
+ * @param ppFileNames (IN) initialization filenames, highest priority
+ *  first.  Files that do not exist yet are treated as empty.
+ * @param nCount (IN) number of filenames
+ *
+ * @return new overlay, or NULL if out of memory
+ */
+PROFILE_OVERLAY *profile_overlay_create(
+  const char * const *ppFileNames,
+  size_t nCount)
+{
+  PROFILE_OVERLAY *pOverlay = NULL;
+  size_t len = 0;
+  size_t i;
+
+  if (!ppFileNames || !nCount)
+    return (NULL);
+  pOverlay = calloc(1,sizeof(PROFILE_OVERLAY));
+  if (!pOverlay)
+    return (NULL);
+  pOverlay->pLayer = calloc(nCount,sizeof(struct overlay_layer));
+  if (!pOverlay->pLayer)
+  {
+    free(pOverlay);
+    return (NULL);
+  }
+  pOverlay->count = nCount;
+  for (i = 0; i < nCount; i++)
+  {
+    if (!ppFileNames[i])
+      break;
+    len = strlen(ppFileNames[i]) + 1;
+    pOverlay->pLayer[i].pFileName = malloc(len);
+    if (!pOverlay->pLayer[i].pFileName)
+      break;
+    memcpy(pOverlay->pLayer[i].pFileName,ppFileNames[i],len);
+    if (!overlay_load(&pOverlay->pLayer[i]))
+      break;
+  }
+  if (i < nCount)
+  {
+    profile_overlay_free(pOverlay);
+    pOverlay = NULL;
+  }
+
+  return (pOverlay);
+}
+
+/**
+ * Release an overlay and all of its layers
+ *
+ * @param pOverlay - overlay, may be NULL
+ */
+void profile_overlay_free(
+  PROFILE_OVERLAY *pOverlay)
+{
+  size_t i;
+
+  if (!pOverlay)
+    return;
+  for (i = 0; i < pOverlay->count; i++)
+  {
+    profile_doc_free(pOverlay->pLayer[i].pDoc);
+    free(pOverlay->pLayer[i].pFileName);
+  }
+  profile_doc_free(pOverlay->pMerged);
+  free(pOverlay->pLayer);
+  free(pOverlay);
+}
+
+/**
+ * Retrieves a string from the first layer that has it.
+ * The parameters and return value are the same as for
+ * GetPrivateProfileString.  When pAppName or pKeyName is NULL,
+ * the names from all of the layers are listed once each, in
+ * priority order.
+ *
+ * @param pOverlay (IN) overlay
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ *
+ * @return number of characters copied to the buffer, not including
+ *  the terminating null character.
+ */
+size_t profile_overlay_get(
+  PROFILE_OVERLAY *pOverlay,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  return (profile_doc_get(pOverlay ? overlay_merged(pOverlay) : NULL,
+    pAppName,pKeyName,pDefault,pReturnedString,nSize));
+}
+
+/**
+ * Find the value of a key in the first layer that has it
+ *
+ * @param pOverlay - overlay
+ * @param pAppName - section name
+ * @param pKeyName - key name
+ *
+ * @return value, or NULL if not found.  The value is valid until
+ *  the overlay is refreshed, invalidated or freed.
+ */
+const char *profile_overlay_value(
+  PROFILE_OVERLAY *pOverlay,
+  const char *pAppName,
+  const char *pKeyName)
+{
+  if (!pOverlay)
+    return (NULL);
+
+  return (profile_doc_value(overlay_merged(pOverlay),pAppName,pKeyName));
+}
+
+/**
+ * Reload one layer from its file
+ *
+ * @param pOverlay - overlay
+ * @param nLayer - layer index, zero is the highest priority
+ *
+ * @return TRUE if the layer was reloaded
+ */
+BOOL profile_overlay_invalidate(
+  PROFILE_OVERLAY *pOverlay,
+  size_t nLayer)
+{
+  BOOL status;
+
+  if (!pOverlay || (nLayer >= pOverlay->count))
+    return (FALSE);
+  status = overlay_load(&pOverlay->pLayer[nLayer]);
+  profile_doc_free(pOverlay->pMerged);
+  pOverlay->pMerged = NULL;
+
+  return (status);
+}
+
+/**
+ * Reload the layers whose files have changed size or modification
+ * time since they were loaded.
+ *
+ * @param pOverlay - overlay
+ *
+ * @return number of layers that were reloaded
+ */
+size_t profile_overlay_refresh(
+  PROFILE_OVERLAY *pOverlay)
+{
+  struct overlay_layer *pLayer;
+  PROFILE_IO_STAT file_stat;
+  size_t count = 0;
+  size_t i;
+
+  if (!pOverlay)
+    return (count);
+  for (i = 0; i < pOverlay->count; i++)
+  {
+    pLayer = &pOverlay->pLayer[i];
+    /* FALSE when there is no file */
+    if (!profile_io_stat(profile_io_posix(),pLayer->pFileName,&file_stat))
+      memset(&file_stat,0,sizeof(file_stat));
+    /* unchanged, or still missing */
+    if ((file_stat.exists == pLayer->file_stat.exists) &&
+      (file_stat.size == pLayer->file_stat.size) &&
+      (file_stat.mtime == pLayer->file_stat.mtime))
+      continue;
+    (void)profile_overlay_invalidate(pOverlay,i);
+    count++;
+  }
+
+  return (count);
+}
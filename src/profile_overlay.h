@@ -0,0 +1,42 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Layered lookups across an ordered list of INI files
+ */
+#ifndef PROFILE_OVERLAY_H
+#define PROFILE_OVERLAY_H
+
+#include "profile.h"
+
+typedef struct profile_overlay PROFILE_OVERLAY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_OVERLAY *profile_overlay_create(
+    const char * const *ppFileNames,	// highest priority first
+    size_t nCount); 	// number of filenames
+  void profile_overlay_free(PROFILE_OVERLAY *pOverlay);
+
+  size_t profile_overlay_get(
+    PROFILE_OVERLAY *pOverlay,
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize); 	// size of destination buffer
+  const char *profile_overlay_value(
+    PROFILE_OVERLAY *pOverlay,
+    const char *pAppName,
+    const char *pKeyName);
+
+  BOOL profile_overlay_invalidate(
+    PROFILE_OVERLAY *pOverlay,
+    size_t nLayer);
+  size_t profile_overlay_refresh(PROFILE_OVERLAY *pOverlay);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_OVERLAY_H */
@@ -0,0 +1,239 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parse large INI files on several threads
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * The INI text is cut into one chunk per thread.  Every cut is made at
+ * the start of a line that begins with '[', because the parser forgets
+ * the current section at any such line, so a chunk parsed on its own
+ * gives the same sections and keys it would give as part of the file.
+ *
+ * Each chunk is parsed into its own document, then the documents are
+ * merged in file order.  A section that already came from an earlier
+ * chunk is skipped as a whole, which keeps the first-occurrence-wins
+ * results of GetPrivateProfileString for repeated sections and keys.
+ * The merge is done with profile_doc_adopt, which links the sections of
+ * a chunk into the first document and takes over its arena, so the
+ * serial part costs one hash insert per section and key and no copies.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_parallel.h"
+
+/* one piece of the INI text */
+struct parallel_chunk
+{
+  const char *pBuffer;
+  size_t nLength;
+  PROFILE_DOC *pDoc;
+  pthread_t thread;
+  BOOL started; /* TRUE if parsed on its own thread */
+};
+
+/**
+ * Parse one chunk into its own document
+ *
+ * @param pArg - chunk
+ *
+ * @return NULL
+ */
+static void *parallel_parse(
+  void *pArg)
+{
+  struct parallel_chunk *pChunk = pArg;
+
+  pChunk->pDoc = profile_doc_create();
+  if (pChunk->pDoc &&
+    !profile_doc_parse(pChunk->pDoc,pChunk->pBuffer,pChunk->nLength))
+  {
+    profile_doc_free(pChunk->pDoc);
+    pChunk->pDoc = NULL;
+  }
+
+  return (NULL);
+}
+
+/**
+ * Find where a chunk may start
+ *
+ * @param pBuffer - INI text
+ * @param nLength - number of characters in pBuffer
+ * @param offset - first possible position
+ *
+ * @return offset of the first line at or after offset that starts
+ *  with '[', or nLength if there is none.
+ */
+static size_t parallel_split(
+  const char *pBuffer,
+  size_t nLength,
+  size_t offset)
+{
+  const char *pLine;
+
+  if (offset == 0)
+    return (offset);
+  pLine = pBuffer + offset - 1;
+  while ((pLine = memchr(pLine,'\n',nLength - (size_t)(pLine - pBuffer))))
+  {
+    pLine++;
+    if ((size_t)(pLine - pBuffer) >= nLength)
+      break;
+    if (*pLine == '[')
+      return ((size_t)(pLine - pBuffer));
+  }
+
+  return (nLength);
+}
+
+/**
+ * Parse INI text on several threads
+ *
+ * @param pBuffer (IN) INI text, which need not be null-terminated
+ * @param nLength (IN) number of characters in pBuffer
+ * @param nThreads (IN) maximum number of threads, or zero for one
+ *  per online CPU.  Fewer threads are used for small texts.
+ *
+ * @return new document, or NULL if out of memory
+ */
+PROFILE_DOC *profile_doc_parse_parallel(
+  const char *pBuffer,
+  size_t nLength,
+  unsigned nThreads)
+{
+  struct parallel_chunk *pChunk = NULL;
+  PROFILE_DOC *pDoc = NULL;
+  size_t count = 0; /* number of chunks */
+  size_t start = 0;
+  size_t end = 0;
+  size_t i;
+  BOOL status = TRUE;
+
+  if (!pBuffer && nLength)
+    return (NULL);
+  if (nThreads == 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    nThreads = (cpus > 0) ? (unsigned)cpus : 1;
+  }
+  count = nLength / PROFILE_PARALLEL_MIN_CHUNK;
+  if (count > nThreads)
+    count = nThreads;
+  if (count < 2)
+  {
+    pDoc = profile_doc_create();
+    if (pDoc && !profile_doc_parse(pDoc,pBuffer,nLength))
+    {
+      profile_doc_free(pDoc);
+      pDoc = NULL;
+    }
+    return (pDoc);
+  }
+  pChunk = calloc(count,sizeof(struct parallel_chunk));
+  if (!pChunk)
+    return (NULL);
+  for (i = 0; i < count; i++)
+  {
+    end = (i + 1 < count) ?
+      parallel_split(pBuffer,nLength,(nLength / count) * (i + 1)) : nLength;
+    if (end < start)
+      end = start;
+    pChunk[i].pBuffer = pBuffer + start;
+    pChunk[i].nLength = end - start;
+    start = end;
+  }
+  /* the first chunk is parsed on this thread */
+  for (i = 1; i < count; i++)
+  {
+    if (pChunk[i].nLength && (pthread_create(&pChunk[i].thread,NULL,
+      parallel_parse,&pChunk[i]) == 0))
+      pChunk[i].started = TRUE;
+  }
+  (void)parallel_parse(&pChunk[0]);
+  for (i = 1; i < count; i++)
+  {
+    if (pChunk[i].started)
+      pthread_join(pChunk[i].thread,NULL);
+    else if (pChunk[i].nLength)
+      (void)parallel_parse(&pChunk[i]);
+    else
+      pChunk[i].pDoc = profile_doc_create();
+    if (!pChunk[i].pDoc)
+      status = FALSE;
+  }
+  pDoc = pChunk[0].pDoc;
+  if (!pDoc)
+    status = FALSE;
+  /* the chunks are linked in, not copied, and go with the document */
+  for (i = 1; i < count; i++)
+  {
+    if (status)
+      status = profile_doc_adopt(pDoc,pChunk[i].pDoc);
+    else
+      profile_doc_free(pChunk[i].pDoc);
+  }
+  if (!status)
+  {
+    profile_doc_free(pDoc);
+    pDoc = NULL;
+  }
+  free(pChunk);
+
+  return (pDoc);
+}
+
+/**
+ * Load and parse an INI file on several threads
+ *
+ * @param pFileName (IN) initialization filename
+ * @param nThreads (IN) maximum number of threads, or zero for one
+ *  per online CPU
+ *
+ * @return new document, or NULL if the file cannot be read
+ */
+PROFILE_DOC *profile_doc_load_parallel(
+  const char *pFileName,
+  unsigned nThreads)
+{
+  PROFILE_DOC *pDoc = NULL;
+  char *pBuffer = NULL;
+  size_t len = 0;
+
+  pBuffer = profile_doc_read_file(pFileName,&len);
+  if (!pBuffer)
+    return (NULL);
+  pDoc = profile_doc_parse_parallel(pBuffer,len,nThreads);
+  free(pBuffer);
+
+  return (pDoc);
+}
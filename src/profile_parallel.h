@@ -0,0 +1,32 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parse large INI files on several threads
+ */
+#ifndef PROFILE_PARALLEL_H
+#define PROFILE_PARALLEL_H
+
+#include "profile.h"
+#include "profile_doc.h"
+
+/* chunks smaller than this are not worth a thread */
+#ifndef PROFILE_PARALLEL_MIN_CHUNK
+#define PROFILE_PARALLEL_MIN_CHUNK 65536
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_DOC *profile_doc_load_parallel(
+    const char *pFileName,	// initialization filename
+    unsigned nThreads); 	// number of threads, zero for one per CPU
+  PROFILE_DOC *profile_doc_parse_parallel(
+    const char *pBuffer,	// INI text
+    size_t nLength,	// number of characters in pBuffer
+    unsigned nThreads); 	// number of threads, zero for one per CPU
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_PARALLEL_H */
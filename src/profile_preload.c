@@ -0,0 +1,230 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Load many INI files into the cache at once
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * A pool of threads shares the list of files.  Each thread takes the
+ * next file that nobody has taken, reads and parses it, and puts the
+ * document into the profile cache (profile_cache.h), so while one
+ * thread waits for the disk the others are parsing.  Reading a file is
+ * mostly waiting, so by default there are two threads for each CPU.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_preload.h"
+
+/* the work shared by the threads of one preload */
+struct preload_work
+{
+  const char * const *ppFileNames;
+  size_t nCount;
+  size_t next; /* index of the next file to load */
+  size_t loaded; /* number of files cached */
+  pthread_mutex_t lock;
+};
+
+/**
+ * Load files until there are none left
+ *
+ * @param pArg - shared work
+ *
+ * @return NULL
+ */
+static void *preload_worker(
+  void *pArg)
+{
+  struct preload_work *pWork = pArg;
+  size_t loaded = 0;
+  size_t i;
+
+  for (;;)
+  {
+    pthread_mutex_lock(&pWork->lock);
+    i = pWork->next;
+    if (i < pWork->nCount)
+      pWork->next++;
+    pthread_mutex_unlock(&pWork->lock);
+    if (i >= pWork->nCount)
+      break;
+    if (pWork->ppFileNames[i] && profile_cache_load(pWork->ppFileNames[i]))
+      loaded++;
+  }
+  pthread_mutex_lock(&pWork->lock);
+  pWork->loaded += loaded;
+  pthread_mutex_unlock(&pWork->lock);
+
+  return (NULL);
+}
+
+/**
+ * Read and parse a list of INI files into the profile cache,
+ * several at a time.  Files that cannot be read are skipped.
+ *
+ * @param ppFileNames (IN) initialization filenames
+ * @param nCount (IN) number of filenames
+ * @param nThreads (IN) number of threads, or zero for two per CPU
+ *
+ * @return number of files that were cached
+ */
+size_t profile_preload(
+  const char * const *ppFileNames,
+  size_t nCount,
+  unsigned nThreads)
+{
+  struct preload_work work;
+  pthread_t thread[PROFILE_PRELOAD_MAX_THREADS];
+  unsigned started = 0;
+  unsigned i;
+
+  if (!ppFileNames || !nCount)
+    return (0);
+  if (nThreads == 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    nThreads = (cpus > 0) ? (unsigned)cpus * 2 : 2;
+  }
+  if (nThreads > PROFILE_PRELOAD_MAX_THREADS)
+    nThreads = PROFILE_PRELOAD_MAX_THREADS;
+  if (nThreads > nCount)
+    nThreads = (unsigned)nCount;
+  work.ppFileNames = ppFileNames;
+  work.nCount = nCount;
+  work.next = 0;
+  work.loaded = 0;
+  if (pthread_mutex_init(&work.lock,NULL) != 0)
+    return (0);
+  /* this thread is one of the workers */
+  for (i = 1; i < nThreads; i++)
+  {
+    if (pthread_create(&thread[started],NULL,preload_worker,&work) == 0)
+      started++;
+  }
+  (void)preload_worker(&work);
+  for (i = 0; i < started; i++)
+    pthread_join(thread[i],NULL);
+  pthread_mutex_destroy(&work.lock);
+
+  return (work.loaded);
+}
+
+/**
+ * Check whether a name ends with a suffix
+ *
+ * @param pName - file name
+ * @param pSuffix - suffix, or NULL for any name
+ *
+ * @return TRUE if the name ends with the suffix
+ */
+static BOOL preload_match(
+  const char *pName,
+  const char *pSuffix)
+{
+  size_t len;
+  size_t suffix_len;
+
+  if (!pSuffix)
+    return (TRUE);
+  len = strlen(pName);
+  suffix_len = strlen(pSuffix);
+  if (suffix_len > len)
+    return (FALSE);
+
+  return (strcmp(pName + len - suffix_len,pSuffix) == 0);
+}
+
+/**
+ * Read and parse the INI files of a directory into the profile cache.
+ * Each file is cached under the directory name, a slash, and its name.
+ *
+ * @param pDirName (IN) directory of initialization files
+ * @param pSuffix (IN) only names that end with this, such as ".ini",
+ *  or NULL for every file
+ * @param nThreads (IN) number of threads, or zero for two per CPU
+ *
+ * @return number of files that were cached
+ */
+size_t profile_preload_dir(
+  const char *pDirName,
+  const char *pSuffix,
+  unsigned nThreads)
+{
+  DIR *pDir;
+  struct dirent *pDirent;
+  char **ppFileNames = NULL;
+  char **ppMore;
+  size_t size = 0;
+  size_t count = 0;
+  size_t dir_len;
+  size_t len;
+  size_t loaded = 0;
+  size_t i;
+
+  if (!pDirName)
+    return (0);
+  pDir = opendir(pDirName);
+  if (!pDir)
+    return (0);
+  dir_len = strlen(pDirName);
+  while ((pDirent = readdir(pDir)) != NULL)
+  {
+    if ((pDirent->d_name[0] == '.') ||
+      !preload_match(pDirent->d_name,pSuffix))
+      continue;
+    if (count == size)
+    {
+      size = size ? size * 2 : 64;
+      ppMore = realloc(ppFileNames,size * sizeof(char *));
+      if (!ppMore)
+        break;
+      ppFileNames = ppMore;
+    }
+    len = strlen(pDirent->d_name);
+    ppFileNames[count] = malloc(dir_len + len + 2);
+    if (!ppFileNames[count])
+      break;
+    memcpy(ppFileNames[count],pDirName,dir_len);
+    ppFileNames[count][dir_len] = '/';
+    memcpy(ppFileNames[count] + dir_len + 1,pDirent->d_name,len + 1);
+    count++;
+  }
+  closedir(pDir);
+  loaded = profile_preload((const char * const *)ppFileNames,count,nThreads);
+  for (i = 0; i < count; i++)
+    free(ppFileNames[i]);
+  free(ppFileNames);
+
+  return (loaded);
+}
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Load many INI files into the cache at once
+ */
+#ifndef PROFILE_PRELOAD_H
+#define PROFILE_PRELOAD_H
+
+#include <stddef.h>
+#include "profile.h"
+
+/* most threads used by one preload */
+#ifndef PROFILE_PRELOAD_MAX_THREADS
+#define PROFILE_PRELOAD_MAX_THREADS 64
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  size_t profile_preload(
+    const char * const *ppFileNames,	// initialization filenames
+    size_t nCount,	// number of filenames
+    unsigned nThreads); 	// number of threads, zero for two per CPU
+  size_t profile_preload_dir(
+    const char *pDirName,	// directory of initialization files
+    const char *pSuffix,	// only names that end with this, or NULL
+    unsigned nThreads); 	// number of threads, zero for two per CPU
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_PRELOAD_H */
@@ -0,0 +1,985 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parsed INI files published in shared memory
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * One process publishes a document (profile_doc.h) into a shared memory
+ * segment, and any number of processes attach to the segment read-only
+ * and look keys up in it without parsing the file or taking a lock.
+ *
+ * The snapshot holds no pointers, only offsets from the start of the
+ * segment, so each process may map it at any address:
+ *
+ *  - a header with the counts and where each table starts,
+ *  - the sections in file order, each with the range of its entries,
+ *  - the entries, grouped by section,
+ *  - the hash chains of the sections and of the entries, using the
+ *    case-folded hashes of profile_doc_hash(),
+ *  - and the names and values, each followed by a null character.
+ *
+ * The header's sequence number is a seqlock.  The publisher builds the
+ * next snapshot in private memory, makes the sequence odd, copies the
+ * snapshot over the old one, and makes it even again.  A reader notes
+ * the sequence, copies its answer out, and tries again if the sequence
+ * was odd or has changed since.  Every offset is checked against the
+ * mapping first, so an answer read while a snapshot is being copied is
+ * thrown away rather than followed.  The number of snapshots published
+ * so far, half the sequence, is the generation.
+ *
+ * The segment only grows.  When a snapshot does not fit, the publisher
+ * makes the segment larger, and a reader that sees the new length in
+ * the header maps the segment again.  A segment may be named, with
+ * shm_open, or on Linux an unnamed memfd that is passed to the readers
+ * by fork or over a unix socket.
+ *
+ * Only one process may publish to a segment at a time.  A handle may
+ * be used by several threads; its lock is held during a lookup, but
+ * other processes never wait for it.
+ */
+
+/* memfd_create is a GNU extension */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE
+#endif
+
+/* includes */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_shm.h"
+#include "strfold.h"
+
+#define SHM_MAGIC 0x31494e49UL /* "INI1" */
+#define SHM_VERSION 1
+#define SHM_NONE 0 /* offset of no string: the header is at 0 */
+#define SHM_MIN_BUCKETS 8
+
+/* start of the segment */
+struct shm_header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sequence; /* odd while a snapshot is being copied */
+  uint64_t length; /* number of bytes in the segment */
+  /* the rest is part of the snapshot */
+  uint32_t used; /* number of bytes in the snapshot */
+  uint32_t sections; /* number of sections */
+  uint32_t entries; /* number of entries */
+  uint32_t buckets; /* size of each hash table, a power of two */
+  uint32_t section_table;
+  uint32_t entry_table;
+  uint32_t bucket_table; /* section chains, then entry chains */
+  uint32_t reserved;
+};
+
+/* a section in the snapshot */
+struct shm_section
+{
+  uint32_t name; /* offset of the name */
+  uint32_t name_length;
+  uint32_t hash; /* profile_doc_hash of the name */
+  uint32_t first; /* index of its first entry */
+  uint32_t count; /* number of entries */
+  uint32_t next; /* next section in the chain, plus one */
+};
+
+/* a key and its value in the snapshot */
+struct shm_entry
+{
+  uint32_t key; /* offset of the key name */
+  uint32_t key_length;
+  uint32_t value; /* offset of the value, or SHM_NONE */
+  uint32_t value_length;
+  uint32_t hash; /* profile_doc_hash of the section and key names */
+  uint32_t next; /* next entry in the chain, plus one */
+};
+
+/* a mapping of a segment */
+struct profile_shm
+{
+  int fd;
+  BOOL writable; /* TRUE for the publisher */
+  unsigned char *pBase;
+  size_t nLength; /* number of bytes mapped */
+  pthread_mutex_t lock;
+};
+
+/**
+ * Map a segment, or map it again at its current size.
+ *
+ * @param pShm - segment
+ * @param nLength - number of bytes to map
+ *
+ * @return TRUE if the segment is mapped
+ */
+static BOOL shm_map(
+  PROFILE_SHM *pShm,
+  size_t nLength)
+{
+  void *pBase = NULL;
+  int prot = PROT_READ;
+
+  if (pShm->writable)
+    prot |= PROT_WRITE;
+  pBase = mmap(NULL,nLength,prot,MAP_SHARED,pShm->fd,0);
+  if (pBase == MAP_FAILED)
+    return (FALSE);
+  if (pShm->pBase)
+    munmap(pShm->pBase,pShm->nLength);
+  pShm->pBase = pBase;
+  pShm->nLength = nLength;
+
+  return (TRUE);
+}
+
+/**
+ * Wrap an open segment in a handle and map it.
+ *
+ * @param fd - open segment, owned by the handle
+ * @param writable - TRUE for the publisher
+ *
+ * @return handle, or NULL if the segment cannot be mapped
+ */
+static PROFILE_SHM *shm_open_fd(
+  int fd,
+  BOOL writable)
+{
+  PROFILE_SHM *pShm = NULL;
+  struct stat file_stat;
+
+  if ((fstat(fd,&file_stat) == 0) &&
+    ((size_t)file_stat.st_size >= sizeof(struct shm_header)))
+    pShm = calloc(1,sizeof(PROFILE_SHM));
+  if (!pShm)
+  {
+    close(fd);
+    return (NULL);
+  }
+  pShm->fd = fd;
+  pShm->writable = writable;
+  pthread_mutex_init(&pShm->lock,NULL);
+  if (!shm_map(pShm,(size_t)file_stat.st_size))
+  {
+    profile_shm_close(pShm);
+    return (NULL);
+  }
+
+  return (pShm);
+}
+
+/**
+ * Create a segment to publish to, or open it again to publish the
+ * next snapshot.  A snapshot that a publisher was copying when it
+ * stopped is dropped, and readers see an empty document until the
+ * next one is published.
+ *
+ * @param pName (IN) name for shm_open, starting with '/', or NULL for
+ *  an unnamed memfd on Linux
+ * @param nSize (IN) number of bytes to start with
+ *
+ * @return segment, or NULL if it cannot be created
+ */
+PROFILE_SHM *profile_shm_create(
+  const char *pName,
+  size_t nSize)
+{
+  PROFILE_SHM *pShm = NULL;
+  struct shm_header *pHeader = NULL;
+  struct stat file_stat;
+  uint64_t sequence = 0;
+  int fd = -1;
+
+  if (pName)
+    fd = shm_open(pName,O_RDWR | O_CREAT,0644);
+#if defined(__linux__)
+  else
+    fd = memfd_create("profile_shm",MFD_CLOEXEC);
+#endif
+  if (fd < 0)
+    return (NULL);
+  if (nSize < sizeof(struct shm_header))
+    nSize = sizeof(struct shm_header);
+  if ((fstat(fd,&file_stat) != 0) ||
+    (((size_t)file_stat.st_size < nSize) && (ftruncate(fd,nSize) != 0)))
+  {
+    close(fd);
+    return (NULL);
+  }
+  pShm = shm_open_fd(fd,TRUE);
+  if (!pShm)
+    return (NULL);
+  pHeader = (struct shm_header *)pShm->pBase;
+  if ((pHeader->magic != SHM_MAGIC) || (pHeader->version != SHM_VERSION))
+  {
+    memset(pHeader,0,sizeof(struct shm_header));
+    pHeader->magic = SHM_MAGIC;
+    pHeader->version = SHM_VERSION;
+  }
+  else
+  {
+    sequence = __atomic_load_n(&pHeader->sequence,__ATOMIC_RELAXED);
+    if (sequence & 1)
+    {
+      pHeader->used = 0;
+      pHeader->sections = 0;
+      pHeader->entries = 0;
+      pHeader->buckets = 0;
+      __atomic_store_n(&pHeader->sequence,sequence + 1,__ATOMIC_RELEASE);
+    }
+  }
+  __atomic_store_n(&pHeader->length,(uint64_t)pShm->nLength,
+    __ATOMIC_RELEASE);
+
+  return (pShm);
+}
+
+/**
+ * Attach read-only to a named segment.
+ *
+ * @param pName (IN) name that the publisher created it with
+ *
+ * @return segment, or NULL if there is no such segment
+ */
+PROFILE_SHM *profile_shm_attach(
+  const char *pName)
+{
+  PROFILE_SHM *pShm = NULL;
+  int fd = -1;
+
+  if (!pName)
+    return (NULL);
+  fd = shm_open(pName,O_RDONLY,0);
+  if (fd < 0)
+    return (NULL);
+  pShm = shm_open_fd(fd,FALSE);
+  if (pShm &&
+    (((struct shm_header *)pShm->pBase)->magic != SHM_MAGIC))
+  {
+    profile_shm_close(pShm);
+    pShm = NULL;
+  }
+
+  return (pShm);
+}
+
+/**
+ * Attach read-only to a segment by file descriptor, such as a memfd
+ * from profile_shm_fd() that was passed from the publisher.
+ *
+ * @param fd (IN) open segment; the handle uses a copy of it
+ *
+ * @return segment, or NULL if it cannot be mapped
+ */
+PROFILE_SHM *profile_shm_attach_fd(
+  int fd)
+{
+  PROFILE_SHM *pShm = NULL;
+
+  fd = fcntl(fd,F_DUPFD_CLOEXEC,0);
+  if (fd < 0)
+    return (NULL);
+  pShm = shm_open_fd(fd,FALSE);
+  if (pShm &&
+    (((struct shm_header *)pShm->pBase)->magic != SHM_MAGIC))
+  {
+    profile_shm_close(pShm);
+    pShm = NULL;
+  }
+
+  return (pShm);
+}
+
+/**
+ * Unmap a segment and close it.  A named segment stays until
+ * profile_shm_unlink() is called.
+ *
+ * @param pShm (IN) segment, or NULL
+ */
+void profile_shm_close(
+  PROFILE_SHM *pShm)
+{
+  if (!pShm)
+    return;
+  if (pShm->pBase)
+    munmap(pShm->pBase,pShm->nLength);
+  close(pShm->fd);
+  pthread_mutex_destroy(&pShm->lock);
+  free(pShm);
+}
+
+/**
+ * Remove the name of a segment.  Processes that have it mapped
+ * may go on using it.
+ *
+ * @param pName (IN) name of the segment
+ *
+ * @return TRUE if the name was removed
+ */
+BOOL profile_shm_unlink(
+  const char *pName)
+{
+  return ((pName && (shm_unlink(pName) == 0)) ? TRUE : FALSE);
+}
+
+/**
+ * File descriptor of a segment, to pass to another process.
+ *
+ * @param pShm (IN) segment
+ *
+ * @return file descriptor
+ */
+int profile_shm_fd(
+  const PROFILE_SHM *pShm)
+{
+  return (pShm ? pShm->fd : -1);
+}
+
+/**
+ * Number of snapshots published to a segment.
+ *
+ * @param pShm (IN) segment
+ *
+ * @return generation, which changes with each snapshot
+ */
+unsigned long profile_shm_generation(
+  PROFILE_SHM *pShm)
+{
+  struct shm_header *pHeader = NULL;
+  uint64_t sequence = 0;
+
+  if (!pShm)
+    return (0);
+  pthread_mutex_lock(&pShm->lock);
+  pHeader = (struct shm_header *)pShm->pBase;
+  sequence = __atomic_load_n(&pHeader->sequence,__ATOMIC_ACQUIRE);
+  pthread_mutex_unlock(&pShm->lock);
+
+  return ((unsigned long)(sequence / 2));
+}
+
+/**
+ * Copy a string into the strings of a snapshot
+ *
+ * @param pImage - snapshot
+ * @param pOffset - offset of the next free byte, moved forward
+ * @param pString - string to copy
+ * @param pLength - receives the length of the string
+ *
+ * @return offset of the copy
+ */
+static uint32_t shm_add_string(
+  unsigned char *pImage,
+  size_t *pOffset,
+  const char *pString,
+  uint32_t *pLength)
+{
+  size_t offset = *pOffset;
+  size_t len = strlen(pString);
+
+  memcpy(pImage + offset,pString,len + 1);
+  *pOffset += len + 1;
+  *pLength = (uint32_t)len;
+
+  return ((uint32_t)offset);
+}
+
+/**
+ * Lay a document out as a snapshot, in private memory.
+ *
+ * @param pDoc - document
+ * @param pnLength - receives the size of the snapshot
+ *
+ * @return snapshot that the caller frees, or NULL if there is not
+ *  enough memory or it would be too large
+ */
+static unsigned char *shm_build(
+  const PROFILE_DOC *pDoc,
+  size_t *pnLength)
+{
+  struct shm_header *pHeader = NULL;
+  struct shm_section *pSections = NULL;
+  struct shm_entry *pEntries = NULL;
+  uint32_t *pBuckets = NULL;
+  unsigned char *pImage = NULL;
+  PROFILE_SECTION *pSection = NULL;
+  PROFILE_ENTRY *pEntry = NULL;
+  const char *pValue = NULL;
+  size_t sections = 0;
+  size_t entries = 0;
+  size_t strings = 0;
+  size_t buckets = SHM_MIN_BUCKETS;
+  size_t length = 0;
+  size_t offset = 0;
+  size_t bucket = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  for (pSection = profile_doc_first(pDoc); pSection;
+    pSection = profile_section_next(pSection))
+  {
+    sections++;
+    strings += strlen(profile_section_name(pSection)) + 1;
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry))
+    {
+      entries++;
+      strings += strlen(profile_entry_key(pEntry)) + 1;
+      pValue = profile_entry_value(pEntry);
+      if (pValue)
+        strings += strlen(pValue) + 1;
+    }
+  }
+  while ((buckets < sections) || (buckets < entries))
+    buckets *= 2;
+  offset = sizeof(struct shm_header) +
+    sections * sizeof(struct shm_section) +
+    entries * sizeof(struct shm_entry) +
+    2 * buckets * sizeof(uint32_t);
+  length = offset + strings;
+  if (length > UINT32_MAX)
+    return (NULL);
+  pImage = calloc(1,length);
+  if (!pImage)
+    return (NULL);
+  pHeader = (struct shm_header *)pImage;
+  pHeader->used = (uint32_t)length;
+  pHeader->sections = (uint32_t)sections;
+  pHeader->entries = (uint32_t)entries;
+  pHeader->buckets = (uint32_t)buckets;
+  pHeader->section_table = sizeof(struct shm_header);
+  pHeader->entry_table = pHeader->section_table +
+    (uint32_t)(sections * sizeof(struct shm_section));
+  pHeader->bucket_table = pHeader->entry_table +
+    (uint32_t)(entries * sizeof(struct shm_entry));
+  pSections = (struct shm_section *)(pImage + pHeader->section_table);
+  pEntries = (struct shm_entry *)(pImage + pHeader->entry_table);
+  pBuckets = (uint32_t *)(pImage + pHeader->bucket_table);
+  for (pSection = profile_doc_first(pDoc); pSection;
+    pSection = profile_section_next(pSection), i++)
+  {
+    pSections[i].name = shm_add_string(pImage,&offset,
+      profile_section_name(pSection),&pSections[i].name_length);
+    pSections[i].hash = profile_doc_hash(profile_section_name(pSection),
+      NULL);
+    pSections[i].first = (uint32_t)j;
+    bucket = pSections[i].hash & (buckets - 1);
+    pSections[i].next = pBuckets[bucket];
+    pBuckets[bucket] = (uint32_t)(i + 1);
+    for (pEntry = profile_section_first(pSection); pEntry;
+      pEntry = profile_entry_next(pEntry), j++)
+    {
+      pEntries[j].key = shm_add_string(pImage,&offset,
+        profile_entry_key(pEntry),&pEntries[j].key_length);
+      pValue = profile_entry_value(pEntry);
+      if (pValue)
+        pEntries[j].value = shm_add_string(pImage,&offset,pValue,
+          &pEntries[j].value_length);
+      pEntries[j].hash = profile_doc_hash(profile_section_name(pSection),
+        profile_entry_key(pEntry));
+      bucket = buckets + (pEntries[j].hash & (buckets - 1));
+      pEntries[j].next = pBuckets[bucket];
+      pBuckets[bucket] = (uint32_t)(j + 1);
+    }
+    pSections[i].count = (uint32_t)j - pSections[i].first;
+  }
+  *pnLength = length;
+
+  return (pImage);
+}
+
+/**
+ * Make a segment large enough for a snapshot.  The publisher's
+ * lock is held.
+ *
+ * @param pShm - segment
+ * @param nLength - size of the snapshot
+ *
+ * @return TRUE if the snapshot fits
+ */
+static BOOL shm_grow(
+  PROFILE_SHM *pShm,
+  size_t nLength)
+{
+  struct shm_header *pHeader = NULL;
+  size_t length = pShm->nLength;
+
+  if (nLength <= length)
+    return (TRUE);
+  while (length < nLength)
+    length *= 2;
+  if ((ftruncate(pShm->fd,(off_t)length) != 0) || !shm_map(pShm,length))
+    return (FALSE);
+  pHeader = (struct shm_header *)pShm->pBase;
+  __atomic_store_n(&pHeader->length,(uint64_t)length,__ATOMIC_RELEASE);
+
+  return (TRUE);
+}
+
+/**
+ * Publish a document as the next snapshot of a segment.
+ *
+ * @param pShm (IN) segment from profile_shm_create()
+ * @param pDoc (IN) document, or NULL for an empty document
+ *
+ * @return TRUE if the snapshot was published
+ */
+BOOL profile_shm_publish(
+  PROFILE_SHM *pShm,
+  const PROFILE_DOC *pDoc)
+{
+  struct shm_header *pHeader = NULL;
+  unsigned char *pImage = NULL;
+  size_t length = 0;
+  size_t start = offsetof(struct shm_header,used);
+  uint64_t sequence = 0;
+  BOOL status = FALSE;
+
+  if (!pShm || !pShm->writable)
+    return (FALSE);
+  pImage = shm_build(pDoc,&length);
+  if (!pImage)
+    return (FALSE);
+  pthread_mutex_lock(&pShm->lock);
+  if (shm_grow(pShm,length))
+  {
+    pHeader = (struct shm_header *)pShm->pBase;
+    sequence = __atomic_load_n(&pHeader->sequence,__ATOMIC_RELAXED);
+    __atomic_store_n(&pHeader->sequence,sequence + 1,__ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(pShm->pBase + start,pImage + start,length - start);
+    __atomic_store_n(&pHeader->sequence,sequence + 2,__ATOMIC_RELEASE);
+    status = TRUE;
+  }
+  pthread_mutex_unlock(&pShm->lock);
+  free(pImage);
+
+  return (status);
+}
+
+/**
+ * Publish an INI file as the next snapshot of a segment.
+ *
+ * @param pShm (IN) segment from profile_shm_create()
+ * @param pFileName (IN) name of the INI file
+ *
+ * @return TRUE if the snapshot was published
+ */
+BOOL profile_shm_publish_file(
+  PROFILE_SHM *pShm,
+  const char *pFileName)
+{
+  PROFILE_DOC *pDoc = NULL;
+  BOOL status = FALSE;
+
+  pDoc = profile_doc_load(pFileName);
+  if (pDoc)
+  {
+    status = profile_shm_publish(pShm,pDoc);
+    profile_doc_free(pDoc);
+  }
+
+  return (status);
+}
+
+/**
+ * Find a string in a snapshot
+ *
+ * @param pShm - segment
+ * @param pHeader - copy of the header of the snapshot
+ * @param offset - offset of the string
+ * @param length - length of the string
+ *
+ * @return string, or NULL if it is not inside the snapshot
+ */
+static const char *shm_string(
+  const PROFILE_SHM *pShm,
+  const struct shm_header *pHeader,
+  uint32_t offset,
+  uint32_t length)
+{
+  if ((offset == SHM_NONE) ||
+    ((uint64_t)offset + length >= pHeader->used))
+    return (NULL);
+
+  return ((const char *)pShm->pBase + offset);
+}
+
+/**
+ * Find a section in a snapshot by name, independent of case
+ *
+ * @param pShm - segment
+ * @param pHeader - copy of the header of the snapshot
+ * @param pAppName - section name
+ * @param pSection - receives a copy of the section
+ * @param pValid - cleared if the snapshot does not hold together
+ *
+ * @return TRUE if the section was found
+ */
+static BOOL shm_find_section(
+  const PROFILE_SHM *pShm,
+  const struct shm_header *pHeader,
+  const char *pAppName,
+  struct shm_section *pSection,
+  BOOL *pValid)
+{
+  const struct shm_section *pSections = (const struct shm_section *)
+    (pShm->pBase + pHeader->section_table);
+  const uint32_t *pBuckets = (const uint32_t *)
+    (pShm->pBase + pHeader->bucket_table);
+  size_t len = strlen(pAppName);
+  unsigned hash = profile_doc_hash(pAppName,NULL);
+  const char *pName = NULL;
+  uint32_t index = pBuckets[hash & (pHeader->buckets - 1)];
+  uint32_t steps = 0;
+
+  for (; index; index = pSection->next)
+  {
+    if ((index > pHeader->sections) || (steps++ > pHeader->sections))
+    {
+      *pValid = FALSE;
+      break;
+    }
+    *pSection = pSections[index - 1];
+    if ((pSection->hash != hash) || (pSection->name_length != len))
+      continue;
+    pName = shm_string(pShm,pHeader,pSection->name,pSection->name_length);
+    if (!pName)
+    {
+      *pValid = FALSE;
+      break;
+    }
+    if (strfold_equal(pName,pAppName,len))
+      return (TRUE);
+  }
+
+  return (FALSE);
+}
+
+/**
+ * Find an entry in a snapshot by section and key name,
+ * independent of case
+ *
+ * @param pShm - segment
+ * @param pHeader - copy of the header of the snapshot
+ * @param pSection - section that holds the entry
+ * @param pAppName - section name
+ * @param pKeyName - key name
+ * @param pEntry - receives a copy of the entry
+ * @param pValid - cleared if the snapshot does not hold together
+ *
+ * @return TRUE if the entry was found
+ */
+static BOOL shm_find_entry(
+  const PROFILE_SHM *pShm,
+  const struct shm_header *pHeader,
+  const struct shm_section *pSection,
+  const char *pAppName,
+  const char *pKeyName,
+  struct shm_entry *pEntry,
+  BOOL *pValid)
+{
+  const struct shm_entry *pEntries = (const struct shm_entry *)
+    (pShm->pBase + pHeader->entry_table);
+  const uint32_t *pBuckets = (const uint32_t *)
+    (pShm->pBase + pHeader->bucket_table) + pHeader->buckets;
+  size_t len = strlen(pKeyName);
+  unsigned hash = profile_doc_hash(pAppName,pKeyName);
+  const char *pName = NULL;
+  uint32_t index = pBuckets[hash & (pHeader->buckets - 1)];
+  uint32_t steps = 0;
+
+  for (; index; index = pEntry->next)
+  {
+    if ((index > pHeader->entries) || (steps++ > pHeader->entries))
+    {
+      *pValid = FALSE;
+      break;
+    }
+    /* the key may be in another section with the same hash */
+    if ((index - 1 < pSection->first) ||
+      (index - 1 >= pSection->first + pSection->count))
+    {
+      *pEntry = pEntries[index - 1];
+      continue;
+    }
+    *pEntry = pEntries[index - 1];
+    if ((pEntry->hash != hash) || (pEntry->key_length != len))
+      continue;
+    pName = shm_string(pShm,pHeader,pEntry->key,pEntry->key_length);
+    if (!pName)
+    {
+      *pValid = FALSE;
+      break;
+    }
+    if (strfold_equal(pName,pKeyName,len))
+      return (TRUE);
+  }
+
+  return (FALSE);
+}
+
+/**
+ * Append a name to a list of null-terminated names, truncating
+ * the same way GetPrivateProfileString does.
+ *
+ * @param ppReturnedString - next free character, moved forward
+ * @param pCount - number of characters used so far, updated
+ * @param nSize - size of the buffer
+ * @param pName - name to append
+ * @param len - number of characters in the name
+ *
+ * @return FALSE if the list is full
+ */
+static BOOL shm_list_append(
+  char **ppReturnedString,
+  size_t *pCount,
+  size_t nSize,
+  const char *pName,
+  size_t len)
+{
+  BOOL status = TRUE;
+
+  if ((len + *pCount + 2) >= nSize)
+  {
+    /* copy as much as we can, then truncate */
+    len = nSize - 2 - *pCount;
+    status = FALSE;
+  }
+  memcpy(*ppReturnedString,pName,len);
+  (*ppReturnedString)[len] = '\0';
+  len++; /* add null */
+  *ppReturnedString += len;
+  *pCount += len;
+
+  return (status);
+}
+
+/**
+ * Look a value up in one consistent copy of the header, the way
+ * profile_doc_get() does in a document.
+ *
+ * @param pShm - segment
+ * @param pHeader - copy of the header of the snapshot
+ * @param pAppName - section name, or NULL for all section names
+ * @param pKeyName - key name, or NULL for all key names
+ * @param pReturnedString - buffer that receives the string
+ * @param nSize - size of the buffer, at least 2
+ * @param pUseDefault - set if the default is the answer
+ *
+ * @return number of characters copied to the buffer, or (size_t)-1 if
+ *  the snapshot does not hold together
+ */
+static size_t shm_lookup(
+  const PROFILE_SHM *pShm,
+  const struct shm_header *pHeader,
+  const char *pAppName,
+  const char *pKeyName,
+  char *pReturnedString,
+  size_t nSize,
+  BOOL *pUseDefault)
+{
+  const struct shm_section *pSections = NULL;
+  const struct shm_entry *pEntries = NULL;
+  struct shm_section section;
+  struct shm_entry entry;
+  const char *pName = NULL;
+  char *pList = pReturnedString;
+  size_t count = 0;
+  size_t len = 0;
+  uint32_t i = 0;
+  BOOL valid = TRUE;
+
+  *pUseDefault = FALSE;
+  pReturnedString[0] = '\0';
+  if ((pHeader->used == 0) || (pHeader->sections == 0))
+  {
+    /* nothing published, or an empty document */
+    *pUseDefault = (pAppName != NULL);
+    return (0);
+  }
+  if ((pHeader->used > pShm->nLength) || (pHeader->buckets == 0) ||
+    (pHeader->buckets & (pHeader->buckets - 1)) ||
+    ((uint64_t)pHeader->section_table +
+    (uint64_t)pHeader->sections * sizeof(struct shm_section) >
+    pHeader->used) ||
+    ((uint64_t)pHeader->entry_table +
+    (uint64_t)pHeader->entries * sizeof(struct shm_entry) >
+    pHeader->used) ||
+    ((uint64_t)pHeader->bucket_table +
+    2 * (uint64_t)pHeader->buckets * sizeof(uint32_t) > pHeader->used))
+    return ((size_t)-1);
+  pSections = (const struct shm_section *)
+    (pShm->pBase + pHeader->section_table);
+  pEntries = (const struct shm_entry *)
+    (pShm->pBase + pHeader->entry_table);
+  if (!pAppName)
+  {
+    for (i = 0; valid && (i < pHeader->sections); i++)
+    {
+      section = pSections[i];
+      pName = shm_string(pShm,pHeader,section.name,section.name_length);
+      if (!pName)
+        valid = FALSE;
+      else if (!shm_list_append(&pList,&count,nSize,pName,
+        section.name_length))
+        break;
+    }
+  }
+  else if (!shm_find_section(pShm,pHeader,pAppName,&section,&valid))
+    *pUseDefault = TRUE;
+  else if (((uint64_t)section.first + section.count) > pHeader->entries)
+    valid = FALSE;
+  else if (pKeyName)
+  {
+    if (!shm_find_entry(pShm,pHeader,&section,pAppName,pKeyName,&entry,
+      &valid) || (entry.value == SHM_NONE))
+      *pUseDefault = TRUE;
+    else
+    {
+      pName = shm_string(pShm,pHeader,entry.value,entry.value_length);
+      if (!pName)
+        valid = FALSE;
+      else
+      {
+        len = entry.value_length;
+        if (len >= nSize)
+          len = nSize - 1; /* less the null */
+        memcpy(pReturnedString,pName,len);
+        pReturnedString[len] = '\0';
+        count = len;
+      }
+    }
+  }
+  else if (section.count == 0)
+    *pUseDefault = TRUE;
+  else
+  {
+    for (i = section.first; valid && (i < section.first + section.count);
+      i++)
+    {
+      entry = pEntries[i];
+      pName = shm_string(pShm,pHeader,entry.key,entry.key_length);
+      if (!pName)
+        valid = FALSE;
+      else if (!shm_list_append(&pList,&count,nSize,pName,
+        entry.key_length))
+        break;
+    }
+  }
+  if (!valid)
+    return ((size_t)-1);
+  if ((!pKeyName || !pAppName) && !*pUseDefault)
+  {
+    /* count doesn't include last 2 nulls */
+    if (count)
+      count--;
+    pList[0] = '\0';
+  }
+
+  return (count);
+}
+
+/**
+ * Copy a value out of the newest snapshot of a segment, with the same
+ * results as GetPrivateProfileString would give for the file it was
+ * published from.
+ *
+ * @param pShm (IN) segment
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ *
+ * @return number of characters copied to the buffer, not including
+ *  the terminating null character.
+ */
+size_t profile_shm_get(
+  PROFILE_SHM *pShm,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  struct shm_header *pHeader = NULL;
+  struct shm_header header;
+  struct stat file_stat;
+  uint64_t sequence = 0;
+  unsigned retries = 0;
+  size_t count = 0;
+  BOOL use_default = FALSE;
+
+  if (!pShm || !pReturnedString || (nSize < 2))
+    return (profile_doc_get(NULL,pAppName,pKeyName,pDefault,
+      pReturnedString,nSize));
+  pthread_mutex_lock(&pShm->lock);
+  for (;;)
+  {
+    pHeader = (struct shm_header *)pShm->pBase;
+    if ((__atomic_load_n(&pHeader->length,__ATOMIC_ACQUIRE) >
+      pShm->nLength) && (fstat(pShm->fd,&file_stat) == 0))
+    {
+      /* the publisher made the segment larger */
+      if (shm_map(pShm,(size_t)file_stat.st_size))
+        continue;
+    }
+    sequence = __atomic_load_n(&pHeader->sequence,__ATOMIC_ACQUIRE);
+    if ((sequence & 1) == 0)
+    {
+      memcpy(&header,pHeader,sizeof(header));
+      count = shm_lookup(pShm,&header,pAppName,pKeyName,pReturnedString,
+        nSize,&use_default);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&pHeader->sequence,__ATOMIC_RELAXED) == sequence)
+        break;
+    }
+    if (++retries > PROFILE_SHM_RETRIES)
+    {
+      /* a publisher stopped while copying: an empty document */
+      count = (size_t)-1;
+      break;
+    }
+    sched_yield();
+  }
+  pthread_mutex_unlock(&pShm->lock);
+  if ((count == (size_t)-1) || use_default)
+    count = profile_doc_get(NULL,pAppName,pKeyName,pDefault,
+      pReturnedString,nSize);
+
+  return (count);
+}
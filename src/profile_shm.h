@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Parsed INI files published in shared memory
+ */
+#ifndef PROFILE_SHM_H
+#define PROFILE_SHM_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_doc.h"
+
+/* times a reader tries again while a snapshot is being copied */
+#ifndef PROFILE_SHM_RETRIES
+#define PROFILE_SHM_RETRIES 100000
+#endif
+
+typedef struct profile_shm PROFILE_SHM;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_SHM *profile_shm_create(
+    const char *pName,
+    size_t nSize);
+  PROFILE_SHM *profile_shm_attach(const char *pName);
+  PROFILE_SHM *profile_shm_attach_fd(int fd);
+  void profile_shm_close(PROFILE_SHM *pShm);
+  BOOL profile_shm_unlink(const char *pName);
+  int profile_shm_fd(const PROFILE_SHM *pShm);
+  unsigned long profile_shm_generation(PROFILE_SHM *pShm);
+
+  BOOL profile_shm_publish(
+    PROFILE_SHM *pShm,
+    const PROFILE_DOC *pDoc);
+  BOOL profile_shm_publish_file(
+    PROFILE_SHM *pShm,
+    const char *pFileName);
+
+  size_t profile_shm_get(
+    PROFILE_SHM *pShm,
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize); 	// size of destination buffer
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_SHM_H */
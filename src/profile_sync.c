@@ -0,0 +1,343 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief How far a write is pushed to the disk before it returns
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * Every function that writes an INI file calls profile_sync_fd() on the
+ * new contents before it replaces the old file, and profile_sync_dir()
+ * after a rename or a new file changed the directory.  What they do
+ * depends on the durability level, which is set for the whole program
+ * with profile_sync_set_level() and may be overridden per call:
+ *
+ *  - NONE returns at once, and the data reaches the disk whenever the
+ *    kernel writes it back.  This is the default and the old behavior.
+ *  - DATA calls fdatasync on the file, which survives a power loss
+ *    but may lose a rename or a new directory entry.
+ *  - FULL calls fsync on the file and on its directory.
+ *  - GROUP gives FULL durability, but a writer that finds a flush
+ *    already running waits for the next one, and the writer that leads
+ *    it flushes every file that queued behind it: each file once, however
+ *    many writers asked.  On Linux the leader starts the write back of
+ *    every file before it waits on the first, so their I/O goes to the
+ *    disk together.  Only the files are flushed, never the rest of the
+ *    file system, so a lone writer costs the same as FULL.  Directories
+ *    get a plain fsync.
+ */
+
+/* sync_file_range is a GNU extension */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+  #define _GNU_SOURCE
+#endif
+
+/* includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "profile.h"
+#include "profile_sync.h"
+
+/* a writer waiting for a group flush */
+struct sync_waiter
+{
+  int fd; /* file to flush */
+  dev_t dev; /* file system it is on */
+  ino_t ino; /* the file on it */
+  BOOL flushed; /* TRUE once the leader flushed it */
+  BOOL status; /* TRUE if that flush worked */
+  BOOL done; /* set under the lock once the group is finished */
+  struct sync_waiter *pNext;
+};
+
+static pthread_mutex_t Sync_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Sync_Done = PTHREAD_COND_INITIALIZER;
+static int Sync_Level = PROFILE_SYNC_NONE;
+static unsigned long Sync_Count = 0; /* number of flushes made */
+static BOOL Sync_Running = FALSE; /* TRUE while a group flush runs */
+static struct sync_waiter *Sync_Queue = NULL; /* next group */
+
+/**
+ * Set the durability level of every write that does not ask for its own
+ *
+ * @param level (IN) PROFILE_SYNC_NONE, DATA, FULL, or GROUP
+ */
+void profile_sync_set_level(
+  int level)
+{
+  if ((level < PROFILE_SYNC_NONE) || (level > PROFILE_SYNC_GROUP))
+    return;
+  pthread_mutex_lock(&Sync_Lock);
+  Sync_Level = level;
+  pthread_mutex_unlock(&Sync_Lock);
+}
+
+/**
+ * The durability level of the program
+ *
+ * @return PROFILE_SYNC_NONE, DATA, FULL, or GROUP
+ */
+int profile_sync_level(void)
+{
+  int level;
+
+  pthread_mutex_lock(&Sync_Lock);
+  level = Sync_Level;
+  pthread_mutex_unlock(&Sync_Lock);
+
+  return (level);
+}
+
+/**
+ * Number of flush system calls made so far, which shows how much
+ * a group flush saved
+ *
+ * @return number of calls
+ */
+unsigned long profile_sync_count(void)
+{
+  unsigned long count;
+
+  pthread_mutex_lock(&Sync_Lock);
+  count = Sync_Count;
+  pthread_mutex_unlock(&Sync_Lock);
+
+  return (count);
+}
+
+/**
+ * Count one flush system call
+ */
+static void sync_counted(void)
+{
+  pthread_mutex_lock(&Sync_Lock);
+  Sync_Count++;
+  pthread_mutex_unlock(&Sync_Lock);
+}
+
+/**
+ * Flush one group of waiters.  The caller holds no lock, and is the
+ * only thread flushing.  The waiters stay blocked until their done
+ * flag is set under the lock, so the list is safe to walk.
+ *
+ * @param pGroup - waiters to flush
+ *
+ * @return number of flush system calls made
+ */
+static unsigned long sync_group(
+  struct sync_waiter *pGroup)
+{
+  struct sync_waiter *pWaiter;
+  struct sync_waiter *pOther;
+  unsigned long count = 0;
+  BOOL status;
+
+#if defined(__linux__)
+  /* start the write back of every file, so the I/O goes out together */
+  for (pWaiter = pGroup; pWaiter; pWaiter = pWaiter->pNext)
+    (void)sync_file_range(pWaiter->fd,0,0,SYNC_FILE_RANGE_WRITE);
+#endif
+  for (pWaiter = pGroup; pWaiter; pWaiter = pWaiter->pNext)
+  {
+    if (pWaiter->flushed)
+      continue;
+    /* one flush of a file covers every writer of it */
+    status = (fsync(pWaiter->fd) == 0);
+    count++;
+    for (pOther = pWaiter; pOther; pOther = pOther->pNext)
+    {
+      if (!pOther->flushed && (pOther->dev == pWaiter->dev) &&
+        (pOther->ino == pWaiter->ino))
+      {
+        pOther->status = status;
+        pOther->flushed = TRUE;
+      }
+    }
+  }
+
+  return (count);
+}
+
+/**
+ * Wait until a group flush that started after this call covers a file
+ *
+ * @param fd - file descriptor
+ *
+ * @return TRUE if the file was flushed
+ */
+static BOOL sync_group_wait(
+  int fd)
+{
+  struct sync_waiter waiter;
+  struct sync_waiter *pGroup;
+  struct stat file_stat;
+  unsigned long count;
+
+  if (fstat(fd,&file_stat) != 0)
+    return (FALSE);
+  memset(&waiter,0,sizeof(waiter));
+  waiter.fd = fd;
+  waiter.dev = file_stat.st_dev;
+  waiter.ino = file_stat.st_ino;
+  pthread_mutex_lock(&Sync_Lock);
+  waiter.pNext = Sync_Queue;
+  Sync_Queue = &waiter;
+  while (!waiter.done)
+  {
+    if (Sync_Running)
+    {
+      pthread_cond_wait(&Sync_Done,&Sync_Lock);
+      continue;
+    }
+    /* lead the next group, which includes this writer */
+    pGroup = Sync_Queue;
+    Sync_Queue = NULL;
+    Sync_Running = TRUE;
+    pthread_mutex_unlock(&Sync_Lock);
+    count = sync_group(pGroup);
+    pthread_mutex_lock(&Sync_Lock);
+    for (; pGroup; pGroup = pGroup->pNext)
+      pGroup->done = TRUE;
+    Sync_Count += count;
+    Sync_Running = FALSE;
+    pthread_cond_broadcast(&Sync_Done);
+  }
+  pthread_mutex_unlock(&Sync_Lock);
+
+  return (waiter.status);
+}
+
+/**
+ * Push the written contents of a file to the disk
+ *
+ * @param fd (IN) file descriptor of the written file
+ * @param level (IN) durability level, or PROFILE_SYNC_DEFAULT
+ *
+ * @return TRUE if the level was met
+ */
+BOOL profile_sync_fd(
+  int fd,
+  int level)
+{
+  int status = 0;
+
+  if (level == PROFILE_SYNC_DEFAULT)
+    level = profile_sync_level();
+  if (fd < 0)
+    return (FALSE);
+  switch (level)
+  {
+    case PROFILE_SYNC_NONE:
+      return (TRUE);
+    case PROFILE_SYNC_DATA:
+#if defined(_POSIX_SYNCHRONIZED_IO) && (_POSIX_SYNCHRONIZED_IO > 0)
+      status = fdatasync(fd);
+#else
+      status = fsync(fd);
+#endif
+      break;
+    case PROFILE_SYNC_GROUP:
+      return (sync_group_wait(fd));
+    default:
+      status = fsync(fd);
+      break;
+  }
+  sync_counted();
+
+  return (status == 0);
+}
+
+/**
+ * Push the written contents of a stream to the disk
+ *
+ * @param pFile (IN) stream of the written file
+ * @param level (IN) durability level, or PROFILE_SYNC_DEFAULT
+ *
+ * @return TRUE if the level was met
+ */
+BOOL profile_sync_stream(
+  FILE *pFile,
+  int level)
+{
+  if (!pFile || (fflush(pFile) != 0))
+    return (FALSE);
+
+  return (profile_sync_fd(fileno(pFile),level));
+}
+
+/**
+ * Push the directory entry of a file that was made or renamed to the
+ * disk.  Only the FULL and GROUP levels do this.
+ *
+ * @param pFileName (IN) file that was made or renamed
+ * @param level (IN) durability level, or PROFILE_SYNC_DEFAULT
+ *
+ * @return TRUE if the level was met
+ */
+BOOL profile_sync_dir(
+  const char *pFileName,
+  int level)
+{
+  const char *pSlash;
+  char *pDirName;
+  size_t len;
+  int fd;
+  BOOL status;
+
+  if (level == PROFILE_SYNC_DEFAULT)
+    level = profile_sync_level();
+  if ((level != PROFILE_SYNC_FULL) && (level != PROFILE_SYNC_GROUP))
+    return (TRUE);
+  if (!pFileName)
+    return (FALSE);
+  pSlash = strrchr(pFileName,'/');
+  if (!pSlash)
+    fd = open(".",O_RDONLY);
+  else
+  {
+    /* "/name" is in the root directory */
+    len = (pSlash == pFileName) ? 1 : (size_t)(pSlash - pFileName);
+    pDirName = malloc(len + 1);
+    if (!pDirName)
+      return (FALSE);
+    memcpy(pDirName,pFileName,len);
+    pDirName[len] = '\0';
+    fd = open(pDirName,O_RDONLY);
+    free(pDirName);
+  }
+  if (fd < 0)
+    return (FALSE);
+  /* a plain fsync, even for GROUP: the directory is not grouped */
+  status = profile_sync_fd(fd,PROFILE_SYNC_FULL);
+  close(fd);
+
+  return (status);
+}
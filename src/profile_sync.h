@@ -0,0 +1,41 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief How far a write is pushed to the disk before it returns
+ */
+#ifndef PROFILE_SYNC_H
+#define PROFILE_SYNC_H
+
+#include <stdio.h>
+#include "profile.h"
+
+/* durability levels */
+#define PROFILE_SYNC_DEFAULT (-1) /* use the level of the program */
+#define PROFILE_SYNC_NONE 0 /* leave the data in the page cache */
+#define PROFILE_SYNC_DATA 1 /* fdatasync the file */
+#define PROFILE_SYNC_FULL 2 /* fsync the file and its directory */
+#define PROFILE_SYNC_GROUP 3 /* like FULL, but writers that sync at
+  the same time are flushed together by one of them */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  void profile_sync_set_level(int level);
+  int profile_sync_level(void);
+  unsigned long profile_sync_count(void);
+
+  BOOL profile_sync_fd(
+    int fd,	// file descriptor of the written file
+    int level); 	// durability level, or PROFILE_SYNC_DEFAULT
+  BOOL profile_sync_stream(
+    FILE *pFile,	// stream of the written file
+    int level); 	// durability level, or PROFILE_SYNC_DEFAULT
+  BOOL profile_sync_dir(
+    const char *pFileName,	// file that was made or renamed
+    int level); 	// durability level, or PROFILE_SYNC_DEFAULT
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_SYNC_H */
@@ -0,0 +1,729 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Byte-for-byte copy of an INI file that records its changes
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * WritePrivateProfileString trims every line it copies and writes the
+ * whole file again.  A text keeps the bytes of the file as they are,
+ * and profile_text_set() changes only the bytes of the value, key line,
+ * or section it is about; comments, blank lines, spacing, and the
+ * spelling of names elsewhere are left alone.
+ *
+ * Each change is recorded as a range of the text.  A change that keeps
+ * the length of the text leaves the rest of the file where it is, so
+ * profile_text_commit() writes only the changed ranges, in place, with
+ * pwrite.  A change that grows or shrinks the text moves everything
+ * after it, and the commit writes from there to the end.  Nothing
+ * before the first change is ever written.
+ *
+ * The file is changed in place, so a crash during the commit can leave
+ * it partly written.  The commit refuses to write if the file changed
+ * since it was read.
+ */
+
+/* includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_sync.h"
+#include "profile_text.h"
+#include "strfold.h"
+
+/* a changed range of the text */
+struct text_span
+{
+  size_t start;
+  size_t end; /* one past the last changed character */
+};
+
+/* the text of an INI file, and what changed */
+struct profile_text
+{
+  char *pFileName; /* file the text was read from, or NULL */
+  PROFILE_IO_STAT file_stat; /* the file when it was last read or written */
+  char *pText; /* the text, not null-terminated */
+  size_t nLength; /* number of characters in pText */
+  size_t nSize; /* size of pText */
+  struct text_span *pSpan; /* changed ranges before tail, in order */
+  size_t nSpans;
+  size_t nSpanSize;
+  BOOL shifted; /* TRUE if everything from tail on moved or changed */
+  size_t tail;
+  int durability; /* PROFILE_SYNC level of the commit */
+};
+
+/* where a section and a key are in the text */
+struct text_find
+{
+  BOOL section; /* TRUE if the section was found */
+  size_t header; /* start of the section header line */
+  size_t end; /* start of the line after the section */
+  size_t insert; /* end of the last line of the section that is not
+    blank, where a new key goes */
+  BOOL key; /* TRUE if the key was found */
+  size_t line; /* start of the key line */
+  size_t line_end; /* start of the line after the key line */
+  BOOL has_value; /* TRUE if the key line has an '=' */
+  size_t value; /* start of the value, trimmed */
+  size_t value_end; /* end of the value, trimmed */
+};
+
+/**
+ * Make a text from a copy of some INI text
+ *
+ * @param pBuffer - INI text, which need not be null-terminated
+ * @param nLength - number of characters in pBuffer
+ *
+ * @return new text, or NULL if out of memory
+ */
+static PROFILE_TEXT *text_create(
+  const char *pBuffer,
+  size_t nLength)
+{
+  PROFILE_TEXT *pText;
+
+  pText = calloc(1,sizeof(PROFILE_TEXT));
+  if (!pText)
+    return (NULL);
+  /* one extra byte so an empty text is not NULL */
+  pText->nSize = nLength + 1;
+  pText->pText = malloc(pText->nSize);
+  if (!pText->pText)
+  {
+    free(pText);
+    return (NULL);
+  }
+  if (nLength)
+    memcpy(pText->pText,pBuffer,nLength);
+  pText->nLength = nLength;
+  pText->durability = PROFILE_SYNC_DEFAULT;
+
+  return (pText);
+}
+
+/**
+ * Make a text from INI text held in memory.  It can be changed
+ * and read, but not committed.
+ *
+ * @param pBuffer (IN) INI text, which need not be null-terminated
+ * @param nLength (IN) number of characters in pBuffer
+ *
+ * @return new text, or NULL if out of memory
+ */
+PROFILE_TEXT *profile_text_load_buffer(
+  const char *pBuffer,
+  size_t nLength)
+{
+  if (!pBuffer && nLength)
+    return (NULL);
+
+  return (text_create(pBuffer,nLength));
+}
+
+/**
+ * Read an INI file into a text.  A file that does not exist gives an
+ * empty text, and the first commit makes the file.
+ *
+ * @param pFileName (IN) initialization filename
+ *
+ * @return new text, or NULL if the file cannot be read
+ */
+PROFILE_TEXT *profile_text_load(
+  const char *pFileName)
+{
+  PROFILE_IO_STAT file_stat;
+  PROFILE_TEXT *pText = NULL;
+  char *pBuffer = NULL;
+  size_t len = 0;
+
+  if (!pFileName)
+    return (NULL);
+  /* stat first, so a change while reading is seen by the commit */
+  if (profile_io_stat(profile_io_posix(),pFileName,&file_stat))
+  {
+    pBuffer = profile_io_read(profile_io_posix(),pFileName,&len);
+    if (!pBuffer)
+      return (NULL);
+  }
+  pText = text_create(pBuffer,len);
+  free(pBuffer);
+  if (!pText)
+    return (NULL);
+  pText->file_stat = file_stat;
+  len = strlen(pFileName) + 1;
+  pText->pFileName = malloc(len);
+  if (!pText->pFileName)
+  {
+    profile_text_free(pText);
+    return (NULL);
+  }
+  memcpy(pText->pFileName,pFileName,len);
+
+  return (pText);
+}
+
+/**
+ * Release a text
+ *
+ * @param pText (IN) text, or NULL
+ */
+void profile_text_free(
+  PROFILE_TEXT *pText)
+{
+  if (!pText)
+    return;
+  free(pText->pSpan);
+  free(pText->pText);
+  free(pText->pFileName);
+  free(pText);
+}
+
+/**
+ * The current text
+ *
+ * @param pText (IN) text
+ * @param pnLength (OUT) receives the number of characters
+ *
+ * @return the characters, which are not null-terminated and are
+ *  valid until the next change
+ */
+const char *profile_text_data(
+  const PROFILE_TEXT *pText,
+  size_t *pnLength)
+{
+  if (!pText || !pnLength)
+    return (NULL);
+  *pnLength = pText->nLength;
+
+  return (pText->pText);
+}
+
+/**
+ * Check whether a text has changes that were not committed
+ *
+ * @param pText (IN) text
+ *
+ * @return TRUE if a commit would write something
+ */
+BOOL profile_text_dirty(
+  const PROFILE_TEXT *pText)
+{
+  return (pText && (pText->nSpans || pText->shifted));
+}
+
+/**
+ * Number of bytes the next commit will write
+ *
+ * @param pText (IN) text
+ *
+ * @return number of bytes
+ */
+size_t profile_text_dirty_bytes(
+  const PROFILE_TEXT *pText)
+{
+  size_t count = 0;
+  size_t i;
+
+  if (!pText)
+    return (count);
+  for (i = 0; i < pText->nSpans; i++)
+    count += pText->pSpan[i].end - pText->pSpan[i].start;
+  if (pText->shifted)
+    count += pText->nLength - pText->tail;
+
+  return (count);
+}
+
+/**
+ * Choose how far profile_text_commit() pushes the file to the disk
+ *
+ * @param pText (IN) text
+ * @param level (IN) PROFILE_SYNC level, or PROFILE_SYNC_DEFAULT for
+ *  the level of the program
+ */
+void profile_text_set_durability(
+  PROFILE_TEXT *pText,
+  int level)
+{
+  if (!pText || (level < PROFILE_SYNC_DEFAULT) ||
+    (level > PROFILE_SYNC_GROUP))
+    return;
+  pText->durability = level;
+}
+
+/**
+ * Record a change that kept the length of the text.  Ranges that
+ * touch are joined.
+ *
+ * @param pText - text
+ * @param start - first changed character
+ * @param end - one past the last changed character
+ *
+ * @return TRUE if recorded, FALSE if out of memory
+ */
+static BOOL text_mark(
+  PROFILE_TEXT *pText,
+  size_t start,
+  size_t end)
+{
+  struct text_span *pSpan;
+  size_t first;
+  size_t last;
+  size_t size;
+
+  if (pText->shifted && (end > pText->tail))
+    end = pText->tail;
+  if (start >= end)
+    return (TRUE);
+  /* the ranges that touch this one are first up to last */
+  for (first = 0; first < pText->nSpans; first++)
+  {
+    if (pText->pSpan[first].end >= start)
+      break;
+  }
+  for (last = first; last < pText->nSpans; last++)
+  {
+    if (pText->pSpan[last].start > end)
+      break;
+  }
+  if (first < last)
+  {
+    if (pText->pSpan[first].start < start)
+      start = pText->pSpan[first].start;
+    if (pText->pSpan[last - 1].end > end)
+      end = pText->pSpan[last - 1].end;
+    pText->pSpan[first].start = start;
+    pText->pSpan[first].end = end;
+    memmove(&pText->pSpan[first + 1],&pText->pSpan[last],
+      (pText->nSpans - last) * sizeof(struct text_span));
+    pText->nSpans -= last - first - 1;
+    return (TRUE);
+  }
+  if (pText->nSpans == pText->nSpanSize)
+  {
+    size = pText->nSpanSize ? pText->nSpanSize * 2 : 8;
+    pSpan = realloc(pText->pSpan,size * sizeof(struct text_span));
+    if (!pSpan)
+      return (FALSE);
+    pText->pSpan = pSpan;
+    pText->nSpanSize = size;
+  }
+  memmove(&pText->pSpan[first + 1],&pText->pSpan[first],
+    (pText->nSpans - first) * sizeof(struct text_span));
+  pText->pSpan[first].start = start;
+  pText->pSpan[first].end = end;
+  pText->nSpans++;
+
+  return (TRUE);
+}
+
+/**
+ * Replace a range of the text and record the change
+ *
+ * @param pText - text
+ * @param offset - first character to replace
+ * @param nRemove - number of characters to replace
+ * @param pInsert - characters that take their place
+ * @param nInsert - number of characters in pInsert
+ *
+ * @return TRUE if changed, FALSE if out of memory
+ */
+static BOOL text_splice(
+  PROFILE_TEXT *pText,
+  size_t offset,
+  size_t nRemove,
+  const char *pInsert,
+  size_t nInsert)
+{
+  char *pGrow;
+  size_t length;
+  size_t size;
+  size_t i;
+
+  length = pText->nLength - nRemove + nInsert;
+  if (length >= pText->nSize)
+  {
+    size = pText->nSize * 2;
+    if (size <= length)
+      size = length + 1;
+    pGrow = realloc(pText->pText,size);
+    if (!pGrow)
+      return (FALSE);
+    pText->pText = pGrow;
+    pText->nSize = size;
+  }
+  if (nInsert == nRemove)
+  {
+    /* nothing moves, so only the range changes */
+    if (!text_mark(pText,offset,offset + nInsert))
+      return (FALSE);
+  }
+  else
+  {
+    /* everything after the range moves */
+    if (!pText->shifted || (offset < pText->tail))
+      pText->tail = offset;
+    pText->shifted = TRUE;
+    for (i = 0; i < pText->nSpans; i++)
+    {
+      if (pText->pSpan[i].end > pText->tail)
+        pText->pSpan[i].end = pText->tail;
+      if (pText->pSpan[i].start >= pText->pSpan[i].end)
+        break;
+    }
+    pText->nSpans = i;
+  }
+  memmove(pText->pText + offset + nInsert,pText->pText + offset + nRemove,
+    pText->nLength - offset - nRemove);
+  if (nInsert)
+    memcpy(pText->pText + offset,pInsert,nInsert);
+  pText->nLength = length;
+
+  return (TRUE);
+}
+
+/**
+ * Find a section, and a key in it, the same way GetPrivateProfileString
+ * does: the first section and the first key with the name win.
+ *
+ * @param pText - text
+ * @param pAppName - section name
+ * @param pKeyName - key name, or NULL
+ * @param pFind - receives where they are
+ */
+static void text_find(
+  const PROFILE_TEXT *pText,
+  const char *pAppName,
+  const char *pKeyName,
+  struct text_find *pFind)
+{
+  const char *pBuffer = pText->pText;
+  size_t app_len = strlen(pAppName);
+  size_t key_len = pKeyName ? strlen(pKeyName) : 0;
+  size_t line = 0; /* start of line */
+  size_t next; /* start of the next line */
+  size_t begin; /* start of trimmed line */
+  size_t end; /* end of trimmed line */
+  const char *pEqual;
+  size_t key_end;
+
+  memset(pFind,0,sizeof(struct text_find));
+  for (; line < pText->nLength; line = next)
+  {
+    pEqual = memchr(pBuffer + line,'\n',pText->nLength - line);
+    next = pEqual ? (size_t)(pEqual - pBuffer) + 1 : pText->nLength;
+    begin = line;
+    end = pEqual ? (size_t)(pEqual - pBuffer) : next;
+    while ((begin < end) && isspace((unsigned char)pBuffer[begin]))
+      begin++;
+    while ((end > begin) && isspace((unsigned char)pBuffer[end - 1]))
+      end--;
+    if (pFind->section)
+    {
+      if (begin == end)
+        continue;
+      /* any new section ends this one */
+      if (pBuffer[begin] == '[')
+        break;
+      pFind->insert = next;
+      if (!pKeyName || (pBuffer[begin] == ';'))
+        continue;
+      pEqual = memchr(pBuffer + begin,'=',end - begin);
+      key_end = pEqual ? (size_t)(pEqual - pBuffer) : end;
+      while ((key_end > begin) && isspace((unsigned char)pBuffer[key_end - 1]))
+        key_end--;
+      if (((key_end - begin) == key_len) &&
+        strfold_equal(pBuffer + begin,pKeyName,key_len))
+      {
+        pFind->key = TRUE;
+        pFind->line = line;
+        pFind->line_end = next;
+        pFind->has_value = (pEqual != NULL);
+        pFind->value = pEqual ? (size_t)(pEqual - pBuffer) + 1 : end;
+        while ((pFind->value < end) &&
+          isspace((unsigned char)pBuffer[pFind->value]))
+          pFind->value++;
+        pFind->value_end = end;
+        return;
+      }
+    }
+    else if (((end - begin) > 1) && (pBuffer[begin] == '[') &&
+      (pBuffer[end - 1] == ']') && ((end - begin - 2) == app_len) &&
+      strfold_equal(pBuffer + begin + 1,pAppName,app_len))
+    {
+      pFind->section = TRUE;
+      pFind->header = line;
+      pFind->insert = next;
+    }
+  }
+  pFind->end = line;
+}
+
+/**
+ * Add a key line, and a section header before it if asked, to the
+ * text.  A newline goes in front of them if the line before does not
+ * end with one.
+ *
+ * @param pText - text
+ * @param offset - where the lines go, at the end of a line
+ * @param pAppName - section name, or NULL for no header
+ * @param pKeyName - key name
+ * @param pString - value
+ *
+ * @return TRUE if added, FALSE if out of memory
+ */
+static BOOL text_insert_entry(
+  PROFILE_TEXT *pText,
+  size_t offset,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString)
+{
+  char *pLines;
+  size_t app_len = pAppName ? strlen(pAppName) : 0;
+  size_t key_len = strlen(pKeyName);
+  size_t len = strlen(pString);
+  size_t count = 0;
+  BOOL status;
+
+  pLines = malloc(app_len + key_len + len + 6);
+  if (!pLines)
+    return (FALSE);
+  if ((offset > 0) && (pText->pText[offset - 1] != '\n'))
+    pLines[count++] = '\n';
+  if (pAppName)
+  {
+    pLines[count++] = '[';
+    memcpy(pLines + count,pAppName,app_len);
+    count += app_len;
+    pLines[count++] = ']';
+    pLines[count++] = '\n';
+  }
+  memcpy(pLines + count,pKeyName,key_len);
+  count += key_len;
+  pLines[count++] = '=';
+  memcpy(pLines + count,pString,len);
+  count += len;
+  pLines[count++] = '\n';
+  status = text_splice(pText,offset,0,pLines,count);
+  free(pLines);
+
+  return (status);
+}
+
+/**
+ * Writes a string into the text, with the same results for
+ * GetPrivateProfileString as WritePrivateProfileString, but
+ * changing only the bytes it has to.  An existing key keeps
+ * its spelling and the spacing around its '='.
+ *
+ * @param pText (IN) text
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to write, or NULL to delete the key
+ *
+ * @return TRUE if the string was written or the key or section was
+ *  deleted; FALSE if there was nothing to delete or out of memory
+ */
+BOOL profile_text_set(
+  PROFILE_TEXT *pText,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString)
+{
+  struct text_find find;
+  size_t len;
+
+  if (!pText || !pAppName)
+    return (FALSE);
+  text_find(pText,pAppName,pKeyName,&find);
+  if (!pKeyName)
+  {
+    /* delete the header and every line up to the next section */
+    if (!find.section)
+      return (FALSE);
+    return (text_splice(pText,find.header,find.end - find.header,NULL,0));
+  }
+  if (!pString)
+  {
+    if (!find.key)
+      return (FALSE);
+    return (text_splice(pText,find.line,find.line_end - find.line,NULL,0));
+  }
+  len = strlen(pString);
+  if (find.key && find.has_value)
+  {
+    /* the same value is not a change */
+    if (((find.value_end - find.value) == len) &&
+      (memcmp(pText->pText + find.value,pString,len) == 0))
+      return (TRUE);
+    return (text_splice(pText,find.value,find.value_end - find.value,
+      pString,len));
+  }
+  if (find.key)
+  {
+    /* a key line without '=' gets one */
+    return (text_splice(pText,find.value_end,0,"=",1) &&
+      text_splice(pText,find.value_end + 1,0,pString,len));
+  }
+  if (find.section)
+    return (text_insert_entry(pText,find.insert,NULL,pKeyName,pString));
+
+  return (text_insert_entry(pText,pText->nLength,pAppName,pKeyName,
+    pString));
+}
+
+/**
+ * Retrieves a string from the text the same way as
+ * GetPrivateProfileString
+ *
+ * @param pText (IN) text
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t profile_text_get(
+  const PROFILE_TEXT *pText,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize)
+{
+  if (!pText)
+    return (0);
+
+  return (GetPrivateProfileStringFromBuffer(pAppName,pKeyName,pDefault,
+    pReturnedString,nSize,pText->pText,pText->nLength));
+}
+
+/**
+ * Write bytes at an offset of a file
+ *
+ * @param fd - file descriptor
+ * @param pBuffer - bytes to write
+ * @param nLength - number of bytes
+ * @param offset - where in the file
+ *
+ * @return TRUE if all the bytes were written
+ */
+static BOOL text_pwrite(
+  int fd,
+  const char *pBuffer,
+  size_t nLength,
+  size_t offset)
+{
+  ssize_t count;
+
+  while (nLength)
+  {
+    count = pwrite(fd,pBuffer,nLength,(off_t)offset);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return (FALSE);
+    }
+    pBuffer += count;
+    nLength -= (size_t)count;
+    offset += (size_t)count;
+  }
+
+  return (TRUE);
+}
+
+/**
+ * Write the changes of a text to the file it was read from.  Only
+ * the changed ranges are written, and the file is cut short if the
+ * text got shorter.
+ *
+ * @param pText (IN) text from profile_text_load
+ *
+ * @return TRUE if the file holds the text; FALSE if it cannot be
+ *  written, or if it changed since it was read, in which case the
+ *  text should be loaded again
+ */
+BOOL profile_text_commit(
+  PROFILE_TEXT *pText)
+{
+  PROFILE_IO_STAT file_stat;
+  int fd;
+  size_t i;
+  BOOL status = TRUE;
+
+  if (!pText || !pText->pFileName)
+    return (FALSE);
+  if (!profile_text_dirty(pText))
+    return (TRUE);
+  (void)profile_io_stat(profile_io_posix(),pText->pFileName,&file_stat);
+  if ((file_stat.exists != pText->file_stat.exists) ||
+    (file_stat.size != pText->file_stat.size) ||
+    (file_stat.mtime != pText->file_stat.mtime))
+    return (FALSE);
+  fd = open(pText->pFileName,O_WRONLY | O_CREAT,0666);
+  if (fd < 0)
+    return (FALSE);
+  for (i = 0; status && (i < pText->nSpans); i++)
+  {
+    status = text_pwrite(fd,pText->pText + pText->pSpan[i].start,
+      pText->pSpan[i].end - pText->pSpan[i].start,pText->pSpan[i].start);
+  }
+  if (status && pText->shifted)
+  {
+    status = text_pwrite(fd,pText->pText + pText->tail,
+      pText->nLength - pText->tail,pText->tail);
+    if (status && (ftruncate(fd,(off_t)pText->nLength) != 0))
+      status = FALSE;
+  }
+  if (status)
+    status = profile_sync_fd(fd,pText->durability);
+  if (close(fd) != 0)
+    status = FALSE;
+  /* a new file is also a new directory entry */
+  if (status && !pText->file_stat.exists)
+    status = profile_sync_dir(pText->pFileName,pText->durability);
+  if (!status)
+    return (FALSE);
+  (void)profile_io_stat(profile_io_posix(),pText->pFileName,
+    &pText->file_stat);
+  pText->nSpans = 0;
+  pText->shifted = FALSE;
+  pText->tail = 0;
+
+  return (TRUE);
+}
@@ -0,0 +1,50 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Byte-for-byte copy of an INI file that records its changes
+ */
+#ifndef PROFILE_TEXT_H
+#define PROFILE_TEXT_H
+
+#include <stddef.h>
+#include "profile.h"
+
+typedef struct profile_text PROFILE_TEXT;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_TEXT *profile_text_load(const char *pFileName);
+  PROFILE_TEXT *profile_text_load_buffer(
+    const char *pBuffer,
+    size_t nLength);
+  void profile_text_free(PROFILE_TEXT *pText);
+
+  const char *profile_text_data(
+    const PROFILE_TEXT *pText,
+    size_t *pnLength);
+  BOOL profile_text_dirty(const PROFILE_TEXT *pText);
+  size_t profile_text_dirty_bytes(const PROFILE_TEXT *pText);
+
+  BOOL profile_text_set(
+    PROFILE_TEXT *pText,
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString); 	// pointer to string to add
+  size_t profile_text_get(
+    const PROFILE_TEXT *pText,
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize); 	// size of destination buffer
+  BOOL profile_text_commit(PROFILE_TEXT *pText);
+  void profile_text_set_durability(
+    PROFILE_TEXT *pText,
+    int level); 	// PROFILE_SYNC level, or PROFILE_SYNC_DEFAULT
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_TEXT_H */
@@ -0,0 +1,369 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Several writes to one or more INI files, committed together
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * A transaction reads each file it touches once, the first time it is
+ * written, and keeps the new contents in memory.  profile_txn_set()
+ * changes that copy the same way WritePrivateProfileString changes a
+ * file, and profile_txn_get() reads it, so a transaction sees its own
+ * writes.  Nothing reaches the backend until the commit.
+ * {@code
+ * PROFILE_TXN *pTxn = profile_txn_begin(NULL);
+ * profile_txn_set(pTxn,"Network","Address","10.0.0.2","net.ini");
+ * profile_txn_set(pTxn,"Device","Instance","1234","device.ini");
+ * if (!profile_txn_commit(pTxn))
+ *   ...nothing was changed, or the files changed underneath...
+ * }
+ *
+ * The commit first checks that no file changed since the transaction
+ * read it, then writes the new contents of every file through the
+ * backend, and only when all of them are written commits them one
+ * after the other.  With the posix and mmap backends each commit is an
+ * atomic rename, so a crash leaves each file either old or new, and
+ * the files of a transaction can only disagree if it strikes between
+ * the renames at the very end.  A failure before then leaves every file
+ * as it was.
+ */
+
+/* includes */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_txn.h"
+
+/* a file written by a transaction */
+struct txn_file
+{
+  char *pFileName;
+  PROFILE_IO_STAT file_stat; /* the file when it was read */
+  char *pBuffer; /* new contents, or NULL for no file */
+  size_t nLength; /* number of characters in pBuffer */
+  void *pHandle; /* opened to write during the commit */
+  struct txn_file *pNext;
+};
+
+/* a transaction */
+struct profile_txn
+{
+  const PROFILE_IO *pIo;
+  struct txn_file *pFirst; /* files in the order they were written */
+  struct txn_file *pLast;
+};
+
+/* commits of this process check and replace their files one at a time */
+static pthread_mutex_t Txn_Lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Start a transaction
+ *
+ * @param pIo (IN) backend of the files, or NULL for profile_io_posix()
+ *
+ * @return new transaction, or NULL if out of memory
+ */
+PROFILE_TXN *profile_txn_begin(
+  const PROFILE_IO *pIo)
+{
+  PROFILE_TXN *pTxn;
+
+  pTxn = calloc(1,sizeof(PROFILE_TXN));
+  if (!pTxn)
+    return (NULL);
+  pTxn->pIo = pIo ? pIo : profile_io_posix();
+
+  return (pTxn);
+}
+
+/**
+ * Find a file of a transaction
+ *
+ * @param pTxn - transaction
+ * @param pFileName - name of the file
+ *
+ * @return file, or NULL if the transaction has not written it
+ */
+static struct txn_file *txn_find(
+  PROFILE_TXN *pTxn,
+  const char *pFileName)
+{
+  struct txn_file *pFile;
+
+  for (pFile = pTxn->pFirst; pFile; pFile = pFile->pNext)
+  {
+    if (strcmp(pFile->pFileName,pFileName) == 0)
+      break;
+  }
+
+  return (pFile);
+}
+
+/**
+ * Read a file into a transaction
+ *
+ * @param pTxn - transaction
+ * @param pFileName - name of the file
+ *
+ * @return file, or NULL if it cannot be read or out of memory
+ */
+static struct txn_file *txn_add(
+  PROFILE_TXN *pTxn,
+  const char *pFileName)
+{
+  struct txn_file *pFile;
+  size_t len;
+
+  pFile = calloc(1,sizeof(struct txn_file));
+  if (!pFile)
+    return (NULL);
+  len = strlen(pFileName) + 1;
+  pFile->pFileName = malloc(len);
+  if (!pFile->pFileName)
+  {
+    free(pFile);
+    return (NULL);
+  }
+  memcpy(pFile->pFileName,pFileName,len);
+  /* stat first, so a change while reading is seen by the commit */
+  if (profile_io_stat(pTxn->pIo,pFileName,&pFile->file_stat))
+  {
+    pFile->pBuffer = profile_io_read(pTxn->pIo,pFileName,&pFile->nLength);
+    if (!pFile->pBuffer)
+    {
+      free(pFile->pFileName);
+      free(pFile);
+      return (NULL);
+    }
+  }
+  if (pTxn->pLast)
+    pTxn->pLast->pNext = pFile;
+  else
+    pTxn->pFirst = pFile;
+  pTxn->pLast = pFile;
+
+  return (pFile);
+}
+
+/**
+ * Writes a string to an INI file as part of a transaction.  The
+ * contents change the same way as WritePrivateProfileString changes
+ * them, but only in memory until profile_txn_commit().
+ *
+ * @param pTxn (IN) transaction
+ * @param pAppName (IN) section name
+ * @param pKeyName (IN) key name, or NULL to delete the section
+ * @param pString (IN) string to write, or NULL to delete the key
+ * @param pFileName (IN) initialization filename
+ *
+ * @return the value WritePrivateProfileString would return
+ */
+BOOL profile_txn_set(
+  PROFILE_TXN *pTxn,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pString,
+  const char *pFileName)
+{
+  struct txn_file *pFile;
+  char *pOutBuffer = NULL;
+  size_t size = 0;
+  size_t out_len = 0;
+  BOOL status = FALSE;
+
+  if (!pTxn || !pAppName || !pFileName)
+    return (status);
+  pFile = txn_find(pTxn,pFileName);
+  if (!pFile)
+    pFile = txn_add(pTxn,pFileName);
+  if (!pFile)
+    return (status);
+  /* a new file is only made to hold a string */
+  if (!pFile->pBuffer && (!pKeyName || !pString))
+    return (status);
+  /* the same estimate as WritePrivateProfileStringIo */
+  size = pFile->nLength + (pFile->nLength / (MAX_LINE_LEN - 2)) +
+    strlen(pAppName) + (pKeyName ? strlen(pKeyName) : 0) +
+    (pString ? strlen(pString) : 0) + 8;
+  pOutBuffer = malloc(size);
+  if (!pOutBuffer)
+    return (status);
+  status = WritePrivateProfileStringToBuffer(pAppName,pKeyName,pString,
+    pFile->pBuffer ? pFile->pBuffer : "",pFile->nLength,pOutBuffer,size,
+    &out_len);
+  if (!status && (out_len >= size))
+  {
+    free(pOutBuffer);
+    size = out_len + 1;
+    pOutBuffer = malloc(size);
+    if (!pOutBuffer)
+      return (FALSE);
+    status = WritePrivateProfileStringToBuffer(pAppName,pKeyName,pString,
+      pFile->pBuffer ? pFile->pBuffer : "",pFile->nLength,pOutBuffer,size,
+      &out_len);
+  }
+  /* a delete that found nothing still rewrites, like the file version */
+  free(pFile->pBuffer);
+  pFile->pBuffer = pOutBuffer;
+  pFile->nLength = out_len;
+
+  return (status);
+}
+
+/**
+ * Retrieves a string the same way as GetPrivateProfileString, with
+ * the writes the transaction has made so far
+ *
+ * @param pTxn (IN) transaction
+ * @param pAppName (IN) section name, or NULL for all section names
+ * @param pKeyName (IN) key name, or NULL for all key names
+ * @param pDefault (IN) default string
+ * @param pReturnedString (OUT) buffer that receives the string
+ * @param nSize (IN) size of the buffer
+ * @param pFileName (IN) initialization filename
+ *
+ * @return number of characters copied to the buffer
+ */
+size_t profile_txn_get(
+  PROFILE_TXN *pTxn,
+  const char *pAppName,
+  const char *pKeyName,
+  const char *pDefault,
+  char *pReturnedString,
+  size_t nSize,
+  const char *pFileName)
+{
+  struct txn_file *pFile;
+
+  if (!pTxn || !pFileName)
+    return (0);
+  pFile = txn_find(pTxn,pFileName);
+  if (!pFile)
+    return (GetPrivateProfileStringIo(pTxn->pIo,pAppName,pKeyName,
+      pDefault,pReturnedString,nSize,pFileName));
+
+  return (GetPrivateProfileStringFromBuffer(pAppName,pKeyName,pDefault,
+    pReturnedString,nSize,pFile->pBuffer ? pFile->pBuffer : "",
+    pFile->nLength));
+}
+
+/**
+ * Check that a file is as the transaction read it
+ *
+ * @param pTxn - transaction
+ * @param pFile - file of the transaction
+ *
+ * @return TRUE if nobody changed it
+ */
+static BOOL txn_unchanged(
+  PROFILE_TXN *pTxn,
+  struct txn_file *pFile)
+{
+  PROFILE_IO_STAT file_stat;
+
+  (void)profile_io_stat(pTxn->pIo,pFile->pFileName,&file_stat);
+
+  return ((file_stat.exists == pFile->file_stat.exists) &&
+    (file_stat.size == pFile->file_stat.size) &&
+    (file_stat.mtime == pFile->file_stat.mtime));
+}
+
+/**
+ * Write every file of a transaction and end it.  If any file changed
+ * since the transaction read it, or any new contents cannot be
+ * written, no file is changed.
+ *
+ * @param pTxn (IN) transaction, which is released
+ *
+ * @return TRUE if every file was replaced
+ */
+BOOL profile_txn_commit(
+  PROFILE_TXN *pTxn)
+{
+  const PROFILE_IO_OPS *pOps;
+  struct txn_file *pFile;
+  BOOL status = TRUE;
+
+  if (!pTxn)
+    return (FALSE);
+  pOps = pTxn->pIo->pOps;
+  pthread_mutex_lock(&Txn_Lock);
+  for (pFile = pTxn->pFirst; status && pFile; pFile = pFile->pNext)
+  {
+    if (pFile->pBuffer)
+      status = txn_unchanged(pTxn,pFile);
+  }
+  /* every file is written before any is replaced */
+  for (pFile = pTxn->pFirst; status && pFile; pFile = pFile->pNext)
+  {
+    if (!pFile->pBuffer)
+      continue;
+    pFile->pHandle = pOps->open(pTxn->pIo->pContext,pFile->pFileName,
+      PROFILE_IO_WRITE);
+    if (!pFile->pHandle ||
+      !pOps->write(pFile->pHandle,pFile->pBuffer,pFile->nLength))
+      status = FALSE;
+  }
+  for (pFile = pTxn->pFirst; pFile; pFile = pFile->pNext)
+  {
+    if (!pFile->pHandle)
+      continue;
+    if (status)
+      status = pOps->commit(pFile->pHandle);
+    else
+      pOps->close(pFile->pHandle);
+    pFile->pHandle = NULL;
+  }
+  pthread_mutex_unlock(&Txn_Lock);
+  profile_txn_rollback(pTxn);
+
+  return (status);
+}
+
+/**
+ * End a transaction without writing anything
+ *
+ * @param pTxn (IN) transaction, which is released
+ */
+void profile_txn_rollback(
+  PROFILE_TXN *pTxn)
+{
+  struct txn_file *pFile;
+  struct txn_file *pNext;
+
+  if (!pTxn)
+    return;
+  for (pFile = pTxn->pFirst; pFile; pFile = pNext)
+  {
+    pNext = pFile->pNext;
+    free(pFile->pBuffer);
+    free(pFile->pFileName);
+    free(pFile);
+  }
+  free(pTxn);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief Several writes to one or more INI files, committed together
+ */
+#ifndef PROFILE_TXN_H
+#define PROFILE_TXN_H
+
+#include <stddef.h>
+#include "profile.h"
+#include "profile_io.h"
+
+typedef struct profile_txn PROFILE_TXN;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  PROFILE_TXN *profile_txn_begin(const PROFILE_IO *pIo);
+  BOOL profile_txn_set(
+    PROFILE_TXN *pTxn,
+    const char *pAppName,	// pointer to section name
+    const char *pKeyName,	// pointer to key name
+    const char *pString,	// pointer to string to add
+    const char *pFileName); 	// pointer to initialization filename
+  size_t profile_txn_get(
+    PROFILE_TXN *pTxn,
+    const char *pAppName,	// points to section name
+    const char *pKeyName,	// points to key name
+    const char *pDefault,	// points to default string
+    char *pReturnedString,	// points to destination buffer
+    size_t nSize,	// size of destination buffer
+    const char *pFileName); 	// points to initialization filename
+  BOOL profile_txn_commit(PROFILE_TXN *pTxn);
+  void profile_txn_rollback(PROFILE_TXN *pTxn);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* PROFILE_TXN_H */
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @author Steve Karg
+ * @brief INI lookup daemon program
+ *
+ * @section LICENSE
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * @section DESCRIPTION
+ *
+ * profiled SOCKET FILE...
+ *
+ * Serves the INI files named on the command line to clients
+ * (profile_client.h) on the unix socket SOCKET, until it is
+ * sent SIGINT or SIGTERM.
+ */
+
+/* includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "profile.h"
+#include "profile_daemon.h"
+
+static PROFILE_DAEMON *Daemon;
+
+/**
+ * Stop the daemon on a signal
+ *
+ * @param sig - signal number
+ */
+static void profiled_signal(
+  int sig)
+{
+  (void)sig;
+  profile_daemon_stop(Daemon);
+}
+
+/**
+ * Main program entry for the daemon
+ *
+ * @param argc - number of arguments
+ * @param argv - socket path, then INI file names
+ *
+ * @return 0 once stopped, non-zero if it could not run
+ */
+int main(
+  int argc,
+  char *argv[])
+{
+  struct sigaction action;
+  int i = 0;
+  BOOL status = FALSE;
+
+  if (argc < 3)
+  {
+    fprintf(stderr,"usage: %s SOCKET FILE...\n",argv[0]);
+    return (2);
+  }
+  Daemon = profile_daemon_create(argv[1]);
+  if (!Daemon)
+  {
+    fprintf(stderr,"%s: cannot listen on %s\n",argv[0],argv[1]);
+    return (1);
+  }
+  for (i = 2; i < argc; i++)
+  {
+    if (!profile_daemon_add_file(Daemon,argv[i]))
+    {
+      fprintf(stderr,"%s: cannot serve %s\n",argv[0],argv[i]);
+      profile_daemon_free(Daemon);
+      return (1);
+    }
+  }
+  memset(&action,0,sizeof(action));
+  action.sa_handler = profiled_signal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT,&action,NULL);
+  sigaction(SIGTERM,&action,NULL);
+  signal(SIGPIPE,SIG_IGN);
+  status = profile_daemon_run(Daemon);
+  profile_daemon_free(Daemon);
+
+  return (status ? 0 : 1);
+}
@@ -94,15 +94,14 @@ size_t rmtrail(char *str)
 {
     size_t i = 0;
 
-    if (str && 0 != (i = strlen(str))) {
-    /* start at end, not at 0 */
-    --i;
-        do {
-      if (!isspace(str[i]))
-        break;
-    } while (--i);
-    str[++i] = '\0';
-  }
+    if (str) {
+        i = strlen(str);
+        /* start at end, and stop at 0 */
+        while ((i > 0) && isspace((unsigned char)str[i - 1])) {
+            --i;
+        }
+        str[i] = '\0';
+    }
 
     return i;
 }
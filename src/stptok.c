@@ -13,10 +13,96 @@
  * using delimiters and returns a token.  Similar to strtok, but
  * thread safe.
  *
+ * The break characters are turned into a 256 bit set, so each
+ * character of the string is classified with a single lookup no
+ * matter how many break characters there are.  Callers that parse
+ * many strings with the same break characters can build the set
+ * once with stptok_compile and use stptok_compiled or stptok_split.
+ *
  */
 #include <stddef.h>
+#include <string.h>
 #include "stptok.h"
 
+/* TRUE if the character is in the set of break characters */
+#define STPTOK_IS_BREAK(d, c) \
+    ((d)->bits[(unsigned char)(c) >> 3] & (1U << ((unsigned char)(c) & 7)))
+
+/**
+ * Builds the set of break characters used by stptok_compiled
+ * and stptok_split.
+ *
+ * @param   delim - set that receives the break characters
+ * @param   brk - string of break characters that will stop the scan
+ */
+void stptok_compile(STPTOK_DELIM *delim,
+    const char *brk)
+{
+    if (!delim) {
+        return;
+    }
+    memset(delim->bits, 0, sizeof(delim->bits));
+    if (!brk) {
+        return;
+    }
+    while (*brk) {
+        delim->bits[(unsigned char)*brk >> 3] |=
+            (unsigned char)(1U << ((unsigned char)*brk & 7));
+        brk++;
+    }
+}
+
+/**
+ * Parses a string using a compiled set of break characters
+ * and returns a token.  Works the same as stptok.
+ *
+ * @param   s - string to parse
+ * @param   tok - buffer that receives the "token" that gets scanned
+ * @param   toklen - size of the buffer
+ * @param   delim - set of break characters from stptok_compile
+ *
+ * @return  It will return a pointer to the first non-breaking character
+ * after the one that stopped the scan or NULL on error or end of string.
+ */
+const char *stptok_compiled(const char *s,
+    char *tok,
+    size_t toklen,
+    const STPTOK_DELIM *delim)
+{
+    char *lim;  /* limit of token */
+
+    /* check for invalid pointers */
+    if (!s || !tok || !delim || !toklen) {
+        return NULL;
+    }
+
+    /* check for empty string */
+    if (!*s) {
+        *tok = 0;
+        return NULL;
+    }
+
+    lim = tok + toklen - 1;
+    while (*s && tok < lim) {
+        if (STPTOK_IS_BREAK(delim, *s)) {
+            *tok = 0;
+            /* skip the whole run of break characters */
+            for (++s; *s && STPTOK_IS_BREAK(delim, *s); ++s) {
+            }
+            if (!*s) {
+                return NULL;
+            }
+            return s;
+        }
+        *tok++ = *s++;
+    }
+    *tok = 0;
+    if (!*s) {
+        return NULL;
+    }
+    return s;
+}
+
 /**
  * Parses a string using delimiters and returns a token
  *
@@ -46,42 +132,64 @@ const char *stptok(const char *s,
 
     const char *brk)
 {       /* string of break characters that will stop the scan */
-    char *lim;  /* limit of token */
-    const char *b;      /* current break character */
-
+    STPTOK_DELIM delim; /* break characters */
 
     /* check for invalid pointers */
     if (!s || !tok || !brk) {
         return NULL;
     }
+    stptok_compile(&delim, brk);
 
-    /* check for empty string */
-    if (!*s) {
-        return NULL;
+    return stptok_compiled(s, tok, toklen, &delim);
+}
+
+/**
+ * Splits a string into tokens in one call
+ *
+ * Gives the same tokens as calling stptok_compiled over and over
+ * until it returns NULL, but without copying them: each token is
+ * returned as a pointer into the string and a length.  The scan
+ * stops at the end of the string or after len characters.
+ *
+ * @param   s - string to parse
+ * @param   len - maximum number of characters to parse
+ * @param   delim - set of break characters from stptok_compile
+ * @param   views - array that receives the tokens, may be NULL
+ * @param   maxviews - number of tokens the array can hold
+ *
+ * @return  number of tokens in the string, which can be more
+ * than maxviews when the array is too small.
+ */
+size_t stptok_split(const char *s,
+    size_t len,
+    const STPTOK_DELIM *delim,
+    STPTOK_VIEW *views,
+    size_t maxviews)
+{
+    const char *lim;    /* end of string */
+    const char *start;  /* start of token */
+    size_t count = 0;   /* number of tokens */
+
+    if (!s || !delim || !len || !*s) {
+        return 0;
     }
 
-    lim = tok + toklen - 1;
-    while (*s && tok < lim) {
-        for (b = brk; *b; b++) {
-            if (*s == *b) {
-                *tok = 0;
-                for (++s, b = brk; *s && *b; ++b) {
-                    if (*s == *b) {
-                        ++s;
-                        b = brk;
-                    }
-                }
-                if (!*s) {
-                    return NULL;
-                }
-                return s;
-            }
+    lim = s + len;
+    while (s < lim && *s) {
+        start = s;
+        while (s < lim && *s && !STPTOK_IS_BREAK(delim, *s)) {
+            s++;
+        }
+        if (views && count < maxviews) {
+            views[count].start = start;
+            views[count].len = (size_t)(s - start);
+        }
+        count++;
+        /* skip the whole run of break characters */
+        while (s < lim && *s && STPTOK_IS_BREAK(delim, *s)) {
+            s++;
         }
-        *tok++ = *s++;
-    }
-    *tok = 0;
-    if (!*s) {
-        return NULL;
     }
-    return s;
+
+    return count;
 }
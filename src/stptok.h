@@ -9,6 +9,19 @@
 #ifndef STPTOK_H
 #define STPTOK_H
 
+#include <stddef.h>
+
+/* set of break characters, one bit per character value */
+typedef struct stptok_delim {
+    unsigned char bits[256 / 8];
+} STPTOK_DELIM;
+
+/* a token inside the string being parsed - not null-terminated */
+typedef struct stptok_view {
+    const char *start;
+    size_t len;
+} STPTOK_VIEW;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -18,6 +31,20 @@ extern "C" {
         size_t toklen,
         const char *brk);
 
+    void stptok_compile(STPTOK_DELIM *delim,
+        const char *brk);
+
+    const char *stptok_compiled(const char *s,
+        char *tok,
+        size_t toklen,
+        const STPTOK_DELIM *delim);
+
+    size_t stptok_split(const char *s,
+        size_t len,
+        const STPTOK_DELIM *delim,
+        STPTOK_VIEW *views,
+        size_t maxviews);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
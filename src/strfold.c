@@ -0,0 +1,261 @@
+/**
+* @file
+* @author Steve Karg
+* @brief ASCII case-folded compare and hash of section and key names
+*
+* @section LICENSE
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+* @section DESCRIPTION
+*
+* Section and key names are matched without regard to case.  Only the
+* ASCII letters A to Z are folded, which is what strcasecmp does in the
+* default "C" locale, but without the locale lookup per character.
+*
+* Names are compared eight characters at a time: each 64-bit word has
+* its upper case letters folded with a few integer operations, and
+* whole words are compared at once.  The hash folds with a table so
+* callers can store the hash of a name and reject most mismatches
+* before comparing any characters.
+* {@code
+* if ((hash == strfold_hash(name, len)) && (stored_len == len) &&
+*     strfold_equal(stored, name, len)) {
+*     ...
+* }
+* }
+*/
+
+/* includes */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "strfold.h"
+
+/* a byte value in every byte of a word */
+#define STRFOLD_BYTES(b) ((uint64_t)(b) * 0x0101010101010101ULL)
+
+/* ASCII folding table */
+static const unsigned char Fold_Table[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+    0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+    0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+    0x40, 'a', 'b', 'c', 'd', 'e', 'f', 'g',
+    'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o',
+    'p', 'q', 'r', 's', 't', 'u', 'v', 'w',
+    'x', 'y', 'z', 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+    0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+    0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97,
+    0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7,
+    0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+    0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7,
+    0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+    0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7,
+    0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+
+/**
+* Fold the upper case ASCII letters of eight characters at once
+*
+* @param word - eight characters
+*
+* @return the characters with 'A' to 'Z' changed to 'a' to 'z'
+*/
+static uint64_t strfold_word(uint64_t word)
+{
+    uint64_t low = word & STRFOLD_BYTES(0x7f);
+    /* high bit of each byte set when the byte is at least 'A' */
+    uint64_t ge_a = low + STRFOLD_BYTES(0x80 - 'A');
+    /* high bit of each byte set when the byte is past 'Z' */
+    uint64_t gt_z = low + STRFOLD_BYTES(0x80 - 'Z' - 1);
+    uint64_t upper = ge_a & ~gt_z & ~word & STRFOLD_BYTES(0x80);
+
+    return word | (upper >> 2);
+}
+
+/**
+* Load up to eight characters into a word
+*
+* @param str - characters
+* @param len - number of characters, at most 8
+*
+* @return characters, with zeros after the last one
+*/
+static uint64_t strfold_load(const char *str, size_t len)
+{
+    uint64_t word = 0;
+
+    memcpy(&word, str, len);
+
+    return word;
+}
+
+/**
+* Fold one character the same way as the compare and hash
+*
+* @param c - character
+*
+* @return lower case character for 'A' to 'Z', others unchanged
+*/
+char strfold_char(char c)
+{
+    return (char)Fold_Table[(unsigned char)c];
+}
+
+/**
+* Continue a case-folded FNV-1a hash over some characters
+*
+* @param hash - hash so far, or STRFOLD_HASH_INIT
+* @param str - characters
+* @param len - number of characters
+*
+* @return hash value
+*/
+unsigned strfold_hash_more(unsigned hash, const char *str, size_t len)
+{
+    const unsigned char *s = (const unsigned char *)str;
+
+    while (len--) {
+        hash ^= Fold_Table[*s++];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+* Case-folded FNV-1a hash of some characters
+*
+* @param str - characters
+* @param len - number of characters
+*
+* @return hash value, the same for names that differ only in case
+*/
+unsigned strfold_hash(const char *str, size_t len)
+{
+    return strfold_hash_more(STRFOLD_HASH_INIT, str, len);
+}
+
+/**
+* Compare two names of the same length without regard to case
+*
+* @param a - characters
+* @param b - characters
+* @param len - number of characters in each
+*
+* @return non-zero when equal, zero when different
+*/
+int strfold_equal(const char *a, const char *b, size_t len)
+{
+    uint64_t wa;
+    uint64_t wb;
+
+    while (len >= sizeof(uint64_t)) {
+        memcpy(&wa, a, sizeof(wa));
+        memcpy(&wb, b, sizeof(wb));
+        if ((wa != wb) && (strfold_word(wa) != strfold_word(wb))) {
+            return 0;
+        }
+        a += sizeof(uint64_t);
+        b += sizeof(uint64_t);
+        len -= sizeof(uint64_t);
+    }
+    if (len) {
+        wa = strfold_load(a, len);
+        wb = strfold_load(b, len);
+        if ((wa != wb) && (strfold_word(wa) != strfold_word(wb))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+* Order two names without regard to case
+*
+* @param a - characters
+* @param alen - number of characters in a
+* @param b - characters
+* @param blen - number of characters in b
+*
+* @return less than, equal to, or greater than zero, the same
+* as strcasecmp in the "C" locale
+*/
+int strfold_cmp(const char *a, size_t alen, const char *b, size_t blen)
+{
+    size_t len = (alen < blen) ? alen : blen;
+    size_t i = 0;
+    int diff = 0;
+
+    /* skip the equal words, then find the character */
+    while ((len - i) >= sizeof(uint64_t)) {
+        if (!strfold_equal(a + i, b + i, sizeof(uint64_t))) {
+            break;
+        }
+        i += sizeof(uint64_t);
+    }
+    for (; i < len; i++) {
+        diff = (int)Fold_Table[(unsigned char)a[i]] -
+            (int)Fold_Table[(unsigned char)b[i]];
+        if (diff) {
+            return diff;
+        }
+    }
+    if (alen < blen) {
+        return -(int)Fold_Table[(unsigned char)b[len]];
+    }
+    if (alen > blen) {
+        return (int)Fold_Table[(unsigned char)a[len]];
+    }
+
+    return 0;
+}
+
+/**
+* Compare two C strings without regard to case.
+* A replacement for strcasecmp and strcmpi.
+*
+* @param a - C string
+* @param b - C string
+*
+* @return less than, equal to, or greater than zero
+*/
+int strfold_casecmp(const char *a, const char *b)
+{
+    return strfold_cmp(a, strlen(a), b, strlen(b));
+}
@@ -0,0 +1,37 @@
+/**
+* @file
+* @author Steve Karg
+* @brief ASCII case-folded compare and hash of section and key names
+*/
+#ifndef STRFOLD_H
+#define STRFOLD_H
+
+#include <stddef.h>
+
+/* starting value for strfold_hash_more */
+#define STRFOLD_HASH_INIT 2166136261U
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    unsigned strfold_hash(const char *str,
+        size_t len);
+    unsigned strfold_hash_more(unsigned hash,
+        const char *str,
+        size_t len);
+    int strfold_equal(const char *a,
+        const char *b,
+        size_t len);
+    int strfold_cmp(const char *a,
+        size_t alen,
+        const char *b,
+        size_t blen);
+    int strfold_casecmp(const char *a,
+        const char *b);
+    char strfold_char(char c);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* STRFOLD_H */
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @brief Test file for the arena allocator
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "arena.h"
+
+/**
+* Unit Test for allocation within one block
+*/
+static void testAlloc(void)
+{
+    ARENA *arena;
+    char *name;
+    long *numbers;
+    size_t i;
+
+    arena = arena_create(1024);
+    assert(arena);
+    assert(arena_blocks(arena) == 1);
+    assert(arena_size(arena) >= 1024);
+    name = arena_strndup(arena, "section name", 7);
+    assert(name);
+    assert(strcmp(name, "section") == 0);
+    /* after a packed string the next allocation is still aligned */
+    numbers = arena_calloc(arena, 10, sizeof(long));
+    assert(numbers);
+    assert(((uintptr_t)numbers % sizeof(long)) == 0);
+    for (i = 0; i < 10; i++) {
+        assert(numbers[i] == 0);
+    }
+    name = arena_strndup(arena, "", 0);
+    assert(name && (name[0] == '\0'));
+    assert(arena_blocks(arena) == 1);
+    assert(arena_used(arena) <= arena_size(arena));
+    arena_free(arena);
+    arena_free(NULL);
+
+    return;
+}
+
+/**
+* Unit Test for an arena that grows
+*/
+static void testGrow(void)
+{
+    ARENA *arena;
+    char *strings[1000];
+    char text[32];
+    char *big;
+    size_t i;
+
+    arena = arena_create(0);
+    assert(arena);
+    for (i = 0; i < 1000; i++) {
+        snprintf(text, sizeof(text), "key%u", (unsigned)i);
+        strings[i] = arena_strndup(arena, text, strlen(text));
+        assert(strings[i]);
+    }
+    assert(arena_blocks(arena) > 1);
+    /* earlier strings are not moved when the arena grows */
+    for (i = 0; i < 1000; i++) {
+        snprintf(text, sizeof(text), "key%u", (unsigned)i);
+        assert(strcmp(strings[i], text) == 0);
+    }
+    /* larger than any block */
+    big = arena_alloc(arena, 4 * 1024 * 1024);
+    assert(big);
+    memset(big, 'x', 4 * 1024 * 1024);
+    assert(arena_size(arena) > 4 * 1024 * 1024);
+    assert(arena_calloc(arena, SIZE_MAX, 2) == NULL);
+    assert(arena_alloc(NULL, 1) == NULL);
+    arena_free(arena);
+
+    return;
+}
+
+/**
+* Unit Test for moving the blocks of one arena into another
+*/
+static void testAdopt(void)
+{
+    ARENA *arena;
+    ARENA *other;
+    char *name;
+    char *kept;
+    size_t size;
+    size_t blocks;
+    size_t i;
+
+    arena = arena_create(0);
+    assert(arena);
+    other = arena_create(0);
+    assert(other);
+    kept = arena_strndup(other, "kept", 4);
+    assert(kept);
+    for (i = 0; i < 100; i++) {
+        assert(arena_alloc(other, 64));
+    }
+    size = arena_size(arena) + arena_size(other);
+    blocks = arena_blocks(arena) + arena_blocks(other);
+    arena_adopt(arena, other);
+    assert(arena_size(arena) == size);
+    assert(arena_blocks(arena) == blocks);
+    assert(strcmp(kept, "kept") == 0);
+    /* allocation carries on in the block it was using */
+    name = arena_strndup(arena, "name", 4);
+    assert(name && (strcmp(name, "name") == 0));
+    assert(arena_blocks(arena) == blocks);
+    arena_adopt(arena, arena);
+    arena_adopt(arena, NULL);
+    arena_free(arena);
+
+    return;
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+    testAlloc();
+    testGrow();
+    testAdopt();
+
+    return 0;
+}
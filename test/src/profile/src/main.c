@@ -8,11 +8,26 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <string.h>
 #include "profile.h"
 
+#if defined(__GLIBC__)
+/* set to make calloc fail, to test what is done without memory */
+static bool Calloc_Fail;
+
+extern void *__libc_calloc(size_t nmemb, size_t size);
+
+void *calloc(size_t nmemb, size_t size)
+{
+  if (Calloc_Fail)
+    return NULL;
+  return __libc_calloc(nmemb,size);
+}
+#endif
+
 /**
 * Unit Test for the WritePrivateProfileString function
 *
@@ -326,6 +341,323 @@ static void test_PrivateProfileStringErase(void)
 
 }
 
+/**
+* Unit Tests for the GetPrivateProfileStringBatch function
+*
+* @param pTest - test tracking pointer
+*/
+static void test_PrivateProfileStringBatch(void)
+{
+  char file_name[MAX_LINE_LEN] = {"test4.ini"};
+  PROFILE_REQUEST request[7];
+  char return_name[7][MAX_LINE_LEN];
+  char short_name[8] = {""};
+  char expected_name[MAX_LINE_LEN] = {""};
+  const char *names[7][2] = {
+    {"MySection2","MyKey4"},
+    {"MySection1","MyKey1"},
+    {"MySection2","MyKey3"},
+    {"MYSECTION1","mykey2"},
+    {"MySection1","Missing"},
+    {"Missing","MyKey1"},
+    {"MySection3","MyKey5"}
+  };
+  size_t count = 0;
+  size_t i = 0;
+
+  /* start clean */
+  remove(file_name);
+
+  TestWritePrivateProfileString(
+    "MySection1","MyKey1","MyKey1Value",file_name);
+  WritePrivateProfileString(
+    "MySection1","MyKey2","\"MyKey2 Value\"",file_name);
+  TestWritePrivateProfileString(
+    "MySection2","MyKey3","MyKey3Value",file_name);
+  TestWritePrivateProfileString(
+    "MySection2","MyKey4","MyKey4Value",file_name);
+  TestWritePrivateProfileString(
+    "MySection3","MyKey5","MyKey5Value",file_name);
+
+  for (i = 0; i < 7; i++)
+  {
+    request[i].pAppName = names[i][0];
+    request[i].pKeyName = names[i][1];
+    request[i].pDefault = " default ";
+    request[i].pReturnedString = return_name[i];
+    request[i].nSize = sizeof(return_name[i]);
+  }
+  /* the short buffer truncates the same way */
+  request[6].pReturnedString = short_name;
+  request[6].nSize = sizeof(short_name);
+  count = GetPrivateProfileStringBatch(request,7,file_name);
+  assert(count == 5);
+  for (i = 0; i < 7; i++)
+  {
+    count = GetPrivateProfileString(request[i].pAppName,
+      request[i].pKeyName,request[i].pDefault,
+      expected_name,request[i].nSize,file_name);
+    assert(request[i].count == count);
+    assert(strcmp(request[i].pReturnedString,expected_name) == 0);
+  }
+  assert(strcmp(return_name[3],"MyKey2 Value") == 0);
+  assert(strcmp(return_name[5],"default") == 0);
+#if defined(__GLIBC__)
+  /* without memory each request is looked up on its own, the same way */
+  Calloc_Fail = true;
+  count = GetPrivateProfileStringBatch(request,7,file_name);
+  Calloc_Fail = false;
+  assert(count == 5);
+  for (i = 0; i < 7; i++)
+  {
+    count = GetPrivateProfileString(request[i].pAppName,
+      request[i].pKeyName,request[i].pDefault,
+      expected_name,request[i].nSize,file_name);
+    assert(request[i].count == count);
+    assert(strcmp(request[i].pReturnedString,expected_name) == 0);
+  }
+#endif
+
+  /* no file - everything is the default */
+  remove(file_name);
+  count = GetPrivateProfileStringBatch(request,7,file_name);
+  assert(count == 0);
+  assert(request[1].count == strlen("default"));
+  assert(strcmp(return_name[1],"default") == 0);
+}
+
+/**
+* Unit Tests for the Get/Write PrivateProfileString functions
+* on INI text held in memory
+*
+* @param pTest - test tracking pointer
+*/
+static void test_PrivateProfileStringBuffer(void)
+{
+  char file_name[MAX_LINE_LEN] = {"test5.ini"};
+  const char *writes[][3] = {
+    {"MySection1","MyKey1","MyKey1Value"},
+    {"MySection1","MyKey2","\"MyKey2 Value\""},
+    {"MySection2","MyKey3","MyKey3Value"},
+    {"mysection1","mykey1","Changed"},
+    {"MySection3","MyKey5","MyKey5Value"},
+    {"MySection2","MyKey3",NULL},
+    {"MySection3",NULL,NULL}
+  };
+  const char *names[][2] = {
+    {"MySection1","MyKey1"},
+    {"MYSECTION1","mykey2"},
+    {"MySection2","MyKey3"},
+    {"MySection3","MyKey5"},
+    {"MySection1",NULL},
+    {NULL,NULL},
+    {"Missing","MyKey1"}
+  };
+  char text[2][512] = {"[Start]\nfirst = 1\n",""};
+  char file_text[512] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected_name[MAX_LINE_LEN] = {""};
+  size_t length = strlen(text[0]);
+  size_t count = 0;
+  size_t i = 0;
+  FILE *pFile = NULL;
+
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  fputs(text[0], pFile);
+  fclose(pFile);
+  /* each change to the text matches the same change to the file */
+  for (i = 0; i < sizeof(writes) / sizeof(writes[0]); i++)
+  {
+    assert(WritePrivateProfileStringToBuffer(writes[i][0],writes[i][1],
+      writes[i][2],text[i % 2],length,text[(i + 1) % 2],
+      sizeof(text[0]),&length) ==
+      WritePrivateProfileString(writes[i][0],writes[i][1],writes[i][2],
+      file_name));
+    pFile = fopen(file_name, "r");
+    assert(pFile);
+    count = fread(file_text, 1, sizeof(file_text) - 1, pFile);
+    fclose(pFile);
+    file_text[count] = '\0';
+    assert(length == count);
+    assert(strcmp(text[(i + 1) % 2],file_text) == 0);
+  }
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+  {
+    count = GetPrivateProfileStringFromBuffer(names[i][0],names[i][1],
+      "default",return_name,sizeof(return_name),file_text,
+      strlen(file_text));
+    assert(count == GetPrivateProfileString(names[i][0],names[i][1],
+      "default",expected_name,sizeof(expected_name),file_name));
+    assert(memcmp(return_name,expected_name,count + 1) == 0);
+  }
+  assert(GetPrivateProfileStringFromBuffer("MySection1","MyKey1",
+    "default",return_name,sizeof(return_name),file_text,
+    strlen(file_text)) == strlen("Changed"));
+  /* a line with no newline at the end of the text */
+  count = GetPrivateProfileStringFromBuffer("a","b","",return_name,
+    sizeof(return_name),"[a]\nb = 'c'",11);
+  assert(count == 1);
+  assert(strcmp(return_name,"c") == 0);
+  /* a buffer that is too small gets the length that is needed */
+  assert(!WritePrivateProfileStringToBuffer("New","Key","Value",
+    file_text,strlen(file_text),return_name,8,&length));
+  assert(length == strlen(file_text) + strlen("[New]\nKey=Value\n"));
+  assert(strlen(return_name) == 7);
+  remove(file_name);
+}
+
+/**
+* Check that a file holds a header followed by the test pattern
+*
+* @param file_name - name of the file
+* @param header - text written before the copy
+* @param skip - number of pattern bytes that were not copied
+* @param size - number of pattern bytes
+*/
+static void TestFileCopyResult(
+  const char *file_name,
+  const char *header,
+  size_t skip,
+  size_t size)
+{
+  FILE *pFile = NULL;
+  size_t len = strlen(header);
+  size_t i = 0;
+  int c = 0;
+
+  pFile = fopen(file_name, "rb");
+  assert(pFile);
+  for (i = 0; i < len; i++)
+  {
+    assert(fgetc(pFile) == header[i]);
+  }
+  for (i = skip; i < size; i++)
+  {
+    c = fgetc(pFile);
+    assert(c == (int)(i % 251));
+  }
+  assert(fgetc(pFile) == EOF);
+  fclose(pFile);
+}
+
+/**
+* Unit Tests for the binary file copy
+*
+* @param pTest - test tracking pointer
+*/
+static void test_ProfileFileCopy(void)
+{
+  const char *source_name = "test_copy_source.bin";
+  const char *dest_name = "test_copy_dest.bin";
+  size_t size = (3 * PROFILE_COPY_BLOCKSIZE) + 17;
+  size_t i = 0;
+  FILE *pSource = NULL;
+  FILE *pDest = NULL;
+
+  pSource = fopen(source_name, "wb");
+  assert(pSource);
+  for (i = 0; i < size; i++)
+  {
+    fputc((int)(i % 251), pSource);
+  }
+  fclose(pSource);
+  /* from the current position of each stream, with buffered data */
+  pSource = fopen(source_name, "rb");
+  assert(pSource);
+  assert(fgetc(pSource) == 0);
+  assert(fgetc(pSource) == 1);
+  pDest = fopen(dest_name, "wb");
+  assert(pDest);
+  fputs("[Header]\n", pDest);
+  assert(profile_filecopy(pDest, pSource));
+  assert(fgetc(pSource) == EOF);
+  fclose(pDest);
+  fclose(pSource);
+  TestFileCopyResult(dest_name, "[Header]\n", 2, size);
+  /* a pipe cannot be copied by the kernel, and uses the buffer */
+  pSource = popen("cat test_copy_source.bin", "r");
+  assert(pSource);
+  pDest = fopen(dest_name, "wb");
+  assert(pDest);
+  assert(profile_filecopy(pDest, pSource));
+  fclose(pDest);
+  pclose(pSource);
+  TestFileCopyResult(dest_name, "", 0, size);
+  /* an empty file */
+  pSource = tmpfile();
+  assert(pSource);
+  pDest = fopen(dest_name, "wb");
+  assert(pDest);
+  assert(profile_filecopy(pDest, pSource));
+  fclose(pDest);
+  fclose(pSource);
+  TestFileCopyResult(dest_name, "", 0, 0);
+  assert(!profile_filecopy(NULL, NULL));
+  remove(source_name);
+  remove(dest_name);
+}
+
+/**
+* Unit Tests for listing the keys of a section with blank lines in it
+*
+* @param pTest - test tracking pointer
+*/
+static void test_PrivateProfileStringKeys(void)
+{
+  const char *file_name = "test_keys.ini";
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  FILE *pFile = NULL;
+
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  fputs("[s]\na=1\n\nb=2\n  \n[t]\nc=3\n", pFile);
+  fclose(pFile);
+  count = GetPrivateProfileString("s",NULL,"",return_name,
+    sizeof(return_name),file_name);
+  assert(count == 3);
+  assert(memcmp(return_name,"a\0b\0",5) == 0);
+  count = GetPrivateProfileString("s","b","",return_name,
+    sizeof(return_name),file_name);
+  assert(count == 1);
+  assert(strcmp(return_name,"2") == 0);
+  remove(file_name);
+}
+
+/**
+* Unit Tests for a write that replaces the file instead of emptying it,
+* so that a reader of the old file still sees all of it
+*
+* @param pTest - test tracking pointer
+*/
+static void test_PrivateProfileStringReplace(void)
+{
+  const char *file_name = "test_replace.ini";
+  char line[MAX_LINE_LEN] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  FILE *pOld = NULL;
+
+  remove(file_name);
+  assert(WritePrivateProfileString("s","a","old",file_name));
+  pOld = fopen(file_name, "r");
+  assert(pOld);
+  (void)WritePrivateProfileString("s",NULL,NULL,file_name);
+  assert(WritePrivateProfileString("t","b","new",file_name));
+  assert(fgets(line, sizeof(line), pOld));
+  assert(strcmp(line, "[s]\n") == 0);
+  assert(fgets(line, sizeof(line), pOld));
+  assert(strcmp(line, "a=old\n") == 0);
+  fclose(pOld);
+  GetPrivateProfileString("t","b","",return_name,sizeof(return_name),
+    file_name);
+  assert(strcmp(return_name,"new") == 0);
+  GetPrivateProfileString("s","a","",return_name,sizeof(return_name),
+    file_name);
+  assert(return_name[0] == 0);
+  remove(file_name);
+}
+
 /**
 * Main program entry for Unit Test
 *
@@ -336,6 +668,11 @@ int main(void)
   test_PrivateProfileString();
   test_PrivateProfileStringWrite();
   test_PrivateProfileStringErase();
+  test_PrivateProfileStringBatch();
+  test_PrivateProfileStringBuffer();
+  test_ProfileFileCopy();
+  test_PrivateProfileStringKeys();
+  test_PrivateProfileStringReplace();
 
   return 0;
 }
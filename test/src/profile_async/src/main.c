@@ -0,0 +1,208 @@
+/**
+ * @file
+ * @brief Test file for the asynchronous reads and write-behind module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "profile.h"
+#include "profile_async.h"
+
+static unsigned Callback_Count;
+static unsigned Callback_Status;
+
+/* reads run on several threads at once */
+static pthread_mutex_t Read_Lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned Read_Count;
+static size_t Read_Chars;
+
+/**
+* Counts completed writes
+*
+* @param status - result of the write
+* @param pContext - unused
+*/
+static void test_callback(BOOL status, void *pContext)
+{
+  (void)pContext;
+  Callback_Count++;
+  if (status)
+    Callback_Status++;
+}
+
+/**
+* Counts completed reads
+*
+* @param count - characters read
+* @param pContext - unused
+*/
+static void test_read_callback(size_t count, void *pContext)
+{
+  (void)pContext;
+  pthread_mutex_lock(&Read_Lock);
+  Read_Count++;
+  Read_Chars += count;
+  pthread_mutex_unlock(&Read_Lock);
+}
+
+/**
+* Check the value of a key in a file
+*
+* @param app_name - section name
+* @param key_name - key name
+* @param expected_name - expected value, or NULL for the default
+* @param file_name - name of INI file
+*/
+static void TestGet(
+  const char *app_name,
+  const char *key_name,
+  const char *expected_name,
+  const char *file_name)
+{
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+
+  if (!expected_name)
+    expected_name = "default";
+  count = GetPrivateProfileString(app_name, key_name, "default",
+    return_name,sizeof(return_name),file_name);
+  assert(count == strlen(expected_name));
+  assert(strcmp(return_name,expected_name) == 0);
+}
+
+/**
+* Unit Tests for queued writes, coalescing and tickets
+*/
+static void test_ProfileAsync(void)
+{
+  const char *file_name = "test_async1.ini";
+  char value[32] = "";
+  unsigned long ticket = 0;
+  unsigned long last = 0;
+  unsigned i;
+
+  remove(file_name);
+  assert(profile_async_init());
+
+  for (i = 0; i < 100; i++)
+  {
+    sprintf(value,"%u",i);
+    ticket = WritePrivateProfileStringAsync("Async","Counter",value,
+      file_name,test_callback,NULL);
+    assert(ticket != 0);
+    assert(ticket >= last);
+    last = ticket;
+  }
+  ticket = WritePrivateProfileStringAsync("Async","Other","x",
+    file_name,test_callback,NULL);
+  profile_async_wait(ticket);
+  assert(Callback_Count == 101);
+  assert(Callback_Status == 101);
+  TestGet("Async","Counter","99",file_name);
+  TestGet("Async","Other","x",file_name);
+
+  /* a section delete must not be overtaken by a later coalesced write */
+  (void)WritePrivateProfileStringAsync("Gone","Key","1",file_name,
+    NULL,NULL);
+  (void)WritePrivateProfileStringAsync("Gone",NULL,NULL,file_name,
+    NULL,NULL);
+  (void)WritePrivateProfileStringAsync("Gone","Key","2",file_name,
+    NULL,NULL);
+  profile_async_flush();
+  assert(profile_async_pending() == 0);
+  TestGet("Gone","Key","2",file_name);
+
+  /* delete a key */
+  (void)WritePrivateProfileStringAsync("Async","Other",NULL,file_name,
+    NULL,NULL);
+  /* all NULL flushes */
+  ticket = WritePrivateProfileStringAsync(NULL,NULL,NULL,file_name,
+    NULL,NULL);
+  assert(ticket == 0);
+  TestGet("Async","Other",NULL,file_name);
+
+  profile_async_cleanup();
+
+  /* without a writer thread the write goes straight through */
+  Callback_Count = 0;
+  ticket = WritePrivateProfileStringAsync("Async","Counter","sync",
+    file_name,test_callback,NULL);
+  assert(ticket == 0);
+  assert(Callback_Count == 1);
+  TestGet("Async","Counter","sync",file_name);
+}
+
+/**
+* Unit Tests for queued reads
+*/
+static void test_ProfileAsyncRead(void)
+{
+  const char *file_name = "test_async2.ini";
+  static char buffers[200][16];
+  char value[16] = "";
+  unsigned i;
+
+  remove(file_name);
+  assert(profile_async_init());
+  Read_Count = 0;
+  Read_Chars = 0;
+  /* each read sees the writes queued before it */
+  for (i = 0; i < 100; i++)
+  {
+    sprintf(value,"%u",i);
+    (void)WritePrivateProfileStringAsync("Read",value,value,file_name,
+      NULL,NULL);
+    assert(GetPrivateProfileStringAsync("Read",value,"missing",
+      buffers[i],sizeof(buffers[i]),file_name,test_read_callback,NULL));
+  }
+  /* and many at once */
+  for (i = 100; i < 200; i++)
+  {
+    sprintf(value,"%u",i % 100);
+    assert(GetPrivateProfileStringAsync("read",value,"missing",
+      buffers[i],sizeof(buffers[i]),file_name,test_read_callback,NULL));
+  }
+  profile_async_drain();
+  assert(profile_async_reads_pending() == 0);
+  assert(Read_Count == 200);
+  for (i = 0; i < 200; i++)
+  {
+    sprintf(value,"%u",i % 100);
+    assert(strcmp(buffers[i],value) == 0);
+  }
+  /* 10 one digit and 90 two digit values, twice */
+  assert(Read_Chars == 2 * (10 + 90 * 2));
+  assert(GetPrivateProfileStringAsync("Read","none","missing",
+    buffers[0],sizeof(buffers[0]),file_name,test_read_callback,NULL));
+  assert(!GetPrivateProfileStringAsync("Read","none","missing",
+    buffers[0],sizeof(buffers[0]),file_name,NULL,NULL));
+  profile_async_cleanup();
+  assert(Read_Count == 201);
+  assert(strcmp(buffers[0],"missing") == 0);
+
+  /* without the readers the read is done before returning */
+  assert(GetPrivateProfileStringAsync("Read","7",NULL,
+    buffers[0],sizeof(buffers[0]),file_name,test_read_callback,NULL));
+  assert(Read_Count == 202);
+  assert(strcmp(buffers[0],"7") == 0);
+  remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileAsync();
+  test_ProfileAsyncRead();
+
+  return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file
+ * @brief Test file for the C++20 coroutine wrappers of the async module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "profile.h"
+#include "profile_async.hpp"
+
+/* a coroutine that starts at once and frees itself when it ends */
+struct task
+{
+  struct promise_type
+  {
+    task get_return_object() noexcept
+    {
+      return task();
+    }
+
+    std::suspend_never initial_suspend() noexcept
+    {
+      return {};
+    }
+
+    std::suspend_never final_suspend() noexcept
+    {
+      return {};
+    }
+
+    void return_void() noexcept
+    {
+    }
+
+    void unhandled_exception() noexcept
+    {
+      std::terminate();
+    }
+  };
+};
+
+/* the loop of the test: coroutines posted to it resume on main */
+static std::mutex Loop_Lock;
+static std::deque<std::coroutine_handle<>> Loop_Queue;
+
+/* the scheduler that posts to the loop */
+struct post_to_loop
+{
+  void operator()(std::coroutine_handle<> handle) const
+  {
+    std::lock_guard<std::mutex> lock(Loop_Lock);
+
+    Loop_Queue.push_back(handle);
+  }
+};
+
+/**
+* Resume what was posted to the loop until a count is reached
+*
+* @param done - count of finished coroutines
+* @param expected - count to reach
+*/
+static void TestRunLoop(
+  const std::atomic<unsigned> &done,
+  unsigned expected)
+{
+  std::coroutine_handle<> handle;
+
+  while (done.load() < expected)
+  {
+    {
+      std::lock_guard<std::mutex> lock(Loop_Lock);
+
+      if (Loop_Queue.empty())
+        handle = nullptr;
+      else
+      {
+        handle = Loop_Queue.front();
+        Loop_Queue.pop_front();
+      }
+    }
+    if (handle)
+      handle.resume();
+    else
+      std::this_thread::yield();
+  }
+}
+
+static std::atomic<unsigned> Done;
+static std::atomic<unsigned> Failed;
+
+/**
+* Write a key, then read it back, resuming on the loop each time
+*
+* @param file - initialization filename
+* @param index - key number
+*/
+static task TestWriteRead(
+  const char *file,
+  unsigned index)
+{
+  std::thread::id loop = std::this_thread::get_id();
+  std::string key = "Key" + std::to_string(index);
+  std::string value = std::to_string(index * 3);
+  char buffer[32];
+
+  bool written = co_await profile::write_async("Coroutine", key.c_str(),
+    value.c_str(), file, post_to_loop());
+  if (!written || (std::this_thread::get_id() != loop))
+    Failed++;
+  std::string_view result = co_await profile::get_async("coroutine",
+    key.c_str(), "missing", buffer, file, post_to_loop());
+  if ((result != value) || (std::this_thread::get_id() != loop))
+    Failed++;
+  Done++;
+}
+
+/**
+* Unit Tests for many coroutines in flight, resumed on a loop
+*/
+static void test_ProfileAsyncLoop(void)
+{
+  const char *file_name = "test_async_hpp1.ini";
+  unsigned i;
+
+  std::remove(file_name);
+  Done = 0;
+  Failed = 0;
+  assert(profile_async_init());
+  for (i = 0; i < 50; i++)
+    TestWriteRead(file_name, i);
+  TestRunLoop(Done, 50);
+  assert(Failed == 0);
+  profile_async_cleanup();
+  std::remove(file_name);
+}
+
+/**
+* Read a key, resuming on whichever thread completes the read
+*
+* @param file - initialization filename
+* @param result - receives the value
+*/
+static task TestRead(
+  const char *file,
+  std::string &result)
+{
+  char buffer[32];
+
+  result = co_await profile::get_async("Section", "Key", "missing", buffer,
+    sizeof(buffer), file);
+  Done++;
+}
+
+/**
+* Unit Tests for the default scheduler, and for the C functions
+* completing before the coroutine suspends
+*/
+static void test_ProfileAsyncInline(void)
+{
+  const char *file_name = "test_async_hpp2.ini";
+  std::string result;
+
+  std::remove(file_name);
+  assert(WritePrivateProfileString("Section", "Key", "Value", file_name));
+  Done = 0;
+  /* on a reader thread */
+  assert(profile_async_init());
+  TestRead(file_name, result);
+  profile_async_drain();
+  assert(Done == 1);
+  assert(result == "Value");
+  profile_async_cleanup();
+  /* without the readers the coroutine never suspends */
+  result.clear();
+  TestRead(file_name, result);
+  assert(Done == 2);
+  assert(result == "Value");
+  std::remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileAsyncLoop();
+  test_ProfileAsyncInline();
+
+  return 0;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file
+ * @brief Test file for the parsed INI file cache module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+/**
+* Unit Tests for the cache
+*/
+static void test_ProfileCache(void)
+{
+  const char *file_name = "test_cache.ini";
+  PROFILE_IO_STAT file_stat;
+  PROFILE_DOC *pDoc = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+
+  remove(file_name);
+  profile_cache_clear();
+  assert(profile_cache_count() == 0);
+  /* no file - the default, and nothing cached */
+  count = GetPrivateProfileStringCached("MySection1", "MyKey1", "none",
+    return_name, sizeof(return_name), file_name);
+  assert(count == 4);
+  assert(strcmp(return_name, "none") == 0);
+  assert(!profile_cache_contains(file_name));
+  assert(!profile_cache_load(file_name));
+  assert(WritePrivateProfileString("MySection1", "MyKey1", "MyKey1Value",
+    file_name));
+  assert(WritePrivateProfileString("MySection1", "MyKey2",
+    "\"MyKey2 Value\"", file_name));
+  /* the first lookup reads the file into the cache */
+  count = GetPrivateProfileStringCached("mysection1", "mykey1", "",
+    return_name, sizeof(return_name), file_name);
+  assert(count == strlen("MyKey1Value"));
+  assert(strcmp(return_name, "MyKey1Value") == 0);
+  assert(profile_cache_contains(file_name));
+  assert(profile_cache_count() == 1);
+  count = GetPrivateProfileStringCached("MySection1", "MyKey2", "",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "MyKey2 Value") == 0);
+  count = GetPrivateProfileStringCached("MySection1", "MyKey3", "x",
+    return_name, sizeof(return_name), file_name);
+  assert(count == 1);
+  assert(strcmp(return_name, "x") == 0);
+  /* a changed file is read again */
+  assert(WritePrivateProfileString("MySection1", "MyKey1", "Changed Value",
+    file_name));
+  count = GetPrivateProfileStringCached("MySection1", "MyKey1", "",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "Changed Value") == 0);
+  assert(profile_cache_count() == 1);
+  /* a document inserted by hand answers until the file changes */
+  pDoc = profile_doc_load_buffer("[MySection1]\nMyKey1=Inserted\n", 29);
+  assert(pDoc);
+  assert(profile_io_stat(profile_io_posix(), file_name, &file_stat));
+  assert(profile_cache_insert(file_name, pDoc, &file_stat));
+  assert(profile_cache_count() == 1);
+  count = GetPrivateProfileStringCached("MySection1", "MyKey1", "",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "Inserted") == 0);
+  profile_cache_invalidate(file_name);
+  assert(!profile_cache_contains(file_name));
+  count = GetPrivateProfileStringCached("MySection1", "MyKey1", "",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "Changed Value") == 0);
+  /* a removed file is dropped */
+  remove(file_name);
+  count = GetPrivateProfileStringCached("MySection1", "MyKey1", "gone",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "gone") == 0);
+  assert(!profile_cache_contains(file_name));
+  assert(profile_cache_count() == 0);
+  profile_cache_clear();
+}
+
+/* number of files the budget test spreads over */
+#define BUDGET_FILES 32
+
+/**
+* Name of one of the files of the budget test
+*
+* @param index - which file
+* @param file_name - receives the name
+* @param size - size of file_name
+*/
+static void TestBudgetName(
+  unsigned index,
+  char *file_name,
+  size_t size)
+{
+  snprintf(file_name, size, "test_cache_budget%u.ini", index);
+}
+
+/**
+* Look up the key of one of the files of the budget test
+*
+* @param index - which file
+*/
+static void TestBudgetGet(
+  unsigned index)
+{
+  char file_name[64] = {""};
+  char expected[32] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+
+  TestBudgetName(index, file_name, sizeof(file_name));
+  snprintf(expected, sizeof(expected), "Value%u", index);
+  GetPrivateProfileStringCached("Device", "Name", "", return_name,
+    sizeof(return_name), file_name);
+  assert(strcmp(return_name, expected) == 0);
+}
+
+/**
+* Unit Tests for the memory budget, pinned handles, and statistics
+*/
+static void test_ProfileCacheBudget(void)
+{
+  PROFILE_CACHE_STATS stats;
+  PROFILE_CACHE_HANDLE *pHandle = NULL;
+  PROFILE_CACHE_HANDLE *pOther = NULL;
+  char file_name[64] = {""};
+  char value[32] = {""};
+  size_t file_bytes = 0;
+  unsigned i = 0;
+  unsigned round = 0;
+
+  profile_cache_clear();
+  profile_cache_set_budget(0);
+  profile_cache_reset_stats();
+  for (i = 0; i < BUDGET_FILES; i++)
+  {
+    TestBudgetName(i, file_name, sizeof(file_name));
+    snprintf(value, sizeof(value), "Value%u", i);
+    remove(file_name);
+    assert(WritePrivateProfileString("Device", "Name", value, file_name));
+  }
+  /* with no budget every file stays */
+  for (i = 0; i < BUDGET_FILES; i++)
+    TestBudgetGet(i);
+  profile_cache_stats(&stats);
+  assert(stats.count == BUDGET_FILES);
+  assert(stats.misses == BUDGET_FILES);
+  assert(stats.hits == 0);
+  assert(stats.evictions == 0);
+  assert(stats.budget == 0);
+  assert(stats.bytes > 0);
+  file_bytes = stats.bytes / BUDGET_FILES;
+  for (i = 0; i < BUDGET_FILES; i++)
+    TestBudgetGet(i);
+  profile_cache_stats(&stats);
+  assert(stats.hits == BUDGET_FILES);
+  /* a budget for about a quarter of them evicts the rest at once */
+  profile_cache_set_budget(file_bytes * BUDGET_FILES / 4);
+  profile_cache_stats(&stats);
+  assert(stats.bytes <= stats.budget);
+  assert(stats.count < BUDGET_FILES / 2);
+  assert(stats.count + stats.evictions == BUDGET_FILES);
+  /* a file that is used often stays while the others come and go */
+  profile_cache_reset_stats();
+  for (round = 0; round < 4; round++)
+  {
+    for (i = 1; i < BUDGET_FILES; i++)
+    {
+      TestBudgetGet(0);
+      TestBudgetGet(i);
+      profile_cache_stats(&stats);
+      assert(stats.bytes <= stats.budget);
+    }
+  }
+  profile_cache_stats(&stats);
+  assert(stats.evictions > 0);
+  /* of its lookups, only the first could miss */
+  assert(stats.misses <= 4 * (BUDGET_FILES - 1) + 1);
+  assert(stats.hits >= 4 * (BUDGET_FILES - 1) - 1);
+  TestBudgetName(0, file_name, sizeof(file_name));
+  assert(profile_cache_contains(file_name));
+  /* a pinned file is not evicted, and keeps its document */
+  TestBudgetName(1, file_name, sizeof(file_name));
+  pHandle = profile_cache_open(file_name);
+  assert(pHandle);
+  assert(strcmp(profile_doc_value(profile_cache_doc(pHandle), "Device",
+    "Name"), "Value1") == 0);
+  profile_cache_stats(&stats);
+  assert(stats.pinned == 1);
+  for (i = 2; i < BUDGET_FILES; i++)
+    TestBudgetGet(i);
+  assert(profile_cache_contains(file_name));
+  /* two handles on the same file pin it once */
+  pOther = profile_cache_open(file_name);
+  assert(pOther == pHandle);
+  profile_cache_stats(&stats);
+  assert(stats.pinned == 1);
+  profile_cache_close(pOther);
+  /* a pinned file that changes is read again for new lookups, and
+     the handle keeps the document it had */
+  assert(WritePrivateProfileString("Device", "Name", "Changed Value1",
+    file_name));
+  pOther = profile_cache_open(file_name);
+  assert(pOther && (pOther != pHandle));
+  assert(strcmp(profile_doc_value(profile_cache_doc(pOther), "Device",
+    "Name"), "Changed Value1") == 0);
+  assert(strcmp(profile_doc_value(profile_cache_doc(pHandle), "Device",
+    "Name"), "Value1") == 0);
+  profile_cache_close(pHandle);
+  /* so does a pinned file that is invalidated or cleared */
+  profile_cache_invalidate(file_name);
+  assert(!profile_cache_contains(file_name));
+  assert(strcmp(profile_doc_value(profile_cache_doc(pOther), "Device",
+    "Name"), "Changed Value1") == 0);
+  profile_cache_stats(&stats);
+  assert(stats.pinned == 0);
+  profile_cache_close(pOther);
+  TestBudgetName(2, file_name, sizeof(file_name));
+  pHandle = profile_cache_open(file_name);
+  assert(pHandle);
+  profile_cache_clear();
+  assert(profile_cache_count() == 0);
+  assert(strcmp(profile_doc_value(profile_cache_doc(pHandle), "Device",
+    "Name"), "Value2") == 0);
+  profile_cache_close(pHandle);
+  /* no file - no handle */
+  assert(!profile_cache_open("test_cache_missing.ini"));
+  /* a file larger than the budget is still cached while it is used */
+  profile_cache_set_budget(1);
+  TestBudgetGet(3);
+  TestBudgetName(3, file_name, sizeof(file_name));
+  assert(profile_cache_contains(file_name));
+  TestBudgetGet(4);
+  assert(!profile_cache_contains(file_name));
+  assert(profile_cache_count() == 1);
+  profile_cache_set_budget(0);
+  profile_cache_clear();
+  for (i = 0; i < BUDGET_FILES; i++)
+  {
+    TestBudgetName(i, file_name, sizeof(file_name));
+    remove(file_name);
+  }
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileCache();
+  test_ProfileCacheBudget();
+
+  return 0;
+}
@@ -0,0 +1,526 @@
+/**
+ * @file
+ * @brief Test file for the INI lookup daemon and its client
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "profile.h"
+#include "profile_client.h"
+#include "profile_daemon.h"
+#include "profile_io.h"
+
+#define SOCKET_NAME "test_daemon.sock"
+#define FILE_NAME "test_daemon.ini"
+#define EXPECTED_NAME "test_daemon_expected.ini"
+#define OTHER_NAME "test_daemon_other.sock"
+/* more lookups of the largest size than fit in one answer */
+#define LARGE_COUNT \
+  (2 * PROFILE_DAEMON_MAX_MESSAGE / PROFILE_DAEMON_MAX_SIZE + 1)
+/* requests sent at once, with more answers than the daemon holds */
+#define PIPELINE_COUNT \
+  (2 * PROFILE_DAEMON_MAX_MESSAGE / PROFILE_DAEMON_MAX_SIZE + 8)
+/* more changes of a long value than fit in one request */
+#define CHANGE_COUNT (2 * PROFILE_DAEMON_MAX_MESSAGE / 200)
+
+/* the same changes are made through the daemon and directly */
+static const char *Writes[][3] = {
+  {"MySection1","MyKey1","MyKey1Value"},
+  {"MySection1","MyKey2","\"MyKey2 Value\""},
+  {"MySection2","MyKey3","MyKey3Value"},
+  {"mysection1","mykey1","Changed"},
+  {"MySection3","MyKey5","MyKey5Value"},
+  {"MySection2","MyKey3",NULL},
+  {"MySection3",NULL,NULL},
+  {"MySection4","MyKey6",""}
+};
+
+/* sections written by clients at the same time */
+static const char *Writers[] = {"Writer1","Writer2"};
+
+/* lookups made through the daemon and directly */
+static const char *Names[][2] = {
+  {"MySection1","MyKey1"},
+  {"MYSECTION1","mykey2"},
+  {"MySection1",NULL},
+  {"MySection2","MyKey3"},
+  {"MySection3","MyKey5"},
+  {"MySection4","MyKey6"},
+  {"Missing","MyKey1"},
+  {"Missing",NULL},
+  {NULL,NULL}
+};
+
+/**
+* Run a daemon until it is stopped
+*
+* @param pArg - daemon
+*
+* @return NULL
+*/
+static void *TestDaemonThread(
+  void *pArg)
+{
+  assert(profile_daemon_run((PROFILE_DAEMON *)pArg));
+
+  return (NULL);
+}
+
+/**
+* Check the answers of the daemon against GetPrivateProfileString
+*
+* @param pClient - connection to the daemon
+*/
+static void TestSameAnswers(
+  PROFILE_CLIENT *pClient)
+{
+  PROFILE_REQUEST request[sizeof(Names) / sizeof(Names[0])];
+  char batch[sizeof(Names) / sizeof(Names[0])][MAX_LINE_LEN];
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t size = 0;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(Names) / sizeof(Names[0]); i++)
+  {
+    for (size = 2; size < 24; size++)
+    {
+      /* a truncated list skips a character in the file version */
+      memset(return_name, 0, sizeof(return_name));
+      memset(expected, 0, sizeof(expected));
+      count = GetPrivateProfileStringClient(pClient, Names[i][0],
+        Names[i][1], "default", return_name, size, FILE_NAME);
+      assert(count == GetPrivateProfileString(Names[i][0], Names[i][1],
+        "default", expected, size, FILE_NAME));
+      assert(memcmp(return_name, expected, count + 1) == 0);
+    }
+    /* a buffer too small for anything */
+    assert(GetPrivateProfileStringClient(pClient, Names[i][0], Names[i][1],
+      "default", return_name, 1, FILE_NAME) == 0);
+    assert(return_name[0] == '\0');
+    request[i].pAppName = Names[i][0];
+    request[i].pKeyName = Names[i][1];
+    request[i].pDefault = "default";
+    request[i].pReturnedString = batch[i];
+    request[i].nSize = sizeof(batch[i]);
+  }
+  assert(profile_client_get_batch(pClient, request,
+    sizeof(Names) / sizeof(Names[0]), FILE_NAME));
+  for (i = 0; i < sizeof(Names) / sizeof(Names[0]); i++)
+  {
+    count = GetPrivateProfileString(Names[i][0], Names[i][1], "default",
+      expected, sizeof(expected), FILE_NAME);
+    assert(request[i].count == count);
+    assert(memcmp(batch[i], expected, count + 1) == 0);
+  }
+}
+
+/**
+* Compare the file written through the daemon with the expected file
+*/
+static void TestSameFile(void)
+{
+  char *pBuffer = NULL;
+  char *pExpected = NULL;
+  size_t len = 0;
+  size_t expected_len = 0;
+
+  pBuffer = profile_io_read(profile_io_stdio(), FILE_NAME, &len);
+  pExpected = profile_io_read(profile_io_stdio(), EXPECTED_NAME,
+    &expected_len);
+  assert(pBuffer && pExpected);
+  assert(len == expected_len);
+  assert(memcmp(pBuffer, pExpected, len) == 0);
+  free(pBuffer);
+  free(pExpected);
+}
+
+/**
+* Write many keys through one client
+*
+* @param pArg - name of the section to write, in Writers
+*
+* @return NULL
+*/
+static void *TestWriterThread(
+  void *pArg)
+{
+  PROFILE_CLIENT *pClient = NULL;
+  char key_name[32] = {""};
+  unsigned i = 0;
+
+  pClient = profile_client_connect(SOCKET_NAME);
+  assert(pClient);
+  for (i = 0; i < 200; i++)
+  {
+    sprintf(key_name, "Key%u", i);
+    assert(WritePrivateProfileStringClient(pClient, *(const char **)pArg,
+      key_name, "value", FILE_NAME));
+  }
+  profile_client_close(pClient);
+
+  return (NULL);
+}
+
+/**
+* Unit Tests for the daemon and its client
+*/
+static void test_ProfileDaemon(void)
+{
+  PROFILE_DAEMON *pDaemon = NULL;
+  PROFILE_CLIENT *pClient = NULL;
+  PROFILE_CLIENT_WRITE changes[3];
+  PROFILE_REQUEST request;
+  PROFILE_REQUEST *pLarge = NULL;
+  pthread_t daemon_thread;
+  pthread_t writer_thread[2];
+  char return_name[MAX_LINE_LEN] = {""};
+  char key_name[32] = {""};
+  size_t i = 0;
+
+  remove(FILE_NAME);
+  remove(EXPECTED_NAME);
+  /* no daemon */
+  assert(profile_client_connect(SOCKET_NAME) == NULL);
+  pDaemon = profile_daemon_create(SOCKET_NAME);
+  assert(pDaemon);
+  /* one daemon per socket */
+  assert(profile_daemon_create(SOCKET_NAME) == NULL);
+  assert(profile_daemon_add_file(pDaemon, FILE_NAME));
+  assert(pthread_create(&daemon_thread, NULL, TestDaemonThread,
+    pDaemon) == 0);
+  pClient = profile_client_connect(SOCKET_NAME);
+  assert(pClient);
+  /* no file yet */
+  TestSameAnswers(pClient);
+  for (i = 0; i < sizeof(Writes) / sizeof(Writes[0]); i++)
+  {
+    assert(WritePrivateProfileStringClient(pClient, Writes[i][0],
+      Writes[i][1], Writes[i][2], FILE_NAME) ==
+      WritePrivateProfileString(Writes[i][0], Writes[i][1], Writes[i][2],
+      EXPECTED_NAME));
+    TestSameFile();
+    TestSameAnswers(pClient);
+  }
+  /* several changes in one round trip */
+  changes[0].pAppName = "Batch";
+  changes[0].pKeyName = "Key1";
+  changes[0].pString = "one";
+  changes[1].pAppName = "Batch";
+  changes[1].pKeyName = "Key2";
+  changes[1].pString = "two";
+  changes[2].pAppName = "Missing";
+  changes[2].pKeyName = "Key1";
+  changes[2].pString = NULL;
+  assert(WritePrivateProfileString("Batch", "Key1", "one", EXPECTED_NAME));
+  assert(WritePrivateProfileString("Batch", "Key2", "two", EXPECTED_NAME));
+  assert(profile_client_set_batch(pClient, changes, 3, FILE_NAME) ==
+    (size_t)(1 + 1 + WritePrivateProfileString("Missing", "Key1", NULL,
+    EXPECTED_NAME)));
+  assert(changes[0].status && changes[1].status);
+  TestSameFile();
+  /* a batch larger than one message takes several round trips */
+  pLarge = calloc(LARGE_COUNT, sizeof(PROFILE_REQUEST));
+  assert(pLarge);
+  for (i = 0; i < LARGE_COUNT; i++)
+  {
+    pLarge[i].pAppName = "Batch";
+    pLarge[i].pKeyName = (i % 2) ? "Key2" : "Key1";
+    pLarge[i].pDefault = "";
+    pLarge[i].nSize = PROFILE_DAEMON_MAX_SIZE;
+    pLarge[i].pReturnedString = malloc(pLarge[i].nSize);
+    assert(pLarge[i].pReturnedString);
+  }
+  assert(profile_client_get_batch(pClient, pLarge, LARGE_COUNT, FILE_NAME));
+  for (i = 0; i < LARGE_COUNT; i++)
+  {
+    assert(pLarge[i].count == 3);
+    assert(strcmp(pLarge[i].pReturnedString, (i % 2) ? "two" : "one") == 0);
+    free(pLarge[i].pReturnedString);
+  }
+  free(pLarge);
+  /* files that were not added are not served */
+  assert(GetPrivateProfileStringClient(pClient, "MySection1", "MyKey1",
+    "none", return_name, sizeof(return_name), EXPECTED_NAME) == 4);
+  assert(strcmp(return_name, "none") == 0);
+  assert(!WritePrivateProfileStringClient(pClient, "MySection1", "MyKey1",
+    "x", EXPECTED_NAME));
+  request.pAppName = "MySection1";
+  request.pKeyName = "MyKey1";
+  request.pDefault = "none";
+  request.pReturnedString = return_name;
+  request.nSize = sizeof(return_name);
+  assert(!profile_client_get_batch(pClient, &request, 1, EXPECTED_NAME));
+  assert(request.count == 4);
+  /* writes from many clients are made one at a time */
+  assert(pthread_create(&writer_thread[0], NULL, TestWriterThread,
+    &Writers[0]) == 0);
+  assert(pthread_create(&writer_thread[1], NULL, TestWriterThread,
+    &Writers[1]) == 0);
+  pthread_join(writer_thread[0], NULL);
+  pthread_join(writer_thread[1], NULL);
+  for (i = 0; i < 200; i++)
+  {
+    sprintf(key_name, "Key%u", (unsigned)i);
+    assert(GetPrivateProfileStringClient(pClient, "Writer1", key_name, "",
+      return_name, sizeof(return_name), FILE_NAME) == 5);
+    assert(GetPrivateProfileString("Writer2", key_name, "", return_name,
+      sizeof(return_name), FILE_NAME) == 5);
+  }
+  profile_daemon_stop(pDaemon);
+  pthread_join(daemon_thread, NULL);
+  profile_daemon_free(pDaemon);
+  /* the daemon is gone: the default, and no writes */
+  assert(GetPrivateProfileStringClient(pClient, "MySection1", "MyKey1",
+    "none", return_name, sizeof(return_name), FILE_NAME) == 4);
+  assert(strcmp(return_name, "none") == 0);
+  assert(!WritePrivateProfileStringClient(pClient, "MySection1", "MyKey1",
+    "x", FILE_NAME));
+  /* and the client finds the next one */
+  pDaemon = profile_daemon_create(SOCKET_NAME);
+  assert(pDaemon);
+  assert(profile_daemon_add_file(pDaemon, FILE_NAME));
+  assert(pthread_create(&daemon_thread, NULL, TestDaemonThread,
+    pDaemon) == 0);
+  assert(GetPrivateProfileStringClient(pClient, "MySection1", "MyKey1",
+    "none", return_name, sizeof(return_name), FILE_NAME) == 7);
+  assert(strcmp(return_name, "Changed") == 0);
+  profile_client_close(pClient);
+  profile_daemon_stop(pDaemon);
+  pthread_join(daemon_thread, NULL);
+  profile_daemon_free(pDaemon);
+  assert(profile_client_connect(SOCKET_NAME) == NULL);
+  remove(FILE_NAME);
+  remove(EXPECTED_NAME);
+}
+
+/**
+* Unit Tests for a batch that fails after some of its requests,
+* and for a socket path that holds something else
+*/
+static void test_ProfileDaemonPartial(void)
+{
+  PROFILE_DAEMON *pDaemon = NULL;
+  PROFILE_CLIENT *pClient = NULL;
+  PROFILE_CLIENT_WRITE *pChanges = NULL;
+  PROFILE_REQUEST requests[3];
+  pthread_t daemon_thread;
+  char value[201] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  char buffers[3][MAX_LINE_LEN];
+  char *pHuge = NULL;
+  FILE *pFile = NULL;
+  size_t i = 0;
+
+  remove(FILE_NAME);
+  pDaemon = profile_daemon_create(SOCKET_NAME);
+  assert(pDaemon);
+  assert(profile_daemon_add_file(pDaemon, FILE_NAME));
+  assert(pthread_create(&daemon_thread, NULL, TestDaemonThread,
+    pDaemon) == 0);
+  pClient = profile_client_connect(SOCKET_NAME);
+  assert(pClient);
+  /* too large for any request, so it and what follows are not sent */
+  pHuge = malloc(PROFILE_DAEMON_MAX_MESSAGE + 1);
+  assert(pHuge);
+  memset(pHuge, 'x', PROFILE_DAEMON_MAX_MESSAGE);
+  pHuge[PROFILE_DAEMON_MAX_MESSAGE] = '\0';
+  memset(value, 'v', sizeof(value) - 1);
+  pChanges = calloc(CHANGE_COUNT + 2, sizeof(PROFILE_CLIENT_WRITE));
+  assert(pChanges);
+  for (i = 0; i < CHANGE_COUNT; i++)
+  {
+    pChanges[i].pAppName = "Partial";
+    pChanges[i].pKeyName = "Key";
+    pChanges[i].pString = (i + 1 < CHANGE_COUNT) ? value : "last";
+  }
+  pChanges[CHANGE_COUNT].pAppName = "Partial";
+  pChanges[CHANGE_COUNT].pKeyName = "Huge";
+  pChanges[CHANGE_COUNT].pString = pHuge;
+  pChanges[CHANGE_COUNT + 1].pAppName = "Partial";
+  pChanges[CHANGE_COUNT + 1].pKeyName = "After";
+  pChanges[CHANGE_COUNT + 1].pString = "after";
+  assert(profile_client_set_batch(pClient, pChanges, CHANGE_COUNT + 2,
+    FILE_NAME) == CHANGE_COUNT);
+  for (i = 0; i < CHANGE_COUNT; i++)
+    assert(pChanges[i].status);
+  assert(!pChanges[CHANGE_COUNT].status);
+  assert(!pChanges[CHANGE_COUNT + 1].status);
+  assert(GetPrivateProfileString("Partial", "Key", "", return_name,
+    sizeof(return_name), FILE_NAME) == 4);
+  assert(GetPrivateProfileString("Partial", "After", "", return_name,
+    sizeof(return_name), FILE_NAME) == 0);
+  /* lookups after the one that cannot be sent get their defaults */
+  for (i = 0; i < 3; i++)
+  {
+    requests[i].pAppName = "Partial";
+    requests[i].pKeyName = "Key";
+    requests[i].pDefault = (i == 1) ? pHuge : "default";
+    requests[i].pReturnedString = buffers[i];
+    requests[i].nSize = sizeof(buffers[i]);
+  }
+  assert(!profile_client_get_batch(pClient, requests, 3, FILE_NAME));
+  assert((requests[0].count == 4) && (strcmp(buffers[0], "last") == 0));
+  assert(requests[1].count == sizeof(buffers[1]) - 1);
+  assert((requests[2].count == 7) && (strcmp(buffers[2], "default") == 0));
+  free(pChanges);
+  free(pHuge);
+  profile_client_close(pClient);
+  profile_daemon_stop(pDaemon);
+  pthread_join(daemon_thread, NULL);
+  profile_daemon_free(pDaemon);
+
+  /* a file at the path of the socket is not removed */
+  pFile = fopen(OTHER_NAME, "w");
+  assert(pFile);
+  fclose(pFile);
+  assert(profile_daemon_create(OTHER_NAME) == NULL);
+  pFile = fopen(OTHER_NAME, "r");
+  assert(pFile);
+  fclose(pFile);
+  remove(OTHER_NAME);
+  remove(FILE_NAME);
+}
+
+/**
+* Copy a string into a request, the way the client does
+*
+* @param ppData - next byte of the request, moved forward
+* @param pString - string
+*/
+static void TestPutString(
+  unsigned char **ppData,
+  const char *pString)
+{
+  uint32_t len = (uint32_t)strlen(pString);
+
+  memcpy(*ppData, &len, sizeof(len));
+  memcpy(*ppData + sizeof(len), pString, len + 1);
+  *ppData += sizeof(len) + len + 1;
+}
+
+/**
+* Receive all of a number of bytes
+*
+* @param fd - socket
+* @param pData - receives the bytes
+* @param nLength - number of bytes
+*/
+static void TestReceive(
+  int fd,
+  unsigned char *pData,
+  size_t nLength)
+{
+  ssize_t received = 0;
+
+  while (nLength)
+  {
+    received = recv(fd, pData, nLength, 0);
+    assert(received > 0);
+    pData += received;
+    nLength -= (size_t)received;
+  }
+}
+
+/**
+* Unit Tests for a client that sends many requests before it reads
+* any answers
+*/
+static void test_ProfileDaemonPipeline(void)
+{
+  PROFILE_DAEMON *pDaemon = NULL;
+  struct sockaddr_un addr;
+  pthread_t daemon_thread;
+  unsigned char request[128];
+  unsigned char *pData = NULL;
+  unsigned char *pAnswer = NULL;
+  char *pLong = NULL;
+  uint32_t length = 0;
+  uint32_t value = 0;
+  size_t i = 0;
+  int fd = -1;
+
+  /* answers long enough that they cannot all be held at once */
+  pLong = malloc(PROFILE_DAEMON_MAX_SIZE);
+  assert(pLong);
+  memset(pLong, 'v', PROFILE_DAEMON_MAX_SIZE - 1);
+  pLong[PROFILE_DAEMON_MAX_SIZE - 1] = '\0';
+  remove(FILE_NAME);
+  assert(WritePrivateProfileString("Pipe", "Key", pLong, FILE_NAME));
+  pDaemon = profile_daemon_create(SOCKET_NAME);
+  assert(pDaemon);
+  assert(profile_daemon_add_file(pDaemon, FILE_NAME));
+  assert(pthread_create(&daemon_thread, NULL, TestDaemonThread,
+    pDaemon) == 0);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  assert(fd >= 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, SOCKET_NAME);
+  assert(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+  /* one lookup of the largest size per request */
+  pData = request + sizeof(uint32_t);
+  value = 1;
+  memcpy(pData, &value, sizeof(value));
+  pData += sizeof(value);
+  *pData++ = PROFILE_DAEMON_GET;
+  TestPutString(&pData, FILE_NAME);
+  TestPutString(&pData, "Pipe");
+  TestPutString(&pData, "Key");
+  TestPutString(&pData, "none");
+  value = PROFILE_DAEMON_MAX_SIZE;
+  memcpy(pData, &value, sizeof(value));
+  pData += sizeof(value);
+  length = (uint32_t)(pData - request - sizeof(uint32_t));
+  memcpy(request, &length, sizeof(length));
+  for (i = 0; i < PIPELINE_COUNT; i++)
+    assert(send(fd, request, sizeof(length) + length, 0) ==
+      (ssize_t)(sizeof(length) + length));
+  /* every answer comes, in order, however many were held back */
+  pAnswer = malloc(PROFILE_DAEMON_MAX_MESSAGE);
+  assert(pAnswer);
+  for (i = 0; i < PIPELINE_COUNT; i++)
+  {
+    TestReceive(fd, (unsigned char *)&length, sizeof(length));
+    assert(length <= PROFILE_DAEMON_MAX_MESSAGE);
+    TestReceive(fd, pAnswer, length);
+    /* one operation, found, the value and its null */
+    assert(length == 4 + 1 + 4 + 4 + PROFILE_DAEMON_MAX_SIZE);
+    memcpy(&value, pAnswer + 5, sizeof(value));
+    assert(value == PROFILE_DAEMON_MAX_SIZE - 1);
+    assert(pAnswer[4] == 1);
+    assert(memcmp(pAnswer + 13, pLong, PROFILE_DAEMON_MAX_SIZE) == 0);
+  }
+  free(pAnswer);
+  free(pLong);
+  close(fd);
+  profile_daemon_stop(pDaemon);
+  pthread_join(daemon_thread, NULL);
+  profile_daemon_free(pDaemon);
+  remove(FILE_NAME);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileDaemon();
+  test_ProfileDaemonPartial();
+  test_ProfileDaemonPipeline();
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file
+ * @brief Test file for the compile-time tables of default values
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "profile.h"
+#include "profile_defaults.hpp"
+
+/* the same text, for the table and for GetPrivateProfileString */
+#define DEFAULTS_TEXT \
+  "; defaults for the device\n" \
+  "[Network]\n" \
+  "  Port = 47808  \n" \
+  "Name=\"BACnet Router\"\n" \
+  "Quoted = ' padded '\n" \
+  "Half=\"open\n" \
+  "Empty=\n" \
+  "Flag\n" \
+  "Equals=a=b\n" \
+  "port=99\n" \
+  "\t[Serial]\r\n" \
+  "Baud=9600\r\n" \
+  "\n" \
+  "[network]\n" \
+  "Hidden=1\n" \
+  "[Broken\n" \
+  "Lost=1\n" \
+  "[ Spaced ]\n" \
+  "Key=Value\n" \
+  "[Empty]\n"
+
+static constexpr const char Text[] = DEFAULTS_TEXT;
+
+constexpr auto &Defaults = profile::defaults<DEFAULTS_TEXT>;
+
+/* a lookup in a constant expression is folded */
+static_assert(Defaults.get("network", "PORT") == "47808");
+static_assert(Defaults.get("Network", "Name") == "BACnet Router");
+static_assert(Defaults.get("Network", "Missing", "none") == "none");
+static_assert(Defaults.size() == 9);
+static_assert(Defaults.section_count() == 4);
+static_assert(Defaults[0].key == "Port");
+static_assert(profile::defaults<"">.size() == 0);
+static_assert(profile::defaults<"">.get("A", "B", "x") == "x");
+
+/* the names looked up in both */
+static const char *Lookups[][2] = {
+  {"Network", "Port"},
+  {"NETWORK", "port"},
+  {"Network", "Name"},
+  {"Network", "Quoted"},
+  {"Network", "Half"},
+  {"Network", "Empty"},
+  {"Network", "Flag"},
+  {"Network", "Equals"},
+  {"Network", "Hidden"},
+  {"Network", "Missing"},
+  {"Serial", "Baud"},
+  {"Broken", "Lost"},
+  {"Spaced", "Key"},
+  {" Spaced ", "Key"},
+  {"Empty", "Key"},
+  {"Missing", "Key"}
+};
+
+/**
+* Unit Tests that the table reads the text as GetPrivateProfileString
+*/
+static void test_ProfileDefaults(void)
+{
+  char expected[MAX_LINE_LEN] = {""};
+  std::string_view value;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(Lookups) / sizeof(Lookups[0]); i++)
+  {
+    GetPrivateProfileStringFromBuffer(Lookups[i][0], Lookups[i][1], "none",
+      expected, sizeof(expected), Text, sizeof(Text) - 1);
+    value = Defaults.get(Lookups[i][0], Lookups[i][1], "none");
+    assert(value == expected);
+    /* values end with a null, for the C functions */
+    assert(value.data()[value.size()] == '\0');
+  }
+  assert(Defaults.contains("Network", "Flag"));
+  assert(Defaults[5].key == "Flag");
+  assert(!Defaults[5].has_value);
+  assert(Defaults[8].section == " Spaced ");
+  assert(Defaults[8].value == "Value");
+}
+
+/**
+* Unit Tests that the text itself is not in the program
+*
+* @param pProgram - file name of this program
+*/
+static void test_ProfileDefaultsImage(
+  const char *pProgram)
+{
+  constexpr auto &Comments = profile::defaults<
+    "; 2zqx7-comment-only\n[Section]\nKey=kept-in-table\n">;
+  std::string image;
+  std::string marker = "2zqx7-";
+  FILE *pFile = NULL;
+  char buffer[4096];
+  size_t count = 0;
+
+  assert(Comments.get("Section", "Key") == "kept-in-table");
+  pFile = std::fopen(pProgram, "rb");
+  assert(pFile);
+  while ((count = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    image.append(buffer, count);
+  std::fclose(pFile);
+  assert(image.find("kept-in-table") != std::string::npos);
+  marker += "comment-only";
+  assert(image.find(marker) == std::string::npos);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(int argc, char *argv[])
+{
+  (void)argc;
+  test_ProfileDefaults();
+  test_ProfileDefaultsImage(argv[0]);
+
+  return 0;
+}
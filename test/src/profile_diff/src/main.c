@@ -0,0 +1,287 @@
+/**
+ * @file
+ * @brief Test file for the INI file diff module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_diff.h"
+#include "profile_doc.h"
+
+/* changes that were reported, one per line */
+struct change_log
+{
+  char text[1024];
+};
+
+static const char Old_Text[] =
+  "[Device]\n"
+  "Name=Gateway\n"
+  "Mode=Auto\n"
+  "Flag\n"
+  "[Serial]\n"
+  "Baud=9600\n"
+  "Parity=None\n"
+  "[Retired]\n"
+  "Key1=One\n";
+
+static const char New_Text[] =
+  "[device]\n"
+  "NAME=Gateway\n"
+  "Mode=Manual\n"
+  "Flag=\n"
+  "Port=47808\n"
+  "[Serial]\n"
+  "Baud=9600\n"
+  "[Network]\n"
+  "Address=10.0.0.1\n";
+
+static const char Expected[] =
+  "- [Serial] Parity=None\n"
+  "- [Retired]\n"
+  "- [Retired] Key1=One\n"
+  "~ [device] Mode=Auto -> Manual\n"
+  "~ [device] Flag=(null) -> \n"
+  "+ [device] Port=47808\n"
+  "+ [Network]\n"
+  "+ [Network] Address=10.0.0.1\n";
+
+/**
+* Log a change as a line of text
+*
+* @param pChange - change
+* @param pContext - struct change_log
+*/
+static void TestLogChange(
+  const PROFILE_CHANGE *pChange,
+  void *pContext)
+{
+  struct change_log *pLog = pContext;
+  char line[MAX_LINE_LEN] = {""};
+  const char *pOld = pChange->pOldValue ? pChange->pOldValue : "(null)";
+
+  switch (pChange->type)
+  {
+    case PROFILE_DIFF_SECTION_ADDED:
+      snprintf(line, sizeof(line), "+ [%s]\n", pChange->pAppName);
+      break;
+    case PROFILE_DIFF_SECTION_REMOVED:
+      snprintf(line, sizeof(line), "- [%s]\n", pChange->pAppName);
+      break;
+    case PROFILE_DIFF_KEY_ADDED:
+      snprintf(line, sizeof(line), "+ [%s] %s=%s\n", pChange->pAppName,
+        pChange->pKeyName, pChange->pNewValue);
+      break;
+    case PROFILE_DIFF_KEY_REMOVED:
+      snprintf(line, sizeof(line), "- [%s] %s=%s\n", pChange->pAppName,
+        pChange->pKeyName, pOld);
+      break;
+    case PROFILE_DIFF_KEY_CHANGED:
+      snprintf(line, sizeof(line), "~ [%s] %s=%s -> %s\n",
+        pChange->pAppName, pChange->pKeyName, pOld, pChange->pNewValue);
+      break;
+    default:
+      assert(0);
+      break;
+  }
+  assert(strlen(pLog->text) + strlen(line) < sizeof(pLog->text));
+  strcat(pLog->text, line);
+}
+
+/* a subscriber that leaves when it is told of a change */
+struct leaving_subscriber
+{
+  PROFILE_WATCH *pWatch;
+  struct change_log *pOther; /* context of another one to remove, or NULL */
+  unsigned count;
+};
+
+/**
+* Count a change, then unsubscribe itself and maybe another subscriber
+*
+* @param pChange - change
+* @param pContext - struct leaving_subscriber
+*/
+static void TestLeaveChange(
+  const PROFILE_CHANGE *pChange,
+  void *pContext)
+{
+  struct leaving_subscriber *pLeaving = pContext;
+
+  (void)pChange;
+  pLeaving->count++;
+  profile_watch_unsubscribe(pLeaving->pWatch, TestLeaveChange, pLeaving);
+  if (pLeaving->pOther)
+    profile_watch_unsubscribe(pLeaving->pWatch, TestLogChange,
+      pLeaving->pOther);
+}
+
+/**
+* Unit Tests for the diff of two documents
+*/
+static void test_ProfileDiff(void)
+{
+  PROFILE_DOC *pOld = NULL;
+  PROFILE_DOC *pNew = NULL;
+  struct change_log log = {{0}};
+  size_t count = 0;
+
+  pOld = profile_doc_load_buffer(Old_Text, strlen(Old_Text));
+  pNew = profile_doc_load_buffer(New_Text, strlen(New_Text));
+  assert(pOld && pNew);
+  count = profile_diff(pOld, pNew, TestLogChange, &log);
+  assert(strcmp(log.text, Expected) == 0);
+  assert(count == 8);
+  /* a document is the same as itself, and names only changed case */
+  assert(profile_diff(pOld, pOld, TestLogChange, &log) == 0);
+  assert(profile_diff(pNew, pNew, NULL, NULL) == 0);
+  /* no file on either side */
+  log.text[0] = 0;
+  assert(profile_diff(NULL, pNew, TestLogChange, &log) == 9);
+  assert(strncmp(log.text, "+ [device]\n+ [device] NAME=Gateway\n", 35) == 0);
+  log.text[0] = 0;
+  assert(profile_diff(pOld, NULL, TestLogChange, &log) == 9);
+  assert(strncmp(log.text, "- [Device]\n- [Device] Name=Gateway\n", 35) == 0);
+  assert(profile_diff(NULL, NULL, NULL, NULL) == 0);
+  /* the other way round, everything is undone */
+  assert(profile_diff(pNew, pOld, NULL, NULL) == 8);
+  profile_doc_free(pOld);
+  profile_doc_free(pNew);
+}
+
+/**
+* Unit Tests for the diff of two files and for watching a file
+*/
+static void test_ProfileWatch(void)
+{
+  const char *file_name = "test_diff.ini";
+  const char *other_name = "test_diff_other.ini";
+  PROFILE_WATCH *pWatch = NULL;
+  struct change_log log = {{0}};
+  struct change_log other = {{0}};
+
+  remove(file_name);
+  remove(other_name);
+  assert(WritePrivateProfileString("Device", "Name", "Gateway", file_name));
+  assert(WritePrivateProfileString("Device", "Name", "Router",
+    other_name));
+  assert(profile_diff_files(file_name, other_name, TestLogChange, &log) ==
+    1);
+  assert(strcmp(log.text, "~ [Device] Name=Gateway -> Router\n") == 0);
+  assert(profile_diff_files(file_name, "test_diff_missing.ini", NULL,
+    NULL) == 2);
+  remove(other_name);
+  /* a watch reports nothing until the file changes */
+  log.text[0] = 0;
+  pWatch = profile_watch_create(file_name);
+  assert(pWatch);
+  assert(strcmp(profile_doc_value(profile_watch_doc(pWatch), "Device",
+    "Name"), "Gateway") == 0);
+  assert(profile_watch_subscribe(pWatch, TestLogChange, &log));
+  assert(profile_watch_subscribe(pWatch, TestLogChange, &other));
+  assert(profile_watch_poll(pWatch) == 0);
+  assert(log.text[0] == 0);
+  /* then each subscriber gets only what changed */
+  assert(WritePrivateProfileString("Device", "Mode", "Auto", file_name));
+  assert(WritePrivateProfileString("Device", "Name", "Router", file_name));
+  assert(profile_watch_poll(pWatch) == 2);
+  assert(strcmp(log.text,
+    "~ [Device] Name=Gateway -> Router\n+ [Device] Mode=Auto\n") == 0);
+  assert(strcmp(log.text, other.text) == 0);
+  assert(profile_watch_poll(pWatch) == 0);
+  /* a subscriber that left is not told */
+  profile_watch_unsubscribe(pWatch, TestLogChange, &other);
+  log.text[0] = 0;
+  other.text[0] = 0;
+  assert(WritePrivateProfileString("Device", "Mode", NULL, file_name));
+  assert(profile_watch_poll(pWatch) == 1);
+  assert(strcmp(log.text, "- [Device] Mode=Auto\n") == 0);
+  assert(other.text[0] == 0);
+  /* a removed file loses everything, and can come back */
+  log.text[0] = 0;
+  remove(file_name);
+  assert(profile_watch_poll(pWatch) == 2);
+  assert(strcmp(log.text, "- [Device]\n- [Device] Name=Router\n") == 0);
+  assert(!profile_watch_doc(pWatch));
+  assert(profile_watch_poll(pWatch) == 0);
+  log.text[0] = 0;
+  assert(WritePrivateProfileString("Device", "Name", "Gateway", file_name));
+  assert(profile_watch_poll(pWatch) == 2);
+  assert(strcmp(log.text, "+ [Device]\n+ [Device] Name=Gateway\n") == 0);
+  profile_watch_free(pWatch);
+  /* a watch of a file that is not there yet */
+  remove(file_name);
+  pWatch = profile_watch_create(file_name);
+  assert(pWatch);
+  assert(!profile_watch_doc(pWatch));
+  assert(profile_watch_poll(pWatch) == 0);
+  assert(WritePrivateProfileString("Device", "Name", "Gateway", file_name));
+  assert(profile_watch_poll(pWatch) == 2);
+  profile_watch_free(pWatch);
+  remove(file_name);
+}
+
+/**
+* Unit Tests for subscribers that unsubscribe from their callback
+*/
+static void test_ProfileWatchLeave(void)
+{
+  const char *file_name = "test_diff_leave.ini";
+  PROFILE_WATCH *pWatch = NULL;
+  struct leaving_subscriber first = {NULL, NULL, 0};
+  struct leaving_subscriber second = {NULL, NULL, 0};
+  struct change_log log = {{0}};
+  struct change_log other = {{0}};
+
+  remove(file_name);
+  assert(WritePrivateProfileString("Device", "Name", "Gateway", file_name));
+  pWatch = profile_watch_create(file_name);
+  assert(pWatch);
+  first.pWatch = pWatch;
+  second.pWatch = pWatch;
+  /* the second one also removes the subscriber after it */
+  second.pOther = &other;
+  assert(profile_watch_subscribe(pWatch, TestLeaveChange, &first));
+  assert(profile_watch_subscribe(pWatch, TestLogChange, &log));
+  assert(profile_watch_subscribe(pWatch, TestLeaveChange, &second));
+  assert(profile_watch_subscribe(pWatch, TestLogChange, &other));
+  assert(WritePrivateProfileString("Device", "Mode", "Auto", file_name));
+  assert(WritePrivateProfileString("Device", "Name", "Router", file_name));
+  assert(profile_watch_poll(pWatch) == 2);
+  /* each leaves on the first change, and misses the second */
+  assert(first.count == 1);
+  assert(second.count == 1);
+  assert(strcmp(log.text,
+    "~ [Device] Name=Gateway -> Router\n+ [Device] Mode=Auto\n") == 0);
+  assert(other.text[0] == 0);
+  log.text[0] = 0;
+  assert(WritePrivateProfileString("Device", "Mode", NULL, file_name));
+  assert(profile_watch_poll(pWatch) == 1);
+  assert((first.count == 1) && (second.count == 1));
+  assert(strcmp(log.text, "- [Device] Mode=Auto\n") == 0);
+  assert(other.text[0] == 0);
+  profile_watch_unsubscribe(pWatch, TestLogChange, &log);
+  profile_watch_free(pWatch);
+  remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileDiff();
+  test_ProfileWatch();
+  test_ProfileWatchLeave();
+
+  return 0;
+}
@@ -0,0 +1,403 @@
+/**
+ * @file
+ * @brief Test file for the parsed INI document module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_intern.h"
+
+static const char *Test_INI =
+  "; leading comment\n"
+  "orphan=ignored\n"
+  "[test1]\n"
+  "key1=0x72\n"
+  "  key 2 =  123 456  \r\n"
+  "key 3=  \"Joe's Garage on Main Street\"  \n"
+  "; comment in section\n"
+  "KEY1=duplicate\n"
+  "empty=\n"
+  "novalue\n"
+  "[relay]\n"
+  "relay 1=\"Relay 104\",NORMAL,YES,PHASE A,50\n"
+  "[TEST1]\n"
+  "hidden=yes\n"
+  "[switch]\n"
+  "switch 1='Switch 101'";
+
+/**
+* Compare a document lookup with GetPrivateProfileString on the file
+*
+* @param pDoc - document loaded from file_name
+* @param app_name - section name
+* @param key_name - key name
+* @param nSize - size of the return buffer
+* @param file_name - name of INI file
+*/
+static void TestSameAsFile(
+  const PROFILE_DOC *pDoc,
+  const char *app_name,
+  const char *key_name,
+  size_t nSize,
+  const char *file_name)
+{
+  char doc_name[MAX_LINE_LEN] = {""};
+  char file_value[MAX_LINE_LEN] = {""};
+  size_t doc_count = 0;
+  size_t file_count = 0;
+
+  assert(nSize <= sizeof(doc_name));
+  doc_count = profile_doc_get(pDoc, app_name, key_name, " 'default' ",
+    doc_name, nSize);
+  file_count = GetPrivateProfileString(app_name, key_name, " 'default' ",
+    file_value, nSize, file_name);
+  assert(doc_count == file_count);
+  assert(memcmp(doc_name, file_value, doc_count + 1) == 0);
+}
+
+/**
+* Unit Tests for parsing and lookups
+*/
+static void test_ProfileDoc(void)
+{
+  const char *file_name = "test_doc1.ini";
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_SECTION *pSection = NULL;
+  PROFILE_ENTRY *pEntry = NULL;
+  FILE *pFile = NULL;
+
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  fputs(Test_INI, pFile);
+  fclose(pFile);
+
+  pDoc = profile_doc_load(file_name);
+  assert(pDoc);
+  /* a loaded document is sized from the file */
+  assert(profile_doc_blocks(pDoc) == 1);
+  assert(profile_doc_memory(pDoc) > 0);
+  assert(profile_doc_section_count(pDoc) == 3);
+  assert(strcmp(profile_doc_value(pDoc, "TEST1", "Key1"), "0x72") == 0);
+  assert(strcmp(profile_doc_value(pDoc, "test1", "key 2"), "123 456") == 0);
+  assert(strcmp(profile_doc_value(pDoc, "test1", "key 3"),
+    "Joe's Garage on Main Street") == 0);
+  assert(strcmp(profile_doc_value(pDoc, "test1", "empty"), "") == 0);
+  assert(profile_doc_entry(pDoc, "test1", "novalue") != NULL);
+  assert(profile_doc_value(pDoc, "test1", "novalue") == NULL);
+  assert(profile_doc_value(pDoc, "test1", "hidden") == NULL);
+  assert(strcmp(profile_doc_value(pDoc, "switch", "switch 1"),
+    "Switch 101") == 0);
+  /* names given by length need not end with a null */
+  assert(profile_doc_section_n(pDoc, "Test1]", 5) ==
+    profile_doc_section(pDoc, "test1"));
+  assert(profile_doc_section_n(pDoc, "Test1]", 6) == NULL);
+  assert(profile_doc_entry_n(pDoc, "TEST1x", 5, "key 2=", 5) ==
+    profile_doc_entry(pDoc, "test1", "key 2"));
+  assert(profile_doc_entry_n(pDoc, "TEST1", 5, "key 2", 4) == NULL);
+
+  pSection = profile_doc_first(pDoc);
+  assert(strcmp(profile_section_name(pSection), "test1") == 0);
+  assert(profile_section_entry_count(pSection) == 5);
+  pEntry = profile_section_first(pSection);
+  assert(strcmp(profile_entry_key(pEntry), "key1") == 0);
+  assert(profile_entry_section(pEntry) == pSection);
+  pEntry = profile_entry_next(pEntry);
+  assert(strcmp(profile_entry_key(pEntry), "key 2") == 0);
+  pSection = profile_section_next(pSection);
+  assert(strcmp(profile_section_name(pSection), "relay") == 0);
+
+  TestSameAsFile(pDoc, "test1", "key1", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "Test1", "KEY 3", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "test1", "key 3", 16, file_name);
+  TestSameAsFile(pDoc, "test1", "empty", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "test1", "novalue", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "test1", "missing", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "missing", "key1", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "relay", "relay 1", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "switch", "switch 1", MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "relay", NULL, MAX_LINE_LEN, file_name);
+  TestSameAsFile(pDoc, "relay", NULL, 6, file_name);
+  TestSameAsFile(pDoc, "missing", NULL, MAX_LINE_LEN, file_name);
+  profile_doc_free(pDoc);
+
+  /* a repeated section is hidden, like GetPrivateProfileString */
+  pDoc = profile_doc_create();
+  assert(pDoc);
+  assert(profile_doc_parse(pDoc, "[a]\nx=1\n", 8));
+  assert(profile_doc_parse(pDoc, "[A]\nX=2\ny=3\n[b]\nz=4", 19));
+  assert(strcmp(profile_doc_value(pDoc, "a", "x"), "1") == 0);
+  assert(profile_doc_value(pDoc, "a", "y") == NULL);
+  assert(strcmp(profile_doc_value(pDoc, "b", "z"), "4") == 0);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Unit Tests for the hash tables growing
+*/
+static void test_ProfileDocGrow(void)
+{
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_SECTION *pSection = NULL;
+  char name[32] = "";
+  char value[32] = "";
+  unsigned i;
+
+  pDoc = profile_doc_create();
+  assert(pDoc);
+  for (i = 0; i < 1000; i++)
+  {
+    sprintf(name, "Section%u", i % 50);
+    pSection = profile_doc_add_section(pDoc, name);
+    assert(pSection);
+    sprintf(name, "Key%u", i);
+    sprintf(value, "%u", i);
+    assert(profile_doc_add_entry(pDoc, pSection, name, value));
+  }
+  assert(profile_doc_section_count(pDoc) == 50);
+  for (i = 0; i < 1000; i++)
+  {
+    sprintf(name, "SECTION%u", i % 50);
+    sprintf(value, "key%u", i);
+    assert(profile_doc_value(pDoc, name, value));
+  }
+  assert(profile_doc_blocks(pDoc) > 1);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Look up every key of the filter test, and as many that are missing
+*
+* @param pDoc - document
+* @param deleted - TRUE if the odd keys were deleted
+*/
+static void TestFilterLookups(
+  const PROFILE_DOC *pDoc,
+  bool deleted)
+{
+  char app_name[32] = "";
+  char key_name[32] = "";
+  PROFILE_ATOM app = 0;
+  PROFILE_ATOM key = 0;
+  unsigned i;
+
+  for (i = 0; i < 2000; i++)
+  {
+    sprintf(app_name, "FILTER%u", i % 100);
+    sprintf(key_name, "key%u", i);
+    assert((profile_doc_value(pDoc, app_name, key_name) != NULL) ==
+      !(deleted && (i % 2)));
+    sprintf(key_name, "Missing%u", i);
+    assert(profile_doc_value(pDoc, app_name, key_name) == NULL);
+    sprintf(app_name, "Missing%u", i);
+    assert(profile_doc_section(pDoc, app_name) == NULL);
+  }
+  if (!profile_intern_enabled())
+    return;
+  /* and by atom */
+  app = profile_intern("Filter8");
+  key = profile_intern("Key8");
+  assert(app && key);
+  assert(profile_doc_value_atom(pDoc, app, key));
+  key = profile_intern("Missing7");
+  assert(key);
+  assert(profile_doc_value_atom(pDoc, app, key) == NULL);
+  app = profile_intern("Missing7");
+  assert(app);
+  assert(profile_doc_section_atom(pDoc, app) == NULL);
+}
+
+/**
+* Unit Tests for the bloom filters of missing names: they may let a
+* missing name through, but must never turn away one that is there
+*/
+static void test_ProfileDocFilter(void)
+{
+  PROFILE_DOC *pDoc = NULL;
+  char app_name[32] = "";
+  char key_name[32] = "";
+  unsigned pass;
+  unsigned i;
+
+  for (pass = 0; pass < 2; pass++)
+  {
+    /* once with the names in the document, once interned */
+    if (pass == 1)
+      assert(profile_intern_init());
+    pDoc = profile_doc_create();
+    assert(pDoc);
+    for (i = 0; i < 2000; i++)
+    {
+      sprintf(app_name, "Filter%u", i % 100);
+      sprintf(key_name, "Key%u", i);
+      assert(profile_doc_set(pDoc, app_name, key_name, "value"));
+    }
+    TestFilterLookups(pDoc, false);
+    for (i = 1; i < 2000; i += 2)
+    {
+      sprintf(app_name, "Filter%u", i % 100);
+      sprintf(key_name, "Key%u", i);
+      assert(profile_doc_set(pDoc, app_name, key_name, NULL));
+    }
+    TestFilterLookups(pDoc, true);
+    /* a deleted section can come back */
+    assert(profile_doc_set(pDoc, "Filter3", NULL, NULL));
+    assert(profile_doc_section(pDoc, "Filter3") == NULL);
+    assert(profile_doc_set(pDoc, "Filter3", "Key3", "again"));
+    assert(strcmp(profile_doc_value(pDoc, "filter3", "key3"), "again") == 0);
+    profile_doc_free(pDoc);
+  }
+  profile_intern_cleanup();
+}
+
+/**
+* Unit Tests for loading a large file in one allocation
+*/
+static void test_ProfileDocLoadSized(void)
+{
+  const char *file_name = "test_doc2.ini";
+  PROFILE_DOC *pDoc = NULL;
+  FILE *pFile = NULL;
+  unsigned i;
+
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  for (i = 0; i < 5000; i++)
+  {
+    if ((i % 100) == 0)
+      fprintf(pFile, "[Section%u]\n", i / 100);
+    fprintf(pFile, "Key%u = \"Value %u\"\n", i, i);
+  }
+  fclose(pFile);
+  pDoc = profile_doc_load(file_name);
+  assert(pDoc);
+  assert(profile_doc_blocks(pDoc) == 1);
+  assert(profile_doc_section_count(pDoc) == 50);
+  assert(strcmp(profile_doc_value(pDoc, "section49", "key4999"),
+    "Value 4999") == 0);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Unit Tests for documents made from and written to memory
+*/
+static void test_ProfileDocBuffer(void)
+{
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_DOC *pCopy = NULL;
+  char text[512] = "";
+  char small[16] = "";
+  size_t len = 0;
+
+  pDoc = profile_doc_load_buffer(Test_INI, strlen(Test_INI));
+  assert(pDoc);
+  assert(profile_doc_blocks(pDoc) == 1);
+  assert(strcmp(profile_doc_value(pDoc, "test1", "key1"), "0x72") == 0);
+  assert(profile_doc_set(pDoc, "Test1", "KEY1", "  spaced  "));
+  assert(profile_doc_set(pDoc, "test1", "quoted", "'q'"));
+  assert(profile_doc_set(pDoc, "new", "key", "value"));
+  assert(profile_doc_set(pDoc, "test1", "key 2", NULL));
+  assert(!profile_doc_set(pDoc, "test1", "key 2", NULL));
+  assert(profile_doc_set(pDoc, "relay", NULL, NULL));
+  assert(!profile_doc_set(pDoc, "relay", NULL, NULL));
+  assert(profile_doc_section_count(pDoc) == 3);
+  assert(profile_doc_value(pDoc, "relay", "relay 1") == NULL);
+  assert(profile_doc_value(pDoc, "test1", "key 2") == NULL);
+  assert(strcmp(profile_doc_value(pDoc, "test1", "key1"), "  spaced  ") == 0);
+
+  len = profile_doc_serialize(pDoc, text, sizeof(text));
+  assert(len == strlen(text));
+  assert(strstr(text, "key1=\"  spaced  \"\n"));
+  assert(strstr(text, "novalue\n"));
+  assert(!strstr(text, "[relay]"));
+  /* writing and reading back gives the same document */
+  pCopy = profile_doc_load_buffer(text, len);
+  assert(pCopy);
+  assert(strcmp(profile_doc_value(pCopy, "test1", "key1"), "  spaced  ") == 0);
+  assert(strcmp(profile_doc_value(pCopy, "test1", "quoted"), "'q'") == 0);
+  assert(strcmp(profile_doc_value(pCopy, "new", "key"), "value") == 0);
+  assert(profile_doc_entry(pCopy, "test1", "novalue"));
+  assert(profile_doc_value(pCopy, "test1", "novalue") == NULL);
+  assert(profile_doc_serialize(pCopy, NULL, 0) == len);
+  /* a short buffer is truncated and still null-terminated */
+  assert(profile_doc_serialize(pCopy, small, sizeof(small)) == len);
+  assert(strlen(small) == sizeof(small) - 1);
+  assert(memcmp(small, text, sizeof(small) - 1) == 0);
+  profile_doc_free(pCopy);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Unit Tests for moving the sections of one document into another
+*/
+static void test_ProfileDocAdopt(void)
+{
+  const char *first = "[a]\nk=1\n[b]\nk=2\n";
+  const char *second = "[B]\nk=hidden\n[c]\nk=3\nother=4\n";
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_DOC *pSource = NULL;
+  PROFILE_SECTION *pSection = NULL;
+  char text[128] = "";
+  unsigned i;
+
+  pDoc = profile_doc_load_buffer(first, strlen(first));
+  assert(pDoc);
+  pSource = profile_doc_load_buffer(second, strlen(second));
+  assert(pSource);
+  assert(profile_doc_adopt(pDoc, pSource));
+  assert(profile_doc_section_count(pDoc) == 3);
+  assert(strcmp(profile_doc_value(pDoc, "b", "k"), "2") == 0);
+  assert(strcmp(profile_doc_value(pDoc, "C", "OTHER"), "4") == 0);
+  pSection = profile_doc_first(pDoc);
+  pSection = profile_section_next(profile_section_next(pSection));
+  assert(strcmp(profile_section_name(pSection), "c") == 0);
+  assert(profile_section_next(pSection) == NULL);
+  /* an adopted section takes new keys like any other */
+  assert(profile_doc_set(pDoc, "c", "new", "5"));
+  assert(strcmp(profile_doc_value(pDoc, "c", "new"), "5") == 0);
+  assert(profile_doc_set(pDoc, "c", "k", NULL));
+  assert(profile_doc_value(pDoc, "c", "k") == NULL);
+  assert(profile_doc_serialize(pDoc, text, sizeof(text)) > 0);
+  assert(strcmp(text,
+    "[a]\nk=1\n[b]\nk=2\n[c]\nother=4\nnew=5\n") == 0);
+  /* enough sections to grow the tables and filter of the destination */
+  for (i = 0; i < 200; i++)
+  {
+    snprintf(text, sizeof(text), "[s%u]\nkey=%u\n", i, i);
+    pSource = profile_doc_load_buffer(text, strlen(text));
+    assert(pSource);
+    assert(profile_doc_adopt(pDoc, pSource));
+  }
+  assert(profile_doc_section_count(pDoc) == 203);
+  for (i = 0; i < 200; i++)
+  {
+    snprintf(text, sizeof(text), "s%u", i);
+    assert(strtoul(profile_doc_value(pDoc, text, "key"), NULL, 10) == i);
+  }
+  assert(profile_doc_adopt(pDoc, NULL));
+  profile_doc_free(pDoc);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileDoc();
+  test_ProfileDocGrow();
+  test_ProfileDocFilter();
+  test_ProfileDocLoadSized();
+  test_ProfileDocBuffer();
+  test_ProfileDocAdopt();
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file
+ * @brief Test file for the C++ wrapper
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include "profile.hpp"
+
+/* number of times operator new was called */
+static std::size_t Allocations = 0;
+
+void *operator new(std::size_t size)
+{
+  void *p = std::malloc(size ? size : 1);
+
+  Allocations++;
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+static const char Text[] =
+  "[Device]\n"
+  "Name=Gateway\n"
+  "Port=47808\n"
+  "Offset=-12\n"
+  "Mask=0xFF00\n"
+  "Scale=+2.5\n"
+  "Enabled=Yes\n"
+  "Flag\n"
+  "Bad=12abc\n"
+  "[Serial]\n"
+  "Baud=9600\n";
+
+static_assert(!std::is_copy_constructible_v<profile::document>);
+static_assert(std::is_nothrow_move_constructible_v<profile::document>);
+static_assert(!std::is_copy_constructible_v<profile::cache_handle>);
+static_assert(std::is_nothrow_move_constructible_v<profile::cache_handle>);
+
+/**
+* Unit Tests for lookups and typed values
+*/
+static void test_ProfileLookup(void)
+{
+  profile::document doc = profile::document::parse(Text);
+  std::string key_name = "NAME and more";
+  std::size_t allocations = 0;
+
+  assert(doc);
+  allocations = Allocations;
+  /* names need not end with a null, and the value is not copied */
+  std::string_view name = doc.get(std::string_view("device]", 6),
+    std::string_view(key_name.data(), 4));
+  assert(name == "Gateway");
+  assert(name.data() == profile_doc_value(doc.native(), "Device", "Name"));
+  assert(doc.get("Device", "Missing", "none") == "none");
+  assert(doc.get("Missing", "Name").empty());
+  assert(doc.get<unsigned>("Device", "Port", 0) == 47808);
+  assert(doc.get<int>("Device", "Offset", 0) == -12);
+  assert(doc.get<unsigned>("Device", "Offset", 7) == 7);
+  assert(doc.get<unsigned>("Device", "Mask", 0) == 0xFF00);
+  assert(doc.get<double>("Device", "Scale", 0.0) > 2.49);
+  assert(doc.get<double>("Device", "Scale", 0.0) < 2.51);
+  assert(doc.get<bool>("Device", "Enabled", false));
+  assert(doc.get<int>("Device", "Bad", 5) == 5);
+  assert(doc.get<int>("Device", "Name", 5) == 5);
+  assert(doc.get<unsigned char>("Device", "Port", 9) == 9);
+  assert(doc.get("Serial", "Baud", 300L) == 9600L);
+  /* a key without '=' has no value, and gets the default */
+  assert(doc.contains("Device", "Flag"));
+  assert(!doc.find("Device", "Flag")->has_value());
+  assert(doc.get("Device", "Flag", "none") == "none");
+  assert(!doc.find("Device", "Nothing"));
+  assert(doc.find_section("SERIAL")->size() == 1);
+  assert(!doc.find_section("Parallel"));
+  /* iteration in file order */
+  std::size_t keys = 0;
+  std::size_t sections = 0;
+  for (profile::section section : doc)
+  {
+    sections++;
+    for (profile::entry entry : section)
+    {
+      keys++;
+      assert(!entry.key().empty());
+    }
+  }
+  assert(sections == 2);
+  assert(keys == 9);
+  assert((*doc.begin()).name() == "Device");
+  assert((*std::next(doc.find_section("Device")->begin())).key() == "Port");
+  /* none of it touched the heap */
+  assert(Allocations == allocations);
+}
+
+/**
+* Unit Tests for ownership and changes
+*/
+static void test_ProfileOwnership(void)
+{
+  profile::document doc;
+  PROFILE_DOC *pDoc = nullptr;
+
+  assert(doc);
+  assert(doc.size() == 0);
+  assert(doc.set("Device", "Name", "Gateway"));
+  assert(doc.get("Device", "Name") == "Gateway");
+  assert(doc.str() == "[Device]\nName=Gateway\n");
+  /* moving hands the document over */
+  profile::document other = std::move(doc);
+  assert(!doc);
+  assert(other.get("Device", "Name") == "Gateway");
+  assert(doc.get("Device", "Name", "none") == "none");
+  doc = std::move(other);
+  assert(doc && !other);
+  /* a view shares the document without owning it */
+  profile::view view = doc;
+  assert(view.get("device", "name") == "Gateway");
+  /* and release gives it back to the C API */
+  pDoc = doc.release();
+  assert(!doc);
+  assert(std::strcmp(profile_doc_value(pDoc, "Device", "Name"),
+    "Gateway") == 0);
+  doc = profile::document(pDoc);
+  assert(doc.set("Device", "Name", nullptr));
+  assert(!doc.contains("Device", "Name"));
+  /* no file */
+  assert(!profile::document::load("test_hpp_missing.ini"));
+}
+
+/**
+* Unit Tests for pinned documents of the profile cache
+*/
+static void test_ProfileCacheHandle(void)
+{
+  const char *file_name = "test_hpp.ini";
+  PROFILE_CACHE_STATS stats;
+
+  std::remove(file_name);
+  assert(WritePrivateProfileString("Device", "Port", "47808", file_name));
+  {
+    profile::cache_handle handle(file_name);
+    assert(handle);
+    assert(handle.get<int>("Device", "Port", 0) == 47808);
+    profile_cache_stats(&stats);
+    assert(stats.pinned == 1);
+    profile::cache_handle moved = std::move(handle);
+    assert(!handle && moved);
+    assert(moved.get("Device", "Port") == "47808");
+  }
+  profile_cache_stats(&stats);
+  assert(stats.pinned == 0);
+  assert(!profile::cache_handle("test_hpp_missing.ini"));
+  profile_cache_clear();
+  std::remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileLookup();
+  test_ProfileOwnership();
+  test_ProfileCacheHandle();
+
+  return 0;
+}
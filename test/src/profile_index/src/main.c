@@ -0,0 +1,182 @@
+/**
+ * @file
+ * @brief Test file for the sorted key index module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_index.h"
+
+/* number of channel keys in the large section */
+#define CHANNEL_COUNT 1000
+
+static const char Text[] =
+  "[Device]\n"
+  "Name=Gateway\n"
+  "channel.2=Two\n"
+  "Channel.1=One\n"
+  "CHANNEL.10=Ten\n"
+  "Chan=Short\n"
+  "Mode=Auto\n"
+  "[Backup]\n"
+  "Channel.1=Backup One\n"
+  "Name=Spare\n"
+  "[Empty]\n";
+
+/**
+* Check the key names of the entries a query found
+*
+* @param ppEntries - entries that were found
+* @param count - number of entries
+* @param pExpected - key names, in order, separated by spaces
+*/
+static void TestKeys(
+  PROFILE_ENTRY **ppEntries,
+  size_t count,
+  const char *pExpected)
+{
+  char keys[MAX_LINE_LEN] = {""};
+  size_t i = 0;
+
+  for (i = 0; i < count; i++)
+  {
+    if (i)
+      strcat(keys, " ");
+    strcat(keys, profile_entry_key(ppEntries[i]));
+  }
+  assert(strcmp(keys, pExpected) == 0);
+}
+
+/**
+* Unit Tests for prefix and wildcard queries
+*/
+static void test_ProfileIndex(void)
+{
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_INDEX *pIndex = NULL;
+  PROFILE_ENTRY *entries[16] = {NULL};
+  PROFILE_ENTRY **ppEntries = NULL;
+  char key_name[32] = {""};
+  size_t count = 0;
+  unsigned i = 0;
+
+  pDoc = profile_doc_load_buffer(Text, strlen(Text));
+  assert(pDoc);
+  pIndex = profile_index_create(pDoc);
+  assert(pIndex);
+  assert(profile_index_count(pIndex) == 8);
+  /* a prefix within a section, in key order, with case folded */
+  count = profile_index_prefix(pIndex, "device", "channel.", entries, 16);
+  assert(count == 3);
+  TestKeys(entries, count, "Channel.1 CHANNEL.10 channel.2");
+  assert(strcmp(profile_entry_value(entries[1]), "Ten") == 0);
+  assert(strcmp(profile_section_name(profile_entry_section(entries[0])),
+    "Device") == 0);
+  count = profile_index_prefix(pIndex, "Device", "Chan", entries, 16);
+  TestKeys(entries, count, "Chan Channel.1 CHANNEL.10 channel.2");
+  /* an empty prefix is every key of the section */
+  count = profile_index_prefix(pIndex, "Device", "", entries, 16);
+  TestKeys(entries, count, "Chan Channel.1 CHANNEL.10 channel.2 Mode Name");
+  /* across sections, in key order and then section order */
+  count = profile_index_prefix(pIndex, NULL, "channel.1", entries, 16);
+  TestKeys(entries, count, "Channel.1 Channel.1 CHANNEL.10");
+  assert(strcmp(profile_entry_value(entries[0]), "Backup One") == 0);
+  assert(strcmp(profile_entry_value(entries[1]), "One") == 0);
+  count = profile_index_prefix(pIndex, NULL, "Name", entries, 16);
+  assert(count == 2);
+  /* no matches */
+  assert(profile_index_prefix(pIndex, "Device", "Zone", entries, 16) == 0);
+  assert(profile_index_prefix(pIndex, "Empty", "", entries, 16) == 0);
+  assert(profile_index_prefix(pIndex, "Missing", "", entries, 16) == 0);
+  assert(profile_index_prefix(pIndex, "Device", "Channel.1.", entries,
+    16) == 0);
+  /* a small array only holds the first ones, and the count says so */
+  count = profile_index_prefix(pIndex, NULL, "", entries, 2);
+  assert(count == 8);
+  TestKeys(entries, 2, "Chan Channel.1");
+  assert(profile_index_prefix(pIndex, NULL, "", NULL, 0) == 8);
+  /* wildcards */
+  count = profile_index_glob(pIndex, "Device", "Channel.*", entries, 16);
+  TestKeys(entries, count, "Channel.1 CHANNEL.10 channel.2");
+  count = profile_index_glob(pIndex, "Device", "channel.?", entries, 16);
+  TestKeys(entries, count, "Channel.1 channel.2");
+  count = profile_index_glob(pIndex, "Device", "*a*e", entries, 16);
+  TestKeys(entries, count, "Name");
+  count = profile_index_glob(pIndex, NULL, "*.1*", entries, 16);
+  TestKeys(entries, count, "Channel.1 Channel.1 CHANNEL.10");
+  count = profile_index_glob(pIndex, "Device", "*", entries, 16);
+  assert(count == 6);
+  count = profile_index_glob(pIndex, "Device", "C*0", entries, 16);
+  TestKeys(entries, count, "CHANNEL.10");
+  count = profile_index_glob(pIndex, "Device", "**n", entries, 16);
+  TestKeys(entries, count, "Chan");
+  /* without a wildcard, the whole key has to match */
+  count = profile_index_glob(pIndex, NULL, "channel.1", entries, 16);
+  TestKeys(entries, count, "Channel.1 Channel.1");
+  assert(profile_index_glob(pIndex, "Device", "Chan?", entries, 16) == 0);
+  profile_index_free(pIndex);
+  /* the index is of the document when it was made */
+  assert(profile_doc_set(pDoc, "Device", "Channel.3", "Three"));
+  pIndex = profile_index_create(pDoc);
+  assert(pIndex);
+  count = profile_index_glob(pIndex, "Device", "Channel.*", entries, 16);
+  TestKeys(entries, count, "Channel.1 CHANNEL.10 channel.2 Channel.3");
+  profile_index_free(pIndex);
+  profile_doc_free(pDoc);
+  /* an empty document */
+  pDoc = profile_doc_create();
+  assert(pDoc);
+  pIndex = profile_index_create(pDoc);
+  assert(pIndex);
+  assert(profile_index_count(pIndex) == 0);
+  assert(profile_index_prefix(pIndex, NULL, "", entries, 16) == 0);
+  assert(profile_index_glob(pIndex, NULL, "*", entries, 16) == 0);
+  profile_index_free(pIndex);
+  /* a large section */
+  for (i = 0; i < CHANNEL_COUNT; i++)
+  {
+    snprintf(key_name, sizeof(key_name), "Channel.%u", i);
+    assert(profile_doc_set(pDoc, "Device", key_name, "x"));
+    snprintf(key_name, sizeof(key_name), "Port.%u", i);
+    assert(profile_doc_set(pDoc, "Device", key_name, "y"));
+  }
+  pIndex = profile_index_create(pDoc);
+  assert(pIndex);
+  ppEntries = calloc(CHANNEL_COUNT, sizeof(PROFILE_ENTRY *));
+  assert(ppEntries);
+  count = profile_index_glob(pIndex, "Device", "Channel.*", ppEntries,
+    CHANNEL_COUNT);
+  assert(count == CHANNEL_COUNT);
+  for (i = 0; i < count; i++)
+  {
+    assert(strncmp(profile_entry_key(ppEntries[i]), "Channel.", 8) == 0);
+    if (i)
+      assert(strcmp(profile_entry_key(ppEntries[i - 1]),
+        profile_entry_key(ppEntries[i])) < 0);
+  }
+  assert(profile_index_prefix(pIndex, "Device", "Port.99", NULL, 0) == 11);
+  assert(profile_index_glob(pIndex, NULL, "*.99?", NULL, 0) == 20);
+  free(ppEntries);
+  profile_index_free(pIndex);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileIndex();
+
+  return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file
+ * @brief Test file for the shared section and key name pool
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_intern.h"
+
+/**
+* Unit Tests for interning names
+*/
+static void test_Intern(void)
+{
+  PROFILE_ATOM atom = 0;
+  PROFILE_ATOM other = 0;
+  const char *pName = NULL;
+  unsigned hash = 0;
+
+  /* nothing is interned until the pool is started */
+  assert(!profile_intern_enabled());
+  assert(profile_intern("Section") == 0);
+  assert(profile_intern_name(1) == NULL);
+
+  assert(profile_intern_init());
+  assert(profile_intern_init());
+  assert(profile_intern_enabled());
+  atom = profile_intern("Section");
+  assert(atom != 0);
+  assert(profile_intern("Section") == atom);
+  /* names that differ only in case share an atom */
+  assert(profile_intern("SECTION") == atom);
+  assert(profile_intern_find("section") == atom);
+  assert(strcmp(profile_intern_name(atom), "Section") == 0);
+  assert(profile_intern_count() == 1);
+  other = profile_intern("Sections");
+  assert(other && (other != atom));
+  assert(profile_intern_find("missing") == 0);
+  /* each spelling is kept once */
+  pName = profile_intern_string("SECTION", 7, &other, &hash);
+  assert(pName && (strcmp(pName, "SECTION") == 0));
+  assert(other == atom);
+  assert(hash == profile_intern_hash(atom));
+  assert(profile_intern_string("SECTION xyz", 7, NULL, NULL) == pName);
+  assert(profile_intern_name(0) == NULL);
+  profile_intern_cleanup();
+  assert(!profile_intern_enabled());
+  assert(profile_intern_find("Section") == 0);
+}
+
+/**
+* Unit Tests for documents that share names
+*/
+static void test_InternDoc(void)
+{
+  PROFILE_DOC *pDoc1 = NULL;
+  PROFILE_DOC *pDoc2 = NULL;
+  PROFILE_DOC *pPrivate = NULL;
+  PROFILE_ATOM app = 0;
+  PROFILE_ATOM key = 0;
+  PROFILE_ATOM missing = 0;
+  const char *pText1 = "[Device]\nName=one\nAddress = 1\n";
+  const char *pText2 = "[device]\nname=two\n[Other]\nName=three\n";
+  char name[32] = "";
+  unsigned i;
+
+  /* a document made before the pool keeps its own names */
+  pPrivate = profile_doc_create();
+  assert(pPrivate);
+  assert(profile_doc_parse(pPrivate, pText1, strlen(pText1)));
+
+  assert(profile_intern_init());
+  app = profile_intern("DEVICE");
+  key = profile_intern("name");
+  missing = profile_intern("missing");
+  pDoc1 = profile_doc_create();
+  pDoc2 = profile_doc_create();
+  assert(pDoc1 && pDoc2);
+  assert(profile_doc_parse(pDoc1, pText1, strlen(pText1)));
+  assert(profile_doc_parse(pDoc2, pText2, strlen(pText2)));
+  /* the spelling in each file is kept */
+  assert(strcmp(profile_section_name(profile_doc_first(pDoc1)),
+    "Device") == 0);
+  assert(strcmp(profile_section_name(profile_doc_first(pDoc2)),
+    "device") == 0);
+  /* the same spelling in two documents is one copy */
+  assert(profile_entry_key(profile_doc_entry(pDoc1, "Device", "Name")) ==
+    profile_entry_key(profile_doc_entry(pDoc2, "Other", "Name")));
+  assert(strcmp(profile_doc_value_atom(pDoc1, app, key), "one") == 0);
+  assert(strcmp(profile_doc_value_atom(pDoc2, app, key), "two") == 0);
+  assert(profile_doc_value_atom(pDoc1, app, missing) == NULL);
+  assert(profile_doc_value_atom(pDoc1, missing, key) == NULL);
+  assert(profile_doc_section_atom(pDoc2, profile_intern("other")) ==
+    profile_doc_section(pDoc2, "OTHER"));
+  /* lookups by name still work */
+  assert(strcmp(profile_doc_value(pDoc1, "device", "ADDRESS"), "1") == 0);
+  /* a document with private names answers atom lookups too */
+  assert(strcmp(profile_doc_value_atom(pPrivate, app, key), "one") == 0);
+  profile_doc_free(pPrivate);
+
+  /* many names make the pool grow */
+  for (i = 0; i < 2000; i++)
+  {
+    sprintf(name, "Key%u", i);
+    assert(profile_doc_add_entry(pDoc1, profile_doc_first(pDoc1), name,
+      name));
+  }
+  for (i = 0; i < 2000; i++)
+  {
+    sprintf(name, "KEY%u", i);
+    key = profile_intern_find(name);
+    assert(key);
+    sprintf(name, "Key%u", i);
+    assert(strcmp(profile_doc_value_atom(pDoc1, app, key), name) == 0);
+  }
+  profile_doc_free(pDoc1);
+  profile_doc_free(pDoc2);
+  profile_intern_cleanup();
+}
+
+/**
+* Interns names while another thread starts the pool
+*
+* @param pArg - unused
+*
+* @return NULL
+*/
+static void *TestInternThread(void *pArg)
+{
+  unsigned i;
+
+  (void)pArg;
+  for (i = 0; i < 10000; i++)
+  {
+    if (profile_intern_enabled())
+    {
+      assert(profile_intern("Shared") != 0);
+      break;
+    }
+    (void)profile_intern_find("Shared");
+  }
+
+  return (NULL);
+}
+
+/**
+* Unit Tests for starting the pool while other threads use it
+*/
+static void test_InternThreads(void)
+{
+  pthread_t thread[4];
+  PROFILE_ATOM atom = 0;
+  unsigned i;
+
+  for (i = 0; i < 4; i++)
+    assert(pthread_create(&thread[i], NULL, TestInternThread, NULL) == 0);
+  assert(profile_intern_init());
+  for (i = 0; i < 4; i++)
+    pthread_join(thread[i], NULL);
+  atom = profile_intern("shared");
+  assert(atom && (profile_intern_find("SHARED") == atom));
+  profile_intern_cleanup();
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_Intern();
+  test_InternDoc();
+  test_InternThreads();
+
+  return 0;
+}
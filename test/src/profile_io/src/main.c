@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Test file for the pluggable file access module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+
+/* the same changes are made with every backend */
+static const char *Writes[][3] = {
+  {"MySection1","MyKey1","MyKey1Value"},
+  {"MySection1","MyKey2","\"MyKey2 Value\""},
+  {"MySection2","MyKey3","MyKey3Value"},
+  {"mysection1","mykey1","Changed"},
+  {"MySection3","MyKey5","MyKey5Value"},
+  {"MySection2","MyKey3",NULL},
+  {"MySection3",NULL,NULL}
+};
+
+/**
+* Read a file through a backend and compare it with a file
+*
+* @param pIo - backend
+* @param file_name - name of the file in the backend
+* @param expected_name - name of the file written with stdio
+*/
+static void TestSameFile(
+  const PROFILE_IO *pIo,
+  const char *file_name,
+  const char *expected_name)
+{
+  char *pBuffer = NULL;
+  char *pExpected = NULL;
+  size_t len = 0;
+  size_t expected_len = 0;
+
+  pBuffer = profile_io_read(pIo, file_name, &len);
+  pExpected = profile_io_read(profile_io_stdio(), expected_name,
+    &expected_len);
+  assert(pBuffer && pExpected);
+  assert(len == expected_len);
+  assert(memcmp(pBuffer, pExpected, len) == 0);
+  free(pBuffer);
+  free(pExpected);
+}
+
+/**
+* Unit Tests for one backend
+*
+* @param pIo - backend
+* @param file_name - name of the file to use in the backend
+*/
+static void TestBackend(
+  const PROFILE_IO *pIo,
+  const char *file_name)
+{
+  const char *expected_name = "test_io_expected.ini";
+  PROFILE_IO_STAT file_stat;
+  PROFILE_DOC *pDoc = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t i = 0;
+
+  remove(expected_name);
+  assert(!profile_io_stat(pIo, file_name, &file_stat));
+  assert(!file_stat.exists);
+  /* no file - the default */
+  count = GetPrivateProfileStringIo(pIo, "MySection1", "MyKey1", "none",
+    return_name, sizeof(return_name), file_name);
+  assert(count == 4);
+  assert(strcmp(return_name, "none") == 0);
+  /* deleting from no file does not make one */
+  assert(!WritePrivateProfileStringIo(pIo, "MySection1", "MyKey1", NULL,
+    file_name));
+  assert(!profile_io_stat(pIo, file_name, &file_stat));
+  for (i = 0; i < sizeof(Writes) / sizeof(Writes[0]); i++)
+  {
+    assert(WritePrivateProfileStringIo(pIo, Writes[i][0], Writes[i][1],
+      Writes[i][2], file_name) ==
+      WritePrivateProfileString(Writes[i][0], Writes[i][1], Writes[i][2],
+      expected_name));
+    TestSameFile(pIo, file_name, expected_name);
+  }
+  assert(profile_io_stat(pIo, file_name, &file_stat));
+  assert(file_stat.exists);
+  assert(file_stat.size > 0);
+  count = GetPrivateProfileStringIo(pIo, NULL, NULL, "", return_name,
+    sizeof(return_name), file_name);
+  assert(count == GetPrivateProfileString(NULL, NULL, "", expected,
+    sizeof(expected), expected_name));
+  assert(memcmp(return_name, expected, count + 1) == 0);
+  count = GetPrivateProfileStringIo(pIo, "MYSECTION1", "mykey2", "",
+    return_name, sizeof(return_name), file_name);
+  assert(strcmp(return_name, "MyKey2 Value") == 0);
+  pDoc = profile_doc_load_io(pIo, file_name);
+  assert(pDoc);
+  assert(strcmp(profile_doc_value(pDoc, "MySection1", "MyKey1"),
+    "Changed") == 0);
+  profile_doc_free(pDoc);
+  remove(expected_name);
+}
+
+/**
+* Unit Tests for each of the backends
+*/
+static void test_ProfileIo(void)
+{
+  PROFILE_IO *pMemory = NULL;
+  PROFILE_IO *pOther = NULL;
+  PROFILE_IO_STAT file_stat;
+  char return_name[MAX_LINE_LEN] = {""};
+
+  remove("test_io_posix.ini");
+  remove("test_io_mmap.ini");
+  remove("test_io_stdio.ini");
+  TestBackend(profile_io_posix(), "test_io_posix.ini");
+  TestBackend(profile_io_mmap(), "test_io_mmap.ini");
+  TestBackend(profile_io_stdio(), "test_io_stdio.ini");
+  pMemory = profile_io_memory_create();
+  assert(pMemory);
+  TestBackend(pMemory, "test_io_memory.ini");
+  /* the memory backend never touches the file system */
+  assert(!profile_io_stat(profile_io_posix(), "test_io_memory.ini",
+    &file_stat));
+  /* and each one has its own files */
+  pOther = profile_io_memory_create();
+  assert(pOther);
+  assert(!profile_io_stat(pOther, "test_io_memory.ini", &file_stat));
+  assert(GetPrivateProfileStringIo(pOther, "MySection1", "MyKey1", "",
+    return_name, sizeof(return_name), "test_io_memory.ini") == 0);
+  profile_io_memory_free(pOther);
+  profile_io_memory_free(pMemory);
+  /* an empty file can be mapped */
+  assert(profile_io_replace(profile_io_mmap(), "test_io_mmap.ini", "", 0));
+  assert(GetPrivateProfileStringIo(profile_io_mmap(), "MySection1",
+    "MyKey1", "x", return_name, sizeof(return_name),
+    "test_io_mmap.ini") == 1);
+  remove("test_io_posix.ini");
+  remove("test_io_mmap.ini");
+  remove("test_io_stdio.ini");
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileIo();
+
+  return 0;
+}
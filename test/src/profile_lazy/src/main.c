@@ -0,0 +1,269 @@
+/**
+ * @file
+ * @brief Test file for the lazy INI section parsing module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_io.h"
+#include "profile_lazy.h"
+
+/* text with the odd cases of the parser */
+static const char Text[] =
+  "; comment before any section\n"
+  "[First]\n"
+  "key1 = value1\n"
+  "key2=\"quoted value\"\n"
+  "novalue\n"
+  "list=[not a section]\n"
+  "  [Indented]  \n"
+  "key1=indented\n"
+  "[bad\n"
+  "key1=after a bad header\n"
+  "[Second]\n"
+  "key1=second\n"
+  "[first]\n"
+  "key1=repeated section\n"
+  "key3=repeated section\n"
+  "[Last]\n"
+  "key1=no newline at the end";
+
+/* lookups made on the lazy file and on the text */
+static const char *Names[][2] = {
+  {"First","key1"},
+  {"FIRST","KEY2"},
+  {"First","novalue"},
+  {"First","list"},
+  {"First","key3"},
+  {"First",NULL},
+  {"Indented","key1"},
+  {"bad","key1"},
+  {"Second","key1"},
+  {"Second",NULL},
+  {"Last","key1"},
+  {"Missing","key1"},
+  {"Missing",NULL},
+  {NULL,NULL}
+};
+
+/**
+* Check a lazy file against GetPrivateProfileStringFromBuffer
+*
+* @param pLazy - lazy file of Text
+*/
+static void TestSameAnswers(
+  PROFILE_LAZY *pLazy)
+{
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t i = 0;
+
+  assert(profile_lazy_section_count(pLazy) == 5);
+  assert(profile_lazy_parsed_count(pLazy) == 0);
+  for (i = 0; i < sizeof(Names) / sizeof(Names[0]); i++)
+  {
+    count = profile_lazy_get(pLazy, Names[i][0], Names[i][1], "default",
+      return_name, sizeof(return_name));
+    assert(count == GetPrivateProfileStringFromBuffer(Names[i][0],
+      Names[i][1], "default", expected, sizeof(expected), Text,
+      strlen(Text)));
+    assert(memcmp(return_name, expected, count + 1) == 0);
+  }
+  /* only the sections that were asked for were parsed */
+  assert(profile_lazy_parsed_count(pLazy) == 4);
+  assert(strcmp(profile_lazy_value(pLazy, "first", "KEY1"),
+    "value1") == 0);
+  assert(profile_lazy_value(pLazy, "First", "novalue") == NULL);
+  assert(profile_lazy_value(pLazy, "Missing", "key1") == NULL);
+  assert(profile_lazy_section(pLazy, "Second"));
+  assert(!profile_lazy_section(pLazy, "Missing"));
+  assert(profile_lazy_parsed_count(pLazy) == 4);
+}
+
+/**
+* Unit Tests for lazy files from memory and from files
+*/
+static void test_ProfileLazy(void)
+{
+  const char *file_name = "test_lazy.ini";
+  PROFILE_LAZY *pLazy = NULL;
+
+  pLazy = profile_lazy_load_buffer(Text, strlen(Text));
+  assert(pLazy);
+  TestSameAnswers(pLazy);
+  profile_lazy_free(pLazy);
+  assert(profile_io_replace(profile_io_posix(), file_name, Text,
+    strlen(Text)));
+  pLazy = profile_lazy_load(file_name);
+  assert(pLazy);
+  TestSameAnswers(pLazy);
+  profile_lazy_free(pLazy);
+  pLazy = profile_lazy_load_io(profile_io_posix(), file_name);
+  assert(pLazy);
+  TestSameAnswers(pLazy);
+  profile_lazy_free(pLazy);
+  remove(file_name);
+  assert(!profile_lazy_load(file_name));
+  /* an empty text */
+  pLazy = profile_lazy_load_buffer("", 0);
+  assert(pLazy);
+  assert(profile_lazy_section_count(pLazy) == 0);
+  assert(profile_lazy_value(pLazy, "a", "b") == NULL);
+  profile_lazy_free(pLazy);
+}
+
+/**
+* Unit Tests for the memory of a large text and file with one section
+* used
+*/
+static void test_ProfileLazyLarge(void)
+{
+  const char *file_name = "test_lazy_large.ini";
+  PROFILE_LAZY *pLazy = NULL;
+  PROFILE_DOC *pDoc = NULL;
+  char *pText = NULL;
+  char value[32] = {""};
+  size_t size = 1000 * 200;
+  size_t len = 0;
+  unsigned i = 0;
+  unsigned j = 0;
+
+  pText = malloc(size);
+  assert(pText);
+  for (i = 0; i < 1000; i++)
+  {
+    len += (size_t)snprintf(pText + len, size - len, "[Device%u]\n", i);
+    for (j = 0; j < 5; j++)
+    {
+      len += (size_t)snprintf(pText + len, size - len, "Key%u=%u\n", j,
+        i * j);
+    }
+  }
+  assert(len < size);
+  pLazy = profile_lazy_load_buffer(pText, len);
+  assert(pLazy);
+  assert(profile_lazy_section_count(pLazy) == 1000);
+  snprintf(value, sizeof(value), "%u", 777 * 4);
+  assert(strcmp(profile_lazy_value(pLazy, "Device777", "Key4"),
+    value) == 0);
+  assert(profile_lazy_parsed_count(pLazy) == 1);
+  pDoc = profile_doc_load_buffer(pText, len);
+  assert(pDoc);
+  assert(profile_lazy_memory(pLazy) < profile_doc_memory(pDoc));
+  profile_lazy_free(pLazy);
+  /* a file is read a section at a time, not held */
+  assert(profile_io_replace(profile_io_posix(), file_name, pText, len));
+  pLazy = profile_lazy_load(file_name);
+  assert(pLazy);
+  assert(profile_lazy_section_count(pLazy) == 1000);
+  assert(strcmp(profile_lazy_value(pLazy, "Device777", "Key4"),
+    value) == 0);
+  assert(profile_lazy_memory(pLazy) < profile_doc_memory(pDoc));
+  profile_doc_free(pDoc);
+  profile_lazy_free(pLazy);
+  remove(file_name);
+  free(pText);
+}
+
+/**
+* Unit Tests for a file that is rewritten in place or replaced under
+* lazy files
+*/
+static void test_ProfileLazyRewrite(void)
+{
+  const char *file_name = "test_lazy_rewrite.ini";
+  const char *replaced = "[s0]\nkey=renamed\n";
+  PROFILE_LAZY *pLazy = NULL;
+  PROFILE_LAZY *pMapped = NULL;
+  PROFILE_LAZY *pCopy = NULL;
+  const char *pOld = NULL;
+  FILE *pFile = NULL;
+  char value[32] = {""};
+  unsigned i = 0;
+
+  /* several blocks, and a line longer than one */
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  for (i = 0; i < 30000; i++)
+    fprintf(pFile, "[s%u]\nkey=%u\n", i, i);
+  fprintf(pFile, "[long]\nkey=");
+  for (i = 0; i < 100000; i++)
+    fputc('x', pFile);
+  fprintf(pFile, "\n[end]\nkey=end");
+  fclose(pFile);
+  pLazy = profile_lazy_load(file_name);
+  assert(pLazy);
+  pMapped = profile_lazy_load_io(profile_io_mmap(), file_name);
+  assert(pMapped);
+  pCopy = profile_lazy_load_io(profile_io_posix(), file_name);
+  assert(pCopy);
+  assert(profile_lazy_section_count(pMapped) == 30002);
+  assert(strcmp(profile_lazy_value(pMapped, "s29999", "key"),
+    "29999") == 0);
+  assert(strlen(profile_lazy_value(pMapped, "long", "key")) == 100000);
+  assert(strcmp(profile_lazy_value(pMapped, "end", "key"), "end") == 0);
+  pOld = profile_lazy_value(pMapped, "s10", "key");
+  assert(strcmp(pOld, "10") == 0);
+  /* truncated in place, the way the stdio backend writes */
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  fprintf(pFile, "[s0]\nkey=changed\n");
+  fclose(pFile);
+  /* a copy of the text is still there */
+  assert(profile_lazy_get(pCopy, "s25000", "key", "none", value,
+    sizeof(value)) == 5);
+  assert(strcmp(value, "25000") == 0);
+  assert(strcmp(profile_lazy_value(pCopy, "s0", "key"), "0") == 0);
+  /* an open file is indexed again, and answers from the new text */
+  assert(profile_lazy_get(pLazy, "s25000", "key", "none", value,
+    sizeof(value)) == 4);
+  assert(strcmp(value, "none") == 0);
+  assert(profile_lazy_section_count(pLazy) == 1);
+  assert(strcmp(profile_lazy_value(pLazy, "s0", "key"), "changed") == 0);
+  assert(strcmp(profile_lazy_value(pMapped, "s0", "key"), "changed") == 0);
+  assert(profile_lazy_value(pMapped, "s10", "key") == NULL);
+  /* what was returned before stays valid */
+  assert(strcmp(pOld, "10") == 0);
+  /* a listing after a change lists the new sections */
+  pFile = fopen(file_name, "a");
+  assert(pFile);
+  fprintf(pFile, "[added]\nkey=added\n");
+  fclose(pFile);
+  assert(profile_lazy_get(pMapped, NULL, NULL, "", value,
+    sizeof(value)) == 8);
+  assert(memcmp(value, "s0\0added\0", 10) == 0);
+  /* a file replaced by rename leaves the open one whole */
+  assert(profile_io_replace(profile_io_posix(), file_name, replaced,
+    strlen(replaced)));
+  assert(strcmp(profile_lazy_value(pMapped, "added", "key"), "added") == 0);
+  assert(strcmp(profile_lazy_value(pMapped, "s0", "key"), "changed") == 0);
+  assert(profile_lazy_get(pMapped, NULL, NULL, "", value,
+    sizeof(value)) == 8);
+  profile_lazy_free(pCopy);
+  profile_lazy_free(pMapped);
+  profile_lazy_free(pLazy);
+  remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileLazy();
+  test_ProfileLazyLarge();
+  test_ProfileLazyRewrite();
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief Test file for the layered INI file overlay module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "profile.h"
+#include "profile_overlay.h"
+
+/**
+* Check the value the overlay gives for a key
+*
+* @param pOverlay - overlay
+* @param app_name - section name
+* @param key_name - key name
+* @param expected_name - expected value
+*/
+static void TestGet(
+  PROFILE_OVERLAY *pOverlay,
+  const char *app_name,
+  const char *key_name,
+  const char *expected_name)
+{
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+
+  count = profile_overlay_get(pOverlay, app_name, key_name, "default",
+    return_name, sizeof(return_name));
+  assert(count == strlen(expected_name));
+  assert(strcmp(return_name, expected_name) == 0);
+}
+
+/**
+* Unit Tests for layered lookups
+*/
+static void test_ProfileOverlay(void)
+{
+  const char *file_names[3] = {
+    "test_local.ini", "test_site.ini", "test_defaults.ini"
+  };
+  PROFILE_OVERLAY *pOverlay = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+
+  remove(file_names[0]);
+  remove(file_names[1]);
+  remove(file_names[2]);
+  WritePrivateProfileString("net", "port", "80", file_names[2]);
+  WritePrivateProfileString("net", "host", "localhost", file_names[2]);
+  WritePrivateProfileString("log", "level", "info", file_names[2]);
+  WritePrivateProfileString("net", "port", "8080", file_names[1]);
+
+  pOverlay = profile_overlay_create(file_names, 3);
+  assert(pOverlay);
+  TestGet(pOverlay, "net", "port", "8080");
+  TestGet(pOverlay, "NET", "Host", "localhost");
+  TestGet(pOverlay, "log", "level", "info");
+  TestGet(pOverlay, "log", "file", "default");
+  assert(profile_overlay_value(pOverlay, "net", "missing") == NULL);
+  /* nothing changed */
+  assert(profile_overlay_refresh(pOverlay) == 0);
+
+  /* the missing local layer appears */
+  WritePrivateProfileString("net", "port", "443", file_names[0]);
+  WritePrivateProfileString("mine", "only", "here", file_names[0]);
+  assert(profile_overlay_refresh(pOverlay) == 1);
+  TestGet(pOverlay, "net", "port", "443");
+  TestGet(pOverlay, "net", "host", "localhost");
+  TestGet(pOverlay, "mine", "only", "here");
+
+  /* section names from all layers, once each, in priority order */
+  count = profile_overlay_get(pOverlay, NULL, NULL, "default",
+    return_name, sizeof(return_name));
+  assert(count == 12);
+  assert(memcmp(return_name, "net\0mine\0log\0\0", 14) == 0);
+  /* key names */
+  count = profile_overlay_get(pOverlay, "net", NULL, "default",
+    return_name, sizeof(return_name));
+  assert(count == 9);
+  assert(memcmp(return_name, "port\0host\0\0", 11) == 0);
+
+  /* explicit invalidation of one layer */
+  WritePrivateProfileString("net", "port", NULL, file_names[0]);
+  assert(profile_overlay_invalidate(pOverlay, 0));
+  TestGet(pOverlay, "net", "port", "8080");
+  assert(!profile_overlay_invalidate(pOverlay, 3));
+
+  /* a layer that goes away */
+  remove(file_names[1]);
+  assert(profile_overlay_refresh(pOverlay) == 1);
+  TestGet(pOverlay, "net", "port", "80");
+
+  profile_overlay_free(pOverlay);
+}
+
+/**
+* Set the modification time of a file
+*
+* @param file_name - name of the file
+* @param nanoseconds - part of a second, added to a fixed second
+*/
+static void TestSetTime(
+  const char *file_name,
+  long nanoseconds)
+{
+  struct timespec times[2];
+
+  times[0].tv_sec = 1700000000;
+  times[0].tv_nsec = nanoseconds;
+  times[1] = times[0];
+  assert(utimensat(AT_FDCWD, file_name, times, 0) == 0);
+}
+
+/**
+* Unit Tests for keys without a value, and changes within a second
+*/
+static void test_ProfileOverlayLayers(void)
+{
+  const char *file_names[2] = {"test_hi.ini", "test_lo.ini"};
+  PROFILE_OVERLAY *pOverlay = NULL;
+  FILE *pFile = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+
+  pFile = fopen(file_names[0], "w");
+  assert(pFile);
+  fputs("[s]\nk\nonly\n", pFile);
+  fclose(pFile);
+  remove(file_names[1]);
+  WritePrivateProfileString("s", "k", "lower", file_names[1]);
+  TestSetTime(file_names[1], 100);
+  pOverlay = profile_overlay_create(file_names, 2);
+  assert(pOverlay);
+  /* a key line without '=' does not hide the lower layers */
+  TestGet(pOverlay, "s", "k", "lower");
+  TestGet(pOverlay, "s", "only", "default");
+  count = profile_overlay_get(pOverlay, "s", NULL, "default",
+    return_name, sizeof(return_name));
+  assert(count == 6);
+  assert(memcmp(return_name, "k\0only\0\0", 9) == 0);
+  /* the same size in the same second is still a change */
+  WritePrivateProfileString("s", "k", "LOWER", file_names[1]);
+  TestSetTime(file_names[1], 200);
+  assert(profile_overlay_refresh(pOverlay) == 1);
+  TestGet(pOverlay, "s", "k", "LOWER");
+  profile_overlay_free(pOverlay);
+  remove(file_names[0]);
+  remove(file_names[1]);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileOverlay();
+  test_ProfileOverlayLayers();
+
+  return 0;
+}
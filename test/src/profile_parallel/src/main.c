@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @brief Test file for the parallel INI parser module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_parallel.h"
+
+/**
+* Check that two documents have the same sections and keys in order
+*
+* @param pExpected - document parsed on one thread
+* @param pDoc - document parsed on several threads
+*/
+static void TestSameDoc(
+  const PROFILE_DOC *pExpected,
+  const PROFILE_DOC *pDoc)
+{
+  PROFILE_SECTION *pSection = profile_doc_first(pExpected);
+  PROFILE_SECTION *pOther = profile_doc_first(pDoc);
+  PROFILE_ENTRY *pEntry = NULL;
+  PROFILE_ENTRY *pOtherEntry = NULL;
+
+  assert(profile_doc_section_count(pExpected) ==
+    profile_doc_section_count(pDoc));
+  while (pSection)
+  {
+    assert(pOther);
+    assert(strcmp(profile_section_name(pSection),
+      profile_section_name(pOther)) == 0);
+    assert(profile_section_entry_count(pSection) ==
+      profile_section_entry_count(pOther));
+    pEntry = profile_section_first(pSection);
+    pOtherEntry = profile_section_first(pOther);
+    while (pEntry)
+    {
+      assert(strcmp(profile_entry_key(pEntry),
+        profile_entry_key(pOtherEntry)) == 0);
+      assert(strcmp(profile_entry_value(pEntry),
+        profile_entry_value(pOtherEntry)) == 0);
+      pEntry = profile_entry_next(pEntry);
+      pOtherEntry = profile_entry_next(pOtherEntry);
+    }
+    pSection = profile_section_next(pSection);
+    pOther = profile_section_next(pOther);
+  }
+  assert(pOther == NULL);
+}
+
+/**
+* Unit Tests for parsing in chunks
+*/
+static void test_ProfileParallel(void)
+{
+  const char *file_name = "test_parallel1.ini";
+  PROFILE_DOC *pExpected = NULL;
+  PROFILE_DOC *pDoc = NULL;
+  FILE *pFile = NULL;
+  char *pBuffer = NULL;
+  size_t len = 0;
+  unsigned i;
+  unsigned j;
+
+  pFile = fopen(file_name, "w");
+  assert(pFile);
+  for (i = 0; i < 4000; i++)
+  {
+    /* every tenth section repeats an earlier one */
+    if (i % 10 == 9)
+      fprintf(pFile, "[Section%u]\n", i / 2);
+    else
+      fprintf(pFile, "  [Section%u]  \n", i);
+    for (j = 0; j < 8; j++)
+      fprintf(pFile, "Key%u = value %u.%u\n", j % 6, i, j);
+    fprintf(pFile, "; comment\n\n");
+  }
+  fclose(pFile);
+
+  pBuffer = profile_doc_read_file(file_name, &len);
+  assert(pBuffer);
+  assert(len > 4 * PROFILE_PARALLEL_MIN_CHUNK);
+  pExpected = profile_doc_create();
+  assert(pExpected);
+  assert(profile_doc_parse(pExpected, pBuffer, len));
+  for (i = 1; i <= 8; i++)
+  {
+    pDoc = profile_doc_parse_parallel(pBuffer, len, i);
+    assert(pDoc);
+    TestSameDoc(pExpected, pDoc);
+    profile_doc_free(pDoc);
+  }
+  free(pBuffer);
+
+  pDoc = profile_doc_load_parallel(file_name, 0);
+  assert(pDoc);
+  TestSameDoc(pExpected, pDoc);
+  assert(strcmp(profile_doc_value(pDoc, "section8", "key1"),
+    "value 8.1") == 0);
+  profile_doc_free(pDoc);
+  profile_doc_free(pExpected);
+
+  assert(profile_doc_load_parallel("missing.ini", 4) == NULL);
+  pDoc = profile_doc_parse_parallel("", 0, 4);
+  assert(pDoc);
+  assert(profile_doc_section_count(pDoc) == 0);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileParallel();
+
+  return 0;
+}
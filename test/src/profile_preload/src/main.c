@@ -0,0 +1,104 @@
+/**
+ * @file
+ * @brief Test file for the INI file preload module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "profile.h"
+#include "profile_cache.h"
+#include "profile_preload.h"
+
+#define TEST_DIR "test_preload.d"
+#define TEST_FILES 40
+
+/**
+* Make the name of one test file
+*
+* @param file_name - buffer that receives the name
+* @param size - size of the buffer
+* @param i - number of the file
+*/
+static void TestFileName(
+  char *file_name,
+  size_t size,
+  unsigned i)
+{
+  snprintf(file_name, size, TEST_DIR "/device%02u.ini", i);
+}
+
+/**
+* Unit Tests for preloading a list of files and a directory
+*/
+static void test_ProfilePreload(void)
+{
+  char file_name[TEST_FILES][64];
+  const char *file_list[TEST_FILES + 1];
+  char value[32] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  unsigned i = 0;
+
+  mkdir(TEST_DIR, 0755);
+  for (i = 0; i < TEST_FILES; i++)
+  {
+    TestFileName(file_name[i], sizeof(file_name[i]), i);
+    remove(file_name[i]);
+    snprintf(value, sizeof(value), "%u", i);
+    assert(WritePrivateProfileString("Device", "Instance", value,
+      file_name[i]));
+    file_list[i] = file_name[i];
+  }
+  /* a file that is not there is skipped */
+  file_list[TEST_FILES] = TEST_DIR "/missing.ini";
+  remove(TEST_DIR "/notes.txt");
+  assert(WritePrivateProfileString("Notes", "Text", "skip",
+    TEST_DIR "/notes.txt"));
+  profile_cache_clear();
+  assert(profile_preload(NULL, 0, 0) == 0);
+  assert(profile_preload(file_list, TEST_FILES + 1, 4) == TEST_FILES);
+  assert(profile_cache_count() == TEST_FILES);
+  for (i = 0; i < TEST_FILES; i++)
+  {
+    assert(profile_cache_contains(file_name[i]));
+    snprintf(value, sizeof(value), "%u", i);
+    GetPrivateProfileStringCached("Device", "Instance", "", return_name,
+      sizeof(return_name), file_name[i]);
+    assert(strcmp(return_name, value) == 0);
+  }
+  assert(!profile_cache_contains(TEST_DIR "/missing.ini"));
+  /* the same files again, from the directory */
+  profile_cache_clear();
+  assert(profile_preload_dir(TEST_DIR, ".ini", 0) == TEST_FILES);
+  assert(profile_cache_count() == TEST_FILES);
+  assert(profile_cache_contains(file_name[TEST_FILES - 1]));
+  assert(!profile_cache_contains(TEST_DIR "/notes.txt"));
+  profile_cache_clear();
+  assert(profile_preload_dir(TEST_DIR, NULL, 1) == TEST_FILES + 1);
+  assert(profile_cache_contains(TEST_DIR "/notes.txt"));
+  assert(profile_preload_dir("test_preload_missing.d", NULL, 0) == 0);
+  profile_cache_clear();
+  for (i = 0; i < TEST_FILES; i++)
+    remove(file_name[i]);
+  remove(TEST_DIR "/notes.txt");
+  rmdir(TEST_DIR);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfilePreload();
+
+  return 0;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file
+ * @brief Test file for the shared memory INI snapshot module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "profile.h"
+#include "profile_doc.h"
+#include "profile_shm.h"
+
+/* text with the odd cases of the parser */
+static const char Text[] =
+  "; comment before any section\n"
+  "[First]\n"
+  "key1 = value1\n"
+  "key2=\"quoted value\"\n"
+  "novalue\n"
+  "[Empty]\n"
+  "[Second]\n"
+  "key1=second\n"
+  "[first]\n"
+  "key1=repeated section\n"
+  "key3=repeated section\n"
+  "[Last]\n"
+  "key1=no newline at the end";
+
+/* lookups made on the snapshot and on the document */
+static const char *Names[][2] = {
+  {"First","key1"},
+  {"FIRST","KEY2"},
+  {"First","novalue"},
+  {"First","key3"},
+  {"First",NULL},
+  {"Empty","key1"},
+  {"Empty",NULL},
+  {"Second","key1"},
+  {"Second",NULL},
+  {"Last","key1"},
+  {"Missing","key1"},
+  {"Missing",NULL},
+  {NULL,NULL}
+};
+
+/**
+* Check a snapshot against the document it was published from
+*
+* @param pShm - segment
+* @param pDoc - document, or NULL for an empty document
+*/
+static void TestSameAnswers(
+  PROFILE_SHM *pShm,
+  const PROFILE_DOC *pDoc)
+{
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t size = 0;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(Names) / sizeof(Names[0]); i++)
+  {
+    /* whole answers and truncated ones */
+    for (size = 0; size < 24; size++)
+    {
+      memset(return_name, 'x', sizeof(return_name));
+      memset(expected, 'x', sizeof(expected));
+      count = profile_shm_get(pShm, Names[i][0], Names[i][1], "default",
+        return_name, size);
+      assert(count == profile_doc_get(pDoc, Names[i][0], Names[i][1],
+        "default", expected, size));
+      assert(memcmp(return_name, expected, size) == 0);
+    }
+    count = profile_shm_get(pShm, Names[i][0], Names[i][1], "default",
+      return_name, sizeof(return_name));
+    assert(count == profile_doc_get(pDoc, Names[i][0], Names[i][1],
+      "default", expected, sizeof(expected)));
+    assert(memcmp(return_name, expected, count + 2) == 0);
+  }
+}
+
+/**
+* Unit Tests for publishing to a named segment
+*/
+static void test_ProfileShmPublish(void)
+{
+  const char *pName = "/profile_shm_test";
+  PROFILE_SHM *pPublisher = NULL;
+  PROFILE_SHM *pReader = NULL;
+  PROFILE_DOC *pDoc = NULL;
+  PROFILE_DOC *pLarge = NULL;
+  char app_name[32] = {""};
+  char key_name[32] = {""};
+  char value[32] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  unsigned i = 0;
+
+  profile_shm_unlink(pName);
+  assert(profile_shm_attach(pName) == NULL);
+  pPublisher = profile_shm_create(pName, 0);
+  assert(pPublisher);
+  pReader = profile_shm_attach(pName);
+  assert(pReader);
+  /* nothing published yet */
+  assert(profile_shm_generation(pReader) == 0);
+  TestSameAnswers(pReader, NULL);
+  pDoc = profile_doc_load_buffer(Text, strlen(Text));
+  assert(pDoc);
+  assert(profile_shm_publish(pPublisher, pDoc));
+  assert(profile_shm_generation(pReader) == 1);
+  TestSameAnswers(pReader, pDoc);
+  TestSameAnswers(pPublisher, pDoc);
+  /* a snapshot larger than the segment makes it grow */
+  pLarge = profile_doc_create();
+  assert(pLarge);
+  for (i = 0; i < 1000; i++)
+  {
+    sprintf(app_name, "Section%u", i / 10);
+    sprintf(key_name, "Key%u", i);
+    sprintf(value, "Value%u", i);
+    assert(profile_doc_set(pLarge, app_name, key_name, value));
+  }
+  assert(profile_shm_publish(pPublisher, pLarge));
+  assert(profile_shm_generation(pReader) == 2);
+  assert(profile_shm_get(pReader, "section99", "KEY999", "", return_name,
+    sizeof(return_name)) == 8);
+  assert(strcmp(return_name, "Value999") == 0);
+  assert(profile_shm_get(pReader, "First", "key1", "none", return_name,
+    sizeof(return_name)) == 4);
+  /* and a reader that attaches later maps all of it */
+  profile_shm_close(pReader);
+  pReader = profile_shm_attach(pName);
+  assert(pReader);
+  assert(profile_shm_get(pReader, "Section0", "Key0", "", return_name,
+    sizeof(return_name)) == 6);
+  assert(profile_shm_publish(pPublisher, pDoc));
+  TestSameAnswers(pReader, pDoc);
+  assert(profile_shm_publish(pPublisher, NULL));
+  TestSameAnswers(pReader, NULL);
+  /* readers cannot publish */
+  assert(!profile_shm_publish(pReader, pDoc));
+  /* a new publisher carries on from the old generation */
+  profile_shm_close(pPublisher);
+  pPublisher = profile_shm_create(pName, 0);
+  assert(pPublisher);
+  assert(profile_shm_generation(pPublisher) == 4);
+  assert(profile_shm_publish(pPublisher, pDoc));
+  TestSameAnswers(pReader, pDoc);
+  assert(profile_shm_unlink(pName));
+  assert(profile_shm_attach(pName) == NULL);
+  /* the segment lasts while it is mapped */
+  TestSameAnswers(pReader, pDoc);
+  profile_shm_close(pReader);
+  profile_shm_close(pPublisher);
+  profile_doc_free(pLarge);
+  profile_doc_free(pDoc);
+}
+
+/**
+* Make a document with one value repeated to a length
+*
+* @param c - character of the value
+* @param len - length of the value
+*
+* @return document
+*/
+static PROFILE_DOC *TestRepeatedDoc(
+  char c,
+  size_t len)
+{
+  PROFILE_DOC *pDoc = NULL;
+  char value[MAX_LINE_LEN] = {""};
+
+  memset(value, c, len);
+  value[len] = '\0';
+  pDoc = profile_doc_create();
+  assert(pDoc);
+  assert(profile_doc_set(pDoc, "Section", "Key1", value));
+  assert(profile_doc_set(pDoc, "Section", "Key2", value));
+
+  return (pDoc);
+}
+
+/**
+* Unit Tests for readers in another process, which must never see
+* a snapshot that is only partly copied
+*/
+static void test_ProfileShmProcesses(void)
+{
+  PROFILE_SHM *pPublisher = NULL;
+  PROFILE_SHM *pReader = NULL;
+  PROFILE_DOC *pDocs[2] = {NULL, NULL};
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t i = 0;
+  int status = 0;
+  pid_t pid = 0;
+
+  pPublisher = profile_shm_create(NULL, 0);
+  if (!pPublisher)
+  {
+    /* no unnamed segments on this system */
+    return;
+  }
+  pDocs[0] = TestRepeatedDoc('a', 100);
+  pDocs[1] = TestRepeatedDoc('b', 200);
+  assert(profile_shm_publish(pPublisher, pDocs[0]));
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0)
+  {
+    pReader = profile_shm_attach_fd(profile_shm_fd(pPublisher));
+    if (!pReader)
+      _exit(1);
+    /* read while the parent publishes two thousand snapshots */
+    while (profile_shm_generation(pReader) < 2000)
+    {
+      count = profile_shm_get(pReader, "Section", "Key2", "", return_name,
+        sizeof(return_name));
+      if (!(((count == 100) && (return_name[0] == 'a') &&
+        (return_name[99] == 'a')) ||
+        ((count == 200) && (return_name[0] == 'b') &&
+        (return_name[199] == 'b'))))
+        _exit(2);
+      count = profile_shm_get(pReader, "Section", NULL, "", return_name,
+        sizeof(return_name));
+      if ((count != 9) || (memcmp(return_name, "Key1\0Key2\0", 11) != 0))
+        _exit(3);
+    }
+    profile_shm_close(pReader);
+    _exit(0);
+  }
+  while (waitpid(pid, &status, WNOHANG) == 0)
+  {
+    assert(profile_shm_publish(pPublisher, pDocs[i % 2]));
+    i++;
+  }
+  assert(WIFEXITED(status));
+  assert(WEXITSTATUS(status) == 0);
+  profile_shm_close(pPublisher);
+  profile_doc_free(pDocs[0]);
+  profile_doc_free(pDocs[1]);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileShmPublish();
+  test_ProfileShmProcesses();
+
+  return 0;
+}
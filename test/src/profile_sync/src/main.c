@@ -0,0 +1,169 @@
+/**
+ * @file
+ * @brief Test file for the write durability module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_sync.h"
+#include "profile_text.h"
+
+#define TEST_THREADS 8
+#define TEST_WRITES 20
+
+/**
+* Unit Tests for the number of flushes at each level
+*/
+static void test_ProfileSyncLevel(void)
+{
+  const char *file_name = "test_sync.ini";
+  PROFILE_TEXT *pText = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  unsigned long count = 0;
+
+  remove(file_name);
+  assert(profile_sync_level() == PROFILE_SYNC_NONE);
+  profile_sync_set_level(7);
+  assert(profile_sync_level() == PROFILE_SYNC_NONE);
+  /* nothing is flushed by default */
+  count = profile_sync_count();
+  assert(WritePrivateProfileString("Sync", "Key", "1", file_name));
+  assert(WritePrivateProfileString("Sync", "Key", "2", file_name));
+  assert(WritePrivateProfileStringIo(profile_io_posix(), "Sync", "Key", "3",
+    file_name));
+  assert(profile_sync_count() == count);
+  /* the file only */
+  profile_sync_set_level(PROFILE_SYNC_DATA);
+  assert(profile_sync_level() == PROFILE_SYNC_DATA);
+  assert(WritePrivateProfileString("Sync", "Key", "4", file_name));
+  assert(profile_sync_count() == count + 1);
+  assert(WritePrivateProfileStringIo(profile_io_posix(), "Sync", "Key", "5",
+    file_name));
+  assert(profile_sync_count() == count + 2);
+  /* the file, and the directory after a rename or a new file */
+  profile_sync_set_level(PROFILE_SYNC_FULL);
+  count = profile_sync_count();
+  assert(WritePrivateProfileString("Sync", "Key", "6", file_name));
+  assert(profile_sync_count() == count + 2);
+  assert(WritePrivateProfileStringIo(profile_io_posix(), "Sync", "Key", "7",
+    file_name));
+  assert(profile_sync_count() == count + 4);
+  /* a lone writer of a group costs the same as FULL */
+  profile_sync_set_level(PROFILE_SYNC_GROUP);
+  count = profile_sync_count();
+  assert(WritePrivateProfileString("Sync", "Key", "6", file_name));
+  assert(profile_sync_count() == count + 2);
+  assert(WritePrivateProfileStringIo(profile_io_posix(), "Sync", "Key", "7",
+    file_name));
+  assert(profile_sync_count() == count + 4);
+  profile_sync_set_level(PROFILE_SYNC_FULL);
+  remove(file_name);
+  assert(WritePrivateProfileString("Sync", "Key", "8", file_name));
+  assert(profile_sync_count() == count + 6);
+  GetPrivateProfileString("Sync", "Key", "", return_name,
+    sizeof(return_name), file_name);
+  assert(strcmp(return_name, "8") == 0);
+  assert(profile_sync_dir("/test_sync.ini", PROFILE_SYNC_FULL));
+  assert(profile_sync_dir("./test_sync.ini", PROFILE_SYNC_FULL));
+  assert(!profile_sync_dir("test_sync_missing.d/x.ini",
+    PROFILE_SYNC_FULL));
+  assert(profile_sync_dir("test_sync_missing.d/x.ini", PROFILE_SYNC_DATA));
+  /* a text may choose its own level */
+  profile_sync_set_level(PROFILE_SYNC_NONE);
+  pText = profile_text_load(file_name);
+  assert(pText);
+  profile_text_set_durability(pText, PROFILE_SYNC_DATA);
+  assert(profile_text_set(pText, "Sync", "Key", "9"));
+  count = profile_sync_count();
+  assert(profile_text_commit(pText));
+  assert(profile_sync_count() == count + 1);
+  profile_text_free(pText);
+  assert(!profile_sync_fd(-1, PROFILE_SYNC_FULL));
+  remove(file_name);
+}
+
+/**
+* Write one file again and again
+*
+* @param pArg - number of the thread
+*
+* @return NULL
+*/
+static void *TestSyncWriter(
+  void *pArg)
+{
+  char file_name[32] = {""};
+  char value[32] = {""};
+  unsigned i = 0;
+
+  snprintf(file_name, sizeof(file_name), "test_sync_%u.ini",
+    *(unsigned *)pArg);
+  for (i = 0; i < TEST_WRITES; i++)
+  {
+    snprintf(value, sizeof(value), "%u", i);
+    assert(WritePrivateProfileStringIo(profile_io_posix(), "Sync", "Key",
+      value, file_name));
+  }
+
+  return (NULL);
+}
+
+/**
+* Unit Tests for writers that share a flush
+*/
+static void test_ProfileSyncGroup(void)
+{
+  pthread_t thread[TEST_THREADS];
+  unsigned number[TEST_THREADS];
+  char file_name[32] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  unsigned long count = 0;
+  unsigned i = 0;
+
+  profile_sync_set_level(PROFILE_SYNC_GROUP);
+  count = profile_sync_count();
+  for (i = 0; i < TEST_THREADS; i++)
+  {
+    number[i] = i;
+    assert(pthread_create(&thread[i], NULL, TestSyncWriter,
+      &number[i]) == 0);
+  }
+  for (i = 0; i < TEST_THREADS; i++)
+  {
+    pthread_join(thread[i], NULL);
+  }
+  /* never more than a file and a directory flush for each write */
+  assert(profile_sync_count() - count <= 2 * TEST_THREADS * TEST_WRITES);
+  assert(profile_sync_count() > count);
+  for (i = 0; i < TEST_THREADS; i++)
+  {
+    snprintf(file_name, sizeof(file_name), "test_sync_%u.ini", i);
+    GetPrivateProfileString("Sync", "Key", "", return_name,
+      sizeof(return_name), file_name);
+    assert(atoi(return_name) == TEST_WRITES - 1);
+    remove(file_name);
+  }
+  profile_sync_set_level(PROFILE_SYNC_NONE);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileSyncLevel();
+  test_ProfileSyncGroup();
+
+  return 0;
+}
@@ -0,0 +1,269 @@
+/**
+ * @file
+ * @brief Test file for the lossless INI text module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_text.h"
+
+/* the same changes are made with WritePrivateProfileString */
+static const char *Writes[][3] = {
+  {"MySection1","MyKey1","MyKey1Value"},
+  {"MySection1","MyKey2","\"MyKey2 Value\""},
+  {"MySection2","MyKey3","MyKey3Value"},
+  {"mysection1","mykey1","Changed"},
+  {"MySection3","MyKey5","MyKey5Value"},
+  {"MySection2","MyKey3",NULL},
+  {"Network","Port","47809"},
+  {"Network","Flag","1"},
+  {"MySection3",NULL,NULL}
+};
+
+/* and then looked up in both files */
+static const char *Names[][2] = {
+  {"MySection1","MyKey1"},
+  {"MYSECTION1","mykey2"},
+  {"MySection2","MyKey3"},
+  {"MySection3","MyKey5"},
+  {"Network","Address"},
+  {"Network","Port"},
+  {"Network","Flag"},
+  {"Network",NULL},
+  {NULL,NULL}
+};
+
+/* a file that was written by hand */
+static const char Text[] =
+  "; Device configuration\n"
+  "[Network]\n"
+  "  Address = 192.168.0.1\n"
+  "  Port=47808\n"
+  "  ; keep this comment\n"
+  "  Flag\n"
+  "\n"
+  "[MySection1]\n"
+  "MyKey1   =   Old\n"
+  "\n";
+
+/**
+* Write a file
+*
+* @param file_name - name of the file
+* @param text - contents
+*/
+static void TestWriteFile(
+  const char *file_name,
+  const char *text)
+{
+  assert(profile_io_replace(profile_io_posix(), file_name, text,
+    strlen(text)));
+}
+
+/**
+* Check that a file holds some text
+*
+* @param file_name - name of the file
+* @param text - expected contents
+*/
+static void TestFileText(
+  const char *file_name,
+  const char *text)
+{
+  char *pBuffer = NULL;
+  size_t len = 0;
+
+  pBuffer = profile_io_read(profile_io_posix(), file_name, &len);
+  assert(pBuffer);
+  assert(len == strlen(text));
+  assert(memcmp(pBuffer, text, len) == 0);
+  free(pBuffer);
+}
+
+/**
+* Unit Tests for the same answers as WritePrivateProfileString
+*/
+static void test_ProfileTextWrite(void)
+{
+  const char *file_name = "test_text.ini";
+  const char *expected_name = "test_text_expected.ini";
+  PROFILE_TEXT *pText = NULL;
+  char return_name[MAX_LINE_LEN] = {""};
+  char expected[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t i = 0;
+  size_t j = 0;
+  BOOL status = FALSE;
+
+  TestWriteFile(file_name, Text);
+  TestWriteFile(expected_name, Text);
+  for (i = 0; i < sizeof(Writes) / sizeof(Writes[0]); i++)
+  {
+    pText = profile_text_load(file_name);
+    assert(pText);
+    status = profile_text_set(pText, Writes[i][0], Writes[i][1],
+      Writes[i][2]);
+    /* deleting the last section of a file reports FALSE there */
+    assert((WritePrivateProfileString(Writes[i][0], Writes[i][1],
+      Writes[i][2], expected_name) == status) || !Writes[i][1]);
+    assert(status);
+    assert(profile_text_commit(pText));
+    assert(!profile_text_dirty(pText));
+    profile_text_free(pText);
+    for (j = 0; j < sizeof(Names) / sizeof(Names[0]); j++)
+    {
+      count = GetPrivateProfileString(Names[j][0], Names[j][1], "none",
+        return_name, sizeof(return_name), file_name);
+      assert(count == GetPrivateProfileString(Names[j][0], Names[j][1],
+        "none", expected, sizeof(expected), expected_name));
+      assert(memcmp(return_name, expected, count + 1) == 0);
+    }
+  }
+  /* only the changed lines were touched */
+  pText = profile_text_load(file_name);
+  assert(pText);
+  count = profile_text_get(pText, "Network", "Address", "", return_name,
+    sizeof(return_name));
+  assert(strcmp(return_name, "192.168.0.1") == 0);
+  TestFileText(file_name,
+    "; Device configuration\n"
+    "[Network]\n"
+    "  Address = 192.168.0.1\n"
+    "  Port=47809\n"
+    "  ; keep this comment\n"
+    "  Flag=1\n"
+    "\n"
+    "[MySection1]\n"
+    "MyKey1   =   Changed\n"
+    "MyKey2=\"MyKey2 Value\"\n"
+    "\n"
+    "[MySection2]\n");
+  profile_text_free(pText);
+  remove(file_name);
+  remove(expected_name);
+}
+
+/**
+* Unit Tests for writing only what changed
+*/
+static void test_ProfileTextDirty(void)
+{
+  const char *file_name = "test_text_dirty.ini";
+  PROFILE_TEXT *pText = NULL;
+  const char *pData = NULL;
+  size_t len = 0;
+
+  TestWriteFile(file_name, Text);
+  pText = profile_text_load(file_name);
+  assert(pText);
+  assert(!profile_text_dirty(pText));
+  assert(profile_text_commit(pText));
+  /* the same value is not a change */
+  assert(profile_text_set(pText, "network", "port", "47808"));
+  assert(!profile_text_dirty(pText));
+  /* the same length changes only the value */
+  assert(profile_text_set(pText, "Network", "Port", "47809"));
+  assert(profile_text_set(pText, "MySection1", "MyKey1", "New"));
+  assert(profile_text_dirty(pText));
+  assert(profile_text_dirty_bytes(pText) == 8);
+  assert(profile_text_set(pText, "Network", "Port", "47810"));
+  assert(profile_text_dirty_bytes(pText) == 8);
+  /* a longer value moves the rest of the file */
+  pData = profile_text_data(pText, &len);
+  assert(len == strlen(Text));
+  assert(profile_text_set(pText, "MySection1", "MyKey1", "Longer"));
+  pData = profile_text_data(pText, &len);
+  assert(profile_text_dirty_bytes(pText) ==
+    5 + (len - (size_t)(strstr(pData, "Longer") - pData)));
+  assert(profile_text_commit(pText));
+  assert(profile_text_dirty_bytes(pText) == 0);
+  TestFileText(file_name,
+    "; Device configuration\n"
+    "[Network]\n"
+    "  Address = 192.168.0.1\n"
+    "  Port=47810\n"
+    "  ; keep this comment\n"
+    "  Flag\n"
+    "\n"
+    "[MySection1]\n"
+    "MyKey1   =   Longer\n"
+    "\n");
+  /* a shorter file is cut short */
+  assert(profile_text_set(pText, "MySection1", NULL, NULL));
+  assert(profile_text_commit(pText));
+  TestFileText(file_name,
+    "; Device configuration\n"
+    "[Network]\n"
+    "  Address = 192.168.0.1\n"
+    "  Port=47810\n"
+    "  ; keep this comment\n"
+    "  Flag\n"
+    "\n");
+  /* nothing to delete */
+  assert(!profile_text_set(pText, "MySection1", NULL, NULL));
+  assert(!profile_text_set(pText, "Network", "Missing", NULL));
+  assert(!profile_text_dirty(pText));
+  /* a file changed by someone else is not overwritten */
+  assert(profile_text_set(pText, "Network", "Port", "1"));
+  assert(WritePrivateProfileString("Other", "Key", "Value", file_name));
+  assert(!profile_text_commit(pText));
+  assert(profile_text_dirty(pText));
+  profile_text_free(pText);
+  remove(file_name);
+}
+
+/**
+* Unit Tests for new files and text in memory
+*/
+static void test_ProfileTextNew(void)
+{
+  const char *file_name = "test_text_new.ini";
+  PROFILE_TEXT *pText = NULL;
+  const char *pData = NULL;
+  size_t len = 0;
+
+  remove(file_name);
+  pText = profile_text_load(file_name);
+  assert(pText);
+  pData = profile_text_data(pText, &len);
+  assert(pData && (len == 0));
+  assert(profile_text_set(pText, "A", "b", "c"));
+  assert(profile_text_set(pText, "A", "d", "e"));
+  assert(profile_text_commit(pText));
+  TestFileText(file_name, "[A]\nb=c\nd=e\n");
+  profile_text_free(pText);
+  /* a last line without a newline */
+  pText = profile_text_load_buffer("[a]\nb=1", 7);
+  assert(pText);
+  assert(profile_text_set(pText, "a", "c", "2"));
+  assert(profile_text_set(pText, "z", "y", "x"));
+  pData = profile_text_data(pText, &len);
+  assert(len == strlen("[a]\nb=1\nc=2\n[z]\ny=x\n"));
+  assert(memcmp(pData, "[a]\nb=1\nc=2\n[z]\ny=x\n", len) == 0);
+  /* text from memory has no file */
+  assert(!profile_text_commit(pText));
+  profile_text_free(pText);
+  remove(file_name);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileTextWrite();
+  test_ProfileTextDirty();
+  test_ProfileTextNew();
+
+  return 0;
+}
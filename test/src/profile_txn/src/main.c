@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @brief Test file for the INI transaction module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "profile.h"
+#include "profile_io.h"
+#include "profile_txn.h"
+
+/* the changes of one transaction, in two files */
+static const char *Writes[][4] = {
+  {"MySection1","MyKey1","MyKey1Value","test_txn_a.ini"},
+  {"MySection1","MyKey2","\"MyKey2 Value\"","test_txn_a.ini"},
+  {"Device","Instance","1234","test_txn_b.ini"},
+  {"mysection1","mykey1","Changed","test_txn_a.ini"},
+  {"MySection2","MyKey3","MyKey3Value","test_txn_a.ini"},
+  {"Device","Name","Boiler","test_txn_b.ini"},
+  {"MySection2","MyKey3",NULL,"test_txn_a.ini"},
+  {"Old",NULL,NULL,"test_txn_a.ini"}
+};
+
+/**
+* Check that two files hold the same bytes
+*
+* @param pIo - backend of the file
+* @param file_name - name of the file
+* @param expected_name - name of the file written with stdio
+*/
+static void TestSameFile(
+  const PROFILE_IO *pIo,
+  const char *file_name,
+  const char *expected_name)
+{
+  char *pBuffer = NULL;
+  char *pExpected = NULL;
+  size_t len = 0;
+  size_t expected_len = 0;
+
+  pBuffer = profile_io_read(pIo, file_name, &len);
+  pExpected = profile_io_read(profile_io_posix(), expected_name,
+    &expected_len);
+  assert(pBuffer && pExpected);
+  assert(len == expected_len);
+  assert(memcmp(pBuffer, pExpected, len) == 0);
+  free(pBuffer);
+  free(pExpected);
+}
+
+/**
+* Unit Tests for one transaction with a backend
+*
+* @param pIo - backend
+*/
+static void TestTransaction(
+  const PROFILE_IO *pIo)
+{
+  PROFILE_TXN *pTxn = NULL;
+  PROFILE_IO_STAT file_stat;
+  char expected_name[32] = {""};
+  char return_name[MAX_LINE_LEN] = {""};
+  size_t count = 0;
+  size_t i = 0;
+
+  remove("test_txn_expected_a.ini");
+  remove("test_txn_expected_b.ini");
+  assert(profile_io_replace(pIo, "test_txn_a.ini", "[Old]\nKey=1\n", 12));
+  assert(profile_io_replace(profile_io_posix(), "test_txn_expected_a.ini",
+    "[Old]\nKey=1\n", 12));
+  /* nothing happens until the commit */
+  pTxn = profile_txn_begin(pIo);
+  assert(pTxn);
+  for (i = 0; i < sizeof(Writes) / sizeof(Writes[0]); i++)
+  {
+    snprintf(expected_name, sizeof(expected_name), "test_txn_expected_%s",
+      Writes[i][3] + strlen("test_txn_"));
+    assert(profile_txn_set(pTxn, Writes[i][0], Writes[i][1], Writes[i][2],
+      Writes[i][3]) == WritePrivateProfileString(Writes[i][0],
+      Writes[i][1], Writes[i][2], expected_name));
+  }
+  /* the transaction sees its own writes */
+  count = profile_txn_get(pTxn, "MySection1", "MyKey1", "", return_name,
+    sizeof(return_name), "test_txn_a.ini");
+  assert(count == strlen("Changed"));
+  assert(strcmp(return_name, "Changed") == 0);
+  count = profile_txn_get(pTxn, "Old", "Key", "gone", return_name,
+    sizeof(return_name), "test_txn_a.ini");
+  assert(strcmp(return_name, "gone") == 0);
+  /* and nobody else does */
+  assert(!profile_io_stat(pIo, "test_txn_b.ini", &file_stat));
+  count = GetPrivateProfileStringIo(pIo, "Old", "Key", "", return_name,
+    sizeof(return_name), "test_txn_a.ini");
+  assert(strcmp(return_name, "1") == 0);
+  assert(profile_txn_commit(pTxn));
+  TestSameFile(pIo, "test_txn_a.ini", "test_txn_expected_a.ini");
+  TestSameFile(pIo, "test_txn_b.ini", "test_txn_expected_b.ini");
+  /* a rollback leaves the files alone */
+  pTxn = profile_txn_begin(pIo);
+  assert(pTxn);
+  assert(profile_txn_set(pTxn, "Device", "Instance", "99",
+    "test_txn_b.ini"));
+  assert(profile_txn_set(pTxn, "New", "Key", "Value", "test_txn_c.ini"));
+  profile_txn_rollback(pTxn);
+  TestSameFile(pIo, "test_txn_b.ini", "test_txn_expected_b.ini");
+  assert(!profile_io_stat(pIo, "test_txn_c.ini", &file_stat));
+  /* a file that changed underneath stops the whole commit */
+  pTxn = profile_txn_begin(pIo);
+  assert(pTxn);
+  assert(profile_txn_set(pTxn, "Device", "Instance", "99",
+    "test_txn_b.ini"));
+  assert(profile_txn_set(pTxn, "MySection1", "MyKey1", "Lost",
+    "test_txn_a.ini"));
+  assert(WritePrivateProfileStringIo(pIo, "Device", "Instance", "5678",
+    "test_txn_a.ini"));
+  assert(!profile_txn_commit(pTxn));
+  GetPrivateProfileStringIo(pIo, "Device", "Instance", "", return_name,
+    sizeof(return_name), "test_txn_b.ini");
+  assert(strcmp(return_name, "1234") == 0);
+  GetPrivateProfileStringIo(pIo, "MySection1", "MyKey1", "", return_name,
+    sizeof(return_name), "test_txn_a.ini");
+  assert(strcmp(return_name, "Changed") == 0);
+  /* deleting from no file does not make one */
+  pTxn = profile_txn_begin(pIo);
+  assert(pTxn);
+  assert(!profile_txn_set(pTxn, "New", "Key", NULL, "test_txn_c.ini"));
+  assert(!profile_txn_set(pTxn, "New", NULL, NULL, "test_txn_c.ini"));
+  assert(profile_txn_commit(pTxn));
+  assert(!profile_io_stat(pIo, "test_txn_c.ini", &file_stat));
+  remove("test_txn_expected_a.ini");
+  remove("test_txn_expected_b.ini");
+}
+
+/**
+* Unit Tests for transactions
+*/
+static void test_ProfileTxn(void)
+{
+  PROFILE_IO *pMemory = NULL;
+
+  remove("test_txn_a.ini");
+  remove("test_txn_b.ini");
+  TestTransaction(profile_io_posix());
+  remove("test_txn_a.ini");
+  remove("test_txn_b.ini");
+  pMemory = profile_io_memory_create();
+  assert(pMemory);
+  TestTransaction(pMemory);
+  profile_io_memory_free(pMemory);
+  assert(!profile_txn_commit(NULL));
+  profile_txn_rollback(NULL);
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+  test_ProfileTxn();
+
+  return 0;
+}
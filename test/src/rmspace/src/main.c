@@ -87,6 +87,16 @@ static void test_rmtrail(void)
   assert(strlen(token) == len);
   assert(strcmp(result,token) == 0);
 
+  /* nothing but spaces */
+  strcpy(token,"\n");
+  len = rmtrail(token);
+  assert(len == 0);
+  assert(token[0] == '\0');
+  strcpy(token," \t ");
+  len = rmtrail(token);
+  assert(len == 0);
+  assert(token[0] == '\0');
+
   return;
 }
 
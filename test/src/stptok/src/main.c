@@ -42,6 +42,94 @@ static void testTokens(void)
     return;
 }
 
+/**
+* Unit Test for runs of break characters and the compiled break set
+*/
+static void testCompiled(void)
+{
+    const char *pCmd = "key   =\t value";
+    char token[80] = "";
+    char small[4] = "";
+    STPTOK_DELIM delim;
+
+    /* a whole run of break characters is skipped */
+    pCmd = stptok(pCmd, token, sizeof(token), " =\t");
+    assert(strcmp(token, "key") == 0);
+    assert(strcmp(pCmd, "value") == 0);
+
+    stptok_compile(&delim, ",;");
+    pCmd = stptok_compiled("alpha,,;beta;", token, sizeof(token), &delim);
+    assert(strcmp(token, "alpha") == 0);
+    assert(strcmp(pCmd, "beta;") == 0);
+    pCmd = stptok_compiled(pCmd, token, sizeof(token), &delim);
+    assert(strcmp(token, "beta") == 0);
+    assert(pCmd == NULL);
+
+    /* the token buffer is full */
+    pCmd = stptok_compiled("alpha,beta", small, sizeof(small), &delim);
+    assert(strcmp(small, "alp") == 0);
+    assert(strcmp(pCmd, "ha,beta") == 0);
+
+    /* empty string */
+    pCmd = stptok_compiled("", token, sizeof(token), &delim);
+    assert(token[0] == 0);
+    assert(pCmd == NULL);
+
+    /* high characters and no break characters */
+    stptok_compile(&delim, "\xff");
+    pCmd = stptok_compiled("a\xff\xff" "b", token, sizeof(token), &delim);
+    assert(strcmp(token, "a") == 0);
+    assert(strcmp(pCmd, "b") == 0);
+    stptok_compile(&delim, NULL);
+    pCmd = stptok_compiled("a b", token, sizeof(token), &delim);
+    assert(strcmp(token, "a b") == 0);
+    assert(pCmd == NULL);
+
+    return;
+}
+
+/**
+* Unit Test for splitting a string into token views
+*/
+static void testSplit(void)
+{
+    const char *pLine = " GET /index.html  200\r\n";
+    STPTOK_VIEW views[3];
+    STPTOK_DELIM delim;
+    const char *pCmd = pLine;
+    char token[80] = "";
+    size_t count = 0;
+    size_t i = 0;
+
+    stptok_compile(&delim, " \r\n");
+    count = stptok_split(pLine, strlen(pLine), &delim, views, 3);
+    assert(count == 4);
+    /* same tokens as stptok */
+    for (i = 0; i < 3; i++) {
+        pCmd = stptok(pCmd, token, sizeof(token), " \r\n");
+        assert(strlen(token) == views[i].len);
+        assert(memcmp(token, views[i].start, views[i].len) == 0);
+    }
+    assert(views[0].len == 0);
+    assert(views[1].start == pLine + 1);
+    assert(views[2].len == 11);
+
+    /* only count */
+    count = stptok_split(pLine, strlen(pLine), &delim, NULL, 0);
+    assert(count == 4);
+
+    /* stop at the length */
+    count = stptok_split("a b c", 3, &delim, views, 3);
+    assert(count == 2);
+    assert(views[1].len == 1);
+    assert(*views[1].start == 'b');
+
+    count = stptok_split("", 5, &delim, views, 3);
+    assert(count == 0);
+
+    return;
+}
+
 /**
 * Main program entry for Unit Test
 *
@@ -50,6 +138,8 @@ static void testTokens(void)
 int main(void)
 {
   testTokens();
+  testCompiled();
+  testSplit();
 
   return 0;
 }
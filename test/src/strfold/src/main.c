@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Test file for the case-folded compare and hash module
+ * @author Steve Karg <skarg@users.sourceforge.net>
+ * @date December 2024
+ * @copyright SPDX-License-Identifier: MIT
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <assert.h>
+#include "strfold.h"
+
+/**
+* Sign of a compare result
+*
+* @param value - compare result
+*
+* @return -1, 0 or 1
+*/
+static int sign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+/**
+* Unit Test for the compare functions
+*/
+static void testCompare(void)
+{
+    const char *names[] = {
+        "", "a", "A", "key", "KEY", "Key1", "key2", "MySection1",
+        "mysection1", "mysection2", "A Much Longer Section Name",
+        "a much longer section name", "a much longer section namf",
+        "@[`{", "`{@[", "Z", "z", "_", "\xe9t\xe9", "\xc9T\xc9"
+    };
+    size_t count = sizeof(names) / sizeof(names[0]);
+    size_t i;
+    size_t j;
+    size_t len;
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < count; j++) {
+            assert(sign(strfold_casecmp(names[i], names[j])) ==
+                sign(strcasecmp(names[i], names[j])));
+            len = strlen(names[i]);
+            if (strlen(names[j]) == len) {
+                assert(!strfold_equal(names[i], names[j], len) ==
+                    !!strcasecmp(names[i], names[j]));
+            }
+        }
+    }
+    /* letters next to the alphabet must not fold */
+    assert(!strfold_equal("@@@@@@@@[", "````````{", 9));
+    assert(strfold_equal("ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+        "abcdefghijklmnopqrstuvwxyz", 26));
+    assert(strfold_char('Q') == 'q');
+    assert(strfold_char('q') == 'q');
+    assert(strfold_char('[') == '[');
+
+    return;
+}
+
+/**
+* Unit Test for the hash functions
+*/
+static void testHash(void)
+{
+    unsigned hash;
+
+    assert(strfold_hash("MySection", 9) == strfold_hash("mysection", 9));
+    assert(strfold_hash("MySection", 9) != strfold_hash("mysectiom", 9));
+    assert(strfold_hash("", 0) == STRFOLD_HASH_INIT);
+    hash = strfold_hash_more(STRFOLD_HASH_INIT, "My", 2);
+    hash = strfold_hash_more(hash, "SECTION", 7);
+    assert(hash == strfold_hash("mysection", 9));
+
+    return;
+}
+
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(void)
+{
+    testCompare();
+    testHash();
+
+    return 0;
+}